@@ -0,0 +1,355 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Asynchronous I/O benchmark.  A SmartFS is formatted on a RAM MTD device,
+ * so that the time measured is that of the file system and of the AIO
+ * logic rather than of a flash part.  A file is written, then read back and
+ * checked, in CONFIG_EXAMPLES_AIO_BENCH_CHUNK byte pieces:
+ *
+ * - with write() and read();
+ * - with aio_write() and aio_read(), waiting for each before the next, as a
+ *   caller that only overlaps I/O with its own work does;
+ * - with lio_listio() lists of up to CONFIG_FS_NAIOC pieces, which the AIO
+ *   threads can merge into larger transfers (FS_AIO_MERGE_SIZE).
+ *
+ * Last, two files are written at the same time by lio_listio() lists mixing
+ * both, which several AIO threads (FS_AIO_NWORKERS) can serve in parallel.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <aio.h>
+#include <sys/mount.h>
+
+#include <tinyara/fs/mtd.h>
+#include <tinyara/fs/mksmartfs.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_AIO_BENCH_MTDSIZE
+#define CONFIG_EXAMPLES_AIO_BENCH_MTDSIZE 65536
+#endif
+
+#ifndef CONFIG_EXAMPLES_AIO_BENCH_MINOR
+#define CONFIG_EXAMPLES_AIO_BENCH_MINOR 7
+#endif
+
+#ifndef CONFIG_EXAMPLES_AIO_BENCH_FILESIZE
+#define CONFIG_EXAMPLES_AIO_BENCH_FILESIZE 8192
+#endif
+
+#ifndef CONFIG_EXAMPLES_AIO_BENCH_CHUNK
+#define CONFIG_EXAMPLES_AIO_BENCH_CHUNK 128
+#endif
+
+#define BENCH_MOUNTPT   "/mnt/aio_bench"
+#define BENCH_FILE1     BENCH_MOUNTPT "/file1"
+#define BENCH_FILE2     BENCH_MOUNTPT "/file2"
+#define BENCH_NCHUNKS   (CONFIG_EXAMPLES_AIO_BENCH_FILESIZE / CONFIG_EXAMPLES_AIO_BENCH_CHUNK)
+
+/* A list takes one AIO container per entry: more than CONFIG_FS_NAIOC
+ * entries would wait for containers in the middle of the list.
+ */
+
+#if CONFIG_FS_NAIOC < 16
+#define BENCH_LISTSIZE  CONFIG_FS_NAIOC
+#else
+#define BENCH_LISTSIZE  16
+#endif
+
+#define BENCH_SYNC      0	/* write() and read() */
+#define BENCH_AIO       1	/* aio_write() and aio_read(), one at a time */
+#define BENCH_LISTIO    2	/* lio_listio() */
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint8_t g_mtdmem[CONFIG_EXAMPLES_AIO_BENCH_MTDSIZE];
+static uint8_t g_wrbuf[2][CONFIG_EXAMPLES_AIO_BENCH_FILESIZE];
+static uint8_t g_rdbuf[CONFIG_EXAMPLES_AIO_BENCH_FILESIZE];
+static struct aiocb g_aiocbs[BENCH_LISTSIZE];
+
+static FAR const char *g_modes[] = { "read()/write()", "aio, one at a time", "lio_listio()" };
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static unsigned long bench_kbps(unsigned long bytes, unsigned long usec)
+{
+	return usec > 0 ? (unsigned long)((uint64_t)bytes * 1000000 / 1024 / usec) : 0;
+}
+
+static int bench_mount(void)
+{
+	FAR struct mtd_dev_s *mtd;
+	char devname[24];
+	int ret;
+
+	mtd = rammtd_initialize(g_mtdmem, sizeof(g_mtdmem));
+	if (mtd == NULL) {
+		printf("cannot create the RAM MTD device\n");
+		return -1;
+	}
+
+	ret = smart_initialize(CONFIG_EXAMPLES_AIO_BENCH_MINOR, mtd, NULL);
+	if (ret < 0) {
+		printf("smart_initialize failed: %d\n", ret);
+		return -1;
+	}
+
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+	snprintf(devname, sizeof(devname), "/dev/smart%dd1", CONFIG_EXAMPLES_AIO_BENCH_MINOR);
+	ret = mksmartfs(devname, 1, true);
+#else
+	snprintf(devname, sizeof(devname), "/dev/smart%d", CONFIG_EXAMPLES_AIO_BENCH_MINOR);
+	ret = mksmartfs(devname, true);
+#endif
+	if (ret < 0) {
+		printf("mksmartfs %s failed: %d\n", devname, errno);
+		return -1;
+	}
+
+	ret = mount(devname, BENCH_MOUNTPT, "smartfs", 0, NULL);
+	if (ret < 0) {
+		printf("mount %s failed: %d\n", devname, errno);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void bench_prepare(FAR struct aiocb *aiocbp, int fd, int opcode, FAR uint8_t *buf, off_t offset)
+{
+	memset(aiocbp, 0, sizeof(struct aiocb));
+	aiocbp->aio_fildes = fd;
+	aiocbp->aio_lio_opcode = opcode;
+	aiocbp->aio_buf = buf + offset;
+	aiocbp->aio_nbytes = CONFIG_EXAMPLES_AIO_BENCH_CHUNK;
+	aiocbp->aio_offset = offset;
+	aiocbp->aio_sigevent.sigev_notify = SIGEV_NONE;
+}
+
+/* Wait for one request and return its result */
+
+static ssize_t bench_wait(FAR struct aiocb *aiocbp)
+{
+	FAR const struct aiocb *list[1];
+
+	list[0] = aiocbp;
+	while (aio_error(aiocbp) == EINPROGRESS) {
+		(void)aio_suspend(list, 1, NULL);
+	}
+
+	return aio_return(aiocbp);
+}
+
+/* Transfer a whole file in chunks, up to nfiles files at a time; a
+ * lio_listio() list takes the chunks of every file in turn.  Returns the
+ * bytes transferred.
+ */
+
+static long bench_transfer(int mode, FAR int *fds, int nfiles, int opcode)
+{
+	FAR struct aiocb *list[BENCH_LISTSIZE];
+	FAR uint8_t *buf;
+	long total = 0;
+	ssize_t nbytes;
+	off_t offset;
+	int chunk;
+	int n;
+	int i;
+
+	for (chunk = 0; chunk < BENCH_NCHUNKS;) {
+		n = 0;
+		do {
+			offset = (off_t)chunk * CONFIG_EXAMPLES_AIO_BENCH_CHUNK;
+			for (i = 0; i < nfiles; i++) {
+				buf = opcode == LIO_WRITE ? g_wrbuf[i] : g_rdbuf;
+				if (mode == BENCH_SYNC) {
+					nbytes = opcode == LIO_WRITE ? write(fds[i], buf + offset, CONFIG_EXAMPLES_AIO_BENCH_CHUNK) : read(fds[i], buf + offset, CONFIG_EXAMPLES_AIO_BENCH_CHUNK);
+				} else {
+					bench_prepare(&g_aiocbs[n], fds[i], opcode, buf, offset);
+					list[n] = &g_aiocbs[n];
+					if (mode == BENCH_LISTIO) {
+						n++;
+						continue;
+					}
+					if ((opcode == LIO_WRITE ? aio_write(list[0]) : aio_read(list[0])) < 0) {
+						return -errno;
+					}
+					nbytes = bench_wait(list[0]);
+				}
+				if (nbytes < 0) {
+					return -errno;
+				}
+				total += nbytes;
+			}
+			chunk++;
+		} while (mode == BENCH_LISTIO && chunk < BENCH_NCHUNKS && n + nfiles <= BENCH_LISTSIZE);
+
+		if (n > 0) {
+			if (lio_listio(LIO_WAIT, list, n, NULL) < 0) {
+				return -errno;
+			}
+			for (i = 0; i < n; i++) {
+				nbytes = aio_return(list[i]);
+				if (nbytes < 0) {
+					return nbytes;
+				}
+				total += nbytes;
+			}
+		}
+	}
+
+	return total;
+}
+
+static int bench_file(int mode)
+{
+	unsigned long wrus;
+	unsigned long rdus;
+	long nbytes;
+	int fd;
+
+	fd = open(BENCH_FILE1, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0) {
+		printf("  cannot create %s: %d\n", BENCH_FILE1, errno);
+		return -1;
+	}
+
+	wrus = bench_usec();
+	nbytes = bench_transfer(mode, &fd, 1, LIO_WRITE);
+	wrus = bench_usec() - wrus;
+	close(fd);
+	if (nbytes != CONFIG_EXAMPLES_AIO_BENCH_FILESIZE) {
+		printf("  %s: write failed: %ld\n", g_modes[mode], nbytes);
+		return -1;
+	}
+
+	fd = open(BENCH_FILE1, O_RDONLY);
+	if (fd < 0) {
+		printf("  cannot open %s: %d\n", BENCH_FILE1, errno);
+		return -1;
+	}
+
+	memset(g_rdbuf, 0, sizeof(g_rdbuf));
+	rdus = bench_usec();
+	nbytes = bench_transfer(mode, &fd, 1, LIO_READ);
+	rdus = bench_usec() - rdus;
+	close(fd);
+	unlink(BENCH_FILE1);
+	if (nbytes != CONFIG_EXAMPLES_AIO_BENCH_FILESIZE || memcmp(g_rdbuf, g_wrbuf[0], sizeof(g_rdbuf)) != 0) {
+		printf("  %s: read back failed: %ld\n", g_modes[mode], nbytes);
+		return -1;
+	}
+
+	printf("  %-20s write %8lu us %6lu KB/s, read %8lu us %6lu KB/s\n", g_modes[mode], wrus, bench_kbps(nbytes, wrus), rdus, bench_kbps(nbytes, rdus));
+	return 0;
+}
+
+static int bench_twofiles(void)
+{
+	unsigned long usec;
+	long nbytes;
+	int fds[2];
+
+	fds[0] = open(BENCH_FILE1, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	fds[1] = open(BENCH_FILE2, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fds[0] < 0 || fds[1] < 0) {
+		printf("  cannot create the files: %d\n", errno);
+		return -1;
+	}
+
+	usec = bench_usec();
+	nbytes = bench_transfer(BENCH_LISTIO, fds, 2, LIO_WRITE);
+	usec = bench_usec() - usec;
+	close(fds[0]);
+	close(fds[1]);
+	unlink(BENCH_FILE1);
+	unlink(BENCH_FILE2);
+	if (nbytes != 2 * CONFIG_EXAMPLES_AIO_BENCH_FILESIZE) {
+		printf("  two files: write failed: %ld\n", nbytes);
+		return -1;
+	}
+
+	printf("  %-20s write %8lu us %6lu KB/s\n", "two files, listio", usec, bench_kbps(nbytes, usec));
+	return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int aio_bench_main(int argc, char *argv[])
+#endif
+{
+	int mode;
+	int i;
+
+	for (i = 0; i < CONFIG_EXAMPLES_AIO_BENCH_FILESIZE; i++) {
+		g_wrbuf[0][i] = (uint8_t)(i * 7 + i / 256);
+		g_wrbuf[1][i] = (uint8_t)~g_wrbuf[0][i];
+	}
+
+	if (bench_mount() != 0) {
+		return -1;
+	}
+
+	printf("AIO throughput, SmartFS on RAM, %d byte file in %d byte pieces, lists of %d:\n", CONFIG_EXAMPLES_AIO_BENCH_FILESIZE, CONFIG_EXAMPLES_AIO_BENCH_CHUNK, BENCH_LISTSIZE);
+	for (mode = BENCH_SYNC; mode <= BENCH_LISTIO; mode++) {
+		if (bench_file(mode) != 0) {
+			break;
+		}
+	}
+
+	if (mode > BENCH_LISTIO) {
+		(void)bench_twofiles();
+	}
+
+	umount(BENCH_MOUNTPT);
+	return 0;
+}
@@ -0,0 +1,292 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Block cache benchmark.  A BCH character device is put on a RAM disk, so
+ * that the time measured is that of the BCH driver and of its cache rather
+ * than of a storage device.  The disk is split into one region per stream
+ * and each stream reads, then writes, its region in
+ * CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK byte pieces through its own file
+ * descriptor, the streams taking turns piece by piece, as several files
+ * of a file system in use at the same time do.
+ *
+ * Without DRVR_BCACHE the BCH driver buffers one sector, which the streams
+ * take from each other on every turn.  With it, each stream keeps its own
+ * blocks in the cache and is read ahead of, and the pieces written are
+ * written back a few sectors at a time.  The counters of /proc/bcache are
+ * printed at the end.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/ramdisk.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE
+#define CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE 65536
+#endif
+
+#ifndef CONFIG_EXAMPLES_BCACHE_BENCH_SECTSIZE
+#define CONFIG_EXAMPLES_BCACHE_BENCH_SECTSIZE 512
+#endif
+
+#ifndef CONFIG_EXAMPLES_BCACHE_BENCH_MINOR
+#define CONFIG_EXAMPLES_BCACHE_BENCH_MINOR 7
+#endif
+
+#ifndef CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK
+#define CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK 64
+#endif
+
+#define BENCH_CHARDEV   "/dev/bchbench"
+#define BENCH_MAXSTREAMS 4
+#define BENCH_NSECTORS  (CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE / CONFIG_EXAMPLES_BCACHE_BENCH_SECTSIZE)
+
+#if defined(CONFIG_DRVR_BCACHE) && defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+#define BENCH_PROCFILE  "/proc/bcache"
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint8_t g_disk[CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE];
+static uint8_t g_buf[CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static unsigned long bench_kbps(unsigned long bytes, unsigned long usec)
+{
+	return usec > 0 ? (unsigned long)((uint64_t)bytes * 1000000 / 1024 / usec) : 0;
+}
+
+static uint8_t bench_pattern(off_t offset, int pass)
+{
+	return (uint8_t)(offset * 7 + offset / 256 + pass);
+}
+
+/* Open one descriptor per stream, each at the start of its region */
+
+static int bench_open(FAR int *fds, int nstreams, int oflags)
+{
+	off_t region = CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE / nstreams;
+	int i;
+
+	for (i = 0; i < nstreams; i++) {
+		fds[i] = open(BENCH_CHARDEV, oflags);
+		if (fds[i] < 0 || lseek(fds[i], i * region, SEEK_SET) != i * region) {
+			printf("  cannot open %s: %d\n", BENCH_CHARDEV, errno);
+			while (i >= 0) {
+				if (fds[i] >= 0) {
+					close(fds[i]);
+				}
+				i--;
+			}
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void bench_close(FAR int *fds, int nstreams)
+{
+	int i;
+
+	for (i = 0; i < nstreams; i++) {
+		close(fds[i]);
+	}
+}
+
+/* Read the whole disk with nstreams streams taking turns, checking the data
+ * against the RAM disk memory.  Returns the time taken, or 0 on failure.
+ */
+
+static unsigned long bench_read(int nstreams)
+{
+	off_t region = CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE / nstreams;
+	int fds[BENCH_MAXSTREAMS];
+	unsigned long usec;
+	off_t offset;
+	int i;
+
+	if (bench_open(fds, nstreams, O_RDONLY) != 0) {
+		return 0;
+	}
+
+	usec = bench_usec();
+	for (offset = 0; offset < region; offset += CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK) {
+		for (i = 0; i < nstreams; i++) {
+			if (read(fds[i], g_buf, CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK) != CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK || memcmp(g_buf, &g_disk[i * region + offset], CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK) != 0) {
+				printf("  read failed at %ld: %d\n", (long)(i * region + offset), errno);
+				bench_close(fds, nstreams);
+				return 0;
+			}
+		}
+	}
+	usec = bench_usec() - usec;
+
+	bench_close(fds, nstreams);
+	return usec > 0 ? usec : 1;
+}
+
+/* Write the whole disk with nstreams streams taking turns.  The time
+ * includes closing the descriptors, which writes back what the cache still
+ * holds.  Returns the time taken, or 0 on failure.
+ */
+
+static unsigned long bench_write(int nstreams, int pass)
+{
+	off_t region = CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE / nstreams;
+	int fds[BENCH_MAXSTREAMS];
+	unsigned long usec;
+	off_t offset;
+	int i;
+	int j;
+
+	if (bench_open(fds, nstreams, O_RDWR) != 0) {
+		return 0;
+	}
+
+	usec = bench_usec();
+	for (offset = 0; offset < region; offset += CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK) {
+		for (i = 0; i < nstreams; i++) {
+			for (j = 0; j < CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK; j++) {
+				g_buf[j] = bench_pattern(i * region + offset + j, pass);
+			}
+			if (write(fds[i], g_buf, CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK) != CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK) {
+				printf("  write failed at %ld: %d\n", (long)(i * region + offset), errno);
+				bench_close(fds, nstreams);
+				return 0;
+			}
+		}
+	}
+	bench_close(fds, nstreams);
+	usec = bench_usec() - usec;
+
+	for (offset = 0; offset < CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE; offset++) {
+		if (g_disk[offset] != bench_pattern(offset, pass)) {
+			printf("  data not written back at %ld\n", (long)offset);
+			return 0;
+		}
+	}
+
+	return usec > 0 ? usec : 1;
+}
+
+#ifdef BENCH_PROCFILE
+static void bench_showstats(void)
+{
+	char line[96];
+	FILE *stream;
+
+	stream = fopen(BENCH_PROCFILE, "r");
+	if (stream == NULL) {
+		return;
+	}
+
+	printf("%s:\n", BENCH_PROCFILE);
+	while (fgets(line, sizeof(line), stream) != NULL) {
+		printf("  %s", line);
+	}
+	fclose(stream);
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int bcache_bench_main(int argc, char *argv[])
+#endif
+{
+	unsigned long rdus;
+	unsigned long wrus;
+	char blkdev[16];
+	int nstreams;
+	int pass = 1;
+	int ret;
+
+	for (ret = 0; ret < CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE; ret++) {
+		g_disk[ret] = bench_pattern(ret, 0);
+	}
+
+	snprintf(blkdev, sizeof(blkdev), "/dev/ram%d", CONFIG_EXAMPLES_BCACHE_BENCH_MINOR);
+	ret = ramdisk_register(CONFIG_EXAMPLES_BCACHE_BENCH_MINOR, g_disk, BENCH_NSECTORS, CONFIG_EXAMPLES_BCACHE_BENCH_SECTSIZE, RDFLAG_WRENABLED);
+	if (ret < 0) {
+		printf("ramdisk_register failed: %d\n", ret);
+		return -1;
+	}
+
+	ret = bchdev_register(blkdev, BENCH_CHARDEV, false);
+	if (ret < 0) {
+		printf("bchdev_register failed: %d\n", ret);
+		unlink(blkdev);
+		return -1;
+	}
+
+	printf("Block cache, BCH on a %d byte RAM disk, %d byte sectors, %d byte pieces:\n", CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE, CONFIG_EXAMPLES_BCACHE_BENCH_SECTSIZE, CONFIG_EXAMPLES_BCACHE_BENCH_CHUNK);
+	for (nstreams = 1; nstreams <= BENCH_MAXSTREAMS; nstreams *= 2, pass++) {
+		rdus = bench_read(nstreams);
+		wrus = rdus != 0 ? bench_write(nstreams, pass) : 0;
+		if (wrus == 0) {
+			break;
+		}
+
+		printf("  %d stream%s read %8lu us %6lu KB/s, write %8lu us %6lu KB/s\n", nstreams, nstreams > 1 ? "s" : " ", rdus, bench_kbps(CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE, rdus), wrus, bench_kbps(CONFIG_EXAMPLES_BCACHE_BENCH_DISKSIZE, wrus));
+	}
+
+#ifdef BENCH_PROCFILE
+	bench_showstats();
+#endif
+
+	bchdev_unregister(BENCH_CHARDEV);
+	unlink(blkdev);
+	return 0;
+}
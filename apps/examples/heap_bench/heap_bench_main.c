@@ -0,0 +1,280 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Heap fragmentation benchmark: a private heap serves a daemon that keeps
+ * a few dozen long-lived allocations and replaces one now and then, and
+ * a request handler that allocates a burst of small buffers per request
+ * and drops them all when the request ends.  The daemon keeps working
+ * while requests are handled, so its allocations land between the request
+ * buffers.  Every few requests a TLS-sized buffer is taken for a while.
+ *
+ * The workload runs twice from the same seeds: once with the requests in
+ * the heap itself, once with the request handler bound to a sub-heap that
+ * is reset after each request.  The large allocations that failed, the
+ * request allocations that failed and the free space of the heap at the
+ * end are reported for both.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <tinyara/mm/mm.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_REQUESTS 2000
+#define BENCH_DAEMON_SLOTS     64
+#define BENCH_REQUEST_CHUNKS   32
+#define BENCH_TLS_SIZE         (16 * 1024)
+#define BENCH_TLS_PERIOD       32	/* requests between two TLS buffers */
+#define BENCH_TLS_HOLD         8	/* requests a TLS buffer is kept for */
+
+#ifndef CONFIG_EXAMPLES_HEAP_BENCH_HEAPSIZE
+#define CONFIG_EXAMPLES_HEAP_BENCH_HEAPSIZE 65536
+#endif
+
+#ifndef CONFIG_EXAMPLES_HEAP_BENCH_SUBHEAPSIZE
+#define CONFIG_EXAMPLES_HEAP_BENCH_SUBHEAPSIZE 12288
+#endif
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+#define bench_malloc(size) mm_malloc(&g_heap, size, 0)
+#else
+#define bench_malloc(size) mm_malloc(&g_heap, size)
+#endif
+#define bench_free(mem)    mm_free(&g_heap, mem)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_result {
+	unsigned long usec;
+	unsigned long tls_fails;	/* TLS buffers that could not be allocated */
+	unsigned long req_fails;	/* request buffers that could not be allocated */
+	size_t min_mxordblk;		/* smallest largest-free-chunk seen before a TLS buffer */
+	size_t subheap_peak;		/* most of the sub-heap used by one request */
+	struct mallinfo info;		/* heap at the end, daemon allocations still live */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct mm_heap_s g_heap;
+static uint64_t g_heapmem[CONFIG_EXAMPLES_HEAP_BENCH_HEAPSIZE / sizeof(uint64_t)];
+static FAR void *g_daemon[BENCH_DAEMON_SLOTS];
+static uint32_t g_dseed;
+static uint32_t g_rseed;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static uint32_t bench_rand(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 16;
+}
+
+/* One step of the daemon: now and then, replace one of its allocations */
+
+static void bench_daemon_step(void)
+{
+	int slot;
+
+	if (bench_rand(&g_dseed) % 3 != 0) {
+		return;
+	}
+
+	slot = bench_rand(&g_dseed) % BENCH_DAEMON_SLOTS;
+	bench_free(g_daemon[slot]);
+	g_daemon[slot] = bench_malloc(24 + bench_rand(&g_dseed) % 480);
+}
+
+static size_t bench_request_size(void)
+{
+	if (bench_rand(&g_rseed) % 5 == 0) {
+		return 256 + bench_rand(&g_rseed) % 768;
+	}
+
+	return 16 + bench_rand(&g_rseed) % 240;
+}
+
+static void bench_run(FAR struct mm_subheap_s *subheap, int requests, FAR struct bench_result *res)
+{
+	FAR void *chunks[BENCH_REQUEST_CHUNKS];
+	FAR void *tls = NULL;
+	struct mallinfo info;
+	unsigned long start;
+	int nchunks;
+	int r;
+	int i;
+
+	for (i = 0; i < BENCH_DAEMON_SLOTS; i++) {
+		g_daemon[i] = bench_malloc(24 + bench_rand(&g_dseed) % 480);
+	}
+
+	start = bench_usec();
+	for (r = 0; r < requests; r++) {
+		if (r % BENCH_TLS_PERIOD == 0) {
+			mm_mallinfo(&g_heap, &info);
+			if (r == 0 || (size_t)info.mxordblk < res->min_mxordblk) {
+				res->min_mxordblk = info.mxordblk;
+			}
+			tls = bench_malloc(BENCH_TLS_SIZE);
+			if (tls == NULL) {
+				res->tls_fails++;
+			}
+		}
+
+		/* The request handler: its buffers come from malloc(), which is
+		 * the sub-heap while it is bound.  Nothing else may allocate with
+		 * malloc() in that time, not even printf().
+		 */
+
+		nchunks = 8 + bench_rand(&g_rseed) % (BENCH_REQUEST_CHUNKS - 8);
+		if (subheap != NULL) {
+			mm_subheap_bind(0, subheap);
+		}
+		for (i = 0; i < nchunks; i++) {
+			size_t size = bench_request_size();
+
+			chunks[i] = subheap != NULL ? malloc(size) : bench_malloc(size);
+			if (chunks[i] == NULL) {
+				res->req_fails++;
+			}
+			bench_daemon_step();
+		}
+		if (subheap != NULL) {
+			mm_subheap_bind(0, NULL);
+		}
+
+		/* The request ends: drop its buffers */
+
+		if (subheap != NULL) {
+			mm_subheap_mallinfo(subheap, &info);
+			if ((size_t)info.uordblks > res->subheap_peak) {
+				res->subheap_peak = info.uordblks;
+			}
+			mm_subheap_reset(subheap);
+		} else {
+			for (i = 0; i < nchunks; i += 2) {
+				bench_free(chunks[i]);
+			}
+			for (i = 1; i < nchunks; i += 2) {
+				bench_free(chunks[i]);
+			}
+		}
+
+		if (r % BENCH_TLS_PERIOD == BENCH_TLS_HOLD) {
+			bench_free(tls);
+			tls = NULL;
+		}
+	}
+	res->usec = bench_usec() - start;
+
+	bench_free(tls);
+	mm_mallinfo(&g_heap, &res->info);
+}
+
+static int bench_scenario(bool subheaps, int requests, FAR struct bench_result *res)
+{
+	FAR struct mm_subheap_s *subheap = NULL;
+
+	memset(res, 0, sizeof(struct bench_result));
+	memset(g_daemon, 0, sizeof(g_daemon));
+	g_dseed = 1;
+	g_rseed = 2;
+	mm_initialize(&g_heap, g_heapmem, sizeof(g_heapmem));
+
+	if (subheaps) {
+		subheap = mm_subheap_create(&g_heap, CONFIG_EXAMPLES_HEAP_BENCH_SUBHEAPSIZE);
+		if (subheap == NULL) {
+			return -1;
+		}
+	}
+
+	bench_run(subheap, requests, res);
+
+	if (subheap != NULL) {
+		mm_subheap_destroy(subheap);
+	}
+	return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int heap_bench_main(int argc, char *argv[])
+#endif
+{
+	struct bench_result res;
+	int requests = BENCH_DEFAULT_REQUESTS;
+	int i;
+
+	if (argc > 1) {
+		requests = atoi(argv[1]);
+		if (requests <= 0) {
+			printf("usage: %s [requests]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	printf("Heap fragmentation, %d requests, heap %d bytes, %d byte TLS buffer every %d requests:\n", requests, CONFIG_EXAMPLES_HEAP_BENCH_HEAPSIZE, BENCH_TLS_SIZE, BENCH_TLS_PERIOD);
+	for (i = 0; i < 2; i++) {
+		if (bench_scenario(i == 1, requests, &res) != 0) {
+			printf("  cannot create a sub-heap of %d bytes\n", CONFIG_EXAMPLES_HEAP_BENCH_SUBHEAPSIZE);
+			return -1;
+		}
+
+		printf("  %-18s %8lu us %5lu TLS fails %5lu request fails, min largest free %6u\n", i == 1 ? "request sub-heap" : "single heap", res.usec, res.tls_fails, res.req_fails, (unsigned int)res.min_mxordblk);
+		printf("  %-18s end: %d free chunks, %d free bytes, largest %d", "", res.info.ordblks, res.info.fordblks, res.info.mxordblk);
+		if (i == 1) {
+			printf(", sub-heap peak %u", (unsigned int)res.subheap_peak);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
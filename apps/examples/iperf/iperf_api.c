@@ -2659,6 +2659,10 @@ static void print_interval_results(struct iperf_test *test, struct iperf_stream
 /**************************************************************************/
 void iperf_free_stream(struct iperf_stream *sp)
 {
+	if (sp->test->zerocopy) {
+		/* zero-copy sends may still reference sp->buffer */
+		Nsendfile_flush();
+	}
 
 #ifdef HAVE_FILESYSTEM
 	/* XXX: need to free interval list too! */
@@ -74,6 +74,33 @@
 #include "iperf_net.h"
 #include "iperf_timer.h"
 
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+#include <semaphore.h>
+
+/* -Z on TinyAra: the stream buffer is sent by reference with send_zc().
+ * The stack posts zc_sem once per send when the peer has acknowledged
+ * the data; zc_pending (only touched by the sending task) counts the
+ * sends whose completion has not been collected yet.
+ */
+static sem_t zc_sem;
+static int zc_sem_ready;
+static int zc_pending;
+
+static void zc_sent(void *arg, err_t err)
+{
+	(void)arg;
+	(void)err;
+	sem_post(&zc_sem);
+}
+
+static void zc_collect(void)
+{
+	while (zc_pending > 0 && sem_trywait(&zc_sem) == 0) {
+		zc_pending--;
+	}
+}
+#endif
+
 /* netdial and netannouce code comes from libtask: http://swtch.com/libtask/
  * Copyright: http://swtch.com/libtask/COPYRIGHT
 */
@@ -290,7 +317,7 @@ int Nwrite(int fd, const char *buf, size_t count, int prot)
 
 int has_sendfile(void)
 {
-#if defined(HAVE_SENDFILE)
+#if defined(HAVE_SENDFILE) || defined(CONFIG_NET_SOCKET_ZEROCOPY_SEND)
 	return 1;
 #else							/* HAVE_SENDFILE */
 	return 0;
@@ -359,12 +386,57 @@ int Nsendfile(int fromfd, int tofd, const char *buf, size_t count)
 #endif
 	}
 	return count;
+#elif defined(CONFIG_NET_SOCKET_ZEROCOPY_SEND)
+	ssize_t r;
+
+	(void)fromfd;
+	if (!zc_sem_ready) {
+		sem_init(&zc_sem, 0, 0);
+		zc_sem_ready = 1;
+	}
+	zc_collect();
+
+	/* The buffer is never modified while the test runs, so it can be
+	 * queued again before the previous sends have been acknowledged.
+	 */
+	r = send_zc(tofd, buf, count, 0, zc_sent, NULL);
+	if (r < 0) {
+		switch (errno) {
+		case EINTR:
+		case EAGAIN:
+#if (EAGAIN != EWOULDBLOCK)
+		case EWOULDBLOCK:
+#endif
+		case ENOBUFS:
+		case ENOMEM:
+			return NET_SOFTERROR;
+
+		default:
+			return NET_HARDERROR;
+		}
+	}
+	zc_pending++;
+	return r;
 #else							/* HAVE_SENDFILE */
 	errno = ENOSYS;				/* error if somehow get called without HAVE_SENDFILE */
 	return NET_HARDERROR;
 #endif							/* HAVE_SENDFILE */
 }
 
+/*
+ * Wait until the stack no longer references buffers passed to Nsendfile()
+ */
+void Nsendfile_flush(void)
+{
+#if defined(CONFIG_NET_SOCKET_ZEROCOPY_SEND)
+	while (zc_pending > 0) {
+		if (sem_wait(&zc_sem) == 0) {
+			zc_pending--;
+		}
+	}
+#endif
+}
+
 /*************************************************************************/
 
 /**
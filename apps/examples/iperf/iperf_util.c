@@ -280,7 +280,7 @@ const char *get_optional_features(void)
 	numfeatures++;
 #endif							/* HAVE_TCP_CONGESTION */
 
-#if defined(HAVE_SENDFILE)
+#if defined(HAVE_SENDFILE) || defined(CONFIG_NET_SOCKET_ZEROCOPY_SEND)
 	if (numfeatures > 0) {
 		strncat(features, ", ", sizeof(features) - strlen(features) - 1);
 	}
@@ -0,0 +1,438 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * JSON benchmark: parses and renders a telemetry-sized document with
+ * cJSON_Parse()/cJSON_PrintUnformatted(), with an arena, with the pull
+ * reader and with the streaming writer, and reports the time and the heap
+ * allocations per document. It then times cJSON_GetObjectItem() on objects
+ * of 10 to 1000 members against the plain list walk.
+ *
+ * Only netutils/json is used, so the same file runs on the target and
+ * natively on the host (see Makefile.host).
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#ifndef JSON_BENCH_HOST
+#include <tinyara/config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include <apps/netutils/cJSON.h>
+#include <apps/netutils/json_stream.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_ITERATIONS 2000
+#define BENCH_BUF_SIZE           1024
+#define BENCH_LOOKUPS            20000	/* Lookups per object size */
+#define BENCH_MAX_MEMBERS        1000
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char g_doc[] =
+	"{\"device\":\"tizenrt-0042\",\"seq\":123456,\"ts\":1500000000,"
+	"\"online\":true,\"fw\":{\"version\":\"1.0.3\",\"build\":\"2017-07-01\"},"
+	"\"sensors\":[{\"id\":1,\"type\":\"temp\",\"value\":23,\"unit\":\"C\"},"
+	"{\"id\":2,\"type\":\"hum\",\"value\":41,\"unit\":\"%\"},"
+	"{\"id\":3,\"type\":\"lux\",\"value\":320,\"unit\":\"lx\"}],"
+	"\"note\":\"line\\none \\\"quoted\\\"\",\"error\":null}";
+
+static unsigned long g_allocs;
+static char g_scratch[BENCH_BUF_SIZE];
+static char g_out[BENCH_BUF_SIZE];
+static char g_arena_buf[BENCH_BUF_SIZE * 2];
+static char g_names[BENCH_MAX_MEMBERS][16];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void *bench_malloc(size_t sz)
+{
+	g_allocs++;
+	return malloc(sz);
+}
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static void bench_report(const char *name, unsigned long start, int iterations)
+{
+	unsigned long usec = bench_usec() - start;
+
+	printf("  %-28s %8lu ns/doc %6lu allocs/doc\n", name, (unsigned long)(usec * 1000.0 / iterations), g_allocs / iterations);
+}
+
+/* Walk all tokens of g_doc and pick two fields, the way a telemetry
+ * consumer would.
+ */
+
+static int bench_read(int *seq, int *value)
+{
+	struct json_reader rd;
+	struct json_token tok;
+	int type;
+	int count = 0;
+
+	memcpy(g_scratch, g_doc, sizeof(g_doc));
+	json_reader_init(&rd, g_scratch, sizeof(g_doc) - 1);
+	while ((type = json_reader_next(&rd, &tok)) > JSON_TOKEN_END) {
+		count++;
+		if (type != JSON_TOKEN_KEY) {
+			continue;
+		}
+
+		if (json_token_equals(&tok, "seq")) {
+			json_reader_next(&rd, &tok);
+			json_token_to_int(&tok, seq);
+			count++;
+		} else if (json_token_equals(&tok, "value")) {
+			json_reader_next(&rd, &tok);
+			json_token_to_int(&tok, value);
+			count++;
+		}
+	}
+
+	return type == JSON_TOKEN_END ? count : -1;
+}
+
+static ssize_t bench_write(char *buf, size_t size)
+{
+	static const char *types[] = { "temp", "hum", "lux" };
+	static const char *units[] = { "C", "%", "lx" };
+	static const int values[] = { 23, 41, 320 };
+	struct json_writer wr;
+	int i;
+
+	json_writer_init(&wr, buf, size, NULL, NULL);
+	json_write_object_start(&wr);
+	json_write_key(&wr, "device");
+	json_write_string(&wr, "tizenrt-0042");
+	json_write_key(&wr, "seq");
+	json_write_int(&wr, 123456);
+	json_write_key(&wr, "ts");
+	json_write_int(&wr, 1500000000);
+	json_write_key(&wr, "online");
+	json_write_bool(&wr, true);
+	json_write_key(&wr, "fw");
+	json_write_object_start(&wr);
+	json_write_key(&wr, "version");
+	json_write_string(&wr, "1.0.3");
+	json_write_key(&wr, "build");
+	json_write_string(&wr, "2017-07-01");
+	json_write_object_end(&wr);
+	json_write_key(&wr, "sensors");
+	json_write_array_start(&wr);
+	for (i = 0; i < 3; i++) {
+		json_write_object_start(&wr);
+		json_write_key(&wr, "id");
+		json_write_int(&wr, i + 1);
+		json_write_key(&wr, "type");
+		json_write_string(&wr, types[i]);
+		json_write_key(&wr, "value");
+		json_write_int(&wr, values[i]);
+		json_write_key(&wr, "unit");
+		json_write_string(&wr, units[i]);
+		json_write_object_end(&wr);
+	}
+	json_write_array_end(&wr);
+	json_write_key(&wr, "note");
+	json_write_string(&wr, "line\none \"quoted\"");
+	json_write_key(&wr, "error");
+	json_write_null(&wr);
+	json_write_object_end(&wr);
+	return json_writer_finish(&wr);
+}
+
+/* cJSON_GetObjectItem() without the index, with the same comparison */
+
+static int bench_strcasecmp(const char *s1, const char *s2)
+{
+	for (; tolower(*s1) == tolower(*s2); ++s1, ++s2) {
+		if (*s1 == 0) {
+			return 0;
+		}
+	}
+
+	return tolower(*(const unsigned char *)s1) - tolower(*(const unsigned char *)s2);
+}
+
+static cJSON *bench_walk(cJSON *object, const char *name)
+{
+	cJSON *c = object->child;
+
+	while (c && bench_strcasecmp(c->string, name)) {
+		c = c->next;
+	}
+
+	return c;
+}
+
+/* Look up every member of an object of the given size, in a shuffled
+ * order, until BENCH_LOOKUPS lookups are done.
+ */
+
+static int bench_lookup(int members)
+{
+	unsigned long start;
+	unsigned long walk;
+	unsigned long hashed;
+	cJSON *object;
+	int rounds = BENCH_LOOKUPS / members;
+	int lookups = rounds * members;
+	int ret = -1;
+	int i;
+	int j;
+
+	object = cJSON_CreateObject();
+	if (!object) {
+		return -1;
+	}
+
+	for (i = 0; i < members; i++) {
+		cJSON_AddNumberToObject(object, g_names[i], i);
+	}
+	(void)cJSON_IndexObject(object);
+
+	start = bench_usec();
+	for (j = 0; j < rounds; j++) {
+		for (i = 0; i < members; i++) {
+			if (!bench_walk(object, g_names[(i * 7) % members])) {
+				goto out;
+			}
+		}
+	}
+	walk = bench_usec() - start;
+
+	start = bench_usec();
+	for (j = 0; j < rounds; j++) {
+		for (i = 0; i < members; i++) {
+			cJSON *c = cJSON_GetObjectItem(object, g_names[(i * 7) % members]);
+			if (!c || c->valueint != (i * 7) % members) {
+				goto out;
+			}
+		}
+	}
+	hashed = bench_usec() - start;
+
+	printf("  %4d members %10lu ns walk %8lu ns GetObjectItem\n", members, (unsigned long)(walk * 1000.0 / lookups), (unsigned long)(hashed * 1000.0 / lookups));
+	ret = 0;
+
+out:
+	cJSON_Delete(object);
+	return ret;
+}
+
+/* The outputs must agree before the timings mean anything */
+
+static int bench_check(void)
+{
+	struct json_writer wr;
+	cJSON_Arena arena;
+	cJSON *root;
+	char *text;
+	int seq = 0;
+	int value = 0;
+	int ret = -1;
+
+	root = cJSON_Parse(g_doc);
+	text = root ? cJSON_PrintUnformatted(root) : NULL;
+	if (!text || strcmp(text, g_doc) != 0) {
+		printf("cJSON round trip differs\n");
+		goto out;
+	}
+
+	json_writer_init(&wr, g_out, sizeof(g_out), NULL, NULL);
+	if (json_write_cjson(&wr, root) < 0 || json_writer_finish(&wr) < 0 || strcmp(g_out, text) != 0) {
+		printf("json_write_cjson() differs: %s\n", g_out);
+		goto out;
+	}
+
+	if (bench_write(g_out, sizeof(g_out)) < 0 || strcmp(g_out, text) != 0) {
+		printf("json_write_*() differs: %s\n", g_out);
+		goto out;
+	}
+
+	cJSON_ArenaInit(&arena, g_arena_buf, sizeof(g_arena_buf));
+	cJSON_Delete(root);
+	root = cJSON_ParseArena(&arena, g_doc);
+	free(text);
+	text = root ? cJSON_PrintUnformatted(root) : NULL;
+	cJSON_ArenaFree(&arena);
+	root = NULL;
+	if (!text || strcmp(text, g_doc) != 0) {
+		printf("arena parse differs\n");
+		goto out;
+	}
+
+	if (bench_read(&seq, &value) < 0 || seq != 123456 || value != 320) {
+		printf("json_reader differs\n");
+		goto out;
+	}
+
+	ret = 0;
+
+out:
+	cJSON_Delete(root);
+	free(text);
+	return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#if defined(JSON_BENCH_HOST)
+int main(int argc, char *argv[])
+#elif defined(CONFIG_BUILD_KERNEL)
+int main(int argc, FAR char *argv[])
+#else
+int json_bench_main(int argc, char *argv[])
+#endif
+{
+	cJSON_Hooks hooks = { bench_malloc, free };
+	struct json_writer wr;
+	cJSON_Arena arena;
+	unsigned long start;
+	cJSON *root;
+	char *text;
+	int iterations = BENCH_DEFAULT_ITERATIONS;
+	int seq;
+	int value;
+	int i;
+
+	if (argc > 1) {
+		iterations = atoi(argv[1]);
+		if (iterations <= 0) {
+			printf("usage: %s [iterations]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	if (bench_check() < 0) {
+		return -1;
+	}
+
+	cJSON_InitHooks(&hooks);
+	printf("JSON benchmark, %d bytes, %d iterations\n", (int)sizeof(g_doc) - 1, iterations);
+
+	/* Parsing */
+
+	g_allocs = 0;
+	start = bench_usec();
+	for (i = 0; i < iterations; i++) {
+		cJSON_Delete(cJSON_Parse(g_doc));
+	}
+	bench_report("cJSON_Parse", start, iterations);
+
+	cJSON_ArenaInit(&arena, NULL, 0);
+	g_allocs = 0;
+	start = bench_usec();
+	for (i = 0; i < iterations; i++) {
+		cJSON_ParseArena(&arena, g_doc);
+		cJSON_ArenaReset(&arena);
+	}
+	bench_report("cJSON_ParseArena (heap)", start, iterations);
+	cJSON_ArenaFree(&arena);
+
+	cJSON_ArenaInit(&arena, g_arena_buf, sizeof(g_arena_buf));
+	g_allocs = 0;
+	start = bench_usec();
+	for (i = 0; i < iterations; i++) {
+		cJSON_ParseArena(&arena, g_doc);
+		cJSON_ArenaReset(&arena);
+	}
+	bench_report("cJSON_ParseArena (static)", start, iterations);
+	cJSON_ArenaFree(&arena);
+
+	g_allocs = 0;
+	start = bench_usec();
+	for (i = 0; i < iterations; i++) {
+		bench_read(&seq, &value);
+	}
+	bench_report("json_reader", start, iterations);
+
+	/* Rendering */
+
+	root = cJSON_Parse(g_doc);
+	if (!root) {
+		cJSON_InitHooks(NULL);
+		return -1;
+	}
+
+	g_allocs = 0;
+	start = bench_usec();
+	for (i = 0; i < iterations; i++) {
+		text = cJSON_PrintUnformatted(root);
+		free(text);
+	}
+	bench_report("cJSON_PrintUnformatted", start, iterations);
+
+	g_allocs = 0;
+	start = bench_usec();
+	for (i = 0; i < iterations; i++) {
+		json_writer_init(&wr, g_out, sizeof(g_out), NULL, NULL);
+		json_write_cjson(&wr, root);
+		json_writer_finish(&wr);
+	}
+	bench_report("json_write_cjson", start, iterations);
+
+	g_allocs = 0;
+	start = bench_usec();
+	for (i = 0; i < iterations; i++) {
+		bench_write(g_out, sizeof(g_out));
+	}
+	bench_report("json_write_*", start, iterations);
+
+	cJSON_Delete(root);
+	cJSON_InitHooks(NULL);
+
+	/* Member lookup, each name is looked up once per round. Sizes are
+	 * coprime with 7 so that the shuffle visits every member.
+	 */
+
+	printf("Object member lookup, per lookup\n");
+	for (i = 0; i < BENCH_MAX_MEMBERS; i++) {
+		snprintf(g_names[i], sizeof(g_names[i]), "member%d", i);
+	}
+
+	if (bench_lookup(10) < 0 || bench_lookup(100) < 0 || bench_lookup(1000) < 0) {
+		printf("lookup returned the wrong member\n");
+		return -1;
+	}
+
+	return 0;
+}
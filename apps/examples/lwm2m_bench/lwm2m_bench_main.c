@@ -0,0 +1,460 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * LWM2M observe benchmark: a client exposes 100 instances of a sensor
+ * object with 5 float resources each, and one server observes all 500
+ * resources (or the 100 instances). The observe step then runs once per
+ * simulated second, either idle with a maximum period or with a few
+ * resources changing before each step, and the time spent, the number of
+ * object reads and the number of notifications sent are reported.
+ *
+ * The changes are drawn from a fixed seed, so two builds of the core must
+ * send the same number of notifications for each scenario.
+ *
+ * The benchmark calls the observe functions of the core directly instead
+ * of going through a registration, so it runs the same on the target and
+ * natively on the host (see Makefile.host).
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#ifndef LWM2M_BENCH_HOST
+#include <tinyara/config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "internals.h"
+#ifndef LWM2M_BENCH_HOST
+#include <sys/socket.h>
+#include <unistd.h>
+#include "connection.h"
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_STEPS   600
+#define BENCH_OBJECT_ID       3303
+#define BENCH_RESOURCE_BASE   5700
+#define BENCH_INSTANCES       100
+#define BENCH_RESOURCES       5
+#define BENCH_TIMEOUT         60
+
+#ifndef CONFIG_EXAMPLES_LWM2M_BENCH_PORT
+#define CONFIG_EXAMPLES_LWM2M_BENCH_PORT 56830
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_scenario {
+	const char *title;
+	int instances;				/* observe the instances, not the resources */
+	uint32_t pmin;
+	uint32_t pmax;
+	double step;
+	int changes;				/* resources changed before each step */
+};
+
+struct bench_result {
+	unsigned long usec;
+	unsigned long reads;
+	unsigned long notifications;
+	int observed;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct bench_scenario g_scenarios[] = {
+	{ "idle, pmax 60", 0, 0, 60, 0.0, 0 },
+	{ "10 changes", 0, 0, 0, 0.0, 10 },
+	{ "10 changes, stp 1", 0, 0, 60, 1.0, 10 },
+	{ "10 changes, pmin 5", 0, 5, 60, 0.0, 10 },
+	{ "10 changes, instances", 1, 0, 0, 0.0, 10 },
+	{ "50 changes, instances", 1, 0, 0, 0.0, 50 },
+};
+
+static lwm2m_list_t g_instances[BENCH_INSTANCES];
+static double g_values[BENCH_INSTANCES][BENCH_RESOURCES];
+static lwm2m_object_t g_object;
+static unsigned long g_reads;
+static uint32_t g_seed;
+
+#ifdef LWM2M_BENCH_HOST
+static time_t g_now;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef LWM2M_BENCH_HOST
+
+/* Platform functions of the core, provided on the target by
+ * wakaama/examples/shared.
+ */
+
+void *lwm2m_malloc(size_t s)
+{
+	return malloc(s);
+}
+
+void lwm2m_free(void *p)
+{
+	free(p);
+}
+
+char *lwm2m_strdup(const char *str)
+{
+	return strdup(str);
+}
+
+int lwm2m_strncmp(const char *s1, const char *s2, size_t n)
+{
+	return strncmp(s1, s2, n);
+}
+
+time_t lwm2m_gettime(void)
+{
+	return g_now;
+}
+
+void lwm2m_printf(const char *format, ...)
+{
+}
+
+void *lwm2m_connect_server(uint16_t secObjInstID, void *userData)
+{
+	return NULL;
+}
+
+void lwm2m_close_connection(void *sessionH, void *userData)
+{
+}
+
+uint8_t lwm2m_buffer_send(void *sessionH, uint8_t *buffer, size_t length, void *userData, coap_protocol_t proto)
+{
+	return COAP_NO_ERROR;
+}
+
+bool lwm2m_session_is_equal(void *session1, void *session2, void *userData)
+{
+	return session1 == session2;
+}
+
+#endif
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static uint32_t bench_rand(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static uint8_t bench_read(uint16_t instanceId, int *numDataP, lwm2m_data_t **dataArrayP, lwm2m_object_t *objectP)
+{
+	int i;
+
+	g_reads++;
+	if (instanceId >= BENCH_INSTANCES) {
+		return COAP_404_NOT_FOUND;
+	}
+
+	if (*numDataP == 0) {
+		*dataArrayP = lwm2m_data_new(BENCH_RESOURCES);
+		if (*dataArrayP == NULL) {
+			return COAP_500_INTERNAL_SERVER_ERROR;
+		}
+		*numDataP = BENCH_RESOURCES;
+		for (i = 0; i < BENCH_RESOURCES; i++) {
+			(*dataArrayP)[i].id = BENCH_RESOURCE_BASE + i;
+		}
+	}
+
+	for (i = 0; i < *numDataP; i++) {
+		int res = (*dataArrayP)[i].id - BENCH_RESOURCE_BASE;
+
+		if (res < 0 || res >= BENCH_RESOURCES) {
+			return COAP_404_NOT_FOUND;
+		}
+		lwm2m_data_encode_float(g_values[instanceId][res], *dataArrayP + i);
+	}
+
+	return COAP_205_CONTENT;
+}
+
+static void bench_init_object(void)
+{
+	int i;
+
+	memset(&g_object, 0, sizeof(g_object));
+	g_object.objID = BENCH_OBJECT_ID;
+	g_object.readFunc = bench_read;
+
+	for (i = 0; i < BENCH_INSTANCES; i++) {
+		g_instances[i].id = i;
+		g_instances[i].next = i + 1 < BENCH_INSTANCES ? &g_instances[i + 1] : NULL;
+	}
+	g_object.instanceList = g_instances;
+}
+
+static void bench_set_uri(lwm2m_uri_t *uriP, int instance, int resource)
+{
+	memset(uriP, 0, sizeof(lwm2m_uri_t));
+	uriP->flag = LWM2M_URI_FLAG_DM | LWM2M_URI_FLAG_OBJECT_ID | LWM2M_URI_FLAG_INSTANCE_ID;
+	uriP->objectId = BENCH_OBJECT_ID;
+	uriP->instanceId = instance;
+	uriP->resourceId = LWM2M_MAX_ID;
+	if (resource >= 0) {
+		uriP->flag |= LWM2M_URI_FLAG_RESOURCE_ID;
+		uriP->resourceId = BENCH_RESOURCE_BASE + resource;
+	}
+}
+
+/* Does what the core does for a Write-Attributes request followed by an
+ * Observe request on the URI.
+ */
+
+static int bench_observe(lwm2m_context_t *contextP, lwm2m_server_t *serverP, lwm2m_uri_t *uriP, const struct bench_scenario *sc, uint16_t mid)
+{
+	coap_packet_t message[1];
+	coap_packet_t response[1];
+	lwm2m_attributes_t attr;
+	lwm2m_data_t *dataP = NULL;
+	uint8_t token[2];
+	coap_status_t result;
+	int size = 0;
+
+	memset(&attr, 0, sizeof(attr));
+	if (sc->pmin > 0) {
+		attr.toSet |= LWM2M_ATTR_FLAG_MIN_PERIOD;
+		attr.minPeriod = sc->pmin;
+	}
+	if (sc->pmax > 0) {
+		attr.toSet |= LWM2M_ATTR_FLAG_MAX_PERIOD;
+		attr.maxPeriod = sc->pmax;
+	}
+	if (sc->step > 0 && LWM2M_URI_IS_SET_RESOURCE(uriP)) {
+		attr.toSet |= LWM2M_ATTR_FLAG_STEP;
+		attr.step = sc->step;
+	}
+	if (attr.toSet != 0 && observe_setParameters(contextP, uriP, serverP, &attr) != COAP_204_CHANGED) {
+		return -1;
+	}
+
+	if (LWM2M_URI_IS_SET_RESOURCE(uriP) && object_readData(contextP, uriP, &size, &dataP) != COAP_205_CONTENT) {
+		return -1;
+	}
+
+	token[0] = mid >> 8;
+	token[1] = mid & 0xff;
+	coap_init_message(message, COAP_UDP, COAP_TYPE_CON, COAP_GET, mid);
+	coap_set_header_observe(message, 0);
+	coap_set_header_token(message, token, sizeof(token));
+	coap_init_message(response, COAP_UDP, COAP_TYPE_ACK, COAP_205_CONTENT, mid);
+
+	result = observe_handleRequest(contextP, uriP, serverP, size, dataP, message, response);
+	if (dataP != NULL) {
+		lwm2m_data_free(size, dataP);
+	}
+
+	return result == COAP_205_CONTENT ? 0 : -1;
+}
+
+static unsigned long bench_notifications(lwm2m_context_t *contextP)
+{
+	lwm2m_observed_t *observedP;
+	lwm2m_watcher_t *watcherP;
+	unsigned long count = 0;
+
+	/* The counter was incremented once by the Observe response */
+
+	for (observedP = contextP->observedList; observedP != NULL; observedP = observedP->next) {
+		for (watcherP = observedP->watcherList; watcherP != NULL; watcherP = watcherP->next) {
+			count += watcherP->counter - 1;
+		}
+	}
+	return count;
+}
+
+static int bench_scenario(const struct bench_scenario *sc, void *sessionH, int steps, struct bench_result *res)
+{
+	lwm2m_context_t *contextP;
+	lwm2m_server_t server;
+	lwm2m_uri_t uri;
+	time_t now;
+	time_t timeout;
+	unsigned long start;
+	uint16_t mid = 1;
+	int ret = -1;
+	int i;
+	int j;
+	int s;
+
+	memset(res, 0, sizeof(*res));
+	for (i = 0; i < BENCH_INSTANCES; i++) {
+		for (j = 0; j < BENCH_RESOURCES; j++) {
+			g_values[i][j] = 20.0 + j;
+		}
+	}
+	g_seed = 1;
+
+	contextP = lwm2m_init(NULL);
+	if (contextP == NULL) {
+		return -1;
+	}
+	contextP->objectList = &g_object;
+
+	memset(&server, 0, sizeof(server));
+	server.shortID = 1;
+	server.sessionH = sessionH;
+	server.status = STATE_REGISTERED;
+
+	now = lwm2m_gettime();
+	for (i = 0; i < BENCH_INSTANCES; i++) {
+		if (sc->instances) {
+			bench_set_uri(&uri, i, -1);
+			if (bench_observe(contextP, &server, &uri, sc, mid++) != 0) {
+				goto out;
+			}
+			res->observed++;
+			continue;
+		}
+		for (j = 0; j < BENCH_RESOURCES; j++) {
+			bench_set_uri(&uri, i, j);
+			if (bench_observe(contextP, &server, &uri, sc, mid++) != 0) {
+				goto out;
+			}
+			res->observed++;
+		}
+	}
+
+	g_reads = 0;
+	start = bench_usec();
+	for (s = 0; s < steps; s++) {
+		now++;
+		for (i = 0; i < sc->changes; i++) {
+			int instance = bench_rand() % BENCH_INSTANCES;
+			int resource = bench_rand() % BENCH_RESOURCES;
+
+			g_values[instance][resource] += ((int)(bench_rand() % 300) - 150) / 100.0;
+			bench_set_uri(&uri, instance, resource);
+			lwm2m_resource_value_changed(contextP, &uri);
+		}
+
+		timeout = BENCH_TIMEOUT;
+		observe_step(contextP, now, &timeout);
+	}
+	res->usec = bench_usec() - start;
+	res->reads = g_reads;
+	res->notifications = bench_notifications(contextP);
+	ret = 0;
+
+out:
+	contextP->objectList = NULL;
+	lwm2m_close(contextP);
+	return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef LWM2M_BENCH_HOST
+int main(int argc, char *argv[])
+#elif defined(CONFIG_BUILD_KERNEL)
+int main(int argc, FAR char *argv[])
+#else
+int lwm2m_bench_main(int argc, char *argv[])
+#endif
+{
+	struct bench_result res;
+	void *sessionH;
+	int steps = BENCH_DEFAULT_STEPS;
+	int ret = 0;
+	int i;
+#ifndef LWM2M_BENCH_HOST
+	char port[8];
+	int sock;
+#endif
+
+	if (argc > 1) {
+		steps = atoi(argv[1]);
+		if (steps <= 0) {
+			printf("usage: %s [steps]\n", argv[0]);
+			return -1;
+		}
+	}
+
+#ifdef LWM2M_BENCH_HOST
+	g_now = 1000;
+	sessionH = &g_now;
+#else
+	/* The notifications are sent to the socket they are sent from */
+
+	snprintf(port, sizeof(port), "%d", CONFIG_EXAMPLES_LWM2M_BENCH_PORT);
+	sock = create_socket(COAP_UDP, port, AF_INET);
+	if (sock < 0) {
+		printf("cannot create the UDP socket\n");
+		return -1;
+	}
+	sessionH = connection_create(COAP_UDP, NULL, sock, "127.0.0.1", port, AF_INET);
+	if (sessionH == NULL) {
+		printf("cannot connect the UDP socket\n");
+		close(sock);
+		return -1;
+	}
+#endif
+
+	bench_init_object();
+
+	printf("LWM2M observe, %d steps of 1 s, %d instances of %d resources:\n", steps, BENCH_INSTANCES, BENCH_RESOURCES);
+	for (i = 0; i < sizeof(g_scenarios) / sizeof(g_scenarios[0]); i++) {
+		if (bench_scenario(&g_scenarios[i], sessionH, steps, &res) != 0) {
+			printf("  %-24s setup failed\n", g_scenarios[i].title);
+			ret = -1;
+			break;
+		}
+
+		printf("  %-24s %3d observed %8lu ns/step %8lu reads %6lu notifications\n", g_scenarios[i].title, res.observed, (unsigned long)(res.usec * 1000.0 / steps), res.reads, res.notifications);
+	}
+
+#ifndef LWM2M_BENCH_HOST
+	connection_free(sessionH);
+	close(sock);
+#endif
+	return ret;
+}
@@ -0,0 +1,629 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * mDNS cache benchmark: replays mDNS responses through the steps mdnsd
+ * takes for each received packet: parse, filter on the name being looked
+ * for, insert into the cache, drop expired records, and resolve a host
+ * name. This is done once with the hashed rr_cache and once with a plain
+ * rr_group list searched by converting every name to a string, as mdnsd
+ * did before the cache was indexed. Both caches must end up answering
+ * every lookup the same way.
+ *
+ * The responses either come from a pcap capture (Ethernet, IPv4, UDP port
+ * 5353) or are generated: a network of N hosts, each announcing an A
+ * record and an _http._tcp service, with some of them saying goodbye.
+ *
+ * Only netutils/mdns/mdns.c is used, so the same file runs on the target
+ * and natively on the host (see Makefile.host).
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#ifndef MDNS_BENCH_HOST
+#include <tinyara/config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mdns.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_ROUNDS  10
+#define BENCH_PKT_SIZE        1536
+#define BENCH_MAX_PACKETS     4096
+#ifdef MDNS_BENCH_HOST
+#define BENCH_CAPTURE_SIZE    (1024 * 1024)
+#else
+#define BENCH_CAPTURE_SIZE    (64 * 1024)	/* About 400 packets */
+#endif
+#define BENCH_MAX_NAMES       1024
+#define BENCH_SERVICE         "_http._tcp.local"
+#define BENCH_MDNS_PORT       5353
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_capture {
+	uint8_t *data;
+	size_t size;
+	size_t used;
+	size_t off[BENCH_MAX_PACKETS];
+	size_t len[BENCH_MAX_PACKETS];
+	int count;
+};
+
+struct bench_result {
+	unsigned long usec;
+	int entries;
+	unsigned long resolved;
+	uint32_t addr_sum;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const int g_hosts[] = { 16, 64, 256, 1024 };
+
+static struct bench_capture g_cap;
+static char *g_names[BENCH_MAX_NAMES];
+static int g_num_names;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static int bench_add_packet(const uint8_t *pkt, size_t len)
+{
+	if (g_cap.count == BENCH_MAX_PACKETS || g_cap.used + len > g_cap.size) {
+		return -1;
+	}
+
+	memcpy(g_cap.data + g_cap.used, pkt, len);
+	g_cap.off[g_cap.count] = g_cap.used;
+	g_cap.len[g_cap.count] = len;
+	g_cap.used += len;
+	g_cap.count++;
+	return 0;
+}
+
+static void bench_reset(void)
+{
+	int i;
+
+	for (i = 0; i < g_num_names; i++) {
+		free(g_names[i]);
+	}
+	g_num_names = 0;
+	g_cap.used = 0;
+	g_cap.count = 0;
+}
+
+/* Remember the A record names of the capture as the names to resolve, in
+ * the dotted form an application passes in.
+ */
+
+static void bench_collect_names(void)
+{
+	struct mdns_pkt *pkt;
+	struct rr_list *l;
+	char *name;
+	int i;
+	int j;
+
+	for (i = 0; i < g_cap.count && g_num_names < BENCH_MAX_NAMES; i++) {
+		pkt = mdns_parse_pkt(g_cap.data + g_cap.off[i], g_cap.len[i]);
+		if (pkt == NULL) {
+			continue;
+		}
+
+		for (l = pkt->rr_ans; l && g_num_names < BENCH_MAX_NAMES; l = l->next) {
+			if (l->e->type != RR_A) {
+				continue;
+			}
+
+			name = nlabel_to_str(l->e->name);
+			name[strlen(name) - 1] = '\0';
+			for (j = 0; j < g_num_names; j++) {
+				if (strcmp(g_names[j], name) == 0) {
+					break;
+				}
+			}
+
+			if (j < g_num_names) {
+				free(name);
+			} else {
+				g_names[g_num_names++] = name;
+			}
+		}
+		mdns_pkt_destroy(pkt);
+	}
+}
+
+/* Responses of a network of hosts: every host announces its address and
+ * an _http._tcp service, three times, and every eighth host then leaves
+ * with TTL 0.
+ */
+
+static int bench_generate(int hosts)
+{
+	uint8_t buf[BENCH_PKT_SIZE];
+	struct mdns_pkt pkt;
+	struct rr_entry *a_e;
+	struct rr_entry *srv_e;
+	struct rr_entry *txt_e;
+	struct rr_entry *ptr_e;
+	char name[64];
+	int round;
+	int h;
+	size_t len;
+	int ret = 0;
+
+	bench_reset();
+
+	for (round = 0; round < 4 && ret == 0; round++) {
+		for (h = 0; h < hosts && ret == 0; h++) {
+			uint32_t ttl = 120;
+
+			if (round == 3) {
+				if (h % 8 != 0) {
+					continue;
+				}
+				ttl = 0;
+			}
+
+			snprintf(name, sizeof(name), "host%d.local", h);
+			a_e = rr_create_a(create_nlabel(name), htonl(0x0a000000 | h));
+
+			snprintf(name, sizeof(name), "host%d.%s", h, BENCH_SERVICE);
+			srv_e = rr_create_srv(create_nlabel(name), 80, dup_nlabel(a_e->name));
+			txt_e = rr_create(create_nlabel(name), RR_TXT);
+			rr_add_txt(txt_e, "path=/");
+			ptr_e = rr_create_ptr(create_nlabel(BENCH_SERVICE), srv_e);
+
+			a_e->ttl = srv_e->ttl = txt_e->ttl = ptr_e->ttl = ttl;
+
+			memset(&pkt, 0, sizeof(pkt));
+			mdns_init_reply(&pkt, 0);
+			pkt.num_ans_rr += rr_list_append(&pkt.rr_ans, ptr_e);
+			pkt.num_ans_rr += rr_list_append(&pkt.rr_ans, srv_e);
+			pkt.num_ans_rr += rr_list_append(&pkt.rr_ans, txt_e);
+			pkt.num_ans_rr += rr_list_append(&pkt.rr_ans, a_e);
+
+			len = mdns_encode_pkt(&pkt, buf, sizeof(buf));
+			if (len == (size_t)-1 || bench_add_packet(buf, len) != 0) {
+				ret = -1;
+			}
+
+			rr_list_destroy(pkt.rr_ans, 1);
+		}
+	}
+
+	bench_collect_names();
+	return ret;
+}
+
+static uint32_t bench_rd32(const uint8_t *p, int swap)
+{
+	if (swap) {
+		return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+	}
+	return (uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | p[0];
+}
+
+/* Load the mDNS payloads of a classic pcap file with Ethernet frames */
+
+static int bench_load_pcap(const char *path)
+{
+	uint8_t hdr[24];
+	uint8_t *frame = NULL;
+	FILE *fp;
+	uint32_t incl;
+	int swap;
+	int ret = -1;
+
+	bench_reset();
+
+	fp = fopen(path, "rb");
+	if (fp == NULL) {
+		printf("cannot open %s\n", path);
+		return -1;
+	}
+
+	if (fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr)) {
+		goto out;
+	}
+
+	if (bench_rd32(hdr, 0) == 0xa1b2c3d4) {
+		swap = 0;
+	} else if (bench_rd32(hdr, 1) == 0xa1b2c3d4) {
+		swap = 1;
+	} else {
+		printf("%s: not a pcap file\n", path);
+		goto out;
+	}
+
+	if (bench_rd32(hdr + 20, swap) != 1) {
+		printf("%s: only Ethernet captures are supported\n", path);
+		goto out;
+	}
+
+	frame = malloc(65536);
+	if (frame == NULL) {
+		goto out;
+	}
+
+	while (fread(hdr, 1, 16, fp) == 16) {
+		const uint8_t *p = frame;
+		size_t len;
+		size_t ihl;
+
+		incl = bench_rd32(hdr + 8, swap);
+		if (incl > 65536 || fread(frame, 1, incl, fp) != incl) {
+			break;
+		}
+
+		len = incl;
+		if (len < 14) {
+			continue;
+		}
+
+		/* Skip a VLAN tag */
+
+		if (p[12] == 0x81 && p[13] == 0x00 && len >= 18) {
+			p += 4;
+			len -= 4;
+		}
+
+		if (p[12] != 0x08 || p[13] != 0x00) {
+			continue;
+		}
+		p += 14;
+		len -= 14;
+
+		if (len < 20 || (p[0] >> 4) != 4 || p[9] != 17) {
+			continue;
+		}
+
+		ihl = (p[0] & 0x0f) * 4;
+		if (len < ihl + 8) {
+			continue;
+		}
+		p += ihl;
+		len -= ihl;
+
+		if (((p[0] << 8) | p[1]) != BENCH_MDNS_PORT && ((p[2] << 8) | p[3]) != BENCH_MDNS_PORT) {
+			continue;
+		}
+
+		if (bench_add_packet(p + 8, len - 8) != 0) {
+			break;
+		}
+	}
+
+	bench_collect_names();
+	ret = 0;
+
+out:
+	free(frame);
+	fclose(fp);
+	return ret;
+}
+
+/* The cache as mdnsd kept it before: one list of rr_groups, names
+ * compared as strings.
+ */
+
+static void list_insert(struct rr_group **cache, struct rr_entry *rr_e)
+{
+	struct rr_group *group = rr_group_find(*cache, rr_e->name);
+	struct rr_entry *in_cache = NULL;
+
+	if (group) {
+		in_cache = rr_entry_match(group->rr, rr_e);
+	}
+
+	if (in_cache) {
+		rr_group_del(cache, in_cache);
+	}
+
+	if (in_cache == NULL || rr_e->ttl > 0) {
+		rr_group_add(cache, rr_duplicate(rr_e));
+	}
+}
+
+static void list_expire(struct rr_group **cache)
+{
+	struct rr_group *group;
+	struct rr_list *list;
+	struct rr_list *remove_list = NULL;
+
+	for (group = *cache; group; group = group->next) {
+		for (list = group->rr; list; list = list->next) {
+			if ((time(NULL) - list->e->update_time) > list->e->ttl) {
+				rr_list_append(&remove_list, list->e);
+			}
+		}
+	}
+
+	for (list = remove_list; list; list = list->next) {
+		rr_group_del(cache, list->e);
+	}
+	rr_list_destroy(remove_list, 0);
+}
+
+static int list_resolve(struct rr_group *cache, const char *hostname, uint32_t *addr)
+{
+	struct rr_group *group;
+	struct rr_list *list;
+	char *name;
+	int ret;
+
+	for (group = cache; group; group = group->next) {
+		for (list = group->rr; list; list = list->next) {
+			if (list->e->type != RR_A) {
+				continue;
+			}
+
+			name = nlabel_to_str(list->e->name);
+			ret = strncmp(name, hostname, strlen(hostname));
+			free(name);
+			if (ret == 0) {
+				*addr = list->e->data.A.addr;
+				return 0;
+			}
+		}
+	}
+	return -1;
+}
+
+static int list_filter(struct rr_entry *rr_e, const char *filter)
+{
+	char *name;
+	int ret;
+
+	if (rr_e->type != RR_PTR) {
+		return 1;
+	}
+
+	name = nlabel_to_str(rr_e->name);
+	ret = strncmp(name, filter, strlen(filter)) == 0;
+	free(name);
+	return ret;
+}
+
+static int list_count(struct rr_group *group)
+{
+	int count = 0;
+
+	for (; group; group = group->next) {
+		count += rr_list_count(group->rr);
+	}
+	return count;
+}
+
+static int cache_resolve(struct rr_cache *cache, const char *hostname, uint32_t *addr)
+{
+	uint8_t *name = create_nlabel(hostname);
+	struct rr_group *group;
+	struct rr_entry *a_e = NULL;
+
+	group = rr_cache_find(cache, name);
+	if (group) {
+		a_e = rr_entry_find(group->rr, name, RR_A);
+	}
+	free(name);
+
+	if (a_e == NULL) {
+		return -1;
+	}
+	*addr = a_e->data.A.addr;
+	return 0;
+}
+
+static int cache_count(struct rr_cache *cache)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < MDNS_CACHE_HASH_SIZE; i++) {
+		count += list_count(cache->bucket[i]);
+	}
+	return count;
+}
+
+static int bench_replay(int indexed, int rounds, struct bench_result *res)
+{
+	struct rr_group *list = NULL;
+	struct rr_cache cache;
+	struct rr_list *l;
+	struct mdns_pkt *pkt;
+	uint8_t *filter;
+	unsigned long start;
+	uint32_t addr;
+	int r;
+	int i;
+	int n = 0;
+
+	rr_cache_init(&cache);
+	memset(res, 0, sizeof(*res));
+	filter = create_nlabel(BENCH_SERVICE);
+
+	start = bench_usec();
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < g_cap.count; i++) {
+			pkt = mdns_parse_pkt(g_cap.data + g_cap.off[i], g_cap.len[i]);
+			if (pkt == NULL) {
+				continue;
+			}
+
+			for (l = pkt->rr_ans; l; l = l->next) {
+				if (indexed) {
+					struct rr_group *group;
+					struct rr_entry *in_cache = NULL;
+					struct rr_entry *rr_e;
+
+					if (l->e->type == RR_PTR && cmp_nlabel(l->e->name, filter) != 0) {
+						continue;
+					}
+
+					group = rr_cache_find(&cache, l->e->name);
+					if (group) {
+						in_cache = rr_entry_match(group->rr, l->e);
+					}
+					if (in_cache) {
+						rr_cache_del(&cache, in_cache);
+					}
+					if (in_cache == NULL || l->e->ttl > 0) {
+						rr_e = rr_duplicate(l->e);
+						if (rr_e) {
+							rr_cache_add(&cache, rr_e);
+						}
+					}
+				} else if (list_filter(l->e, BENCH_SERVICE)) {
+					list_insert(&list, l->e);
+				}
+			}
+			mdns_pkt_destroy(pkt);
+
+			if (indexed) {
+				rr_cache_expire(&cache, time(NULL));
+			} else {
+				list_expire(&list);
+			}
+
+			if (g_num_names > 0) {
+				const char *name = g_names[n++ % g_num_names];
+
+				if ((indexed ? cache_resolve(&cache, name, &addr) : list_resolve(list, name, &addr)) == 0) {
+					res->resolved++;
+					res->addr_sum += addr;
+				}
+			}
+		}
+	}
+	res->usec = bench_usec() - start;
+
+	res->entries = indexed ? cache_count(&cache) : list_count(list);
+
+	rr_cache_destroy(&cache);
+	rr_group_destroy(list);
+	free(filter);
+	return 0;
+}
+
+static int bench_run(const char *title, int rounds)
+{
+	struct bench_result list;
+	struct bench_result indexed;
+	unsigned long packets = (unsigned long)g_cap.count * rounds;
+
+	if (packets == 0) {
+		printf("  %-24s no mDNS packets\n", title);
+		return 0;
+	}
+
+	bench_replay(0, rounds, &list);
+	bench_replay(1, rounds, &indexed);
+
+	printf("  %-24s %5d pkts %5d records %8lu ns/pkt list %8lu ns/pkt hashed\n", title, g_cap.count, indexed.entries, (unsigned long)(list.usec * 1000.0 / packets), (unsigned long)(indexed.usec * 1000.0 / packets));
+
+	if (list.entries != indexed.entries || list.resolved != indexed.resolved || list.addr_sum != indexed.addr_sum) {
+		printf("  MISMATCH: %d/%d records, %lu/%lu resolved\n", list.entries, indexed.entries, list.resolved, indexed.resolved);
+		return -1;
+	}
+	return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef MDNS_BENCH_HOST
+int main(int argc, char *argv[])
+#elif defined(CONFIG_BUILD_KERNEL)
+int main(int argc, FAR char *argv[])
+#else
+int mdns_bench_main(int argc, char *argv[])
+#endif
+{
+	char title[32];
+	int rounds = BENCH_DEFAULT_ROUNDS;
+	int ret = -1;
+	int i;
+
+	if (argc > 1) {
+		rounds = atoi(argv[1]);
+		if (rounds <= 0) {
+			printf("usage: %s [rounds] [capture.pcap]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	g_cap.size = BENCH_CAPTURE_SIZE;
+	g_cap.data = malloc(g_cap.size);
+	if (g_cap.data == NULL) {
+		printf("out of memory\n");
+		return -1;
+	}
+
+	printf("mDNS cache, %d rounds, %d buckets:\n", rounds, MDNS_CACHE_HASH_SIZE);
+
+	if (argc > 2) {
+		if (bench_load_pcap(argv[2]) == 0) {
+			ret = bench_run(argv[2], rounds);
+		}
+		goto out;
+	}
+
+	for (i = 0; i < sizeof(g_hosts) / sizeof(g_hosts[0]); i++) {
+		if (bench_generate(g_hosts[i]) != 0) {
+			printf("  %d hosts do not fit in the capture buffer\n", g_hosts[i]);
+			break;
+		}
+
+		snprintf(title, sizeof(title), "%d hosts", g_hosts[i]);
+		if (bench_run(title, rounds) != 0) {
+			goto out;
+		}
+	}
+	ret = 0;
+
+out:
+	bench_reset();
+	free(g_cap.data);
+	return ret;
+}
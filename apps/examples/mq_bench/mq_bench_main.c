@@ -0,0 +1,344 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/*
+ * Message queue benchmark.  Three measurements:
+ *
+ * - burst: a queue is filled with messages of mixed priorities and then
+ *   drained, as a pipeline does when its consumer falls behind; the time
+ *   per mq_send() and per mq_receive() is reported.
+ * - round trip: a message goes to an echo thread and comes back, which is
+ *   the latency a blocked receiver sees.
+ * - payload (MQ_ZEROCOPY only): a large payload is moved either in
+ *   MQ_MAXMSGSIZE pieces with mq_send()/mq_receive() or as one shared
+ *   buffer with mq_sendbuf()/mq_receivebuf().
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <mqueue.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_ROUNDS 1000
+#define BENCH_PRIOS          32	/* distinct priorities in a burst */
+#define BENCH_QUEUE          "mq_bench"
+#define BENCH_ECHO_QUEUE     "mq_bench_echo"
+
+#ifndef CONFIG_EXAMPLES_MQ_BENCH_DEPTH
+#define CONFIG_EXAMPLES_MQ_BENCH_DEPTH 32
+#endif
+
+#ifndef CONFIG_EXAMPLES_MQ_BENCH_PAYLOAD
+#define CONFIG_EXAMPLES_MQ_BENCH_PAYLOAD 1024
+#endif
+
+#define BENCH_MSGSIZE CONFIG_MQ_MAXMSGSIZE
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint32_t g_seed;
+static int g_rounds;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static uint32_t bench_rand(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 16;
+}
+
+static mqd_t bench_open(FAR const char *name, int oflags, int depth)
+{
+	struct mq_attr attr;
+
+	attr.mq_maxmsg = depth;
+	attr.mq_msgsize = BENCH_MSGSIZE;
+	attr.mq_flags = 0;
+	attr.mq_curmsgs = 0;
+
+	return mq_open(name, oflags | O_CREAT, 0666, &attr);
+}
+
+/* Fill the queue and drain it, g_rounds times.  With mixed priorities,
+ * each message lands among the others; otherwise they all go at the end.
+ */
+
+static int bench_burst(int mixed)
+{
+	char msg[BENCH_MSGSIZE];
+	unsigned long sendus = 0;
+	unsigned long rcvus = 0;
+	unsigned long start;
+	mqd_t mqd;
+	int prio;
+	int last;
+	int r;
+	int i;
+
+	mqd = bench_open(BENCH_QUEUE, O_RDWR | O_NONBLOCK, CONFIG_EXAMPLES_MQ_BENCH_DEPTH);
+	if (mqd == (mqd_t)-1) {
+		printf("  cannot open %s: %d\n", BENCH_QUEUE, errno);
+		return -1;
+	}
+
+	memset(msg, 0x5a, sizeof(msg));
+	g_seed = 1;
+	for (r = 0; r < g_rounds; r++) {
+		start = bench_usec();
+		for (i = 0; i < CONFIG_EXAMPLES_MQ_BENCH_DEPTH; i++) {
+			prio = mixed ? (int)(bench_rand() % BENCH_PRIOS) : 1;
+			if (mq_send(mqd, msg, sizeof(msg), prio) != OK) {
+				printf("  mq_send failed: %d\n", errno);
+				goto errout;
+			}
+		}
+		sendus += bench_usec() - start;
+
+		/* Check the order on the way out: never a rising priority */
+
+		last = BENCH_PRIOS;
+		start = bench_usec();
+		for (i = 0; i < CONFIG_EXAMPLES_MQ_BENCH_DEPTH; i++) {
+			if (mq_receive(mqd, msg, sizeof(msg), &prio) < 0 || prio > last) {
+				printf("  mq_receive failed: %d, priority %d after %d\n", errno, prio, last);
+				goto errout;
+			}
+			last = prio;
+		}
+		rcvus += bench_usec() - start;
+	}
+
+	printf("  burst, %-6s priorities: %6lu ns/send %6lu ns/receive\n", mixed ? "mixed" : "equal", sendus * 1000 / ((unsigned long)g_rounds * CONFIG_EXAMPLES_MQ_BENCH_DEPTH), rcvus * 1000 / ((unsigned long)g_rounds * CONFIG_EXAMPLES_MQ_BENCH_DEPTH));
+
+	mq_close(mqd);
+	mq_unlink(BENCH_QUEUE);
+	return 0;
+
+errout:
+	mq_close(mqd);
+	mq_unlink(BENCH_QUEUE);
+	return -1;
+}
+
+/* Echo every message of BENCH_QUEUE back on BENCH_ECHO_QUEUE */
+
+static pthread_addr_t bench_echo(pthread_addr_t arg)
+{
+	char msg[BENCH_MSGSIZE];
+	mqd_t in;
+	mqd_t out;
+	int r;
+
+	in = bench_open(BENCH_QUEUE, O_RDONLY, 1);
+	out = bench_open(BENCH_ECHO_QUEUE, O_WRONLY, 1);
+	if (in == (mqd_t)-1 || out == (mqd_t)-1) {
+		return (pthread_addr_t)-1;
+	}
+
+	for (r = 0; r < g_rounds; r++) {
+		if (mq_receive(in, msg, sizeof(msg), NULL) < 0 || mq_send(out, msg, sizeof(msg), 1) != OK) {
+			break;
+		}
+	}
+
+	mq_close(in);
+	mq_close(out);
+	return NULL;
+}
+
+static int bench_roundtrip(void)
+{
+	char msg[BENCH_MSGSIZE];
+	pthread_t echo;
+	unsigned long start;
+	unsigned long us;
+	mqd_t out;
+	mqd_t in;
+	int r;
+
+	out = bench_open(BENCH_QUEUE, O_WRONLY, 1);
+	in = bench_open(BENCH_ECHO_QUEUE, O_RDONLY, 1);
+	if (out == (mqd_t)-1 || in == (mqd_t)-1) {
+		printf("  cannot open the round trip queues: %d\n", errno);
+		return -1;
+	}
+
+	if (pthread_create(&echo, NULL, bench_echo, NULL) != 0) {
+		printf("  cannot start the echo thread\n");
+		return -1;
+	}
+
+	memset(msg, 0xa5, sizeof(msg));
+	start = bench_usec();
+	for (r = 0; r < g_rounds; r++) {
+		if (mq_send(out, msg, sizeof(msg), 1) != OK || mq_receive(in, msg, sizeof(msg), NULL) < 0) {
+			printf("  round trip %d failed: %d\n", r, errno);
+			break;
+		}
+	}
+	us = bench_usec() - start;
+
+	pthread_join(echo, NULL);
+	mq_close(out);
+	mq_close(in);
+	mq_unlink(BENCH_QUEUE);
+	mq_unlink(BENCH_ECHO_QUEUE);
+
+	if (r < g_rounds) {
+		return -1;
+	}
+
+	printf("  round trip:               %6lu ns\n", us * 1000 / g_rounds);
+	return 0;
+}
+
+#ifdef CONFIG_MQ_ZEROCOPY
+/* Move a large payload through the queue, in pieces or by reference.
+ * Either way the producer writes the payload once and the consumer reads
+ * it once.
+ */
+
+static int bench_payload(void)
+{
+	static char payload[CONFIG_EXAMPLES_MQ_BENCH_PAYLOAD];
+	static char copy[CONFIG_EXAMPLES_MQ_BENCH_PAYLOAD];
+	unsigned long copyus;
+	unsigned long refus;
+	unsigned long start;
+	FAR void *buf;
+	size_t off;
+	size_t len;
+	mqd_t mqd;
+	int r;
+
+	mqd = bench_open(BENCH_QUEUE, O_RDWR | O_NONBLOCK, 2);
+	if (mqd == (mqd_t)-1) {
+		printf("  cannot open %s: %d\n", BENCH_QUEUE, errno);
+		return -1;
+	}
+
+	memset(payload, 0x3c, sizeof(payload));
+	start = bench_usec();
+	for (r = 0; r < g_rounds; r++) {
+		for (off = 0; off < sizeof(payload); off += len) {
+			len = sizeof(payload) - off < BENCH_MSGSIZE ? sizeof(payload) - off : BENCH_MSGSIZE;
+			if (mq_send(mqd, payload + off, len, 1) != OK || mq_receive(mqd, copy + off, BENCH_MSGSIZE, NULL) != (ssize_t)len) {
+				printf("  mq_send/mq_receive failed: %d\n", errno);
+				goto errout;
+			}
+		}
+	}
+	copyus = bench_usec() - start;
+
+	start = bench_usec();
+	for (r = 0; r < g_rounds; r++) {
+		buf = mq_bufalloc(sizeof(payload));
+		if (buf == NULL) {
+			printf("  mq_bufalloc failed: %d\n", errno);
+			goto errout;
+		}
+
+		memcpy(buf, payload, sizeof(payload));
+		if (mq_sendbuf(mqd, buf, sizeof(payload), 1) != OK) {
+			printf("  mq_sendbuf failed: %d\n", errno);
+			mq_buffree(buf);
+			goto errout;
+		}
+
+		if (mq_receivebuf(mqd, &buf, NULL) != (ssize_t)sizeof(payload)) {
+			printf("  mq_receivebuf failed: %d\n", errno);
+			goto errout;
+		}
+
+		memcpy(copy, buf, sizeof(payload));
+		mq_buffree(buf);
+	}
+	refus = bench_usec() - start;
+
+	printf("  %d byte payload:          %6lu ns in %d byte pieces, %6lu ns by reference\n", CONFIG_EXAMPLES_MQ_BENCH_PAYLOAD, copyus * 1000 / g_rounds, BENCH_MSGSIZE, refus * 1000 / g_rounds);
+
+	mq_close(mqd);
+	mq_unlink(BENCH_QUEUE);
+	return 0;
+
+errout:
+	mq_close(mqd);
+	mq_unlink(BENCH_QUEUE);
+	return -1;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int mq_bench_main(int argc, char *argv[])
+#endif
+{
+	g_rounds = BENCH_DEFAULT_ROUNDS;
+	if (argc > 1) {
+		g_rounds = atoi(argv[1]);
+		if (g_rounds <= 0) {
+			printf("usage: %s [rounds]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	printf("Message queues, %d rounds, %d messages of %d bytes per burst:\n", g_rounds, CONFIG_EXAMPLES_MQ_BENCH_DEPTH, BENCH_MSGSIZE);
+	if (bench_burst(0) != 0 || bench_burst(1) != 0 || bench_roundtrip() != 0) {
+		return -1;
+	}
+#ifdef CONFIG_MQ_ZEROCOPY
+	if (bench_payload() != 0) {
+		return -1;
+	}
+#endif
+
+	return 0;
+}
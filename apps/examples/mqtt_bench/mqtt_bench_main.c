@@ -0,0 +1,639 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * MQTT benchmark: a publisher and a subscriber client talk to a minimal
+ * broker stand-in that runs in a thread of this task on the loopback
+ * interface. The stand-in acknowledges CONNECT, SUBSCRIBE, PUBLISH and
+ * PINGREQ, and forwards every PUBLISH to the subscribers at QoS 1, so both
+ * clients also have acknowledgements to send. It keeps no state beyond the
+ * subscription flag and is only meant to be faster than the clients.
+ *
+ * For each mode the time from the first publish until the last PUBACK
+ * (publisher) and the last delivery (subscriber) is reported.
+ *
+ * Only netutils/mqtt is used, so the same file runs on the target and
+ * natively on the host (see Makefile.host).
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#ifndef MQTT_BENCH_HOST
+#include <tinyara/config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "mosquitto.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_MQTT_BENCH_PORT
+#define CONFIG_EXAMPLES_MQTT_BENCH_PORT 18830
+#endif
+
+#define BENCH_DEFAULT_MESSAGES 5000
+#define BENCH_DEFAULT_PAYLOAD  64
+#define BENCH_MAX_PAYLOAD      1024
+#define BENCH_HOST             "127.0.0.1"
+#define BENCH_TOPIC            "bench/data"
+#define BENCH_TIMEOUT_SEC      30
+
+#define BROKER_MAX_CLIENTS     4
+#define BROKER_BUF_SIZE        4096
+
+/* MQTT control packet types, upper nibble of the first byte */
+
+#define MQTT_CONNECT           0x10
+#define MQTT_CONNACK           0x20
+#define MQTT_PUBLISH           0x30
+#define MQTT_PUBACK            0x40
+#define MQTT_SUBSCRIBE         0x80
+#define MQTT_SUBACK            0x90
+#define MQTT_PINGREQ           0xC0
+#define MQTT_PINGRESP          0xD0
+#define MQTT_DISCONNECT        0xE0
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct broker_client {
+	int fd;
+	bool subscribed;
+	uint16_t mid;				/* Last mid used when forwarding */
+	size_t len;
+	uint8_t buf[BROKER_BUF_SIZE];
+};
+
+struct broker {
+	int listen_fd;
+	volatile bool stop;
+	pthread_t thread;
+	struct broker_client client[BROKER_MAX_CLIENTS];
+	uint8_t out[BROKER_BUF_SIZE];	/* Forwarded PUBLISH */
+};
+
+struct bench_state {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool connected;
+	bool subscribed;
+	int published;
+	int received;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct broker g_broker;
+static struct bench_state g_pub_state;
+static struct bench_state g_sub_state;
+static uint8_t g_payload[BENCH_MAX_PAYLOAD];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+/* Broker stand-in */
+
+static int broker_send(struct broker_client *c, const uint8_t *data, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = send(c->fd, data, len, 0);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		data += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+static void broker_forward(struct broker *b, const uint8_t *topic, size_t topic_len, const uint8_t *payload, size_t payload_len)
+{
+	uint8_t *out = b->out;
+	uint32_t remaining;
+	size_t n;
+	int i;
+
+	/* QoS 1 PUBLISH: topic length, topic, mid, payload */
+
+	remaining = 2 + topic_len + 2 + payload_len;
+	if (remaining + 5 > sizeof(b->out)) {
+		return;
+	}
+
+	n = 0;
+	out[n++] = MQTT_PUBLISH | 0x02;
+	do {
+		out[n] = remaining & 0x7f;
+		remaining >>= 7;
+		if (remaining) {
+			out[n] |= 0x80;
+		}
+		n++;
+	} while (remaining);
+	out[n++] = topic_len >> 8;
+	out[n++] = topic_len & 0xff;
+	memcpy(&out[n], topic, topic_len);
+	n += topic_len + 2;
+	memcpy(&out[n], payload, payload_len);
+	n += payload_len;
+
+	for (i = 0; i < BROKER_MAX_CLIENTS; i++) {
+		struct broker_client *c = &b->client[i];
+
+		if (c->fd < 0 || !c->subscribed) {
+			continue;
+		}
+
+		c->mid = c->mid == 0xffff ? 1 : c->mid + 1;
+		out[n - payload_len - 2] = c->mid >> 8;
+		out[n - payload_len - 1] = c->mid & 0xff;
+		broker_send(c, out, n);
+	}
+}
+
+/* Handle one complete packet. Returns -1 when the client should be
+ * dropped.
+ */
+
+static int broker_packet(struct broker *b, struct broker_client *c, uint8_t type, const uint8_t *body, uint32_t len)
+{
+	uint8_t reply[5];
+	uint16_t topic_len;
+	uint32_t hdr_len;
+
+	switch (type & 0xf0) {
+	case MQTT_CONNECT:
+		reply[0] = MQTT_CONNACK;
+		reply[1] = 2;
+		reply[2] = 0;
+		reply[3] = 0;
+		return broker_send(c, reply, 4);
+
+	case MQTT_PUBLISH:
+		if (len < 2) {
+			return -1;
+		}
+		topic_len = (body[0] << 8) | body[1];
+		hdr_len = 2 + topic_len + ((type & 0x06) ? 2 : 0);
+		if (hdr_len > len) {
+			return -1;
+		}
+		if (type & 0x06) {
+			reply[0] = MQTT_PUBACK;
+			reply[1] = 2;
+			reply[2] = body[2 + topic_len];
+			reply[3] = body[3 + topic_len];
+			if (broker_send(c, reply, 4) < 0) {
+				return -1;
+			}
+		}
+		broker_forward(b, body + 2, topic_len, body + hdr_len, len - hdr_len);
+		return 0;
+
+	case MQTT_SUBSCRIBE:
+		if (len < 2) {
+			return -1;
+		}
+		c->subscribed = true;
+		reply[0] = MQTT_SUBACK;
+		reply[1] = 3;
+		reply[2] = body[0];
+		reply[3] = body[1];
+		reply[4] = body[len - 1] & 0x03;
+		return broker_send(c, reply, 5);
+
+	case MQTT_PINGREQ:
+		reply[0] = MQTT_PINGRESP;
+		reply[1] = 0;
+		return broker_send(c, reply, 2);
+
+	case MQTT_DISCONNECT:
+		return -1;
+
+	default:
+		/* PUBACK from the subscriber and the like */
+		return 0;
+	}
+}
+
+static int broker_read(struct broker *b, struct broker_client *c)
+{
+	ssize_t ret;
+	uint32_t remaining;
+	uint32_t mult;
+	size_t pos;
+	size_t hdr;
+
+	ret = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+	if (ret <= 0) {
+		return -1;
+	}
+	c->len += ret;
+
+	pos = 0;
+	for (;;) {
+		/* Fixed header: type, then 1-4 bytes of remaining length */
+
+		remaining = 0;
+		mult = 1;
+		hdr = pos + 1;
+		do {
+			if (hdr >= c->len) {
+				goto incomplete;
+			}
+			remaining += (c->buf[hdr] & 0x7f) * mult;
+			mult <<= 7;
+		} while (c->buf[hdr++] & 0x80);
+
+		if (remaining > sizeof(c->buf) - (hdr - pos)) {
+			return -1;
+		}
+		if (hdr + remaining > c->len) {
+			goto incomplete;
+		}
+
+		if (broker_packet(b, c, c->buf[pos], c->buf + hdr, remaining) < 0) {
+			return -1;
+		}
+		pos = hdr + remaining;
+	}
+
+incomplete:
+	memmove(c->buf, c->buf + pos, c->len - pos);
+	c->len -= pos;
+	return 0;
+}
+
+static void *broker_main(void *arg)
+{
+	struct broker *b = arg;
+	struct pollfd fds[BROKER_MAX_CLIENTS + 1];
+	int nfds;
+	int fd;
+	int i;
+
+	while (!b->stop) {
+		fds[0].fd = b->listen_fd;
+		fds[0].events = POLLIN;
+		nfds = 1;
+		for (i = 0; i < BROKER_MAX_CLIENTS; i++) {
+			fds[nfds].fd = b->client[i].fd;
+			fds[nfds].events = POLLIN;
+			fds[nfds].revents = 0;
+			nfds++;
+		}
+
+		if (poll(fds, nfds, 100) <= 0) {
+			continue;
+		}
+
+		if (fds[0].revents & POLLIN) {
+			fd = accept(b->listen_fd, NULL, NULL);
+			for (i = 0; fd >= 0 && i < BROKER_MAX_CLIENTS; i++) {
+				if (b->client[i].fd < 0) {
+					memset(&b->client[i], 0, sizeof(b->client[i]));
+					b->client[i].fd = fd;
+					fd = -1;
+				}
+			}
+			if (fd >= 0) {
+				close(fd);
+			}
+		}
+
+		for (i = 0; i < BROKER_MAX_CLIENTS; i++) {
+			if (fds[i + 1].fd >= 0 && (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+				if (broker_read(b, &b->client[i]) < 0) {
+					close(b->client[i].fd);
+					b->client[i].fd = -1;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < BROKER_MAX_CLIENTS; i++) {
+		if (b->client[i].fd >= 0) {
+			close(b->client[i].fd);
+		}
+	}
+	close(b->listen_fd);
+	return NULL;
+}
+
+static int broker_start(struct broker *b)
+{
+	struct sockaddr_in addr;
+	int on = 1;
+	int i;
+
+	memset(b, 0, sizeof(*b));
+	for (i = 0; i < BROKER_MAX_CLIENTS; i++) {
+		b->client[i].fd = -1;
+	}
+
+	b->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (b->listen_fd < 0) {
+		return -1;
+	}
+	setsockopt(b->listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(CONFIG_EXAMPLES_MQTT_BENCH_PORT);
+	addr.sin_addr.s_addr = inet_addr(BENCH_HOST);
+	if (bind(b->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(b->listen_fd, BROKER_MAX_CLIENTS) < 0) {
+		close(b->listen_fd);
+		return -1;
+	}
+
+	if (pthread_create(&b->thread, NULL, broker_main, b) != 0) {
+		close(b->listen_fd);
+		return -1;
+	}
+	return 0;
+}
+
+static void broker_stop(struct broker *b)
+{
+	b->stop = true;
+	pthread_join(b->thread, NULL);
+}
+
+/* Clients */
+
+static void state_signal(struct bench_state *st, int *field)
+{
+	pthread_mutex_lock(&st->lock);
+	(*field)++;
+	pthread_cond_signal(&st->cond);
+	pthread_mutex_unlock(&st->lock);
+}
+
+/* Wait until *field reaches target. Returns -1 on timeout. */
+
+static int state_wait(struct bench_state *st, int *field, int target)
+{
+	struct timespec deadline;
+	int ret = 0;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += BENCH_TIMEOUT_SEC;
+
+	pthread_mutex_lock(&st->lock);
+	while (*field < target && ret == 0) {
+		ret = pthread_cond_timedwait(&st->cond, &st->lock, &deadline);
+	}
+	ret = *field < target ? -1 : 0;
+	pthread_mutex_unlock(&st->lock);
+	return ret;
+}
+
+static void state_reset(struct bench_state *st)
+{
+	pthread_mutex_lock(&st->lock);
+	st->connected = false;
+	st->subscribed = false;
+	st->published = 0;
+	st->received = 0;
+	pthread_mutex_unlock(&st->lock);
+}
+
+static void on_connect(struct mosquitto *mosq, void *obj, int rc)
+{
+	struct bench_state *st = obj;
+
+	if (rc == 0) {
+		pthread_mutex_lock(&st->lock);
+		st->connected = true;
+		pthread_cond_signal(&st->cond);
+		pthread_mutex_unlock(&st->lock);
+	}
+}
+
+static void on_subscribe(struct mosquitto *mosq, void *obj, int mid, int qos_count, const int *granted_qos)
+{
+	struct bench_state *st = obj;
+
+	pthread_mutex_lock(&st->lock);
+	st->subscribed = true;
+	pthread_cond_signal(&st->cond);
+	pthread_mutex_unlock(&st->lock);
+}
+
+static void on_publish(struct mosquitto *mosq, void *obj, int mid)
+{
+	struct bench_state *st = obj;
+
+	state_signal(st, &st->published);
+}
+
+static void on_message(struct mosquitto *mosq, void *obj, const struct mosquitto_message *msg)
+{
+	struct bench_state *st = obj;
+
+	state_signal(st, &st->received);
+}
+
+static int wait_flag(struct bench_state *st, bool *flag)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += BENCH_TIMEOUT_SEC;
+
+	pthread_mutex_lock(&st->lock);
+	while (!*flag) {
+		if (pthread_cond_timedwait(&st->cond, &st->lock, &deadline) != 0) {
+			break;
+		}
+	}
+	pthread_mutex_unlock(&st->lock);
+	return *flag ? 0 : -1;
+}
+
+static struct mosquitto *client_start(const char *id, struct bench_state *st)
+{
+	struct mosquitto *mosq;
+
+	state_reset(st);
+	mosq = mosquitto_new(id, true, st);
+	if (!mosq) {
+		return NULL;
+	}
+
+	mosquitto_connect_callback_set(mosq, on_connect);
+	mosquitto_subscribe_callback_set(mosq, on_subscribe);
+	mosquitto_publish_callback_set(mosq, on_publish);
+	mosquitto_message_callback_set(mosq, on_message);
+
+	if (mosquitto_connect(mosq, BENCH_HOST, CONFIG_EXAMPLES_MQTT_BENCH_PORT, 60) != MOSQ_ERR_SUCCESS || mosquitto_loop_start(mosq) != MOSQ_ERR_SUCCESS || wait_flag(st, &st->connected) < 0) {
+		mosquitto_destroy(mosq);
+		return NULL;
+	}
+	return mosq;
+}
+
+static void client_stop(struct mosquitto *mosq)
+{
+	mosquitto_disconnect(mosq);
+	mosquitto_destroy(mosq);
+}
+
+static int bench_run(const char *name, int qos, int inflight, int messages, int payload_len)
+{
+	struct mosquitto *pub = NULL;
+	struct mosquitto *sub = NULL;
+	unsigned long start;
+	unsigned long pub_usec;
+	unsigned long sub_usec;
+	int ret = -1;
+	int i;
+
+	sub = client_start("bench-sub", &g_sub_state);
+	if (!sub || mosquitto_subscribe(sub, NULL, BENCH_TOPIC, 1) != MOSQ_ERR_SUCCESS || wait_flag(&g_sub_state, &g_sub_state.subscribed) < 0) {
+		printf("  %-24s subscriber failed\n", name);
+		goto out;
+	}
+
+	pub = client_start("bench-pub", &g_pub_state);
+	if (!pub) {
+		printf("  %-24s publisher failed\n", name);
+		goto out;
+	}
+	mosquitto_max_inflight_messages_set(pub, inflight);
+
+	start = bench_usec();
+	for (i = 0; i < messages; i++) {
+		if (mosquitto_publish(pub, NULL, BENCH_TOPIC, payload_len, g_payload, qos, false) != MOSQ_ERR_SUCCESS) {
+			printf("  %-24s publish %d failed\n", name, i);
+			goto out;
+		}
+	}
+
+	if (state_wait(&g_pub_state, &g_pub_state.published, messages) < 0) {
+		printf("  %-24s %d of %d published\n", name, g_pub_state.published, messages);
+		goto out;
+	}
+	pub_usec = bench_usec() - start;
+
+	if (state_wait(&g_sub_state, &g_sub_state.received, messages) < 0) {
+		printf("  %-24s %d of %d delivered\n", name, g_sub_state.received, messages);
+		goto out;
+	}
+	sub_usec = bench_usec() - start;
+
+	printf("  %-24s %9lu msg/s published %9lu msg/s delivered\n", name, (unsigned long)(messages * 1000000.0 / (pub_usec ? pub_usec : 1)), (unsigned long)(messages * 1000000.0 / (sub_usec ? sub_usec : 1)));
+	ret = 0;
+
+out:
+	if (pub) {
+		client_stop(pub);
+	}
+	if (sub) {
+		client_stop(sub);
+	}
+	return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#if defined(MQTT_BENCH_HOST)
+int main(int argc, char *argv[])
+#elif defined(CONFIG_BUILD_KERNEL)
+int main(int argc, FAR char *argv[])
+#else
+int mqtt_bench_main(int argc, char *argv[])
+#endif
+{
+	int messages = BENCH_DEFAULT_MESSAGES;
+	int payload_len = BENCH_DEFAULT_PAYLOAD;
+	int ret = 0;
+
+	if (argc > 1) {
+		messages = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		payload_len = atoi(argv[2]);
+	}
+	if (messages <= 0 || payload_len < 0 || payload_len > BENCH_MAX_PAYLOAD) {
+		printf("usage: %s [messages] [payload bytes, <= %d]\n", argv[0], BENCH_MAX_PAYLOAD);
+		return 1;
+	}
+	memset(g_payload, 'x', payload_len);
+
+	pthread_mutex_init(&g_pub_state.lock, NULL);
+	pthread_cond_init(&g_pub_state.cond, NULL);
+	pthread_mutex_init(&g_sub_state.lock, NULL);
+	pthread_cond_init(&g_sub_state.cond, NULL);
+
+	mosquitto_lib_init();
+	if (broker_start(&g_broker) < 0) {
+		printf("mqtt_bench: cannot listen on %s:%d\n", BENCH_HOST, CONFIG_EXAMPLES_MQTT_BENCH_PORT);
+		return 1;
+	}
+
+	printf("mqtt_bench: %d messages of %d bytes\n", messages, payload_len);
+	ret |= bench_run("qos 0", 0, 0, messages, payload_len);
+	ret |= bench_run("qos 1, 20 in flight", 1, 20, messages, payload_len);
+	ret |= bench_run("qos 1, unbounded", 1, 0, messages, payload_len);
+
+	broker_stop(&g_broker);
+	mosquitto_lib_cleanup();
+
+	pthread_mutex_destroy(&g_pub_state.lock);
+	pthread_cond_destroy(&g_pub_state.cond);
+	pthread_mutex_destroy(&g_sub_state.lock);
+	pthread_cond_destroy(&g_sub_state.cond);
+	return ret ? 1 : 0;
+}
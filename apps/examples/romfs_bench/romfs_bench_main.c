@@ -0,0 +1,410 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * ROMFS benchmark.  A ROMFS image of CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS
+ * directories of CONFIG_EXAMPLES_ROMFS_BENCH_NFILES small files each is
+ * built in memory, as genromfs would lay it out.  It is mounted from a RAM
+ * disk, which romfs reads in place (XIP), then from a block driver that
+ * only reads sectors, and every file is served as a web server would:
+ * open(), read() in BENCH_CHUNK pieces, close().  On the XIP mount the
+ * files are also served through FIOC_MMAP, without any copy.
+ *
+ * The time to find each file grows with the size of its directory unless
+ * FS_ROMFS_DIRINDEX is enabled; the time to mount includes building that
+ * index.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/ioctl.h>
+#include <tinyara/fs/ramdisk.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS
+#define CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS 4
+#endif
+
+#ifndef CONFIG_EXAMPLES_ROMFS_BENCH_NFILES
+#define CONFIG_EXAMPLES_ROMFS_BENCH_NFILES 32
+#endif
+
+#ifndef CONFIG_EXAMPLES_ROMFS_BENCH_MAXFILESIZE
+#define CONFIG_EXAMPLES_ROMFS_BENCH_MAXFILESIZE 1024
+#endif
+
+#ifndef CONFIG_EXAMPLES_ROMFS_BENCH_MINOR
+#define CONFIG_EXAMPLES_ROMFS_BENCH_MINOR 6
+#endif
+
+#ifndef CONFIG_EXAMPLES_ROMFS_BENCH_PASSES
+#define CONFIG_EXAMPLES_ROMFS_BENCH_PASSES 4
+#endif
+
+#define BENCH_MINFILESIZE 64
+#define BENCH_SECTSIZE    512
+#define BENCH_CHUNK       512
+#define BENCH_VOLNAME     "romfs_bench"
+#define BENCH_BLKDEV      "/dev/romfsb"
+#define BENCH_MOUNTPT     "/mnt/romfsb"
+#define BENCH_PATHLEN     48
+
+/* The ROMFS format: 16 byte headers and names, big endian words */
+
+#define BENCH_ALIGN(n)    (((n) + 15) & ~15)
+#define BENCH_HARDLINK    0
+#define BENCH_DIRECTORY   1
+#define BENCH_FILE        2
+
+#define BENCH_IMAGESIZE \
+	(32 + 32 * (2 + CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS) + \
+	 CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS * (64 + CONFIG_EXAMPLES_ROMFS_BENCH_NFILES * \
+	 (32 + BENCH_ALIGN(CONFIG_EXAMPLES_ROMFS_BENCH_MAXFILESIZE))) + BENCH_SECTSIZE)
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static ssize_t bench_blkread(FAR struct inode *inode, FAR unsigned char *buffer, size_t start_sector, unsigned int nsectors);
+static int bench_blkgeometry(FAR struct inode *inode, FAR struct geometry *geometry);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* A block driver without ioctl(): romfs has to read it sector by sector */
+
+static const struct block_operations g_bench_bops = {
+	NULL,						/* open */
+	NULL,						/* close */
+	bench_blkread,				/* read */
+	NULL,						/* write */
+	bench_blkgeometry,			/* geometry */
+	NULL,						/* ioctl */
+	NULL						/* unlink */
+};
+
+static FAR uint8_t *g_image;
+static uint32_t g_nsectors;
+static uint32_t g_filesum;		/* Sum of the bytes of every file */
+static uint32_t g_filebytes;	/* Size of every file together */
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static ssize_t bench_blkread(FAR struct inode *inode, FAR unsigned char *buffer, size_t start_sector, unsigned int nsectors)
+{
+	if (start_sector + nsectors > g_nsectors) {
+		return -EINVAL;
+	}
+
+	memcpy(buffer, g_image + start_sector * BENCH_SECTSIZE, nsectors * BENCH_SECTSIZE);
+	return nsectors;
+}
+
+static int bench_blkgeometry(FAR struct inode *inode, FAR struct geometry *geometry)
+{
+	memset(geometry, 0, sizeof(struct geometry));
+	geometry->geo_available = true;
+	geometry->geo_nsectors = g_nsectors;
+	geometry->geo_sectorsize = BENCH_SECTSIZE;
+	return OK;
+}
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static void bench_put32(uint32_t offset, uint32_t value)
+{
+	g_image[offset] = value >> 24;
+	g_image[offset + 1] = value >> 16;
+	g_image[offset + 2] = value >> 8;
+	g_image[offset + 3] = value;
+}
+
+/* Write the header of an entry at offset, without its next link.  Return
+ * the offset following its name.  The checksums are left zero; romfs does
+ * not verify them.
+ */
+
+static uint32_t bench_entry(uint32_t offset, FAR const char *name, uint32_t info, uint32_t size)
+{
+	bench_put32(offset + 4, info);
+	bench_put32(offset + 8, size);
+	strcpy((FAR char *)g_image + offset + 16, name);
+	return offset + 16 + BENCH_ALIGN(strlen(name) + 1);
+}
+
+/* Lay out the image as genromfs does: "." and ".." first in each directory,
+ * a file's data right after its name.  Return the size of the volume.
+ */
+
+static uint32_t bench_mkimage(void)
+{
+	uint32_t dirent[CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS];
+	char name[16];
+	uint32_t seed = 1;
+	uint32_t offset;
+	uint32_t root;
+	uint32_t prev;
+	uint32_t size;
+	uint32_t i;
+	int mode;
+	int d;
+	int f;
+
+	memset(g_image, 0, BENCH_IMAGESIZE);
+	g_filesum = 0;
+	g_filebytes = 0;
+
+	/* The volume header: magic, size, checksum and name */
+
+	memcpy(g_image, "-rom1fs-", 8);
+	strcpy((FAR char *)g_image + 16, BENCH_VOLNAME);
+	offset = 16 + BENCH_ALIGN(sizeof(BENCH_VOLNAME));
+
+	/* The root: "." is the directory itself, ".." a hard link to it */
+
+	root = offset;
+	offset = bench_entry(root, ".", root, 0);
+	prev = offset;
+	offset = bench_entry(prev, "..", root, 0);
+	bench_put32(root, prev | BENCH_DIRECTORY);
+	mode = BENCH_HARDLINK;
+
+	for (d = 0; d < CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS; d++) {
+		dirent[d] = offset;
+		snprintf(name, sizeof(name), "dir%d", d);
+		offset = bench_entry(offset, name, 0, 0);
+		bench_put32(prev, dirent[d] | mode);
+		prev = dirent[d];
+		mode = BENCH_DIRECTORY;
+	}
+
+	bench_put32(prev, mode);
+
+	/* Each directory: "." and ".." hard links, then the files */
+
+	for (d = 0; d < CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS; d++) {
+		prev = offset;
+		bench_put32(dirent[d] + 4, prev);
+		offset = bench_entry(prev, ".", dirent[d], 0);
+		bench_put32(prev, offset | BENCH_HARDLINK);
+		prev = offset;
+		offset = bench_entry(prev, "..", root, 0);
+		mode = BENCH_HARDLINK;
+
+		for (f = 0; f < CONFIG_EXAMPLES_ROMFS_BENCH_NFILES; f++) {
+			seed = seed * 1103515245 + 12345;
+			size = BENCH_MINFILESIZE + (seed >> 16) % (CONFIG_EXAMPLES_ROMFS_BENCH_MAXFILESIZE - BENCH_MINFILESIZE + 1);
+
+			bench_put32(prev, offset | mode);
+			prev = offset;
+			snprintf(name, sizeof(name), "file%03d.htm", f);
+			offset = bench_entry(offset, name, 0, size);
+			mode = BENCH_FILE;
+
+			for (i = 0; i < size; i++) {
+				g_image[offset + i] = (uint8_t)(i + f + d);
+				g_filesum += g_image[offset + i];
+			}
+
+			g_filebytes += size;
+			offset += BENCH_ALIGN(size);
+		}
+
+		bench_put32(prev, mode);
+	}
+
+	bench_put32(8, offset);
+	return offset;
+}
+
+/* Serve every file once.  Return the sum of the bytes read, or 0 */
+
+static uint32_t bench_serve(bool mmap)
+{
+	char path[BENCH_PATHLEN];
+	uint8_t buffer[BENCH_CHUNK];
+	FAR uint8_t *addr;
+	uint32_t sum = 0;
+	ssize_t nread;
+	int fd;
+	int d;
+	int f;
+	int i;
+
+	for (d = 0; d < CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS; d++) {
+		for (f = 0; f < CONFIG_EXAMPLES_ROMFS_BENCH_NFILES; f++) {
+			snprintf(path, sizeof(path), BENCH_MOUNTPT "/dir%d/file%03d.htm", d, f);
+			fd = open(path, O_RDONLY);
+			if (fd < 0) {
+				printf("  open %s failed: %d\n", path, errno);
+				return 0;
+			}
+
+			if (mmap) {
+				nread = lseek(fd, 0, SEEK_END);
+				if (ioctl(fd, FIOC_MMAP, (unsigned long)&addr) < 0) {
+					printf("  FIOC_MMAP %s failed: %d\n", path, errno);
+					close(fd);
+					return 0;
+				}
+
+				for (i = 0; i < nread; i++) {
+					sum += addr[i];
+				}
+			} else {
+				while ((nread = read(fd, buffer, BENCH_CHUNK)) > 0) {
+					for (i = 0; i < nread; i++) {
+						sum += buffer[i];
+					}
+				}
+			}
+
+			close(fd);
+		}
+	}
+
+	return sum;
+}
+
+/* Mount source, serve every file CONFIG_EXAMPLES_ROMFS_BENCH_PASSES times
+ * and report the times.
+ */
+
+static int bench_run(FAR const char *label, FAR const char *source, bool mmap)
+{
+	unsigned long mountus;
+	unsigned long serveus;
+	uint32_t sum = 0;
+	int nfiles = CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS * CONFIG_EXAMPLES_ROMFS_BENCH_NFILES;
+	int pass;
+
+	mountus = bench_usec();
+	if (mount(source, BENCH_MOUNTPT, "romfs", MS_RDONLY, NULL) < 0) {
+		printf("  mount %s failed: %d\n", source, errno);
+		return -1;
+	}
+	mountus = bench_usec() - mountus;
+
+	serveus = bench_usec();
+	for (pass = 0; pass < CONFIG_EXAMPLES_ROMFS_BENCH_PASSES; pass++) {
+		sum = bench_serve(false);
+		if (sum != g_filesum) {
+			break;
+		}
+	}
+	serveus = bench_usec() - serveus;
+
+	printf("  %-16s mount %6lu us, read  %6lu us per file", label, mountus, serveus / (CONFIG_EXAMPLES_ROMFS_BENCH_PASSES * nfiles));
+	printf(sum == g_filesum ? "\n" : ", wrong data\n");
+
+	if (mmap) {
+		serveus = bench_usec();
+		for (pass = 0; pass < CONFIG_EXAMPLES_ROMFS_BENCH_PASSES; pass++) {
+			sum = bench_serve(true);
+			if (sum != g_filesum) {
+				break;
+			}
+		}
+		serveus = bench_usec() - serveus;
+
+		printf("  %-16s                  mmap  %6lu us per file", "", serveus / (CONFIG_EXAMPLES_ROMFS_BENCH_PASSES * nfiles));
+		printf(sum == g_filesum ? "\n" : ", wrong data\n");
+	}
+
+	umount(BENCH_MOUNTPT);
+	return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int romfs_bench_main(int argc, char *argv[])
+#endif
+{
+	char devname[16];
+	uint32_t volsize;
+	int ret;
+
+	g_image = (FAR uint8_t *)malloc(BENCH_IMAGESIZE);
+	if (g_image == NULL) {
+		printf("cannot allocate %d bytes for the image\n", BENCH_IMAGESIZE);
+		return -1;
+	}
+
+	volsize = bench_mkimage();
+	g_nsectors = (volsize + BENCH_SECTSIZE - 1) / BENCH_SECTSIZE;
+
+	printf("ROMFS, %d directories of %d files, %lu bytes of files in a %lu byte image, %d passes:\n", CONFIG_EXAMPLES_ROMFS_BENCH_NDIRS, CONFIG_EXAMPLES_ROMFS_BENCH_NFILES, (unsigned long)g_filebytes, (unsigned long)volsize, CONFIG_EXAMPLES_ROMFS_BENCH_PASSES);
+
+	/* In place, from a RAM disk */
+
+	ret = romdisk_register(CONFIG_EXAMPLES_ROMFS_BENCH_MINOR, g_image, g_nsectors, BENCH_SECTSIZE);
+	if (ret < 0) {
+		printf("romdisk_register failed: %d\n", ret);
+	} else {
+		snprintf(devname, sizeof(devname), "/dev/ram%d", CONFIG_EXAMPLES_ROMFS_BENCH_MINOR);
+		(void)bench_run("XIP", devname, true);
+		unregister_blockdriver(devname);
+	}
+
+	/* Sector by sector */
+
+	ret = register_blockdriver(BENCH_BLKDEV, &g_bench_bops, 0444, NULL);
+	if (ret < 0) {
+		printf("register_blockdriver failed: %d\n", ret);
+	} else {
+		(void)bench_run("sectors", BENCH_BLKDEV, false);
+		unregister_blockdriver(BENCH_BLKDEV);
+	}
+
+	free(g_image);
+	return 0;
+}
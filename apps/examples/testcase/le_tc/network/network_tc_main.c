@@ -83,6 +83,12 @@ int network_tc_main(int argc, char *argv[])
 #ifdef CONFIG_TC_NET_RECV
 	net_recv_main();
 #endif
+#ifdef CONFIG_TC_NET_RECV_ZC
+	net_recv_zc_main();
+#endif
+#ifdef CONFIG_TC_NET_SENDMSG
+	net_sendmsg_main();
+#endif
 #ifdef CONFIG_TC_NET_GETPEERNAME
 	net_getpeername_main();
 #endif
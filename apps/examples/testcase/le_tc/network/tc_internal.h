@@ -72,6 +72,12 @@ int net_send_main(void);
 #ifdef CONFIG_TC_NET_RECV
 int net_recv_main(void);
 #endif
+#ifdef CONFIG_TC_NET_RECV_ZC
+int net_recv_zc_main(void);
+#endif
+#ifdef CONFIG_TC_NET_SENDMSG
+int net_sendmsg_main(void);
+#endif
 #ifdef CONFIG_TC_NET_GETPEERNAME
 int net_getpeername_main(void);
 #endif
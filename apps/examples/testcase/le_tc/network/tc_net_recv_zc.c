@@ -0,0 +1,198 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+// @file tc_net_recv_zc.c
+// @brief Test Case Example for recv_zc() API
+#include <tinyara/config.h>
+#include <errno.h>
+#include <semaphore.h>
+#include "tc_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <pthread.h>
+
+#define PORTNUM 1110
+#define RECV_ZC_IOVCNT 4
+#define RECV_ZC_MSG "Hello World !\n"
+
+static sem_t g_recv_zc_sem;
+
+/**
+   * @fn                   :recv_zc_copy
+   * @brief                :gather the lent segments into a flat buffer
+   * @return               :number of bytes copied
+   */
+static int recv_zc_copy(char *buf, struct iovec *iov, int iovcnt)
+{
+	int off = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(buf + off, iov[i].iov_base, iov[i].iov_len);
+		off += iov[i].iov_len;
+	}
+	return off;
+}
+
+/**
+   * @testcase		   :tc_net_recv_zc_p
+   * @brief		   :data lent by recv_zc() matches what the peer sent
+   * @scenario		   :lend, consume a partial message, lend the rest again
+   * @apicovered	   :recv_zc(), recv_zc_release()
+   * @precondition	   :
+   * @postcondition	   :
+   */
+static void tc_net_recv_zc_p(int fd)
+{
+	struct iovec iov[RECV_ZC_IOVCNT];
+	char buffer[sizeof(RECV_ZC_MSG)];
+	int iovcnt = RECV_ZC_IOVCNT;
+	int len = strlen(RECV_ZC_MSG);
+	int ret;
+
+	ret = recv_zc(fd, iov, &iovcnt, 5, 0);
+	TC_ASSERT_EQ("recv_zc", ret, 5);
+	TC_ASSERT_EQ("recv_zc", recv_zc_copy(buffer, iov, iovcnt), 5);
+	TC_ASSERT_EQ("recv_zc", strncmp(buffer, RECV_ZC_MSG, 5), 0);
+
+	ret = recv_zc_release(fd, 5);
+	TC_ASSERT_EQ("recv_zc_release", ret, 0);
+
+	iovcnt = RECV_ZC_IOVCNT;
+	ret = recv_zc(fd, iov, &iovcnt, len - 5, 0);
+	TC_ASSERT_EQ("recv_zc", ret, len - 5);
+	TC_ASSERT_EQ("recv_zc", recv_zc_copy(buffer, iov, iovcnt), len - 5);
+	TC_ASSERT_EQ("recv_zc", strncmp(buffer, RECV_ZC_MSG + 5, len - 5), 0);
+
+	ret = recv_zc_release(fd, len - 5);
+	TC_ASSERT_EQ("recv_zc_release", ret, 0);
+	TC_SUCCESS_RESULT();
+}
+
+/**
+   * @testcase		   :tc_net_recv_zc_n
+   * @brief		   :invalid arguments are rejected
+   * @scenario		   :bad descriptor, empty iovec, over-release
+   * @apicovered	   :recv_zc(), recv_zc_release()
+   * @precondition	   :
+   * @postcondition	   :
+   */
+static void tc_net_recv_zc_n(int fd)
+{
+	struct iovec iov[RECV_ZC_IOVCNT];
+	int iovcnt = RECV_ZC_IOVCNT;
+	int ret;
+
+	ret = recv_zc(-1, iov, &iovcnt, sizeof(RECV_ZC_MSG), 0);
+	TC_ASSERT_EQ("recv_zc", ret, -1);
+
+	iovcnt = 0;
+	ret = recv_zc(fd, iov, &iovcnt, sizeof(RECV_ZC_MSG), 0);
+	TC_ASSERT_EQ("recv_zc", ret, -1);
+
+	ret = recv_zc_release(fd, 1);
+	TC_ASSERT_EQ("recv_zc_release", ret, -1);
+	TC_SUCCESS_RESULT();
+}
+
+/**
+   * @fn                   :recv_zc_server
+   * @brief                :
+   * @scenario             :
+   * API's covered         :socket,bind,listen,accept,send,close
+   * Preconditions         :
+   * Postconditions        :
+   * @return               :void *
+   */
+static void *recv_zc_server(void *args)
+{
+	struct sockaddr_in sa;
+	int SocketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	int ConnectFD;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = PF_INET;
+	sa.sin_port = htons(PORTNUM);
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	bind(SocketFD, (struct sockaddr *)&sa, sizeof(sa));
+	listen(SocketFD, 2);
+	sem_post(&g_recv_zc_sem);
+
+	ConnectFD = accept(SocketFD, NULL, NULL);
+	send(ConnectFD, RECV_ZC_MSG, strlen(RECV_ZC_MSG), 0);
+
+	/* wait for the client to finish before tearing down the connection */
+	sem_wait(&g_recv_zc_sem);
+	close(ConnectFD);
+	close(SocketFD);
+	return 0;
+}
+
+/**
+   * @fn                   :recv_zc_client
+   * @brief                :
+   * @scenario             :
+   * API's covered         :socket,connect,close
+   * Preconditions         :
+   * Postconditions        :
+   * @return               :void *
+   */
+static void *recv_zc_client(void *args)
+{
+	struct sockaddr_in dest;
+	int mysocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	memset(&dest, 0, sizeof(dest));
+	dest.sin_family = PF_INET;
+	dest.sin_addr.s_addr = inet_addr("127.0.0.1");
+	dest.sin_port = htons(PORTNUM);
+
+	sem_wait(&g_recv_zc_sem);
+	connect(mysocket, (struct sockaddr *)&dest, sizeof(struct sockaddr));
+	tc_net_recv_zc_p(mysocket);
+	tc_net_recv_zc_n(mysocket);
+	sem_post(&g_recv_zc_sem);
+	close(mysocket);
+	return 0;
+}
+
+/****************************************************************************
+ * Name: recv_zc()
+ ****************************************************************************/
+int net_recv_zc_main(void)
+{
+	pthread_t Server, Client;
+
+	sem_init(&g_recv_zc_sem, 0, 0);
+
+	pthread_create(&Server, NULL, recv_zc_server, NULL);
+	pthread_create(&Client, NULL, recv_zc_client, NULL);
+
+	pthread_join(Server, NULL);
+	pthread_join(Client, NULL);
+
+	sem_destroy(&g_recv_zc_sem);
+	return 0;
+}
@@ -0,0 +1,253 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+// @file tc_net_sendmsg.c
+// @brief Test Case Example for sendmsg() and send_zc() API
+#include <tinyara/config.h>
+#include <errno.h>
+#include <semaphore.h>
+#include "tc_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <pthread.h>
+#include <uio.h>
+
+#define PORTNUM 1116
+#define SENDMSG_HDR "Hello "
+#define SENDMSG_BODY "World !\n"
+#define SENDMSG_MSG SENDMSG_HDR SENDMSG_BODY
+
+static sem_t g_sendmsg_sem;
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+static sem_t g_send_zc_sem;
+static int g_send_zc_err;
+static const char g_send_zc_buf[] = SENDMSG_MSG;
+#endif
+
+/**
+   * @fn                   :sendmsg_recv_all
+   * @brief                :receive exactly len bytes
+   * @return               :number of bytes received
+   */
+static int sendmsg_recv_all(int fd, char *buf, int len)
+{
+	int off = 0;
+	int ret;
+
+	while (off < len) {
+		ret = recv(fd, buf + off, len - off, 0);
+		if (ret <= 0) {
+			break;
+		}
+		off += ret;
+	}
+	return off;
+}
+
+/**
+   * @testcase		   :tc_net_sendmsg_p
+   * @brief		   :sendmsg() gathers all iovec entries into the stream
+   * @scenario		   :send header and body as two entries
+   * @apicovered	   :sendmsg()
+   * @precondition	   :
+   * @postcondition	   :
+   */
+static void tc_net_sendmsg_p(int fd)
+{
+	struct iovec iov[2];
+	struct msghdr msg;
+	int ret;
+
+	iov[0].iov_base = SENDMSG_HDR;
+	iov[0].iov_len = strlen(SENDMSG_HDR);
+	iov[1].iov_base = SENDMSG_BODY;
+	iov[1].iov_len = strlen(SENDMSG_BODY);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+
+	ret = sendmsg(fd, &msg, 0);
+	TC_ASSERT_EQ("sendmsg", ret, strlen(SENDMSG_MSG));
+	TC_SUCCESS_RESULT();
+}
+
+/**
+   * @testcase		   :tc_net_sendmsg_n
+   * @brief		   :invalid arguments are rejected
+   * @scenario		   :bad descriptor, NULL msghdr
+   * @apicovered	   :sendmsg()
+   * @precondition	   :
+   * @postcondition	   :
+   */
+static void tc_net_sendmsg_n(int fd)
+{
+	struct iovec iov;
+	struct msghdr msg;
+	int ret;
+
+	iov.iov_base = SENDMSG_HDR;
+	iov.iov_len = strlen(SENDMSG_HDR);
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	ret = sendmsg(-1, &msg, 0);
+	TC_ASSERT_EQ("sendmsg", ret, -1);
+
+	ret = sendmsg(fd, NULL, 0);
+	TC_ASSERT_EQ("sendmsg", ret, -1);
+	TC_SUCCESS_RESULT();
+}
+
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+static void send_zc_done(void *arg, err_t err)
+{
+	g_send_zc_err = err;
+	sem_post(&g_send_zc_sem);
+}
+
+/**
+   * @testcase		   :tc_net_send_zc_p
+   * @brief		   :send_zc() reports completion once the data is acknowledged
+   * @scenario		   :send a static buffer by reference and wait for the callback
+   * @apicovered	   :send_zc()
+   * @precondition	   :
+   * @postcondition	   :
+   */
+static void tc_net_send_zc_p(int fd)
+{
+	int ret;
+
+	g_send_zc_err = -1;
+	ret = send_zc(fd, g_send_zc_buf, strlen(g_send_zc_buf), 0, send_zc_done, NULL);
+	TC_ASSERT_EQ("send_zc", ret, strlen(g_send_zc_buf));
+
+	sem_wait(&g_send_zc_sem);
+	TC_ASSERT_EQ("send_zc", g_send_zc_err, 0);
+	TC_SUCCESS_RESULT();
+}
+#endif
+
+/**
+   * @fn                   :sendmsg_server
+   * @brief                :
+   * @scenario             :
+   * API's covered         :socket,bind,listen,accept,recv,close
+   * Preconditions         :
+   * Postconditions        :
+   * @return               :void *
+   */
+static void *sendmsg_server(void *args)
+{
+	struct sockaddr_in sa;
+	char buffer[sizeof(SENDMSG_MSG)];
+	int len = strlen(SENDMSG_MSG);
+	int SocketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	int ConnectFD;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = PF_INET;
+	sa.sin_port = htons(PORTNUM);
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	bind(SocketFD, (struct sockaddr *)&sa, sizeof(sa));
+	listen(SocketFD, 2);
+	sem_post(&g_sendmsg_sem);
+
+	ConnectFD = accept(SocketFD, NULL, NULL);
+
+	memset(buffer, 0, sizeof(buffer));
+	if (sendmsg_recv_all(ConnectFD, buffer, len) != len || strncmp(buffer, SENDMSG_MSG, len) != 0) {
+		printf("\nsendmsg: received data mismatch\n");
+	}
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+	memset(buffer, 0, sizeof(buffer));
+	if (sendmsg_recv_all(ConnectFD, buffer, len) != len || strncmp(buffer, SENDMSG_MSG, len) != 0) {
+		printf("\nsend_zc: received data mismatch\n");
+	}
+#endif
+
+	/* wait for the client to finish before tearing down the connection */
+	sem_wait(&g_sendmsg_sem);
+	close(ConnectFD);
+	close(SocketFD);
+	return 0;
+}
+
+/**
+   * @fn                   :sendmsg_client
+   * @brief                :
+   * @scenario             :
+   * API's covered         :socket,connect,close
+   * Preconditions         :
+   * Postconditions        :
+   * @return               :void *
+   */
+static void *sendmsg_client(void *args)
+{
+	struct sockaddr_in dest;
+	int mysocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	memset(&dest, 0, sizeof(dest));
+	dest.sin_family = PF_INET;
+	dest.sin_addr.s_addr = inet_addr("127.0.0.1");
+	dest.sin_port = htons(PORTNUM);
+
+	sem_wait(&g_sendmsg_sem);
+	connect(mysocket, (struct sockaddr *)&dest, sizeof(struct sockaddr));
+	tc_net_sendmsg_p(mysocket);
+	tc_net_sendmsg_n(mysocket);
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+	tc_net_send_zc_p(mysocket);
+#endif
+	sem_post(&g_sendmsg_sem);
+	close(mysocket);
+	return 0;
+}
+
+/****************************************************************************
+ * Name: sendmsg()
+ ****************************************************************************/
+int net_sendmsg_main(void)
+{
+	pthread_t Server, Client;
+
+	sem_init(&g_sendmsg_sem, 0, 0);
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+	sem_init(&g_send_zc_sem, 0, 0);
+#endif
+
+	pthread_create(&Server, NULL, sendmsg_server, NULL);
+	pthread_create(&Client, NULL, sendmsg_client, NULL);
+
+	pthread_join(Server, NULL);
+	pthread_join(Client, NULL);
+
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+	sem_destroy(&g_send_zc_sem);
+#endif
+	sem_destroy(&g_sendmsg_sem);
+	return 0;
+}
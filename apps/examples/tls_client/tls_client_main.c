@@ -74,6 +74,9 @@
 #include "tls/error.h"
 #include "tls/debug.h"
 #include "tls/timing.h"
+#ifdef CONFIG_TLS_SESSION_STORE
+#include "tls/tls_session_store.h"
+#endif
 
 #ifdef CONFIG_EXAMPLES_TLS_ARTIK_KEY
 #include "tls/see_api.h"
@@ -128,6 +131,7 @@ struct pthread_arg {
 #define DFL_RECO_DELAY          0
 #define DFL_RECONNECT_HARD      0
 #define DFL_TICKETS             MBEDTLS_SSL_SESSION_TICKETS_ENABLED
+#define DFL_SESSION_STORE       0
 #define DFL_ALPN_STRING         NULL
 #define DFL_TRANSPORT           MBEDTLS_SSL_TRANSPORT_STREAM
 #define DFL_HS_TO_MIN           0
@@ -172,6 +176,13 @@ struct pthread_arg {
 #define USAGE_TICKETS ""
 #endif							/* MBEDTLS_SSL_SESSION_TICKETS */
 
+#if defined(CONFIG_TLS_SESSION_STORE)
+#define USAGE_SESSION_STORE                                 \
+	"    session_store=%%d    default: 0 (1: resume from and save to the TLS session store)\n"
+#else
+#define USAGE_SESSION_STORE ""
+#endif							/* CONFIG_TLS_SESSION_STORE */
+
 #if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
 #define USAGE_TRUNC_HMAC                                    \
 	"    trunc_hmac=%%d       default: library default\n"
@@ -284,6 +295,7 @@ struct pthread_arg {
 	"    reconnect=%%d        default: 0 (disabled)\n"      \
 	"    reco_delay=%%d       default: 0 seconds\n"         \
 	"    reconnect_hard=%%d   default: 0 (disabled)\n"      \
+	USAGE_SESSION_STORE                                     \
 	USAGE_TICKETS                                           \
 	USAGE_MAX_FRAG_LEN                                      \
 	USAGE_TRUNC_HMAC                                        \
@@ -338,6 +350,7 @@ struct options {
 	int reco_delay;				/* delay in seconds before resuming session */
 	int reconnect_hard;			/* unexpectedly reconnect from the same port */
 	int tickets;				/* enable / disable session tickets         */
+	int session_store;			/* use the TLS session store                */
 	const char *alpn_string;	/* ALPN supported protocols                 */
 	int transport;				/* TLS or DTLS?                             */
 	uint32_t hs_to_min;			/* Initial value of DTLS handshake timer    */
@@ -347,6 +360,40 @@ struct options {
 	int etm;					/* negotiate encrypt then mac?              */
 } opt;
 
+#if defined(MBEDTLS_TIMING_C)
+/*
+ * Wall time and heap in use around one handshake, so that full and resumed
+ * handshakes (reconnect=N, session_store=1) can be compared.
+ */
+struct hs_bench {
+	struct mbedtls_timing_hr_time timer;
+	int heap_before;
+	size_t offered;
+	unsigned char master[48];
+};
+
+static void hs_bench_start(struct hs_bench *b, const mbedtls_ssl_context *ssl)
+{
+	/* a resumed session keeps the master secret of the offered one */
+	b->offered = ssl->session_negotiate->id_len;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_CLI_C)
+	b->offered += ssl->session_negotiate->ticket_len;
+#endif
+	memcpy(b->master, ssl->session_negotiate->master, sizeof(b->master));
+	b->heap_before = mallinfo().uordblks;
+	(void)mbedtls_timing_get_timer(&b->timer, 1);
+}
+
+static void hs_bench_report(struct hs_bench *b, const mbedtls_ssl_context *ssl)
+{
+	unsigned long ms = mbedtls_timing_get_timer(&b->timer, 0);
+	int heap = mallinfo().uordblks;
+	int resumed = b->offered != 0 && memcmp(b->master, ssl->session->master, sizeof(b->master)) == 0;
+
+	mbedtls_printf("    [ %s handshake took %lu ms, heap in use %d bytes (%+d) ]\n", resumed ? "Resumed" : "Full", ms, heap, heap - b->heap_before);
+}
+#endif
+
 static void my_debug(void *ctx, int level, const char *file, int line, const char *str)
 {
 	const char *p;
@@ -457,6 +504,7 @@ int tls_client_cb(void *args)
 	mbedtls_ssl_session saved_session;
 #if defined(MBEDTLS_TIMING_C)
 	mbedtls_timing_delay_context *timer;
+	struct hs_bench bench;
 #endif
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
 	uint32_t flags;
@@ -545,6 +593,7 @@ usage:
 	opt.reco_delay = DFL_RECO_DELAY;
 	opt.reconnect_hard = DFL_RECONNECT_HARD;
 	opt.tickets = DFL_TICKETS;
+	opt.session_store = DFL_SESSION_STORE;
 	opt.alpn_string = DFL_ALPN_STRING;
 	opt.transport = DFL_TRANSPORT;
 	opt.hs_to_min = DFL_HS_TO_MIN;
@@ -667,6 +716,11 @@ usage:
 			if (opt.tickets < 0 || opt.tickets > 2) {
 				goto usage;
 			}
+		} else if (strcmp(p, "session_store") == 0) {
+			opt.session_store = atoi(q);
+			if (opt.session_store < 0 || opt.session_store > 1) {
+				goto usage;
+			}
 		} else if (strcmp(p, "alpn") == 0) {
 			opt.alpn_string = q;
 		} else if (strcmp(p, "fallback") == 0) {
@@ -1222,12 +1276,21 @@ usage:
 #endif
 	mbedtls_printf(" ok\n");
 
+#if defined(CONFIG_TLS_SESSION_STORE)
+	if (opt.session_store && tls_session_store_load(opt.server_name, (unsigned short)atoi(opt.server_port), &ssl) == 0) {
+		mbedtls_printf("  . Offering session from the session store\n");
+	}
+#endif
+
 	/*
 	 * 4. Handshake
 	 */
 	mbedtls_printf("  . Performing the SSL/TLS handshake...");
 	fflush(stdout);
 
+#if defined(MBEDTLS_TIMING_C)
+	hs_bench_start(&bench, &ssl);
+#endif
 	while ((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
 		if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
 			mbedtls_printf(" failed\n  ! mbedtls_ssl_handshake returned -0x%x\n", -ret);
@@ -1235,11 +1298,24 @@ usage:
 				mbedtls_printf("    Unable to verify the server's certificate. " "Either it is invalid,\n" "    or you didn't set ca_file or ca_path " "to an appropriate value.\n" "    Alternatively, you may want to use " "auth_mode=optional for testing purposes.\n");
 			}
 			mbedtls_printf("\n");
+#if defined(CONFIG_TLS_SESSION_STORE)
+			if (opt.session_store) {
+				tls_session_store_remove(opt.server_name, (unsigned short)atoi(opt.server_port));
+			}
+#endif
 			goto exit;
 		}
 	}
 
 	mbedtls_printf(" ok\n    [ Protocol is %s ]\n    [ Ciphersuite is %s ]\n", mbedtls_ssl_get_version(&ssl), mbedtls_ssl_get_ciphersuite(&ssl));
+#if defined(MBEDTLS_TIMING_C)
+	hs_bench_report(&bench, &ssl);
+#endif
+#if defined(CONFIG_TLS_SESSION_STORE)
+	if (opt.session_store) {
+		tls_session_store_save(opt.server_name, (unsigned short)atoi(opt.server_port), &ssl);
+	}
+#endif
 
 	if ((ret = mbedtls_ssl_get_record_expansion(&ssl)) >= 0) {
 		mbedtls_printf("    [ Record expansion is %d ]\n", ret);
@@ -1480,6 +1556,9 @@ send_request:
 			goto exit;
 		}
 
+#if defined(MBEDTLS_TIMING_C)
+		hs_bench_start(&bench, &ssl);
+#endif
 		while ((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
 			if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
 				mbedtls_printf(" failed\n  ! mbedtls_ssl_handshake returned -0x%x\n\n", -ret);
@@ -1488,6 +1567,9 @@ send_request:
 		}
 
 		mbedtls_printf(" ok\n");
+#if defined(MBEDTLS_TIMING_C)
+		hs_bench_report(&bench, &ssl);
+#endif
 
 		goto send_request;
 	}
@@ -1560,6 +1642,9 @@ reconnect:
 			goto exit;
 		}
 
+#if defined(MBEDTLS_TIMING_C)
+		hs_bench_start(&bench, &ssl);
+#endif
 		while ((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
 			if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
 				mbedtls_printf(" failed\n  ! mbedtls_ssl_handshake returned -0x%x\n\n", -ret);
@@ -1568,6 +1653,9 @@ reconnect:
 		}
 
 		mbedtls_printf(" ok\n");
+#if defined(MBEDTLS_TIMING_C)
+		hs_bench_report(&bench, &ssl);
+#endif
 
 		goto send_request;
 	}
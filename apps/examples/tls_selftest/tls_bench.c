@@ -0,0 +1,342 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * P-256 benchmark: ECDHE, ECDSA sign/verify and a full ECDHE-ECDSA
+ * handshake between a client and a server in the same thread.
+ *
+ * It only uses mbedTLS, so the same file runs from tls_selftest on the
+ * target and natively on the host (see Makefile.host), which makes it easy
+ * to compare the bignum/ECP changes before flashing a board.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tls/config.h"
+#include "tls/entropy.h"
+#include "tls/ctr_drbg.h"
+#include "tls/ecdh.h"
+#include "tls/ecdsa.h"
+#include "tls/certs.h"
+#include "tls/x509_crt.h"
+#include "tls/pk.h"
+#include "tls/ssl.h"
+#include "tls/timing.h"
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED) && \
+	defined(MBEDTLS_TIMING_C) && defined(MBEDTLS_CTR_DRBG_C) && defined(MBEDTLS_ENTROPY_C)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_PIPE_SIZE			4096
+#define BENCH_HANDSHAKE_ROUNDS	64
+
+#define BENCH_CHK(f)								\
+	do {											\
+		if ((ret = (f)) != 0) {						\
+			printf("  ! %s returned -0x%04x\n", #f, -ret); \
+			goto cleanup;							\
+		}											\
+	} while (0)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One direction of the in-memory connection */
+struct bench_pipe {
+	unsigned char buf[BENCH_PIPE_SIZE];
+	size_t len;
+};
+
+struct bench_end {
+	struct bench_pipe *in;
+	struct bench_pipe *out;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int bench_send(void *ctx, const unsigned char *buf, size_t len)
+{
+	struct bench_end *end = ctx;
+	size_t room = BENCH_PIPE_SIZE - end->out->len;
+
+	if (room == 0) {
+		return MBEDTLS_ERR_SSL_WANT_WRITE;
+	}
+	if (len > room) {
+		len = room;
+	}
+	memcpy(end->out->buf + end->out->len, buf, len);
+	end->out->len += len;
+	return (int)len;
+}
+
+static int bench_recv(void *ctx, unsigned char *buf, size_t len)
+{
+	struct bench_end *end = ctx;
+
+	if (end->in->len == 0) {
+		return MBEDTLS_ERR_SSL_WANT_READ;
+	}
+	if (len > end->in->len) {
+		len = end->in->len;
+	}
+	memcpy(buf, end->in->buf, len);
+	memmove(end->in->buf, end->in->buf + len, end->in->len - len);
+	end->in->len -= len;
+	return (int)len;
+}
+
+static void bench_report(const char *name, unsigned long ms, int iterations)
+{
+	unsigned long tenth = ms * 10 / iterations;
+
+	printf("  %-36s: %5lu.%lu ms/op\n", name, tenth / 10, tenth % 10);
+}
+
+/* ECDHE as a TLS peer does it: a fresh group, a key pair and the secret */
+static int bench_ecdh(mbedtls_ctr_drbg_context *drbg, const mbedtls_ecp_point *peer, int iterations)
+{
+	struct mbedtls_timing_hr_time timer;
+	mbedtls_ecdh_context ecdh;
+	int ret = 0;
+	int i;
+
+	(void)mbedtls_timing_get_timer(&timer, 1);
+	for (i = 0; i < iterations; i++) {
+		mbedtls_ecdh_init(&ecdh);
+		BENCH_CHK(mbedtls_ecp_group_load(&ecdh.grp, MBEDTLS_ECP_DP_SECP256R1));
+		BENCH_CHK(mbedtls_ecdh_gen_public(&ecdh.grp, &ecdh.d, &ecdh.Q, mbedtls_ctr_drbg_random, drbg));
+		BENCH_CHK(mbedtls_ecdh_compute_shared(&ecdh.grp, &ecdh.z, peer, &ecdh.d, mbedtls_ctr_drbg_random, drbg));
+		mbedtls_ecdh_free(&ecdh);
+	}
+	bench_report("P-256 ECDHE (keygen + shared secret)", mbedtls_timing_get_timer(&timer, 0), iterations);
+	return 0;
+
+cleanup:
+	mbedtls_ecdh_free(&ecdh);
+	return ret;
+}
+
+static int bench_ecdsa(mbedtls_ctr_drbg_context *drbg, mbedtls_ecdsa_context *key, int iterations)
+{
+	struct mbedtls_timing_hr_time timer;
+	unsigned char hash[32];
+	mbedtls_mpi r, s;
+	int ret = 0;
+	int i;
+
+	mbedtls_mpi_init(&r);
+	mbedtls_mpi_init(&s);
+	memset(hash, 0x5a, sizeof(hash));
+
+	(void)mbedtls_timing_get_timer(&timer, 1);
+	for (i = 0; i < iterations; i++) {
+		BENCH_CHK(mbedtls_ecdsa_sign(&key->grp, &r, &s, &key->d, hash, sizeof(hash), mbedtls_ctr_drbg_random, drbg));
+	}
+	bench_report("P-256 ECDSA sign", mbedtls_timing_get_timer(&timer, 0), iterations);
+
+	(void)mbedtls_timing_get_timer(&timer, 1);
+	for (i = 0; i < iterations; i++) {
+		BENCH_CHK(mbedtls_ecdsa_verify(&key->grp, hash, sizeof(hash), &key->Q, &r, &s));
+	}
+	bench_report("P-256 ECDSA verify", mbedtls_timing_get_timer(&timer, 0), iterations);
+
+cleanup:
+	mbedtls_mpi_free(&r);
+	mbedtls_mpi_free(&s);
+	return ret;
+}
+
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && \
+	defined(MBEDTLS_CERTS_C) && defined(MBEDTLS_PEM_PARSE_C)
+static int bench_handshake(mbedtls_ctr_drbg_context *drbg, int iterations)
+{
+	static const mbedtls_ecp_group_id curves[] = { MBEDTLS_ECP_DP_SECP256R1, MBEDTLS_ECP_DP_NONE };
+	struct mbedtls_timing_hr_time timer;
+	struct bench_pipe *c2s;
+	struct bench_pipe *s2c;
+	struct bench_end cli_end;
+	struct bench_end srv_end;
+	mbedtls_ssl_config cli_conf, srv_conf;
+	mbedtls_ssl_context cli, srv;
+	mbedtls_x509_crt ca, crt;
+	mbedtls_pk_context pkey;
+	unsigned long ms = 0;
+	int rounds;
+	int rc, rs;
+	int ret = 0;
+	int i;
+
+	mbedtls_ssl_config_init(&cli_conf);
+	mbedtls_ssl_config_init(&srv_conf);
+	mbedtls_ssl_init(&cli);
+	mbedtls_ssl_init(&srv);
+	mbedtls_x509_crt_init(&ca);
+	mbedtls_x509_crt_init(&crt);
+	mbedtls_pk_init(&pkey);
+
+	c2s = malloc(sizeof(struct bench_pipe));
+	s2c = malloc(sizeof(struct bench_pipe));
+	if (c2s == NULL || s2c == NULL) {
+		printf("  ! out of memory\n");
+		ret = -1;
+		goto cleanup;
+	}
+	cli_end.in = s2c;
+	cli_end.out = c2s;
+	srv_end.in = c2s;
+	srv_end.out = s2c;
+
+	BENCH_CHK(mbedtls_x509_crt_parse(&ca, (const unsigned char *)mbedtls_test_ca_crt_ec, mbedtls_test_ca_crt_ec_len));
+	BENCH_CHK(mbedtls_x509_crt_parse(&crt, (const unsigned char *)mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len));
+	BENCH_CHK(mbedtls_pk_parse_key(&pkey, (const unsigned char *)mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len, NULL, 0));
+
+	BENCH_CHK(mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT));
+	BENCH_CHK(mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT));
+	mbedtls_ssl_conf_rng(&cli_conf, mbedtls_ctr_drbg_random, drbg);
+	mbedtls_ssl_conf_rng(&srv_conf, mbedtls_ctr_drbg_random, drbg);
+	mbedtls_ssl_conf_curves(&cli_conf, curves);
+	mbedtls_ssl_conf_curves(&srv_conf, curves);
+
+	/* the test certificates may have expired: verify, but do not fail */
+	mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+	mbedtls_ssl_conf_ca_chain(&cli_conf, &ca, NULL);
+	BENCH_CHK(mbedtls_ssl_conf_own_cert(&srv_conf, &crt, &pkey));
+
+	for (i = 0; i < iterations; i++) {
+		c2s->len = 0;
+		s2c->len = 0;
+		BENCH_CHK(mbedtls_ssl_setup(&cli, &cli_conf));
+		BENCH_CHK(mbedtls_ssl_setup(&srv, &srv_conf));
+		BENCH_CHK(mbedtls_ssl_set_hostname(&cli, "localhost"));
+		mbedtls_ssl_set_bio(&cli, &cli_end, bench_send, bench_recv, NULL);
+		mbedtls_ssl_set_bio(&srv, &srv_end, bench_send, bench_recv, NULL);
+
+		(void)mbedtls_timing_get_timer(&timer, 1);
+		rounds = 0;
+		do {
+			rc = mbedtls_ssl_handshake(&cli);
+			if (rc != 0 && rc != MBEDTLS_ERR_SSL_WANT_READ && rc != MBEDTLS_ERR_SSL_WANT_WRITE) {
+				printf("  ! client handshake returned -0x%04x\n", -rc);
+				ret = rc;
+				goto cleanup;
+			}
+			rs = mbedtls_ssl_handshake(&srv);
+			if (rs != 0 && rs != MBEDTLS_ERR_SSL_WANT_READ && rs != MBEDTLS_ERR_SSL_WANT_WRITE) {
+				printf("  ! server handshake returned -0x%04x\n", -rs);
+				ret = rs;
+				goto cleanup;
+			}
+			if (++rounds > BENCH_HANDSHAKE_ROUNDS) {
+				printf("  ! handshake does not progress\n");
+				ret = -1;
+				goto cleanup;
+			}
+		} while (rc != 0 || rs != 0);
+		ms += mbedtls_timing_get_timer(&timer, 0);
+
+		if (i == 0) {
+			printf("  [ %s ]\n", mbedtls_ssl_get_ciphersuite(&cli));
+		}
+		mbedtls_ssl_free(&cli);
+		mbedtls_ssl_free(&srv);
+		mbedtls_ssl_init(&cli);
+		mbedtls_ssl_init(&srv);
+	}
+	bench_report("ECDHE-ECDSA handshake (both ends)", ms, iterations);
+
+cleanup:
+	mbedtls_ssl_free(&cli);
+	mbedtls_ssl_free(&srv);
+	mbedtls_ssl_config_free(&cli_conf);
+	mbedtls_ssl_config_free(&srv_conf);
+	mbedtls_x509_crt_free(&ca);
+	mbedtls_x509_crt_free(&crt);
+	mbedtls_pk_free(&pkey);
+	free(c2s);
+	free(s2c);
+	return ret;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int tls_bench_main(int iterations)
+{
+	static const char pers[] = "tls_bench";
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context drbg;
+	mbedtls_ecdsa_context key;
+	int ret;
+
+	if (iterations <= 0) {
+		iterations = 1;
+	}
+
+	mbedtls_entropy_init(&entropy);
+	mbedtls_ctr_drbg_init(&drbg);
+	mbedtls_ecdsa_init(&key);
+
+	printf("\n  . TLS benchmark, %d iterations\n", iterations);
+
+	BENCH_CHK(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, (const unsigned char *)pers, sizeof(pers) - 1));
+	BENCH_CHK(mbedtls_ecdsa_genkey(&key, MBEDTLS_ECP_DP_SECP256R1, mbedtls_ctr_drbg_random, &drbg));
+
+	BENCH_CHK(bench_ecdh(&drbg, &key.Q, iterations));
+	BENCH_CHK(bench_ecdsa(&drbg, &key, iterations));
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && \
+	defined(MBEDTLS_CERTS_C) && defined(MBEDTLS_PEM_PARSE_C)
+	BENCH_CHK(bench_handshake(&drbg, iterations));
+#endif
+
+cleanup:
+	mbedtls_ecdsa_free(&key);
+	mbedtls_ctr_drbg_free(&drbg);
+	mbedtls_entropy_free(&entropy);
+
+	printf("  [ %s ]\n\n", ret == 0 ? "Done" : "Failed");
+	return ret;
+}
+
+#else
+
+int tls_bench_main(int iterations)
+{
+	(void)iterations;
+	printf("tls_bench: needs ECDH, ECDSA, P-256, TIMING, CTR_DRBG and ENTROPY\n");
+	return -1;
+}
+
+#endif
+
+#ifdef TLS_BENCH_HOST
+int main(int argc, char **argv)
+{
+	return tls_bench_main(argc > 1 ? atoi(argv[1]) : 10) == 0 ? 0 : 1;
+}
+#endif
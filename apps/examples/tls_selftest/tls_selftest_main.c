@@ -64,6 +64,7 @@
 #include "tls/timing.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define mbedtls_printf     printf
@@ -74,6 +75,18 @@
 #define TLS_SELFTEST_STACK_SIZE   51200
 #define TLS_SELFTEST_SCHED_POLICY SCHED_RR
 
+#define TLS_BENCH_ITERATIONS      10
+
+#ifdef CONFIG_EXAMPLES_TLS_BENCH
+int tls_bench_main(int iterations);
+
+pthread_addr_t tls_bench_cb(void *args)
+{
+	tls_bench_main((int)args);
+	return NULL;
+}
+#endif
+
 
 #define DO_TLS_TEST(func, v) \
 if ((ret = func(v)) != 0) { \
@@ -210,8 +223,17 @@ int tls_selftest_main(int argc, char **argv)
 	pthread_t tid;
 	pthread_attr_t attr;
 	struct sched_param sparam;
+	pthread_startroutine_t entry = tls_selftest_cb;
+	void *arg = NULL;
 	int r;
 
+#ifdef CONFIG_EXAMPLES_TLS_BENCH
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		entry = tls_bench_cb;
+		arg = (void *)(argc > 2 ? atoi(argv[2]) : TLS_BENCH_ITERATIONS);
+	}
+#endif
+
 	/* Initialize the attribute variable */
 	if ((r = pthread_attr_init(&attr)) != 0) {
 		printf("%s: pthread_attr_init failed, status=%d\n", __func__, r);
@@ -233,7 +255,7 @@ int tls_selftest_main(int argc, char **argv)
 	}
 
 	/* 3. create pthread with entry function */
-	if ((r = pthread_create(&tid, &attr, tls_selftest_cb, (void *)0)) != 0) {
+	if ((r = pthread_create(&tid, &attr, entry, arg)) != 0) {
 		printf("%s: pthread_create failed, status=%d\n", __func__, r);
 	}
 
@@ -0,0 +1,212 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Path lookup benchmark.  CONFIG_EXAMPLES_VFS_BENCH_NDRIVERS drivers that
+ * do nothing are registered in /dev, and as many again three levels below
+ * it, so that the peer lists of the inode tree are as long as those of a
+ * board with many devices.  Then open() and close(), and stat(), are timed
+ * on the last of them, on /proc/uptime when procfs is mounted, and on a
+ * path that does not exist.
+ *
+ * The time of each operation is mostly that of finding the inode of the
+ * path, which FS_INODE_CACHE shortens.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <tinyara/fs/fs.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_VFS_BENCH_NDRIVERS
+#define CONFIG_EXAMPLES_VFS_BENCH_NDRIVERS 24
+#endif
+
+#ifndef CONFIG_EXAMPLES_VFS_BENCH_ITERATIONS
+#define CONFIG_EXAMPLES_VFS_BENCH_ITERATIONS 2000
+#endif
+
+#define BENCH_SHALLOW   "/dev/vfsb%02d"
+#define BENCH_DEEP      "/dev/vfsbench/bus0/port1/dev%02d"
+#define BENCH_MISSING   "/dev/vfsbench/bus0/port1/none"
+#define BENCH_PROCFILE  "/proc/uptime"
+#define BENCH_PATHLEN   48
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int bench_drvopen(FAR struct file *filep);
+static int bench_drvclose(FAR struct file *filep);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct file_operations g_bench_fops = {
+	bench_drvopen,				/* open */
+	bench_drvclose,				/* close */
+	NULL,						/* read */
+	NULL,						/* write */
+	NULL,						/* seek */
+	NULL						/* ioctl */
+#ifndef CONFIG_DISABLE_POLL
+	, NULL						/* poll */
+#endif
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int bench_drvopen(FAR struct file *filep)
+{
+	return OK;
+}
+
+static int bench_drvclose(FAR struct file *filep)
+{
+	return OK;
+}
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static int bench_register(bool add)
+{
+	char path[BENCH_PATHLEN];
+	int ret = OK;
+	int i;
+
+	for (i = 0; i < CONFIG_EXAMPLES_VFS_BENCH_NDRIVERS && ret == OK; i++) {
+		snprintf(path, sizeof(path), BENCH_SHALLOW, i);
+		ret = add ? register_driver(path, &g_bench_fops, 0666, NULL) : unregister_driver(path);
+		if (ret == OK) {
+			snprintf(path, sizeof(path), BENCH_DEEP, i);
+			ret = add ? register_driver(path, &g_bench_fops, 0666, NULL) : unregister_driver(path);
+		}
+	}
+
+	return ret;
+}
+
+/* Time open() and close(), then stat(), of path.  A path that does not
+ * exist is expected to fail.
+ */
+
+static void bench_path(FAR const char *path, bool exists)
+{
+	struct stat st;
+	unsigned long opus;
+	unsigned long stus;
+	int fd;
+	int i;
+
+	opus = bench_usec();
+	for (i = 0; i < CONFIG_EXAMPLES_VFS_BENCH_ITERATIONS; i++) {
+		fd = open(path, O_RDONLY);
+		if ((fd >= 0) != exists) {
+			printf("  %s: open failed: %d\n", path, errno);
+			return;
+		}
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+	opus = bench_usec() - opus;
+
+	stus = bench_usec();
+	for (i = 0; i < CONFIG_EXAMPLES_VFS_BENCH_ITERATIONS; i++) {
+		if ((stat(path, &st) == 0) != exists) {
+			printf("  %s: stat failed: %d\n", path, errno);
+			return;
+		}
+	}
+	stus = bench_usec() - stus;
+
+	printf("  %-36s open+close %6lu ns, stat %6lu ns\n", path, opus * 1000 / CONFIG_EXAMPLES_VFS_BENCH_ITERATIONS, stus * 1000 / CONFIG_EXAMPLES_VFS_BENCH_ITERATIONS);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int vfs_bench_main(int argc, char *argv[])
+#endif
+{
+	char path[BENCH_PATHLEN];
+	struct stat st;
+#ifdef CONFIG_FS_INODE_CACHE
+	struct inode_cachestats_s before;
+	struct inode_cachestats_s after;
+#endif
+
+	if (bench_register(true) != OK) {
+		printf("cannot register the drivers\n");
+		(void)bench_register(false);
+		return -1;
+	}
+
+	printf("Path lookup, %d drivers in /dev and below, %d iterations:\n", 2 * CONFIG_EXAMPLES_VFS_BENCH_NDRIVERS, CONFIG_EXAMPLES_VFS_BENCH_ITERATIONS);
+#ifdef CONFIG_FS_INODE_CACHE
+	inode_getcachestats(&before);
+#endif
+
+	snprintf(path, sizeof(path), BENCH_SHALLOW, CONFIG_EXAMPLES_VFS_BENCH_NDRIVERS - 1);
+	bench_path(path, true);
+	snprintf(path, sizeof(path), BENCH_DEEP, CONFIG_EXAMPLES_VFS_BENCH_NDRIVERS - 1);
+	bench_path(path, true);
+	if (stat(BENCH_PROCFILE, &st) == 0) {
+		bench_path(BENCH_PROCFILE, true);
+	}
+	bench_path(BENCH_MISSING, false);
+
+#ifdef CONFIG_FS_INODE_CACHE
+	inode_getcachestats(&after);
+	printf("  lookup cache: %lu hits, %lu misses, %lu flushes\n", (unsigned long)(after.hits - before.hits), (unsigned long)(after.misses - before.misses), (unsigned long)(after.flushes - before.flushes));
+#endif
+
+	(void)bench_register(false);
+	return 0;
+}
@@ -0,0 +1,505 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * wslay benchmark: pushes binary messages of 16 B to 64 KB through
+ * wslay_event_send() as a server (unmasked) and as a client (masked), once
+ * copied into the queue with wslay_event_queue_msg() and once by reference
+ * with wslay_event_queue_msg_ref(), and receives the masked stream back on
+ * a server context. The "socket" is a memory sink that copies what it is
+ * given, as the network stack would.
+ *
+ * Before timing anything, messages of every length up to a few hundred
+ * bytes, sent from unaligned buffers, are looped back through a peer
+ * context and compared with what was sent.
+ *
+ * Only the wslay sources are used, so the same file runs on the target and
+ * natively on the host (see Makefile.host).
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#ifndef WSLAY_BENCH_HOST
+#include <tinyara/config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <apps/netutils/wslay/wslay.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_KBYTES 1024	/* Payload sent per size and mode */
+#define BENCH_SINK_SIZE      16384
+#define BENCH_MAX_MSG        65536
+#define BENCH_VERIFY_MAX     300	/* Every length up to this is checked */
+#define BENCH_STREAM_SIZE    (256 * 1024)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Handed to the contexts as user_data; wslay_event_context_free() frees
+ * it.
+ */
+
+struct bench_peer {
+	const uint8_t *in;			/* Stream returned by the recv callback */
+	size_t in_len;
+	size_t in_pos;
+	unsigned long in_rounds;	/* Times the stream is replayed */
+	uint8_t *capture;			/* Sent bytes are appended here if set */
+	size_t capture_len;
+	size_t capture_size;
+	unsigned long send_calls;
+	unsigned long msgs;
+	unsigned long freed;
+	const uint8_t *expect;		/* Checked against received messages */
+	size_t expect_len;
+	int mismatch;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const size_t g_sizes[] = { 16, 128, 1024, 4096, 16384, 65536 };
+
+static uint8_t g_sink[BENCH_SINK_SIZE];
+static size_t g_sink_pos;
+static uint8_t *g_payload;
+static uint8_t *g_stream;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef WSLAY_BENCH_HOST
+/* wslay_event.c reports a received close frame here */
+
+void websocket_update_state(void *websocket, int state)
+{
+}
+#endif
+
+static unsigned long bench_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static void bench_sink(struct bench_peer *p, const uint8_t *data, size_t len)
+{
+	size_t n;
+
+	if (p->capture) {
+		if (p->capture_len + len <= p->capture_size) {
+			memcpy(p->capture + p->capture_len, data, len);
+		}
+		p->capture_len += len;
+		return;
+	}
+
+	while (len > 0) {
+		n = BENCH_SINK_SIZE - g_sink_pos;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(g_sink + g_sink_pos, data, n);
+		g_sink_pos = (g_sink_pos + n) % BENCH_SINK_SIZE;
+		data += n;
+		len -= n;
+	}
+}
+
+static ssize_t bench_send_cb(wslay_event_context_ptr ctx, const uint8_t *data, size_t len, int flags, void *user_data)
+{
+	struct bench_peer *p = user_data;
+
+	p->send_calls++;
+	bench_sink(p, data, len);
+	return len;
+}
+
+static ssize_t bench_send_iov_cb(wslay_event_context_ptr ctx, const struct wslay_iovec *iov, int iovcnt, int flags, void *user_data)
+{
+	struct bench_peer *p = user_data;
+	ssize_t total = 0;
+	int i;
+
+	p->send_calls++;
+	for (i = 0; i < iovcnt; i++) {
+		bench_sink(p, iov[i].base, iov[i].len);
+		total += iov[i].len;
+	}
+	return total;
+}
+
+static ssize_t bench_recv_cb(wslay_event_context_ptr ctx, uint8_t *buf, size_t len, int flags, void *user_data)
+{
+	struct bench_peer *p = user_data;
+	size_t n = p->in_len - p->in_pos;
+
+	if (n == 0 && p->in_rounds > 1) {
+		p->in_rounds--;
+		p->in_pos = 0;
+		n = p->in_len;
+	}
+
+	if (n == 0) {
+		wslay_event_set_error(ctx, WSLAY_ERR_WOULDBLOCK);
+		return -1;
+	}
+
+	if (n > len) {
+		n = len;
+	}
+	memcpy(buf, p->in + p->in_pos, n);
+	p->in_pos += n;
+	return n;
+}
+
+static int bench_genmask_cb(wslay_event_context_ptr ctx, uint8_t *buf, size_t len, void *user_data)
+{
+	static uint8_t seed = 0x5a;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		buf[i] = seed;
+		seed = seed * 33 + 7;
+	}
+	return 0;
+}
+
+static void bench_msg_recv_cb(wslay_event_context_ptr ctx, const struct wslay_event_on_msg_recv_arg *arg, void *user_data)
+{
+	struct bench_peer *p = user_data;
+
+	p->msgs++;
+	if (p->expect && (arg->msg_length != p->expect_len || memcmp(arg->msg, p->expect, p->expect_len) != 0)) {
+		p->mismatch++;
+	}
+}
+
+static void bench_msg_free_cb(wslay_event_context_ptr ctx, const uint8_t *msg, size_t msg_length, void *user_data)
+{
+	struct bench_peer *p = user_data;
+
+	p->freed++;
+}
+
+static wslay_event_context_ptr bench_context(int client, int iov, struct bench_peer **peer)
+{
+	struct wslay_event_callbacks callbacks = {
+		bench_recv_cb,
+		bench_send_cb,
+		bench_genmask_cb,
+		NULL,
+		NULL,
+		NULL,
+		bench_msg_recv_cb,
+		iov ? bench_send_iov_cb : NULL
+	};
+	wslay_event_context_ptr ctx;
+	struct bench_peer *p;
+	int ret;
+
+	p = calloc(1, sizeof(*p));
+	if (!p) {
+		return NULL;
+	}
+
+	if (client) {
+		ret = wslay_event_context_client_init(&ctx, &callbacks, p);
+	} else {
+		ret = wslay_event_context_server_init(&ctx, &callbacks, p);
+	}
+
+	if (ret != 0) {
+		free(p);
+		return NULL;
+	}
+
+	*peer = p;
+	return ctx;
+}
+
+static int bench_queue(wslay_event_context_ptr ctx, const uint8_t *data, size_t len, int ref)
+{
+	struct wslay_event_msg msg;
+
+	msg.opcode = WSLAY_BINARY_FRAME;
+	msg.msg = data;
+	msg.msg_length = len;
+
+	if (ref) {
+		return wslay_event_queue_msg_ref(ctx, &msg, bench_msg_free_cb);
+	}
+	return wslay_event_queue_msg(ctx, &msg);
+}
+
+/* Send one message of every length up to BENCH_VERIFY_MAX, and a few large
+ * ones, from a buffer at a different misalignment each time, and check that
+ * the peer receives it intact.
+ */
+
+static int bench_verify(int client, int ref)
+{
+	static const size_t large[] = { 4093, 4096, 4099, 65535, BENCH_MAX_MSG };
+	wslay_event_context_ptr tx;
+	wslay_event_context_ptr rx;
+	struct bench_peer *txp;
+	struct bench_peer *rxp;
+	unsigned long count = 0;
+	size_t len;
+	size_t i;
+	int ret = -1;
+
+	tx = bench_context(client, ref, &txp);
+	rx = bench_context(!client, 0, &rxp);
+	if (!tx || !rx) {
+		goto out;
+	}
+
+	txp->capture = g_stream;
+	txp->capture_size = BENCH_STREAM_SIZE;
+
+	for (i = 0; i <= BENCH_VERIFY_MAX + sizeof(large) / sizeof(large[0]); i++) {
+		len = i <= BENCH_VERIFY_MAX ? i : large[i - BENCH_VERIFY_MAX - 1];
+
+		txp->capture_len = 0;
+		rxp->expect = g_payload + (i & 7);
+		rxp->expect_len = len;
+
+		if (bench_queue(tx, rxp->expect, len, ref) != 0 || wslay_event_send(tx) != 0) {
+			goto out;
+		}
+
+		rxp->in = g_stream;
+		rxp->in_len = txp->capture_len;
+		rxp->in_pos = 0;
+		if (wslay_event_recv(rx) != 0) {
+			goto out;
+		}
+		count++;
+	}
+
+	if (rxp->msgs != count || rxp->mismatch != 0 || (ref && txp->freed != count)) {
+		goto out;
+	}
+
+	/* The payload must not have been masked in place */
+
+	for (i = 0; i < BENCH_MAX_MSG + 8; i++) {
+		if (g_payload[i] != (uint8_t)(i * 7 + (i >> 8))) {
+			goto out;
+		}
+	}
+
+	ret = 0;
+
+out:
+	printf("  %-8s %-10s %lu messages %s\n", client ? "client" : "server", ref ? "msg_ref" : "queue_msg", count, ret == 0 ? "OK" : "FAILED");
+	wslay_event_context_free(tx);
+	wslay_event_context_free(rx);
+	return ret;
+}
+
+static int bench_send(int client, int ref, size_t size, unsigned long bytes)
+{
+	wslay_event_context_ptr ctx;
+	struct bench_peer *p;
+	unsigned long count = bytes / size;
+	unsigned long start;
+	unsigned long usec;
+	unsigned long i;
+
+	ctx = bench_context(client, ref, &p);
+	if (!ctx) {
+		return -1;
+	}
+
+	if (count == 0) {
+		count = 1;
+	}
+
+	start = bench_usec();
+	for (i = 0; i < count; i++) {
+		if (bench_queue(ctx, g_payload, size, ref) != 0 || wslay_event_send(ctx) != 0) {
+			wslay_event_context_free(ctx);
+			return -1;
+		}
+	}
+	usec = bench_usec() - start;
+
+	printf("  %-8s %-10s %6lu B %8.1f MB/s %5.2f sends/msg\n", client ? "client" : "server", ref ? "msg_ref" : "queue_msg", (unsigned long)size, (double)count * size / (usec ? usec : 1), (double)p->send_calls / count);
+	wslay_event_context_free(ctx);
+	return 0;
+}
+
+/* Receive a stream of masked frames on a server context */
+
+static int bench_recv(size_t size, unsigned long bytes)
+{
+	wslay_event_context_ptr tx;
+	wslay_event_context_ptr rx;
+	struct bench_peer *txp;
+	struct bench_peer *rxp;
+	unsigned long frames = (BENCH_STREAM_SIZE / 2) / size;
+	unsigned long rounds;
+	unsigned long start;
+	unsigned long usec;
+	unsigned long i;
+	int ret = -1;
+
+	if (frames == 0) {
+		frames = 1;
+	}
+
+	rounds = bytes / (frames * size);
+	if (rounds == 0) {
+		rounds = 1;
+	}
+
+	tx = bench_context(1, 0, &txp);
+	rx = bench_context(0, 0, &rxp);
+	if (!tx || !rx) {
+		goto out;
+	}
+
+	txp->capture = g_stream;
+	txp->capture_size = BENCH_STREAM_SIZE;
+	for (i = 0; i < frames; i++) {
+		if (bench_queue(tx, g_payload, size, 0) != 0 || wslay_event_send(tx) != 0) {
+			goto out;
+		}
+	}
+	if (txp->capture_len > txp->capture_size) {
+		goto out;
+	}
+
+	rxp->in = g_stream;
+	rxp->in_len = txp->capture_len;
+	rxp->in_rounds = rounds;
+
+	start = bench_usec();
+	while (rxp->msgs < frames * rounds) {
+		i = rxp->msgs;
+		if (wslay_event_recv(rx) != 0 || (rxp->msgs == i && rxp->in_pos == rxp->in_len && rxp->in_rounds <= 1)) {
+			break;
+		}
+	}
+	usec = bench_usec() - start;
+
+	if (rxp->msgs != frames * rounds) {
+		goto out;
+	}
+
+	printf("  %-8s %-10s %6lu B %8.1f MB/s\n", "server", "recv", (unsigned long)size, (double)frames * rounds * size / (usec ? usec : 1));
+	ret = 0;
+
+out:
+	wslay_event_context_free(tx);
+	wslay_event_context_free(rx);
+	return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#ifdef WSLAY_BENCH_HOST
+int main(int argc, char *argv[])
+#elif defined(CONFIG_BUILD_KERNEL)
+int main(int argc, FAR char *argv[])
+#else
+int wslay_bench_main(int argc, char *argv[])
+#endif
+{
+	unsigned long bytes = BENCH_DEFAULT_KBYTES * 1024UL;
+	size_t i;
+	int client;
+	int ref;
+	int ret = -1;
+
+	if (argc > 1) {
+		bytes = strtoul(argv[1], NULL, 10) * 1024UL;
+		if (bytes == 0) {
+			printf("usage: %s [kbytes per case]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	/* Room for the largest message at every misalignment */
+
+	g_payload = malloc(BENCH_MAX_MSG + 8);
+	g_stream = malloc(BENCH_STREAM_SIZE);
+	if (!g_payload || !g_stream) {
+		printf("out of memory\n");
+		goto out;
+	}
+
+	for (i = 0; i < BENCH_MAX_MSG + 8; i++) {
+		g_payload[i] = (uint8_t)(i * 7 + (i >> 8));
+	}
+
+	printf("loopback check:\n");
+	for (client = 0; client < 2; client++) {
+		for (ref = 0; ref < 2; ref++) {
+			if (bench_verify(client, ref) != 0) {
+				goto out;
+			}
+		}
+	}
+
+	printf("send, %lu KB per case:\n", bytes / 1024);
+	for (client = 0; client < 2; client++) {
+		for (ref = 0; ref < 2; ref++) {
+			for (i = 0; i < sizeof(g_sizes) / sizeof(g_sizes[0]); i++) {
+				if (bench_send(client, ref, g_sizes[i], bytes) != 0) {
+					printf("send failed\n");
+					goto out;
+				}
+			}
+		}
+	}
+
+	printf("receive, %lu KB per case:\n", bytes / 1024);
+	for (i = 0; i < sizeof(g_sizes) / sizeof(g_sizes[0]); i++) {
+		if (bench_recv(g_sizes[i], bytes) != 0) {
+			printf("recv failed\n");
+			goto out;
+		}
+	}
+
+	ret = 0;
+
+out:
+	free(g_payload);
+	free(g_stream);
+	return ret;
+}
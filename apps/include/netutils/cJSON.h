@@ -115,6 +115,12 @@ typedef struct cJSON {
 	 */
 
 	char *string;
+
+	/* Name index of a large object, built while parsing or by
+	 * cJSON_IndexObject(). Private to cJSON.c.
+	 */
+
+	struct cJSON_Index *index;
 } cJSON;
 
 typedef struct cJSON_Hooks {
@@ -122,6 +128,20 @@ typedef struct cJSON_Hooks {
 	void (*free_fn)(void *ptr);
 } cJSON_Hooks;
 
+/* Memory for trees built by cJSON_ParseArena(). The arena starts with the
+ * optional buffer given to cJSON_ArenaInit() and grows by blocks taken from
+ * the malloc hook.
+ */
+
+typedef struct cJSON_Arena {
+	char *buf;				/* Block being carved */
+	size_t size;			/* Size of that block */
+	size_t used;			/* Bytes handed out from it */
+	void *blocks;			/* Blocks allocated by cJSON */
+	char *user_buf;			/* Buffer from cJSON_ArenaInit() */
+	size_t user_size;
+} cJSON_Arena;
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -136,6 +156,20 @@ void cJSON_InitHooks(cJSON_Hooks *hooks);
 
 cJSON *cJSON_Parse(const char *value);
 
+/* Arena parsing, for the many short-lived documents of telemetry and
+ * control traffic: cJSON_ParseArena() builds the tree in the arena with no
+ * per-item allocation. Several documents can share an arena. The trees are
+ * released all at once with cJSON_ArenaReset(), which keeps the largest
+ * block for the next documents, or with cJSON_ArenaFree(). Never pass an
+ * arena tree or one of its items to cJSON_Delete() or to the Delete/Replace
+ * calls below, and do not add heap items to it.
+ */
+
+void cJSON_ArenaInit(cJSON_Arena *arena, void *buf, size_t size);
+cJSON *cJSON_ParseArena(cJSON_Arena *arena, const char *value);
+void cJSON_ArenaReset(cJSON_Arena *arena);
+void cJSON_ArenaFree(cJSON_Arena *arena);
+
 /* Render a cJSON entity to text for transfer/storage. Free the char* when
  * finished.
  */
@@ -162,10 +196,26 @@ int cJSON_GetArraySize(cJSON *array);
 
 cJSON *cJSON_GetArrayItem(cJSON *array, int item);
 
-/* Get item "string" from object. Case insensitive. */
+/* Get item "string" from object. Case insensitive. Lookups do not change
+ * the tree, so threads may share one that none of them modifies. Objects
+ * with an index (see below) are changed only through the Add, Detach, Delete
+ * and Replace calls, which keep it up to date, not by relinking
+ * next/prev/child by hand.
+ */
 
 cJSON *cJSON_GetObjectItem(cJSON *object, const char *string);
 
+/* Give object a hash index of its member names, so that each lookup costs
+ * one probe instead of a walk. Parsing does this for objects with at least
+ * CONFIG_NETUTILS_JSON_INDEX_THRESHOLD members; call it for large objects
+ * built with the Add calls. Not for objects of an arena tree that were not
+ * indexed while parsing, as the index could not be freed. Returns 0, or -1
+ * if object is not an object, the index is disabled (threshold 0) or out of
+ * memory.
+ */
+
+int cJSON_IndexObject(cJSON *object);
+
 /* For analysing failed parses. This returns a pointer to the parse error.
  * You'll probably need to look a few chars back to make sense of it.
  * Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds.
@@ -0,0 +1,196 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * apps/include/netutils/json_stream.h
+ *
+ * Pull tokenizer and streaming writer for JSON.
+ *
+ * Neither of them allocates memory. The reader works in place over a
+ * writable input buffer: strings are unescaped and NUL-terminated where
+ * they are, so a token can be used as a C string until the buffer is
+ * reused. The writer renders into a caller buffer and, when a flush
+ * callback is given, hands the buffer over (e.g. to a socket) each time it
+ * fills up, so documents of any size can be sent with a small buffer.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_JSON_STREAM_H
+#define __APPS_INCLUDE_NETUTILS_JSON_STREAM_H
+
+#ifdef __cplusplus
+// *INDENT-OFF*
+extern "C"
+{
+// *INDENT-ON*
+#endif
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <apps/netutils/cJSON.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Deepest nesting of objects/arrays the reader and writer keep track of.
+ * The state is one bit per level.
+ */
+
+#define JSON_STREAM_MAX_DEPTH 32
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+enum json_token_type {
+	JSON_TOKEN_ERROR = -1,		/* Malformed input, see json_reader.err */
+	JSON_TOKEN_END = 0,			/* The top-level value is complete */
+	JSON_TOKEN_OBJECT_START,
+	JSON_TOKEN_OBJECT_END,
+	JSON_TOKEN_ARRAY_START,
+	JSON_TOKEN_ARRAY_END,
+	JSON_TOKEN_KEY,				/* Member name, str is NUL-terminated */
+	JSON_TOKEN_STRING,			/* str is unescaped and NUL-terminated */
+	JSON_TOKEN_NUMBER,			/* str/len is the literal, not terminated */
+	JSON_TOKEN_TRUE,
+	JSON_TOKEN_FALSE,
+	JSON_TOKEN_NULL
+};
+
+struct json_token {
+	enum json_token_type type;
+	const char *str;			/* Points into the input buffer */
+	size_t len;
+};
+
+struct json_reader {
+	char *buf;
+	size_t len;
+	size_t pos;
+	uint32_t stack;				/* Bit n set: level n is an object */
+	uint8_t depth;
+	uint8_t state;
+	const char *err;			/* Where parsing stopped on error */
+};
+
+/* Called by the writer with the rendered data whenever its buffer is full
+ * and on json_writer_finish(). Return 0 on success, a negative value to
+ * abort the document.
+ */
+
+typedef int (*json_flush_fn)(void *arg, const char *data, size_t len);
+
+struct json_writer {
+	char *buf;
+	size_t size;
+	size_t len;					/* Bytes pending in buf */
+	size_t total;				/* Bytes rendered so far */
+	json_flush_fn flush;
+	void *arg;
+	uint32_t comma;				/* Bit n set: level n needs a ',' */
+	uint32_t object;			/* Bit n set: level n is an object */
+	uint8_t depth;
+	bool key;					/* A key was written, the value follows */
+	int err;
+};
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* Prepare to read one JSON value from buf[0..len). The buffer is modified
+ * as strings are read.
+ */
+
+void json_reader_init(struct json_reader *rd, char *buf, size_t len);
+
+/* Return the next token of the document in *tok. Returns the token type;
+ * JSON_TOKEN_END once the top-level value is complete and only whitespace
+ * follows, JSON_TOKEN_ERROR on malformed input.
+ */
+
+int json_reader_next(struct json_reader *rd, struct json_token *tok);
+
+/* Skip the value that starts with tok (the token just returned by
+ * json_reader_next()), including all nested members for objects and
+ * arrays. Returns 0 on success, JSON_TOKEN_ERROR on malformed input.
+ */
+
+int json_reader_skip(struct json_reader *rd, const struct json_token *tok);
+
+/* Helpers for tokens. */
+
+bool json_token_equals(const struct json_token *tok, const char *str);
+int json_token_to_int(const struct json_token *tok, int *value);
+int json_token_to_double(const struct json_token *tok, double *value);
+
+/* Prepare to write a document into buf. With flush == NULL the document
+ * must fit in buf (json_writer_finish() adds a terminating NUL, so one byte
+ * is reserved for it); otherwise flush is called each time buf fills up.
+ */
+
+void json_writer_init(struct json_writer *wr, char *buf, size_t size, json_flush_fn flush, void *arg);
+
+/* Flush callback that writes to a file descriptor or socket, pass the
+ * descriptor as (void *)(intptr_t)fd.
+ */
+
+int json_writer_fd_flush(void *arg, const char *data, size_t len);
+
+/* Emit values. Inside an object, each value must be preceded by
+ * json_write_key(). All return 0 on success and a negative value once
+ * anything has failed (buffer full, flush error, misnested calls); the
+ * error sticks until the writer is initialized again.
+ */
+
+int json_write_object_start(struct json_writer *wr);
+int json_write_object_end(struct json_writer *wr);
+int json_write_array_start(struct json_writer *wr);
+int json_write_array_end(struct json_writer *wr);
+int json_write_key(struct json_writer *wr, const char *key);
+int json_write_string(struct json_writer *wr, const char *str);
+int json_write_int(struct json_writer *wr, long value);
+int json_write_double(struct json_writer *wr, double value);
+int json_write_bool(struct json_writer *wr, bool value);
+int json_write_null(struct json_writer *wr);
+
+/* Render a cJSON tree in the layout of cJSON_PrintUnformatted(), without
+ * allocating.
+ */
+
+int json_write_cjson(struct json_writer *wr, cJSON *item);
+
+/* Flush what is left. Returns the length of the document, or a negative
+ * value on failure.
+ */
+
+ssize_t json_writer_finish(struct json_writer *wr);
+
+#ifdef __cplusplus
+// *INDENT-OFF*
+}
+// *INDENT-ON*
+#endif
+#endif							/* __APPS_INCLUDE_NETUTILS_JSON_STREAM_H */
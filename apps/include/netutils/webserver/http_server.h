@@ -60,6 +60,7 @@
 #include "tls/error.h"
 #include "tls/debug.h"
 #include "tls/ssl_cache.h"
+#include "tls/ssl_ticket.h"
 #endif
 
 /****************************************************************************
@@ -175,6 +176,9 @@ struct http_server_t {
 	mbedtls_x509_crt          tls_srvcert;
 	mbedtls_pk_context        tls_pkey;
 	mbedtls_ssl_cache_context tls_cache;
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+	mbedtls_ssl_ticket_context tls_ticket;
+#endif
 	mbedtls_net_context       tls_ctx;
 #endif
 
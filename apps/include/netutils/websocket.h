@@ -36,7 +36,10 @@
  * Included Files
  ****************************************************************************/
 
+#include <tinyara/config.h>
+
 #include <stdint.h>
+#include <time.h>
 #include <netinet/in.h>
 #include <apps/netutils/wslay/wslay.h>
 #include <tinyara/wqueue.h>
@@ -138,7 +141,17 @@
 /**
  * @brief The maximum amount of client to accept from server.
  */
+#ifdef CONFIG_NETUTILS_WEBSOCKET_MAX_CLIENT
+#define WEBSOCKET_MAX_CLIENT                         CONFIG_NETUTILS_WEBSOCKET_MAX_CLIENT
+#else
 #define WEBSOCKET_MAX_CLIENT                         (3)
+#endif
+
+/**
+ * @brief The maximum number of wslay_event_recv() rounds the event loop gives
+ *        one connection before moving on to the next one.
+ */
+#define WEBSOCKET_LOOP_RECV_BUDGET                   (8)
 
 /**
  * @brief The maximun retry of tls handshake.
@@ -179,6 +192,12 @@
  */
 #define websocket_frame_t                            struct wslay_event_msg
 
+/**
+ * @brief Websocket wrapper of the callback that releases a frame queued by
+ *        websocket_queue_msg_ref(), see wslay_event_msg_free_callback.
+ */
+#define websocket_msg_free_cb                        wslay_event_msg_free_callback
+
 /**
  * @brief Websocket structure wrapper to send a fragmented frame.
  *
@@ -381,6 +400,18 @@ typedef struct {
 ///< Websocket event handler thread ID
 	pthread_attr_t thread_attr;
 ///< Websocket event handler thread attribute
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+	clock_t ping_time;
+///< Event loop only, system time when the next ping is due
+	uint8_t loop_flags;
+///< Event loop only, socket readiness not yet used by the callbacks
+	char *loop_header;
+///< Event loop only, upgrade request read so far, then the reply, during the handshake
+	size_t loop_header_len;
+///< Event loop only, length of loop_header
+	size_t loop_header_sent;
+///< Event loop only, bytes of the reply in loop_header already sent
+#endif
 } websocket_t;
 
 /**
@@ -468,7 +499,9 @@ websocket_return_t websocket_server_open(websocket_t *server);
  * @brief websocket_server_init
  *
  *        This function start message handling loop.\n
- *        It initiates websocket context structure and select() fd to handle the messages.
+ *        It initiates websocket context structure and select() fd to handle the messages.\n
+ *        With CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP the connection is handed to the
+ *        shared event loop thread instead and this function returns at once.
  * @param[in] server websocket structure manages file descriptor, websocket context and TLS context.
  *               users must give a pointer of websocket callback structure in websocket_t *server
  * @return On success, return WEBSOCKET_SUCCESS. On failure, return values defined in websocket_return_t.
@@ -499,6 +532,20 @@ void websocket_register_cb(websocket_t *websocket, websocket_cb_t *cb);
  */
 websocket_return_t websocket_queue_msg(websocket_t *websocket, websocket_frame_t *tx_frame);
 
+/**
+ * @brief websocket_queue_msg_ref() queues a message without copying it.
+ *
+ *        The payload of tx_frame must stay valid until free_cb is called with it,
+ *        which happens once the frame is sent or the websocket is released.
+ *        Control frames must go through websocket_queue_msg().
+ * @param[in] websocket message queue is in websocket context
+ * @param[in] tx_frame message frame to be sent
+ * @param[in] free_cb callback that gives the payload back to the caller
+ * @return On success return WEBSOCKET_SUCCESS, On failure return values defined in websocket_return_t
+ * @since Tizen RT v1.0
+ */
+websocket_return_t websocket_queue_msg_ref(websocket_t *websocket, websocket_frame_t *tx_frame, websocket_msg_free_cb free_cb);
+
 /**
  * @brief websocket_queue_ping() is used to send a websocket ping message.
  *
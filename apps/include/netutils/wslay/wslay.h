@@ -120,10 +120,26 @@ typedef ssize_t (*wslay_frame_recv_callback)(uint8_t *buf, size_t len, int flags
  */
 typedef int (*wslay_frame_genmask_callback)(uint8_t *buf, size_t len, void *user_data);
 
+struct wslay_iovec {
+	const uint8_t *base;
+	size_t len;
+};
+
+/*
+ * Optional callback used by wslay_frame_send() to send the frame header
+ * and the payload with one call when they are not contiguous in
+ * memory. It must send at most the total length of the iovcnt buffers
+ * in iov, in order, e.g. with sendmsg(), and otherwise behave like
+ * wslay_frame_send_callback. If it is NULL, the header and the payload
+ * are passed to send_callback separately.
+ */
+typedef ssize_t (*wslay_frame_send_iov_callback)(const struct wslay_iovec *iov, int iovcnt, int flags, void *user_data);
+
 struct wslay_frame_callbacks {
 	wslay_frame_send_callback send_callback;
 	wslay_frame_recv_callback recv_callback;
 	wslay_frame_genmask_callback genmask_callback;
+	wslay_frame_send_iov_callback send_iov_callback;
 };
 
 /*
@@ -176,8 +192,29 @@ struct wslay_frame_iocb {
 	const uint8_t *data;
 	/* bytes of data defined above */
 	size_t data_length;
+	/*
+	 * Bitwise OR of WSLAY_FRAME_DATA_* flags, telling how the library
+	 * may use data when it holds the whole payload. 0 if unsure.
+	 */
+	uint8_t data_flags;
 };
 
+/*
+ * The longest frame header is 14 bytes. Headroom is rounded up so that a
+ * word aligned header area leaves the payload word aligned too.
+ */
+#define WSLAY_FRAME_HEADROOM 16
+
+/*
+ * data may be overwritten, so a masked payload is masked in place.
+ */
+#define WSLAY_FRAME_DATA_WRITABLE (1 << 0)
+/*
+ * WSLAY_FRAME_HEADROOM bytes before data are writable, so the header is
+ * put there and the frame is sent as one buffer.
+ */
+#define WSLAY_FRAME_DATA_HEADROOM (1 << 1)
+
 struct wslay_frame_context;
 typedef struct wslay_frame_context *wslay_frame_context_ptr;
 
@@ -350,6 +387,16 @@ typedef ssize_t (*wslay_event_send_callback)(wslay_event_context_ptr ctx, const
  */
 typedef int (*wslay_event_genmask_callback)(wslay_event_context_ptr ctx, uint8_t *buf, size_t len, void *user_data);
 
+/*
+ * Optional callback invoked by wslay_event_send() to send a frame header
+ * and a payload that are not contiguous in memory, which happens for
+ * messages queued by wslay_event_queue_msg_ref(). It must send at most
+ * the total length of the iovcnt buffers in iov, in order, and otherwise
+ * behave like wslay_event_send_callback. If it is NULL, send_callback is
+ * called for the header and the payload separately.
+ */
+typedef ssize_t (*wslay_event_send_iov_callback)(wslay_event_context_ptr ctx, const struct wslay_iovec *iov, int iovcnt, int flags, void *user_data);
+
 struct wslay_event_callbacks {
 	wslay_event_recv_callback recv_callback;
 	wslay_event_send_callback send_callback;
@@ -358,6 +405,7 @@ struct wslay_event_callbacks {
 	wslay_event_on_frame_recv_chunk_callback on_frame_recv_chunk_callback;
 	wslay_event_on_frame_recv_end_callback on_frame_recv_end_callback;
 	wslay_event_on_msg_recv_callback on_msg_recv_callback;
+	wslay_event_send_iov_callback send_iov_callback;
 };
 
 /*
@@ -545,6 +593,25 @@ int wslay_event_queue_msg(wslay_event_context_ptr ctx, const struct wslay_event_
  */
 int wslay_event_queue_msg_ex(wslay_event_context_ptr ctx, const struct wslay_event_msg *arg, uint8_t rsv);
 
+/*
+ * Callback function invoked when the library is done with a message
+ * queued by wslay_event_queue_msg_ref(), because it has been sent or
+ * dropped. msg and msg_length are the ones that were queued.
+ */
+typedef void (*wslay_event_msg_free_callback)(wslay_event_context_ptr ctx, const uint8_t *msg, size_t msg_length, void *user_data);
+
+/*
+ * Queues message specified in arg like wslay_event_queue_msg(), but
+ * without copying the payload: arg->msg must stay valid and unchanged
+ * until free_callback is called for it. Only non-control messages can be
+ * queued this way. When masking is needed (client side), the payload is
+ * masked through a bounce buffer and arg->msg is never written.
+ *
+ * Returns the same values as wslay_event_queue_msg(). free_callback is
+ * not called if queueing fails.
+ */
+int wslay_event_queue_msg_ref(wslay_event_context_ptr ctx, const struct wslay_event_msg *arg, wslay_event_msg_free_callback free_callback);
+
 /*
  * Specify "source" to generate message.
  */
@@ -62,6 +62,7 @@ enum fotahal_return_e {
 	FOTAHAL_RETURN_PART_NOTSET,
 	FOTAHAL_RETURN_BIN_NOTSET,
 	FOTAHAL_RETURN_PARAM_NOTSET,
+	FOTAHAL_RETURN_DECODEFAIL,
 	FOTAHAL_RETURN_MAX,
 };
 
@@ -69,6 +70,24 @@ typedef enum fotahal_return_e fotahal_return_t;
 
 typedef void *fotahal_handle_t;
 
+/* What fotahal_write() receives: the binary itself, or a packed image of
+ * it, compressed and/or a delta against the running binary (see
+ * apps/system/fota_hal/fota_decode.h).
+ */
+
+enum fotahal_encoding_e {
+	FOTAHAL_ENCODING_RAW = 0,
+	FOTAHAL_ENCODING_PACKED,
+};
+
+typedef enum fotahal_encoding_e fotahal_encoding_t;
+
+/* Reads len bytes at offset of the binary a delta applies to, into buffer.
+ * Returns len, or a negated errno value.
+ */
+
+typedef int (*fotahal_source_t)(void *arg, uint32_t offset, uint8_t *buffer, size_t len);
+
 /****************************************************************************
 * Public Data
 ****************************************************************************/
@@ -125,6 +144,28 @@ fotahal_return_t fotahal_set_binary(fotahal_handle_t handle, uint32_t bin_id);
  ****************************************************************************/
 fotahal_return_t fotahal_write(fotahal_handle_t handle, const char *buffer, uint32_t bin_size);
 
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+/****************************************************************************
+ * Name: fotahal_set_encoding
+ *
+ * Description:
+ *   Set what the next fotahal_write() calls receive, after
+ *   fotahal_set_binary().  source, with its arg, reads the running binary
+ *   of a delta; it may be NULL otherwise.
+ ****************************************************************************/
+fotahal_return_t fotahal_set_encoding(fotahal_handle_t handle, fotahal_encoding_t encoding, fotahal_source_t source, void *arg);
+#endif
+
+/****************************************************************************
+ * Name: fotahal_verify
+ *
+ * Description:
+ *   Check that the binary written since fotahal_set_binary() is bin_size
+ *   bytes long with a crc32() of checksum.  A packed image must be
+ *   complete.
+ ****************************************************************************/
+fotahal_return_t fotahal_verify(fotahal_handle_t handle, uint32_t bin_size, uint32_t checksum);
+
 /****************************************************************************
  * Name: fotahal_update_bootparam
  *
@@ -51,6 +51,8 @@
  * Included Files
  ****************************************************************************/
 
+#include <tinyara/config.h>
+
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
@@ -66,6 +68,52 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* Arena allocations are aligned for the double in cJSON */
+
+#define CJSON_ARENA_ALIGN(n) (((n) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+/* Size of the first arena block for a document of n characters. A cJSON
+ * node is about the size of a short member, so this fits typical documents
+ * in one block.
+ */
+
+#define CJSON_ARENA_HINT(n) (4 * (n) + 4 * sizeof(cJSON))
+
+/* Objects with at least this many members get a name index; 0 disables */
+
+#ifndef CONFIG_NETUTILS_JSON_INDEX_THRESHOLD
+#define CONFIG_NETUTILS_JSON_INDEX_THRESHOLD 0
+#endif
+
+#define CJSON_INDEX_THRESHOLD CONFIG_NETUTILS_JSON_INDEX_THRESHOLD
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Header of an arena block taken from cJSON_malloc, data follows */
+
+struct cJSON_ArenaBlock {
+	struct cJSON_ArenaBlock *next;
+	size_t size;
+};
+
+#define CJSON_ARENA_HDR CJSON_ARENA_ALIGN(sizeof(struct cJSON_ArenaBlock))
+
+/* Open-addressed (linear probing) table of the members of an object, by
+ * case-folded name. Only the first member with a given name is in the
+ * table, as that is the one cJSON_GetObjectItem() returns; ndup counts the
+ * others.
+ */
+
+struct cJSON_Index {
+	unsigned int size;			/* Number of slots, a power of two */
+	unsigned int count;			/* Used slots */
+	unsigned int ndup;			/* Members shadowed by an earlier one */
+	int arena;					/* Allocated from an arena, never freed */
+	cJSON *slot[1];
+};
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -81,17 +129,69 @@ static void (*cJSON_free)(void *ptr) = free;
  * Private Prototypes
  ****************************************************************************/
 
-static const char *parse_value(cJSON *item, const char *value);
+static const char *parse_value(cJSON_Arena *arena, cJSON *item, const char *value);
 static char *print_value(cJSON *item, int depth, int fmt);
-static const char *parse_array(cJSON *item, const char *value);
+static const char *parse_array(cJSON_Arena *arena, cJSON *item, const char *value);
 static char *print_array(cJSON *item, int depth, int fmt);
-static const char *parse_object(cJSON *item, const char *value);
+static const char *parse_object(cJSON_Arena *arena, cJSON *item, const char *value);
 static char *print_object(cJSON *item, int depth, int fmt);
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/* Make sure the arena has a block with at least sz free bytes. */
+
+static int cJSON_arena_grow(cJSON_Arena *arena, size_t sz)
+{
+	struct cJSON_ArenaBlock *block;
+	size_t bsize;
+
+	if (arena->size - arena->used >= sz) {
+		return 0;
+	}
+
+	/* Double the block size so a large document needs few blocks */
+
+	bsize = arena->size * 2;
+	if (bsize < sz) {
+		bsize = sz;
+	}
+
+	block = (struct cJSON_ArenaBlock *)cJSON_malloc(CJSON_ARENA_HDR + bsize);
+	if (!block) {
+		return -1;
+	}
+
+	block->next = (struct cJSON_ArenaBlock *)arena->blocks;
+	block->size = bsize;
+	arena->blocks = block;
+	arena->buf = (char *)block + CJSON_ARENA_HDR;
+	arena->size = bsize;
+	arena->used = 0;
+	return 0;
+}
+
+/* Allocate from the arena if there is one, from the heap otherwise. */
+
+static void *cJSON_alloc(cJSON_Arena *arena, size_t sz)
+{
+	void *ptr;
+
+	if (!arena) {
+		return cJSON_malloc(sz);
+	}
+
+	sz = CJSON_ARENA_ALIGN(sz);
+	if (cJSON_arena_grow(arena, sz) < 0) {
+		return 0;
+	}
+
+	ptr = arena->buf + arena->used;
+	arena->used += sz;
+	return ptr;
+}
+
 static char *cJSON_strdup(const char *str)
 {
 	size_t len;
@@ -106,11 +206,11 @@ static char *cJSON_strdup(const char *str)
 	return copy;
 }
 
-/* Internal constructor. */
+/* Internal constructors. */
 
-static cJSON *cJSON_New_Item(void)
+static cJSON *cJSON_New_Arena_Item(cJSON_Arena *arena)
 {
-	cJSON *node = (cJSON *)cJSON_malloc(sizeof(cJSON));
+	cJSON *node = (cJSON *)cJSON_alloc(arena, sizeof(cJSON));
 	if (node) {
 		memset(node, 0, sizeof(cJSON));
 	}
@@ -118,6 +218,11 @@ static cJSON *cJSON_New_Item(void)
 	return node;
 }
 
+static cJSON *cJSON_New_Item(void)
+{
+	return cJSON_New_Arena_Item(0);
+}
+
 static int cJSON_strcasecmp(const char *s1, const char *s2)
 {
 	if (!s1) {
@@ -137,6 +242,175 @@ static int cJSON_strcasecmp(const char *s1, const char *s2)
 	return tolower(*(const unsigned char *)s1) - tolower(*(const unsigned char *)s2);
 }
 
+#if CJSON_INDEX_THRESHOLD > 0
+static unsigned int cJSON_hash(const char *str)
+{
+	unsigned int hash = 2166136261u;
+
+	while (*str) {
+		hash ^= (unsigned char)tolower(*(const unsigned char *)str++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/* Return the slot holding the member named str, or the empty slot where it
+ * would go.
+ */
+
+static cJSON **cJSON_index_slot(struct cJSON_Index *index, const char *str)
+{
+	unsigned int mask = index->size - 1;
+	unsigned int i = cJSON_hash(str) & mask;
+
+	while (index->slot[i] && cJSON_strcasecmp(index->slot[i]->string, str)) {
+		i = (i + 1) & mask;
+	}
+
+	return &index->slot[i];
+}
+
+static void cJSON_index_drop(cJSON *object)
+{
+	if (object->index && !object->index->arena) {
+		cJSON_free(object->index);
+	}
+
+	object->index = 0;
+}
+
+/* Build the index of object for at least count members. */
+
+static int cJSON_index_build(cJSON_Arena *arena, cJSON *object, unsigned int count)
+{
+	struct cJSON_Index *index;
+	unsigned int size = 16;
+	size_t len;
+	cJSON **slot;
+	cJSON *c;
+
+	/* Keep the table at most half full */
+
+	while (size < 2 * count) {
+		size <<= 1;
+	}
+
+	len = sizeof(struct cJSON_Index) + (size - 1) * sizeof(cJSON *);
+	index = (struct cJSON_Index *)cJSON_alloc(arena, len);
+	if (!index) {
+		return -1;
+	}
+
+	memset(index, 0, len);
+	index->size = size;
+	index->arena = arena != 0;
+
+	for (c = object->child; c; c = c->next) {
+		if (!c->string) {
+			continue;
+		}
+
+		slot = cJSON_index_slot(index, c->string);
+		if (*slot) {
+			index->ndup++;
+		} else {
+			*slot = c;
+			index->count++;
+		}
+	}
+
+	cJSON_index_drop(object);
+	object->index = index;
+	return 0;
+}
+
+/* item was appended to object. */
+
+static void cJSON_index_add(cJSON *object, cJSON *item)
+{
+	struct cJSON_Index *index = object->index;
+	cJSON **slot;
+
+	if (!item->string) {
+		return;
+	}
+
+	if (2 * (index->count + 1) > index->size) {
+		if (index->arena || cJSON_index_build(0, object, index->count + 1) < 0) {
+			/* Fall back to the linear walk */
+
+			cJSON_index_drop(object);
+		}
+		return;
+	}
+
+	slot = cJSON_index_slot(index, item->string);
+	if (*slot) {
+		index->ndup++;
+	} else {
+		*slot = item;
+		index->count++;
+	}
+}
+
+/* item was unlinked from object. */
+
+static void cJSON_index_remove(cJSON *object, cJSON *item)
+{
+	struct cJSON_Index *index = object->index;
+	unsigned int mask = index->size - 1;
+	unsigned int i;
+	unsigned int j;
+	unsigned int home;
+	cJSON **slot;
+	cJSON *c;
+
+	if (!item->string) {
+		return;
+	}
+
+	slot = cJSON_index_slot(index, item->string);
+	if (*slot != item) {
+		/* A shadowed duplicate, or not indexed at all */
+
+		if (*slot && index->ndup) {
+			index->ndup--;
+		}
+		return;
+	}
+
+	/* Empty the slot and move back the entries of the probe run after it,
+	 * so that no lookup stops early at the hole.
+	 */
+
+	i = slot - index->slot;
+	index->slot[i] = 0;
+	index->count--;
+	for (j = (i + 1) & mask; index->slot[j]; j = (j + 1) & mask) {
+		home = cJSON_hash(index->slot[j]->string) & mask;
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			index->slot[i] = index->slot[j];
+			index->slot[j] = 0;
+			i = j;
+		}
+	}
+
+	/* A member with the same name that was shadowed by item takes over */
+
+	if (index->ndup) {
+		for (c = object->child; c; c = c->next) {
+			if (!cJSON_strcasecmp(c->string, item->string)) {
+				*cJSON_index_slot(index, c->string) = c;
+				index->count++;
+				index->ndup--;
+				break;
+			}
+		}
+	}
+}
+#endif
+
 /* Parse the input text to generate a number, and populate the result into item. */
 
 static const char *parse_number(cJSON *item, const char *num)
@@ -239,7 +513,7 @@ static char *print_number(cJSON *item)
 
 /* Parse the input text into an unescaped cstring, and populate item. */
 
-static const char *parse_string(cJSON *item, const char *str)
+static const char *parse_string(cJSON_Arena *arena, cJSON *item, const char *str)
 {
 	const char *ptr = str + 1;
 	char *ptr2;
@@ -265,7 +539,7 @@ static const char *parse_string(cJSON *item, const char *str)
 
 	/* This is how long we need for the string, roughly. */
 
-	out = (char *)cJSON_malloc(len + 1);
+	out = (char *)cJSON_alloc(arena, len + 1);
 	if (!out) {
 		return 0;
 	}
@@ -477,7 +751,7 @@ static const char *skip(const char *in)
 
 /* Parser core - when encountering text, process appropriately. */
 
-static const char *parse_value(cJSON *item, const char *value)
+static const char *parse_value(cJSON_Arena *arena, cJSON *item, const char *value)
 {
 	if (!value) {
 		/* Fail on null. */
@@ -502,7 +776,7 @@ static const char *parse_value(cJSON *item, const char *value)
 	}
 
 	if (*value == '\"') {
-		return parse_string(item, value);
+		return parse_string(arena, item, value);
 	}
 
 	if (*value == '-' || (*value >= '0' && *value <= '9')) {
@@ -510,11 +784,11 @@ static const char *parse_value(cJSON *item, const char *value)
 	}
 
 	if (*value == '[') {
-		return parse_array(item, value);
+		return parse_array(arena, item, value);
 	}
 
 	if (*value == '{') {
-		return parse_object(item, value);
+		return parse_object(arena, item, value);
 	}
 
 	/* Failure. */
@@ -567,7 +841,7 @@ static char *print_value(cJSON *item, int depth, int fmt)
 
 /* Build an array from input text. */
 
-static const char *parse_array(cJSON *item, const char *value)
+static const char *parse_array(cJSON_Arena *arena, cJSON *item, const char *value)
 {
 	cJSON *child;
 
@@ -586,7 +860,7 @@ static const char *parse_array(cJSON *item, const char *value)
 		return value + 1;
 	}
 
-	item->child = child = cJSON_New_Item();
+	item->child = child = cJSON_New_Arena_Item(arena);
 	if (!item->child) {
 		/* Memory fail */
 
@@ -595,14 +869,14 @@ static const char *parse_array(cJSON *item, const char *value)
 
 	/* Skip any spacing, get the value. */
 
-	value = skip(parse_value(child, skip(value)));
+	value = skip(parse_value(arena, child, skip(value)));
 	if (!value) {
 		return 0;
 	}
 
 	while (*value == ',') {
 		cJSON *new_item;
-		if (!(new_item = cJSON_New_Item())) {
+		if (!(new_item = cJSON_New_Arena_Item(arena))) {
 			/* <emory fail */
 
 			return 0;
@@ -611,7 +885,7 @@ static const char *parse_array(cJSON *item, const char *value)
 		child->next = new_item;
 		new_item->prev = child;
 		child = new_item;
-		value = skip(parse_value(child, skip(value + 1)));
+		value = skip(parse_value(arena, child, skip(value + 1)));
 		if (!value) {
 			/* Memory fail */
 
@@ -727,9 +1001,11 @@ static char *print_array(cJSON *item, int depth, int fmt)
 
 /* Build an object from the text. */
 
-static const char *parse_object(cJSON *item, const char *value)
+static const char *parse_object(cJSON_Arena *arena, cJSON *item, const char *value)
 {
 	cJSON *child;
+	unsigned int count = 1;
+
 	if (*value != '{') {
 		/* Not an object! */
 
@@ -745,12 +1021,12 @@ static const char *parse_object(cJSON *item, const char *value)
 		return value + 1;
 	}
 
-	item->child = child = cJSON_New_Item();
+	item->child = child = cJSON_New_Arena_Item(arena);
 	if (!item->child) {
 		return 0;
 	}
 
-	value = skip(parse_string(child, skip(value)));
+	value = skip(parse_string(arena, child, skip(value)));
 	if (!value) {
 		return 0;
 	}
@@ -764,14 +1040,14 @@ static const char *parse_object(cJSON *item, const char *value)
 
 	/* Skip any spacing, get the value. */
 
-	value = skip(parse_value(child, skip(value + 1)));
+	value = skip(parse_value(arena, child, skip(value + 1)));
 	if (!value) {
 		return 0;
 	}
 
 	while (*value == ',') {
 		cJSON *new_item;
-		if (!(new_item = cJSON_New_Item())) {
+		if (!(new_item = cJSON_New_Arena_Item(arena))) {
 			/* Memory fail */
 
 			return 0;
@@ -780,7 +1056,8 @@ static const char *parse_object(cJSON *item, const char *value)
 		child->next = new_item;
 		new_item->prev = child;
 		child = new_item;
-		value = skip(parse_string(child, skip(value + 1)));
+		count++;
+		value = skip(parse_string(arena, child, skip(value + 1)));
 		if (!value) {
 			return 0;
 		}
@@ -794,14 +1071,22 @@ static const char *parse_object(cJSON *item, const char *value)
 
 		/* Skip any spacing, get the value. */
 
-		value = skip(parse_value(child, skip(value + 1)));
+		value = skip(parse_value(arena, child, skip(value + 1)));
 		if (!value) {
 			return 0;
 		}
 	}
 
 	if (*value == '}') {
-		/* End of array */
+		/* End of object. Lookups never change the tree, so that readers can
+		 * share it: large objects are indexed now or not at all.
+		 */
+
+#if CJSON_INDEX_THRESHOLD > 0
+		if (count >= CJSON_INDEX_THRESHOLD) {
+			cJSON_index_build(arena, item, count);
+		}
+#endif
 
 		return value + 1;
 	}
@@ -969,11 +1254,85 @@ static cJSON *create_reference(cJSON *item)
 
 	memcpy(ref, item, sizeof(cJSON));
 	ref->string = 0;
+	ref->index = 0;
 	ref->type |= cJSON_IsReference;
 	ref->next = ref->prev = 0;
 	return ref;
 }
 
+/* Unlink c from the members of array. */
+
+static cJSON *detach_item(cJSON *array, cJSON *c)
+{
+	if (c->prev) {
+		c->prev->next = c->next;
+	}
+
+	if (c->next) {
+		c->next->prev = c->prev;
+	}
+
+	if (c == array->child) {
+		array->child = c->next;
+	}
+
+	c->prev = c->next = 0;
+
+#if CJSON_INDEX_THRESHOLD > 0
+	if (array->index) {
+		cJSON_index_remove(array, c);
+	}
+#endif
+
+	return c;
+}
+
+/* Put newitem in the place of c among the members of array, delete c. */
+
+static void replace_item(cJSON *array, cJSON *c, cJSON *newitem)
+{
+#if CJSON_INDEX_THRESHOLD > 0
+	int reindex = 0;
+
+	if (array->index) {
+		cJSON **slot = c->string ? cJSON_index_slot(array->index, c->string) : 0;
+
+		/* Same name in the same place: the entry just changes hands.
+		 * Anything else is rare enough to rebuild the index below, except
+		 * in an arena, where a new one could not be freed.
+		 */
+
+		if (slot && *slot == c && newitem->string && !cJSON_strcasecmp(c->string, newitem->string)) {
+			*slot = newitem;
+		} else {
+			reindex = !array->index->arena;
+			cJSON_index_drop(array);
+		}
+	}
+#endif
+
+	newitem->next = c->next;
+	newitem->prev = c->prev;
+	if (newitem->next) {
+		newitem->next->prev = newitem;
+	}
+
+	if (c == array->child) {
+		array->child = newitem;
+	} else {
+		newitem->prev->next = newitem;
+	}
+
+	c->next = c->prev = 0;
+	cJSON_Delete(c);
+
+#if CJSON_INDEX_THRESHOLD > 0
+	if (reindex) {
+		(void)cJSON_IndexObject(array);
+	}
+#endif
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -1008,6 +1367,10 @@ void cJSON_Delete(cJSON *c)
 			cJSON_Delete(c->child);
 		}
 
+#if CJSON_INDEX_THRESHOLD > 0
+		cJSON_index_drop(c);
+#endif
+
 		if (!(c->type & cJSON_IsReference) && c->valuestring) {
 			cJSON_free(c->valuestring);
 		}
@@ -1033,7 +1396,7 @@ cJSON *cJSON_Parse(const char *value)
 		return 0;
 	}
 
-	if (!parse_value(c, skip(value))) {
+	if (!parse_value(0, c, skip(value))) {
 		cJSON_Delete(c);
 		return 0;
 	}
@@ -1041,6 +1404,110 @@ cJSON *cJSON_Parse(const char *value)
 	return c;
 }
 
+void cJSON_ArenaInit(cJSON_Arena *arena, void *buf, size_t size)
+{
+	memset(arena, 0, sizeof(cJSON_Arena));
+
+	/* Keep the caller's buffer aligned like the blocks we allocate */
+
+	if (buf) {
+		size_t pad = CJSON_ARENA_ALIGN((size_t)buf) - (size_t)buf;
+		if (size > pad) {
+			arena->user_buf = (char *)buf + pad;
+			arena->user_size = size - pad;
+		}
+	}
+
+	arena->buf = arena->user_buf;
+	arena->size = arena->user_size;
+}
+
+/* Parse into an arena: nodes and strings are carved from the arena's
+ * blocks instead of being allocated one by one.
+ */
+
+cJSON *cJSON_ParseArena(cJSON_Arena *arena, const char *value)
+{
+	char *buf;
+	size_t used;
+	cJSON *c;
+
+	ep = 0;
+	if (!arena->buf && cJSON_arena_grow(arena, CJSON_ARENA_HINT(strlen(value))) < 0) {
+		return 0;
+	}
+
+	buf = arena->buf;
+	used = arena->used;
+
+	c = cJSON_New_Arena_Item(arena);
+	if (!c) {
+		return 0;
+	}
+
+	if (!parse_value(arena, c, skip(value))) {
+		/* Give back what this document used, unless the arena has moved
+		 * to a new block since.
+		 */
+
+		if (arena->buf == buf) {
+			arena->used = used;
+		}
+
+		return 0;
+	}
+
+	return c;
+}
+
+void cJSON_ArenaReset(cJSON_Arena *arena)
+{
+	struct cJSON_ArenaBlock *block = (struct cJSON_ArenaBlock *)arena->blocks;
+	struct cJSON_ArenaBlock *next;
+
+	/* Keep the newest block, it is the largest one. Free the others. */
+
+	if (block) {
+		next = block->next;
+		block->next = 0;
+		while (next) {
+			struct cJSON_ArenaBlock *tmp = next->next;
+			cJSON_free(next);
+			next = tmp;
+		}
+
+		if (block->size >= arena->user_size) {
+			arena->buf = (char *)block + CJSON_ARENA_HDR;
+			arena->size = block->size;
+			arena->used = 0;
+			return;
+		}
+
+		cJSON_free(block);
+		arena->blocks = 0;
+	}
+
+	arena->buf = arena->user_buf;
+	arena->size = arena->user_size;
+	arena->used = 0;
+}
+
+void cJSON_ArenaFree(cJSON_Arena *arena)
+{
+	struct cJSON_ArenaBlock *block = (struct cJSON_ArenaBlock *)arena->blocks;
+
+	while (block) {
+		struct cJSON_ArenaBlock *next = block->next;
+		cJSON_free(block);
+		block = next;
+	}
+
+	arena->blocks = 0;
+	arena->buf = arena->user_buf;
+	arena->size = arena->user_size;
+	arena->used = 0;
+}
+
 /* Render a cJSON item/entity/structure to text. */
 
 char *cJSON_Print(cJSON *item)
@@ -1084,6 +1551,12 @@ cJSON *cJSON_GetObjectItem(cJSON *object, const char *string)
 {
 	cJSON *c = object->child;
 
+#if CJSON_INDEX_THRESHOLD > 0
+	if (object->index && string) {
+		return *cJSON_index_slot(object->index, string);
+	}
+#endif
+
 	while (c && cJSON_strcasecmp(c->string, string)) {
 		c = c->next;
 	}
@@ -1091,6 +1564,37 @@ cJSON *cJSON_GetObjectItem(cJSON *object, const char *string)
 	return c;
 }
 
+/* A reference shares the members of another object, which may change
+ * under it, so it is never indexed.
+ */
+
+int cJSON_IndexObject(cJSON *object)
+{
+#if CJSON_INDEX_THRESHOLD > 0
+	unsigned int count = 0;
+	cJSON *c;
+
+	if (!object || (object->type & 255) != cJSON_Object || (object->type & cJSON_IsReference)) {
+		return -1;
+	}
+
+	if (object->index && object->index->arena) {
+		/* Indexed while parsing into an arena, and kept current since */
+
+		return 0;
+	}
+
+	for (c = object->child; c; c = c->next) {
+		count++;
+	}
+
+	return cJSON_index_build(0, object, count);
+#else
+	(void)object;
+	return -1;
+#endif
+}
+
 /* Add item to array/object. */
 void cJSON_AddItemToArray(cJSON *array, cJSON *item)
 {
@@ -1109,6 +1613,12 @@ void cJSON_AddItemToArray(cJSON *array, cJSON *item)
 
 		suffix_object(c, item);
 	}
+
+#if CJSON_INDEX_THRESHOLD > 0
+	if (array->index) {
+		cJSON_index_add(array, item);
+	}
+#endif
 }
 
 void cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
@@ -1147,20 +1657,7 @@ cJSON *cJSON_DetachItemFromArray(cJSON *array, int which)
 		return 0;
 	}
 
-	if (c->prev) {
-		c->prev->next = c->next;
-	}
-
-	if (c->next) {
-		c->next->prev = c->prev;
-	}
-
-	if (c == array->child) {
-		array->child = c->next;
-	}
-
-	c->prev = c->next = 0;
-	return c;
+	return detach_item(array, c);
 }
 
 void cJSON_DeleteItemFromArray(cJSON *array, int which)
@@ -1170,16 +1667,10 @@ void cJSON_DeleteItemFromArray(cJSON *array, int which)
 
 cJSON *cJSON_DetachItemFromObject(cJSON *object, const char *string)
 {
-	int i = 0;
-	cJSON *c = object->child;
-
-	while (c && cJSON_strcasecmp(c->string, string)) {
-		i++;
-		c = c->next;
-	}
+	cJSON *c = cJSON_GetObjectItem(object, string);
 
 	if (c) {
-		return cJSON_DetachItemFromArray(object, i);
+		return detach_item(object, c);
 	}
 
 	return 0;
@@ -1204,35 +1695,16 @@ void cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newitem)
 		return;
 	}
 
-	newitem->next = c->next;
-	newitem->prev = c->prev;
-	if (newitem->next) {
-		newitem->next->prev = newitem;
-	}
-
-	if (c == array->child) {
-		array->child = newitem;
-	} else {
-		newitem->prev->next = newitem;
-	}
-
-	c->next = c->prev = 0;
-	cJSON_Delete(c);
+	replace_item(array, c, newitem);
 }
 
 void cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newitem)
 {
-	int i = 0;
-	cJSON *c = object->child;
-
-	while (c && cJSON_strcasecmp(c->string, string)) {
-		i++;
-		c = c->next;
-	}
+	cJSON *c = cJSON_GetObjectItem(object, string);
 
 	if (c) {
 		newitem->string = cJSON_strdup(string);
-		cJSON_ReplaceItemInArray(object, i, newitem);
+		replace_item(object, c, newitem);
 	}
 }
 
@@ -0,0 +1,562 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * apps/netutils/json/json_reader.c
+ *
+ * In-place pull tokenizer for JSON. The reader keeps one bit of state per
+ * nesting level and never allocates; string tokens are unescaped inside
+ * the input buffer, which works because every escape sequence is longer
+ * than the UTF-8 it decodes to.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include <apps/netutils/json_stream.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* What the reader expects next */
+
+#define ST_VALUE        0		/* A value */
+#define ST_VALUE_OR_END 1		/* A value or ']' (right after '[') */
+#define ST_KEY          2		/* A member name */
+#define ST_KEY_OR_END   3		/* A member name or '}' (right after '{') */
+#define ST_NEXT         4		/* ',' or the end of the container */
+#define ST_DONE         5		/* Nothing, the top-level value is complete */
+#define ST_ERROR        6
+
+#define IN_OBJECT(rd)   ((rd)->stack & (1UL << ((rd)->depth - 1)))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int reader_error(struct json_reader *rd, struct json_token *tok)
+{
+	rd->err = rd->buf + rd->pos;
+	rd->state = ST_ERROR;
+	tok->type = JSON_TOKEN_ERROR;
+	tok->str = rd->err;
+	tok->len = 0;
+	return JSON_TOKEN_ERROR;
+}
+
+static void skip_ws(struct json_reader *rd)
+{
+	while (rd->pos < rd->len) {
+		char c = rd->buf[rd->pos];
+		if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+			break;
+		}
+		rd->pos++;
+	}
+}
+
+static void value_done(struct json_reader *rd)
+{
+	rd->state = rd->depth ? ST_NEXT : ST_DONE;
+}
+
+static int hex4(const char *p, const char *end, unsigned *uc)
+{
+	unsigned v = 0;
+	int i;
+
+	if (end - p < 4) {
+		return -1;
+	}
+
+	for (i = 0; i < 4; i++) {
+		char c = p[i];
+		v <<= 4;
+		if (c >= '0' && c <= '9') {
+			v |= c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			v |= c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			v |= c - 'A' + 10;
+		} else {
+			return -1;
+		}
+	}
+
+	*uc = v;
+	return 0;
+}
+
+/* Read the string at rd->pos (which is on the opening quote), unescape it
+ * in place and terminate it where it ends.
+ */
+
+static int read_string(struct json_reader *rd, struct json_token *tok)
+{
+	char *start = rd->buf + rd->pos + 1;
+	char *end = rd->buf + rd->len;
+	char *in = start;
+	char *out;
+	unsigned uc;
+	unsigned uc2;
+
+	/* Fast path: nothing to move until the first escape */
+
+	while (in < end && *in != '"' && *in != '\\' && (unsigned char)*in >= 0x20) {
+		in++;
+	}
+
+	out = in;
+	while (in < end) {
+		char c = *in;
+
+		if (c == '"') {
+			*out = '\0';
+			tok->str = start;
+			tok->len = out - start;
+			rd->pos = in + 1 - rd->buf;
+			return 0;
+		}
+
+		if ((unsigned char)c < 0x20) {
+			break;
+		}
+
+		if (c != '\\') {
+			*out++ = *in++;
+			continue;
+		}
+
+		if (++in >= end) {
+			break;
+		}
+
+		switch (*in++) {
+		case '"':
+			*out++ = '"';
+			break;
+
+		case '\\':
+			*out++ = '\\';
+			break;
+
+		case '/':
+			*out++ = '/';
+			break;
+
+		case 'b':
+			*out++ = '\b';
+			break;
+
+		case 'f':
+			*out++ = '\f';
+			break;
+
+		case 'n':
+			*out++ = '\n';
+			break;
+
+		case 'r':
+			*out++ = '\r';
+			break;
+
+		case 't':
+			*out++ = '\t';
+			break;
+
+		case 'u':
+			if (hex4(in, end, &uc) < 0) {
+				goto errout;
+			}
+			in += 4;
+
+			if (uc >= 0xdc00 && uc <= 0xdfff) {
+				/* Second half of a surrogate pair without the first */
+
+				goto errout;
+			}
+
+			if (uc >= 0xd800 && uc <= 0xdbff) {
+				if (end - in < 6 || in[0] != '\\' || in[1] != 'u' || hex4(in + 2, end, &uc2) < 0 || uc2 < 0xdc00 || uc2 > 0xdfff) {
+					goto errout;
+				}
+				in += 6;
+				uc = 0x10000 + (((uc & 0x3ff) << 10) | (uc2 & 0x3ff));
+			}
+
+			if (uc < 0x80) {
+				*out++ = uc;
+			} else if (uc < 0x800) {
+				*out++ = 0xc0 | (uc >> 6);
+				*out++ = 0x80 | (uc & 0x3f);
+			} else if (uc < 0x10000) {
+				*out++ = 0xe0 | (uc >> 12);
+				*out++ = 0x80 | ((uc >> 6) & 0x3f);
+				*out++ = 0x80 | (uc & 0x3f);
+			} else {
+				*out++ = 0xf0 | (uc >> 18);
+				*out++ = 0x80 | ((uc >> 12) & 0x3f);
+				*out++ = 0x80 | ((uc >> 6) & 0x3f);
+				*out++ = 0x80 | (uc & 0x3f);
+			}
+			break;
+
+		default:
+			goto errout;
+		}
+	}
+
+errout:
+	rd->pos = in - rd->buf;
+	return -1;
+}
+
+static int read_number(struct json_reader *rd, struct json_token *tok)
+{
+	const char *start = rd->buf + rd->pos;
+	const char *end = rd->buf + rd->len;
+	const char *p = start;
+
+	if (*p == '-') {
+		p++;
+	}
+
+	if (p < end && *p == '0') {
+		p++;
+	} else if (p < end && *p >= '1' && *p <= '9') {
+		while (p < end && *p >= '0' && *p <= '9') {
+			p++;
+		}
+	} else {
+		goto errout;
+	}
+
+	if (p < end && *p == '.') {
+		p++;
+		if (p >= end || *p < '0' || *p > '9') {
+			goto errout;
+		}
+		while (p < end && *p >= '0' && *p <= '9') {
+			p++;
+		}
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		if (p < end && (*p == '+' || *p == '-')) {
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9') {
+			goto errout;
+		}
+		while (p < end && *p >= '0' && *p <= '9') {
+			p++;
+		}
+	}
+
+	tok->str = start;
+	tok->len = p - start;
+	rd->pos = p - rd->buf;
+	return 0;
+
+errout:
+	rd->pos = p - rd->buf;
+	return -1;
+}
+
+static int read_literal(struct json_reader *rd, struct json_token *tok, const char *lit, size_t len)
+{
+	if (rd->len - rd->pos < len || memcmp(rd->buf + rd->pos, lit, len) != 0) {
+		return -1;
+	}
+
+	tok->str = rd->buf + rd->pos;
+	tok->len = len;
+	rd->pos += len;
+	return 0;
+}
+
+static int read_close(struct json_reader *rd, struct json_token *tok, char c)
+{
+	int object = IN_OBJECT(rd) ? 1 : 0;
+
+	if (object != (c == '}')) {
+		return reader_error(rd, tok);
+	}
+
+	tok->type = object ? JSON_TOKEN_OBJECT_END : JSON_TOKEN_ARRAY_END;
+	tok->str = rd->buf + rd->pos;
+	tok->len = 1;
+	rd->pos++;
+	rd->depth--;
+	value_done(rd);
+	return tok->type;
+}
+
+static int read_open(struct json_reader *rd, struct json_token *tok, int object)
+{
+	if (rd->depth >= JSON_STREAM_MAX_DEPTH) {
+		return reader_error(rd, tok);
+	}
+
+	if (object) {
+		rd->stack |= 1UL << rd->depth;
+	} else {
+		rd->stack &= ~(1UL << rd->depth);
+	}
+
+	rd->depth++;
+	tok->type = object ? JSON_TOKEN_OBJECT_START : JSON_TOKEN_ARRAY_START;
+	tok->str = rd->buf + rd->pos;
+	tok->len = 1;
+	rd->pos++;
+	rd->state = object ? ST_KEY_OR_END : ST_VALUE_OR_END;
+	return tok->type;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void json_reader_init(struct json_reader *rd, char *buf, size_t len)
+{
+	memset(rd, 0, sizeof(*rd));
+	rd->buf = buf;
+	rd->len = len;
+	rd->state = ST_VALUE;
+}
+
+int json_reader_next(struct json_reader *rd, struct json_token *tok)
+{
+	char c;
+
+	if (rd->state == ST_ERROR) {
+		tok->type = JSON_TOKEN_ERROR;
+		tok->str = rd->err;
+		tok->len = 0;
+		return JSON_TOKEN_ERROR;
+	}
+
+	skip_ws(rd);
+
+	if (rd->state == ST_DONE) {
+		/* Allow a C string to be passed with its terminator included */
+
+		if (rd->pos < rd->len && rd->buf[rd->pos] != '\0') {
+			return reader_error(rd, tok);
+		}
+
+		tok->type = JSON_TOKEN_END;
+		tok->str = rd->buf + rd->pos;
+		tok->len = 0;
+		return JSON_TOKEN_END;
+	}
+
+	if (rd->pos >= rd->len) {
+		return reader_error(rd, tok);
+	}
+
+	c = rd->buf[rd->pos];
+
+	if (rd->state == ST_NEXT) {
+		if (c == '}' || c == ']') {
+			return read_close(rd, tok, c);
+		}
+
+		if (c != ',') {
+			return reader_error(rd, tok);
+		}
+
+		rd->pos++;
+		skip_ws(rd);
+		if (rd->pos >= rd->len) {
+			return reader_error(rd, tok);
+		}
+
+		c = rd->buf[rd->pos];
+		rd->state = IN_OBJECT(rd) ? ST_KEY : ST_VALUE;
+	} else if ((rd->state == ST_KEY_OR_END && c == '}') || (rd->state == ST_VALUE_OR_END && c == ']')) {
+		return read_close(rd, tok, c);
+	}
+
+	if (rd->state == ST_KEY || rd->state == ST_KEY_OR_END) {
+		if (c != '"' || read_string(rd, tok) < 0) {
+			return reader_error(rd, tok);
+		}
+
+		skip_ws(rd);
+		if (rd->pos >= rd->len || rd->buf[rd->pos] != ':') {
+			return reader_error(rd, tok);
+		}
+
+		rd->pos++;
+		rd->state = ST_VALUE;
+		tok->type = JSON_TOKEN_KEY;
+		return JSON_TOKEN_KEY;
+	}
+
+	switch (c) {
+	case '{':
+		return read_open(rd, tok, 1);
+
+	case '[':
+		return read_open(rd, tok, 0);
+
+	case '"':
+		if (read_string(rd, tok) < 0) {
+			return reader_error(rd, tok);
+		}
+		tok->type = JSON_TOKEN_STRING;
+		break;
+
+	case 't':
+		if (read_literal(rd, tok, "true", 4) < 0) {
+			return reader_error(rd, tok);
+		}
+		tok->type = JSON_TOKEN_TRUE;
+		break;
+
+	case 'f':
+		if (read_literal(rd, tok, "false", 5) < 0) {
+			return reader_error(rd, tok);
+		}
+		tok->type = JSON_TOKEN_FALSE;
+		break;
+
+	case 'n':
+		if (read_literal(rd, tok, "null", 4) < 0) {
+			return reader_error(rd, tok);
+		}
+		tok->type = JSON_TOKEN_NULL;
+		break;
+
+	default:
+		if (c != '-' && (c < '0' || c > '9')) {
+			return reader_error(rd, tok);
+		}
+
+		if (read_number(rd, tok) < 0) {
+			return reader_error(rd, tok);
+		}
+		tok->type = JSON_TOKEN_NUMBER;
+		break;
+	}
+
+	value_done(rd);
+	return tok->type;
+}
+
+int json_reader_skip(struct json_reader *rd, const struct json_token *tok)
+{
+	struct json_token t;
+	uint8_t depth;
+
+	switch (tok->type) {
+	case JSON_TOKEN_ERROR:
+		return JSON_TOKEN_ERROR;
+
+	case JSON_TOKEN_KEY:
+		/* Skip the member value */
+
+		if (json_reader_next(rd, &t) == JSON_TOKEN_ERROR) {
+			return JSON_TOKEN_ERROR;
+		}
+		return json_reader_skip(rd, &t);
+
+	case JSON_TOKEN_OBJECT_START:
+	case JSON_TOKEN_ARRAY_START:
+		depth = rd->depth - 1;
+		do {
+			if (json_reader_next(rd, &t) == JSON_TOKEN_ERROR) {
+				return JSON_TOKEN_ERROR;
+			}
+		} while (rd->depth != depth);
+		return 0;
+
+	default:
+		return 0;
+	}
+}
+
+bool json_token_equals(const struct json_token *tok, const char *str)
+{
+	return strlen(str) == tok->len && memcmp(tok->str, str, tok->len) == 0;
+}
+
+int json_token_to_int(const struct json_token *tok, int *value)
+{
+	const char *p = tok->str;
+	const char *end = tok->str + tok->len;
+	unsigned long limit = (unsigned long)INT_MAX;
+	unsigned long v = 0;
+	double d;
+	int neg = 0;
+
+	if (tok->type != JSON_TOKEN_NUMBER) {
+		return -1;
+	}
+
+	if (p < end && *p == '-') {
+		neg = 1;
+		limit++;
+		p++;
+	}
+
+	while (p < end && *p >= '0' && *p <= '9') {
+		unsigned digit = *p++ - '0';
+		if (v > (limit - digit) / 10) {
+			return -1;
+		}
+		v = v * 10 + digit;
+	}
+
+	if (p != end) {
+		/* Fraction or exponent */
+
+		if (json_token_to_double(tok, &d) < 0 || d < INT_MIN || d > INT_MAX) {
+			return -1;
+		}
+		*value = (int)d;
+		return 0;
+	}
+
+	*value = neg ? (int)(0 - v) : (int)v;
+	return 0;
+}
+
+int json_token_to_double(const struct json_token *tok, double *value)
+{
+	char tmp[64];
+
+	if (tok->type != JSON_TOKEN_NUMBER || tok->len >= sizeof(tmp)) {
+		return -1;
+	}
+
+	/* The literal is not terminated in the input buffer */
+
+	memcpy(tmp, tok->str, tok->len);
+	tmp[tok->len] = '\0';
+	*value = strtod(tmp, NULL);
+	return 0;
+}
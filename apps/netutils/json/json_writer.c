@@ -0,0 +1,480 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * apps/netutils/json/json_writer.c
+ *
+ * Streaming JSON writer. Output goes straight into the caller's buffer;
+ * with a flush callback the buffer is drained whenever it fills up.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <apps/netutils/json_stream.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WR_ERROR(wr)    ((wr)->err = -1)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char g_hex[] = "0123456789abcdef";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int wr_drain(struct json_writer *wr)
+{
+	if (wr->len == 0) {
+		return 0;
+	}
+
+	if (!wr->flush || wr->flush(wr->arg, wr->buf, wr->len) < 0) {
+		return WR_ERROR(wr);
+	}
+
+	wr->len = 0;
+	return 0;
+}
+
+static void wr_put(struct json_writer *wr, const char *data, size_t len)
+{
+	/* Without a flush callback the last byte is kept for the NUL */
+
+	size_t room = wr->flush ? wr->size : wr->size - 1;
+
+	wr->total += len;
+	while (len > 0 && !wr->err) {
+		size_t n = room - wr->len;
+
+		if (n == 0) {
+			wr_drain(wr);
+			continue;
+		}
+
+		if (n > len) {
+			n = len;
+		}
+
+		memcpy(wr->buf + wr->len, data, n);
+		wr->len += n;
+		data += n;
+		len -= n;
+	}
+}
+
+static void wr_putc(struct json_writer *wr, char c)
+{
+	if (wr->len < wr->size - 1) {
+		wr->buf[wr->len++] = c;
+		wr->total++;
+	} else {
+		wr_put(wr, &c, 1);
+	}
+}
+
+/* Emit the ',' that goes before a new member or element, if it is not the
+ * first one of its level.
+ */
+
+static int wr_separator(struct json_writer *wr)
+{
+	uint32_t bit = 1UL << wr->depth;
+
+	if (wr->comma & bit) {
+		wr_putc(wr, ',');
+	}
+	wr->comma |= bit;
+	return wr->err;
+}
+
+/* Check that a value may go here and emit its separator. Inside an object
+ * only the value after a key may.
+ */
+
+static int wr_begin_value(struct json_writer *wr)
+{
+	if (wr->err) {
+		return wr->err;
+	}
+
+	if (wr->key) {
+		wr->key = false;
+		return 0;
+	}
+
+	if (wr->depth == 0) {
+		if (wr->comma & 1) {
+			/* Only one top-level value per document */
+
+			return WR_ERROR(wr);
+		}
+		wr->comma |= 1;
+		return 0;
+	}
+
+	if (wr->object & (1UL << wr->depth)) {
+		return WR_ERROR(wr);
+	}
+
+	return wr_separator(wr);
+}
+
+static void wr_string(struct json_writer *wr, const char *str)
+{
+	const char *run = str;
+	char esc[6];
+
+	wr_putc(wr, '"');
+	for (; *str; str++) {
+		unsigned char c = *str;
+
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+
+		/* Copy the plain run before the character, then escape it */
+
+		wr_put(wr, run, str - run);
+		run = str + 1;
+
+		esc[0] = '\\';
+		switch (c) {
+		case '"':
+		case '\\':
+			esc[1] = c;
+			break;
+
+		case '\b':
+			esc[1] = 'b';
+			break;
+
+		case '\f':
+			esc[1] = 'f';
+			break;
+
+		case '\n':
+			esc[1] = 'n';
+			break;
+
+		case '\r':
+			esc[1] = 'r';
+			break;
+
+		case '\t':
+			esc[1] = 't';
+			break;
+
+		default:
+			esc[1] = 'u';
+			esc[2] = '0';
+			esc[3] = '0';
+			esc[4] = g_hex[c >> 4];
+			esc[5] = g_hex[c & 0xf];
+			wr_put(wr, esc, 6);
+			continue;
+		}
+		wr_put(wr, esc, 2);
+	}
+
+	wr_put(wr, run, str - run);
+	wr_putc(wr, '"');
+}
+
+static int wr_open(struct json_writer *wr, char c, int object)
+{
+	if (wr_begin_value(wr) < 0) {
+		return wr->err;
+	}
+
+	if (wr->depth >= JSON_STREAM_MAX_DEPTH - 1) {
+		return WR_ERROR(wr);
+	}
+
+	wr->depth++;
+	wr->comma &= ~(1UL << wr->depth);
+	if (object) {
+		wr->object |= 1UL << wr->depth;
+	} else {
+		wr->object &= ~(1UL << wr->depth);
+	}
+
+	wr_putc(wr, c);
+	return wr->err;
+}
+
+static int wr_close(struct json_writer *wr, char c, int object)
+{
+	if (wr->err) {
+		return wr->err;
+	}
+
+	if (wr->depth == 0 || wr->key || !(wr->object & (1UL << wr->depth)) != !object) {
+		return WR_ERROR(wr);
+	}
+
+	wr->depth--;
+	wr_putc(wr, c);
+	return wr->err;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void json_writer_init(struct json_writer *wr, char *buf, size_t size, json_flush_fn flush, void *arg)
+{
+	memset(wr, 0, sizeof(*wr));
+	wr->buf = buf;
+	wr->size = size;
+	wr->flush = flush;
+	wr->arg = arg;
+	if (!buf || size < 2) {
+		wr->err = -1;
+	}
+}
+
+int json_writer_fd_flush(void *arg, const char *data, size_t len)
+{
+	int fd = (int)(intptr_t)arg;
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = write(fd, data, len);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+
+		data += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+int json_write_object_start(struct json_writer *wr)
+{
+	return wr_open(wr, '{', 1);
+}
+
+int json_write_object_end(struct json_writer *wr)
+{
+	return wr_close(wr, '}', 1);
+}
+
+int json_write_array_start(struct json_writer *wr)
+{
+	return wr_open(wr, '[', 0);
+}
+
+int json_write_array_end(struct json_writer *wr)
+{
+	return wr_close(wr, ']', 0);
+}
+
+int json_write_key(struct json_writer *wr, const char *key)
+{
+	if (wr->err) {
+		return wr->err;
+	}
+
+	if (wr->key || wr->depth == 0 || !(wr->object & (1UL << wr->depth))) {
+		return WR_ERROR(wr);
+	}
+
+	if (wr_separator(wr) < 0) {
+		return wr->err;
+	}
+
+	wr_string(wr, key ? key : "");
+	wr_putc(wr, ':');
+	wr->key = true;
+	return wr->err;
+}
+
+int json_write_string(struct json_writer *wr, const char *str)
+{
+	if (wr_begin_value(wr) < 0) {
+		return wr->err;
+	}
+
+	if (str) {
+		wr_string(wr, str);
+	} else {
+		wr_put(wr, "\"\"", 2);
+	}
+	return wr->err;
+}
+
+int json_write_int(struct json_writer *wr, long value)
+{
+	char tmp[24];
+	char *p = tmp + sizeof(tmp);
+	unsigned long v = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+
+	if (wr_begin_value(wr) < 0) {
+		return wr->err;
+	}
+
+	do {
+		*--p = '0' + v % 10;
+		v /= 10;
+	} while (v);
+
+	if (value < 0) {
+		*--p = '-';
+	}
+
+	wr_put(wr, p, tmp + sizeof(tmp) - p);
+	return wr->err;
+}
+
+int json_write_double(struct json_writer *wr, double value)
+{
+	char tmp[32];
+	int len;
+
+	/* Integral values print like integers, as cJSON does */
+
+	if (value >= INT_MIN && value <= INT_MAX && fabs(floor(value) - value) <= DBL_EPSILON) {
+		return json_write_int(wr, (long)value);
+	}
+
+	if (wr_begin_value(wr) < 0) {
+		return wr->err;
+	}
+
+	if (isnan(value) || isinf(value)) {
+		/* Not representable in JSON */
+
+		wr_put(wr, "null", 4);
+		return wr->err;
+	}
+
+	len = snprintf(tmp, sizeof(tmp), "%.15g", value);
+	if (len <= 0 || len >= (int)sizeof(tmp)) {
+		return WR_ERROR(wr);
+	}
+
+	wr_put(wr, tmp, len);
+	return wr->err;
+}
+
+int json_write_bool(struct json_writer *wr, bool value)
+{
+	if (wr_begin_value(wr) < 0) {
+		return wr->err;
+	}
+
+	if (value) {
+		wr_put(wr, "true", 4);
+	} else {
+		wr_put(wr, "false", 5);
+	}
+	return wr->err;
+}
+
+int json_write_null(struct json_writer *wr)
+{
+	if (wr_begin_value(wr) < 0) {
+		return wr->err;
+	}
+
+	wr_put(wr, "null", 4);
+	return wr->err;
+}
+
+int json_write_cjson(struct json_writer *wr, cJSON *item)
+{
+	cJSON *child;
+
+	if (!item) {
+		return WR_ERROR(wr);
+	}
+
+	switch (item->type & 255) {
+	case cJSON_NULL:
+		return json_write_null(wr);
+
+	case cJSON_False:
+		return json_write_bool(wr, false);
+
+	case cJSON_True:
+		return json_write_bool(wr, true);
+
+	case cJSON_Number:
+		return json_write_double(wr, item->valuedouble);
+
+	case cJSON_String:
+		return json_write_string(wr, item->valuestring);
+
+	case cJSON_Array:
+		json_write_array_start(wr);
+		for (child = item->child; child && !wr->err; child = child->next) {
+			json_write_cjson(wr, child);
+		}
+		return json_write_array_end(wr);
+
+	case cJSON_Object:
+		json_write_object_start(wr);
+		for (child = item->child; child && !wr->err; child = child->next) {
+			json_write_key(wr, child->string);
+			json_write_cjson(wr, child);
+		}
+		return json_write_object_end(wr);
+
+	default:
+		return WR_ERROR(wr);
+	}
+}
+
+ssize_t json_writer_finish(struct json_writer *wr)
+{
+	if (wr->err || wr->depth != 0 || wr->key) {
+		return -1;
+	}
+
+	if (wr->flush) {
+		if (wr_drain(wr) < 0) {
+			return -1;
+		}
+	} else {
+		wr->buf[wr->len] = '\0';
+	}
+
+	return wr->total;
+}
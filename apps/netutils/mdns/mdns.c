@@ -695,6 +695,159 @@ void rr_group_destroy(struct rr_group *group)
 	}
 }
 
+// ----- record cache -----
+
+#define CACHE_HEAP_MIN_SIZE		16
+
+// FNV-1a over the wire-format name, consistent with cmp_nlabel()
+static unsigned int nlabel_hash(const uint8_t *name)
+{
+	unsigned int hash = 2166136261u;
+
+	for (; *name; name++) {
+		hash ^= *name;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static inline struct rr_group **rr_cache_bucket(struct rr_cache *cache, const uint8_t *name)
+{
+	return &cache->bucket[nlabel_hash(name) & (MDNS_CACHE_HASH_SIZE - 1)];
+}
+
+static inline time_t rr_expiry(const struct rr_entry *rr)
+{
+	return rr->update_time + (time_t)rr->ttl;
+}
+
+static inline void rr_cache_heap_set(struct rr_cache *cache, int i, struct rr_entry *rr)
+{
+	cache->heap[i] = rr;
+	rr->cache_idx = i;
+}
+
+static void rr_cache_sift_up(struct rr_cache *cache, int i)
+{
+	struct rr_entry *rr = cache->heap[i];
+
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (rr_expiry(cache->heap[parent]) <= rr_expiry(rr)) {
+			break;
+		}
+		rr_cache_heap_set(cache, i, cache->heap[parent]);
+		i = parent;
+	}
+	rr_cache_heap_set(cache, i, rr);
+}
+
+static void rr_cache_sift_down(struct rr_cache *cache, int i)
+{
+	struct rr_entry *rr = cache->heap[i];
+
+	for (;;) {
+		int child = 2 * i + 1;
+		if (child >= cache->heap_len) {
+			break;
+		}
+		if (child + 1 < cache->heap_len && rr_expiry(cache->heap[child + 1]) < rr_expiry(cache->heap[child])) {
+			child++;
+		}
+		if (rr_expiry(rr) <= rr_expiry(cache->heap[child])) {
+			break;
+		}
+		rr_cache_heap_set(cache, i, cache->heap[child]);
+		i = child;
+	}
+	rr_cache_heap_set(cache, i, rr);
+}
+
+void rr_cache_init(struct rr_cache *cache)
+{
+	memset(cache, 0, sizeof(struct rr_cache));
+}
+
+void rr_cache_destroy(struct rr_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < MDNS_CACHE_HASH_SIZE; i++) {
+		rr_group_destroy(cache->bucket[i]);
+	}
+
+	if (cache->heap) {
+		MDNS_FREE(cache->heap);
+	}
+	rr_cache_init(cache);
+}
+
+// finds the rr_group of the given name, without walking other names
+struct rr_group *rr_cache_find(struct rr_cache *cache, uint8_t *name)
+{
+	return rr_group_find(*rr_cache_bucket(cache, name), name);
+}
+
+// adds a record to the cache, which then owns it
+// returns 0, or -1 if out of memory, in which case rr is destroyed
+int rr_cache_add(struct rr_cache *cache, struct rr_entry *rr)
+{
+	assert(rr != NULL);
+
+	if (cache->heap_len == cache->heap_size) {
+		int size = cache->heap_size ? cache->heap_size * 2 : CACHE_HEAP_MIN_SIZE;
+		struct rr_entry **heap = MDNS_MALLOC(size * sizeof(struct rr_entry *));
+		if (heap == NULL) {
+			rr_entry_destroy(rr);
+			return -1;
+		}
+		if (cache->heap) {
+			memcpy(heap, cache->heap, cache->heap_len * sizeof(struct rr_entry *));
+			MDNS_FREE(cache->heap);
+		}
+		cache->heap = heap;
+		cache->heap_size = size;
+	}
+
+	rr_group_add(rr_cache_bucket(cache, rr->name), rr);
+
+	rr_cache_heap_set(cache, cache->heap_len++, rr);
+	rr_cache_sift_up(cache, rr->cache_idx);
+	return 0;
+}
+
+// removes a cached record and destroys it
+void rr_cache_del(struct rr_cache *cache, struct rr_entry *rr)
+{
+	int i = rr->cache_idx;
+
+	assert(i >= 0 && i < cache->heap_len && cache->heap[i] == rr);
+
+	cache->heap_len--;
+	if (i < cache->heap_len) {
+		struct rr_entry *last = cache->heap[cache->heap_len];
+
+		rr_cache_heap_set(cache, i, last);
+		rr_cache_sift_up(cache, i);
+		rr_cache_sift_down(cache, last->cache_idx);
+	}
+
+	rr_group_del(rr_cache_bucket(cache, rr->name), rr);
+}
+
+// drops the records whose TTL has run out by now
+// returns the number of records dropped
+int rr_cache_expire(struct rr_cache *cache, time_t now)
+{
+	int count = 0;
+
+	while (cache->heap_len > 0 && now > rr_expiry(cache->heap[0])) {
+		rr_cache_del(cache, cache->heap[0]);
+		count++;
+	}
+	return count;
+}
+
 uint8_t *mdns_write_u16(uint8_t *ptr, const uint16_t v)
 {
 	*ptr++ = (uint8_t)(v >> 8) & 0xFF;
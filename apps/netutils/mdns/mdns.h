@@ -50,6 +50,7 @@
 #ifndef __MDNS_H__
 #define __MDNS_H__
 
+#include <tinyara/config.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -164,6 +165,9 @@ struct rr_entry {
 	} data;
 
 	time_t update_time;
+
+	// position in the rr_cache expiry heap, for cached entries only
+	int cache_idx;
 };
 
 struct rr_list {
@@ -179,6 +183,23 @@ struct rr_group {
 	struct rr_group *next;
 };
 
+// number of hash buckets of an rr_cache, a power of 2
+#ifdef CONFIG_NETUTILS_MDNS_CACHE_HASH_SIZE
+#define MDNS_CACHE_HASH_SIZE	CONFIG_NETUTILS_MDNS_CACHE_HASH_SIZE
+#else
+#define MDNS_CACHE_HASH_SIZE	16
+#endif
+
+// records learned from the network: rr_groups hashed by name, and a
+// min-heap of the entries ordered by the time their TTL runs out
+struct rr_cache {
+	struct rr_group *bucket[MDNS_CACHE_HASH_SIZE];
+
+	struct rr_entry **heap;
+	int heap_len;
+	int heap_size;
+};
+
 #define MDNS_FLAG_RESP  (1 << 15)	// Query=0 / Response=1
 #define MDNS_FLAG_AA    (1 << 10)	// Authoritative
 #define MDNS_FLAG_TC    (1 <<  9)	// TrunCation
@@ -220,6 +241,13 @@ struct rr_entry *rr_entry_match(struct rr_list *rr_list, struct rr_entry *entry)
 void rr_group_add(struct rr_group **group, struct rr_entry *rr);
 void rr_group_del(struct rr_group **group, struct rr_entry *rr);
 
+void rr_cache_init(struct rr_cache *cache);
+void rr_cache_destroy(struct rr_cache *cache);
+struct rr_group *rr_cache_find(struct rr_cache *cache, uint8_t *name);
+int rr_cache_add(struct rr_cache *cache, struct rr_entry *rr);
+void rr_cache_del(struct rr_cache *cache, struct rr_entry *rr);
+int rr_cache_expire(struct rr_cache *cache, time_t now);
+
 int rr_list_count(struct rr_list *rr);
 int rr_list_append(struct rr_list **rr_head, struct rr_entry *rr);
 struct rr_entry *rr_list_remove(struct rr_list **rr_head, struct rr_entry *rr);
@@ -150,8 +150,9 @@ struct mdnsd {
 	int domain;
 
 	enum mdns_cache_status c_status;
-	char *c_filter;
-	struct rr_group *cache;
+	uint8_t *c_filter;			/* name label the cache is filtered on */
+	int c_svc_cached;			/* PTR or SRV records are in the cache */
+	struct rr_cache cache;
 	struct rr_list *query;
 #if defined(CONFIG_NETUTILS_MDNS_RESPONDER_SUPPORT)
 	struct rr_group *group;
@@ -222,33 +223,36 @@ static void print_rr_entry(struct rr_entry *rr_e)
 
 static void print_cache(struct mdnsd *svr)
 {
-	struct rr_group *group = svr->cache;
+	struct rr_group *group = NULL;
 	struct rr_list *list = NULL;
 	struct rr_entry *entry = NULL;
 	char *pname = NULL;
+	int i;
 
 	DEBUG_PRINTF("\n");
 	DEBUG_PRINTF(" Multicast DNS Cache\n");
 
-	for (; group; group = group->next) {
-		if (group->name) {
-			pname = nlabel_to_str(group->name);
-		} else {
-			pname = NULL;
-		}
+	for (i = 0; i < MDNS_CACHE_HASH_SIZE; i++) {
+		for (group = svr->cache.bucket[i]; group; group = group->next) {
+			if (group->name) {
+				pname = nlabel_to_str(group->name);
+			} else {
+				pname = NULL;
+			}
 
-		DEBUG_PRINTF("==================================================\n");
-		DEBUG_PRINTF(" Group: %s\n", pname ? pname : "Unknown");
-		DEBUG_PRINTF("==================================================\n");
-		if (pname) {
-			MDNS_FREE(pname);
-		}
+			DEBUG_PRINTF("==================================================\n");
+			DEBUG_PRINTF(" Group: %s\n", pname ? pname : "Unknown");
+			DEBUG_PRINTF("==================================================\n");
+			if (pname) {
+				MDNS_FREE(pname);
+			}
 
-		list = group->rr;
-		for (; list; list = list->next) {
-			entry = list->e;
-			if (entry) {
-				print_rr_entry(entry);
+			list = group->rr;
+			for (; list; list = list->next) {
+				entry = list->e;
+				if (entry) {
+					print_rr_entry(entry);
+				}
 			}
 		}
 	}
@@ -303,43 +307,21 @@ static char *get_service_type_without_subtype(char *name)
 static int lookup_hostname(struct mdnsd *svr, char *hostname)
 {
 	int result = -1;
-	struct rr_group *group = svr->cache;
-	struct rr_list *list = NULL;
-	struct rr_entry *entry = NULL;
-	int b_found = 0;
-	char *e_name;
-	int ret;
+	uint8_t *name = create_nlabel(hostname);
 
-	pthread_mutex_lock(&svr->data_lock);
-
-	for (; group; group = group->next) {
-		list = group->rr;
-		for (; list; list = list->next) {
-			entry = list->e;
-			if (entry && entry->name) {
-				e_name = nlabel_to_str(entry->name);
-				ret = strncmp(e_name, hostname, strlen(hostname));
-				MDNS_FREE(e_name);
-			} else {
-				ret = -1;
-			}
+	if (name == NULL) {
+		return result;
+	}
 
-			if (ret == 0) {
-				b_found = 1;
-				break;
-			}
-		}
+	pthread_mutex_lock(&svr->data_lock);
 
-		if (b_found) {
-			break;
-		}
+	if (rr_cache_find(&svr->cache, name)) {
+		result = 0;
 	}
 
 	pthread_mutex_unlock(&svr->data_lock);
 
-	if (b_found) {
-		result = 0;
-	}
+	MDNS_FREE(name);
 
 	return result;
 }
@@ -348,48 +330,30 @@ static int lookup_hostname(struct mdnsd *svr, char *hostname)
 static int lookup_hostname_to_addr(struct mdnsd *svr, char *hostname, int *ipaddr)
 {
 	int result = -1;
-	struct rr_group *group = svr->cache;
-	struct rr_list *list = NULL;
+	uint8_t *name = create_nlabel(hostname);
+	struct rr_group *group = NULL;
 	struct rr_entry *entry = NULL;
-	int b_found = 0;
-	char *e_name;
-	int ret;
+
+	if (name == NULL) {
+		return result;
+	}
 
 	update_cache(svr);
 
 	pthread_mutex_lock(&svr->data_lock);
 
-	for (; group; group = group->next) {
-		list = group->rr;
-		for (; list; list = list->next) {
-			entry = list->e;
-			if (entry && (entry->type == RR_A)) {	// currently, support only ipv4
-				if (entry->name) {
-					e_name = nlabel_to_str(entry->name);
-					ret = strncmp(e_name, hostname, strlen(hostname));
-					MDNS_FREE(e_name);
-				} else {
-					ret = -1;
-				}
-
-				if (ret == 0) {
-					*ipaddr = entry->data.A.addr;
-					b_found = 1;
-					break;
-				}
-			}
-		}
-
-		if (b_found) {
-			break;
+	group = rr_cache_find(&svr->cache, name);
+	if (group) {
+		entry = rr_entry_find(group->rr, name, RR_A);	// currently, support only ipv4
+		if (entry) {
+			*ipaddr = entry->data.A.addr;
+			result = 0;
 		}
 	}
 
 	pthread_mutex_unlock(&svr->data_lock);
 
-	if (b_found) {
-		result = 0;
-	}
+	MDNS_FREE(name);
 
 	return result;
 }
@@ -407,7 +371,7 @@ static int lookup_service(struct mdnsd *svr, char *type, struct mdns_service_inf
 
 	pthread_mutex_lock(&svr->data_lock);
 
-	struct rr_group *ptr_grp = rr_group_find(svr->cache, (uint8_t *)type_nlabel);
+	struct rr_group *ptr_grp = rr_cache_find(&svr->cache, (uint8_t *)type_nlabel);
 
 	MDNS_FREE(type_nlabel);
 	if (ptr_grp) {
@@ -417,7 +381,7 @@ static int lookup_service(struct mdnsd *svr, char *type, struct mdns_service_inf
 			entry = list->e;
 			if (entry && (entry->type == RR_PTR)) {
 				if (entry->data.PTR.name) {	/* SRV's name */
-					struct rr_group *srv_grp = rr_group_find(svr->cache,
+					struct rr_group *srv_grp = rr_cache_find(&svr->cache,
 											   (uint8_t *)entry->data.PTR.name);
 					if (srv_grp) {
 						/* find service */
@@ -451,7 +415,7 @@ static int lookup_service(struct mdnsd *svr, char *type, struct mdns_service_inf
 								MDNS_FREE(name);
 
 								/* ip address */
-								a_grp = rr_group_find(svr->cache, (uint8_t *)srv_e->data.SRV.target);
+								a_grp = rr_cache_find(&svr->cache, (uint8_t *)srv_e->data.SRV.target);
 								if (a_grp) {
 									struct rr_entry *a_e = rr_entry_find(a_grp->rr, srv_e->data.SRV.target, RR_A);
 									if (a_e) {
@@ -743,34 +707,37 @@ static void process_for_query(struct mdnsd *svr, struct mdns_pkt *mdns_packet)
 
 static void update_cache(struct mdnsd *svr)
 {
-	struct rr_group *group = svr->cache;
+	struct rr_group *group = NULL;
 	struct rr_list *list = NULL;
 	struct rr_entry *entry = NULL;
 	struct rr_list *remove_list = NULL;
+	int i;
 
 	pthread_mutex_lock(&svr->data_lock);
-	for (; group; group = group->next) {
-		list = group->rr;
-		for (; list; list = list->next) {
-			entry = list->e;
-			if (entry) {
-				/* if ttl is expired or rr is RR_PTR or RR_SRV, remove rr from cache */
-				if (((time(NULL) - entry->update_time) > entry->ttl) || (svr->c_status != CACHE_SERVICE_DISCOVERY && (entry->type == RR_PTR || entry->type == RR_SRV))) {
-					rr_list_append(&remove_list, entry);
+
+	/* RR_PTR and RR_SRV are only kept while service discovery runs */
+	if (svr->c_svc_cached && svr->c_status != CACHE_SERVICE_DISCOVERY) {
+		for (i = 0; i < MDNS_CACHE_HASH_SIZE; i++) {
+			for (group = svr->cache.bucket[i]; group; group = group->next) {
+				for (list = group->rr; list; list = list->next) {
+					entry = list->e;
+					if (entry && (entry->type == RR_PTR || entry->type == RR_SRV)) {
+						rr_list_append(&remove_list, entry);
+					}
 				}
 			}
 		}
-	}
 
-	/* remove ttl expired entry */
-	list = remove_list;
-	for (; list; list = list->next) {
-		entry = list->e;
-		if (entry) {
-			rr_group_del(&svr->cache, entry);
+		for (list = remove_list; list; list = list->next) {
+			rr_cache_del(&svr->cache, list->e);
 		}
+		rr_list_destroy(remove_list, 0);	/* destroy remove list */
+
+		svr->c_svc_cached = 0;
 	}
-	rr_list_destroy(remove_list, 0);	/* destroy remove list */
+
+	/* remove ttl expired entries, soonest to expire first */
+	rr_cache_expire(&svr->cache, time(NULL));
 
 	pthread_mutex_unlock(&svr->data_lock);
 }
@@ -809,13 +776,9 @@ static void add_rr_to_cache(struct mdnsd *svr, struct mdns_pkt *pkt)
 					rr_list_append(&filtered_rr_list, rr_e);
 #else
 					if (svr->c_status == CACHE_RESOLVE_HOSTNAME) {
-						if (svr->c_filter) {
-							char *name = nlabel_to_str(rr_e->name);
-							if (strncmp(name, svr->c_filter, strlen(svr->c_filter)) == 0) {
-								b_found = 1;
-								rr_list_append(&filtered_rr_list, rr_e);
-							}
-							MDNS_FREE(name);
+						if (svr->c_filter && cmp_nlabel(rr_e->name, svr->c_filter) == 0) {
+							b_found = 1;
+							rr_list_append(&filtered_rr_list, rr_e);
 						}
 					} else if (svr->c_status == CACHE_SERVICE_DISCOVERY) {
 						rr_list_append(&filtered_rr_list, rr_e);
@@ -823,13 +786,9 @@ static void add_rr_to_cache(struct mdnsd *svr, struct mdns_pkt *pkt)
 #endif							/* CONFIG_NETUTILS_MDNS_RESPONDER_SUPPORT */
 				} else if (rr_e->type == RR_PTR) {
 					if (svr->c_status == CACHE_SERVICE_DISCOVERY) {
-						if (svr->c_filter) {
-							char *name = nlabel_to_str(rr_e->name);
-							if (strncmp(name, svr->c_filter, strlen(svr->c_filter)) == 0) {
-								b_found = 1;
-								rr_list_append(&filtered_rr_list, rr_e);
-							}
-							MDNS_FREE(name);
+						if (svr->c_filter && cmp_nlabel(rr_e->name, svr->c_filter) == 0) {
+							b_found = 1;
+							rr_list_append(&filtered_rr_list, rr_e);
 						}
 					}
 				} else if (rr_e->type == RR_SRV) {
@@ -856,22 +815,25 @@ static void add_rr_to_cache(struct mdnsd *svr, struct mdns_pkt *pkt)
 
 		if (rr_e) {
 			cached_rr_e = NULL;
-			group = rr_group_find(svr->cache, rr_e->name);
+			group = rr_cache_find(&svr->cache, rr_e->name);
 			if (group) {
 				rr_e_in_cache = rr_entry_match(group->rr, rr_e);
-				if (rr_e_in_cache) {
-					rr_group_del(&svr->cache, rr_e_in_cache);
-					if (rr_e->ttl > 0) {
-						cached_rr_e = rr_duplicate(rr_e);
-						rr_group_add(&svr->cache, cached_rr_e);
-					}
-				} else {
-					cached_rr_e = rr_duplicate(rr_e);
-					rr_group_add(&svr->cache, cached_rr_e);
-				}
-			} else {
+			}
+
+			if (rr_e_in_cache) {
+				rr_cache_del(&svr->cache, rr_e_in_cache);
+			}
+
+			/* a known record with TTL 0 is a goodbye, it is only removed */
+			if (rr_e_in_cache == NULL || rr_e->ttl > 0) {
 				cached_rr_e = rr_duplicate(rr_e);
-				rr_group_add(&svr->cache, cached_rr_e);
+				if (cached_rr_e && rr_cache_add(&svr->cache, cached_rr_e) != 0) {
+					cached_rr_e = NULL;
+				}
+			}
+
+			if (cached_rr_e && (cached_rr_e->type == RR_PTR || cached_rr_e->type == RR_SRV)) {
+				svr->c_svc_cached = 1;
 			}
 
 			/* if SRV's target is null, add RR_A 's hostname to SRV's target */
@@ -1406,7 +1368,7 @@ static int probe_hostname(struct mdnsd *svr, char *hostname)
 	svr->c_status = CACHE_RESOLVE_HOSTNAME;
 	if (svr->c_filter) {
 		MDNS_FREE(svr->c_filter);
-		svr->c_filter = MDNS_STRDUP(hostname);
+		svr->c_filter = create_nlabel(hostname);
 	}
 	pthread_mutex_unlock(&svr->data_lock);
 
@@ -1679,6 +1641,7 @@ static int init_mdns_context(int domain)
 	g_svr->sockfd = -1;
 	g_svr->notify_pipe[0] = -1;
 	g_svr->notify_pipe[1] = -1;
+	rr_cache_init(&g_svr->cache);
 
 	switch (domain) {
 #if defined(CONFIG_NETUTILS_MDNS_XMDNS)
@@ -1809,8 +1772,7 @@ static void release_mdns_context_resource(void)
 	pthread_mutex_destroy(&g_svr->data_lock);
 	sem_destroy(&g_svr->sendmsg_sem);
 
-	rr_group_destroy(g_svr->cache);
-	g_svr->cache = NULL;
+	rr_cache_destroy(&g_svr->cache);
 
 	rr_list_destroy(g_svr->query, 0);
 	g_svr->query = NULL;
@@ -2169,7 +2131,7 @@ int mdnsd_resolve_hostname(char *hostname, int *ipaddr)
 		MDNS_FREE(g_svr->c_filter);
 		g_svr->c_filter = NULL;
 	}
-	g_svr->c_filter = MDNS_STRDUP(hostname);
+	g_svr->c_filter = create_nlabel(hostname);
 	pthread_mutex_unlock(&g_svr->data_lock);
 #endif
 
@@ -2331,7 +2293,7 @@ int mdnsd_discover_service(char *service_type, int discover_time_msec, struct md
 		MDNS_FREE(g_svr->c_filter);
 		g_svr->c_filter = NULL;
 	}
-	g_svr->c_filter = MDNS_STRDUP(service_type_str);
+	g_svr->c_filter = create_nlabel(service_type_str);
 	pthread_mutex_unlock(&g_svr->data_lock);
 
 	/* query PTR for service discovery */
@@ -42,6 +42,67 @@ Contributors:
 #include <send_mosq.h>
 #include <time_mosq.h>
 
+/* Besides the in/out queues, which keep the order messages are resent in,
+ * every queued message is chained by mid into mosq->in_mid_hash or
+ * mosq->out_mid_hash, so acknowledgements find it without walking the
+ * queue. A mid can be queued more than once on the incoming side (a
+ * retransmitted QoS 2 PUBLISH); buckets are kept in queue order so the
+ * oldest one is found first, as with the queue walk.
+ */
+
+static struct mosquitto_message_all **_mosquitto_mid_bucket(struct mosquitto *mosq, uint16_t mid, enum mosquitto_msg_direction dir)
+{
+	if (dir == mosq_md_out) {
+		return &mosq->out_mid_hash[MOSQ_MID_HASH(mid)];
+	} else {
+		return &mosq->in_mid_hash[MOSQ_MID_HASH(mid)];
+	}
+}
+
+static struct mosquitto_message_all *_mosquitto_message_find(struct mosquitto *mosq, uint16_t mid, enum mosquitto_msg_direction dir)
+{
+	struct mosquitto_message_all *message;
+
+	message = *_mosquitto_mid_bucket(mosq, mid, dir);
+	while (message && message->msg.mid != mid) {
+		message = message->hnext;
+	}
+	return message;
+}
+
+/* Take a message off its queue and its bucket. The queue length and the
+ * in-flight count are left to the caller. */
+static void _mosquitto_message_unlink(struct mosquitto *mosq, struct mosquitto_message_all *message, enum mosquitto_msg_direction dir)
+{
+	struct mosquitto_message_all **bucket;
+
+	bucket = _mosquitto_mid_bucket(mosq, message->msg.mid, dir);
+	while (*bucket && *bucket != message) {
+		bucket = &(*bucket)->hnext;
+	}
+	if (*bucket) {
+		*bucket = message->hnext;
+	}
+	message->hnext = NULL;
+
+	if (message->next) {
+		message->next->prev = message->prev;
+	} else if (dir == mosq_md_out) {
+		mosq->out_messages_last = message->prev;
+	} else {
+		mosq->in_messages_last = message->prev;
+	}
+	if (message->prev) {
+		message->prev->next = message->next;
+	} else if (dir == mosq_md_out) {
+		mosq->out_messages = message->next;
+	} else {
+		mosq->in_messages = message->next;
+	}
+	message->next = NULL;
+	message->prev = NULL;
+}
+
 void _mosquitto_message_cleanup(struct mosquitto_message_all **message)
 {
 	struct mosquitto_message_all *msg;
@@ -77,6 +138,10 @@ void _mosquitto_message_cleanup_all(struct mosquitto *mosq)
 		_mosquitto_message_cleanup(&mosq->out_messages);
 		mosq->out_messages = tmp;
 	}
+	mosq->in_messages_last = NULL;
+	mosq->out_messages_last = NULL;
+	memset(mosq->in_mid_hash, 0, sizeof(mosq->in_mid_hash));
+	memset(mosq->out_mid_hash, 0, sizeof(mosq->out_mid_hash));
 }
 
 int mosquitto_message_copy(struct mosquitto_message *dst, const struct mosquitto_message *src)
@@ -148,15 +213,24 @@ void mosquitto_message_free(struct mosquitto_message **message)
  */
 int _mosquitto_message_queue(struct mosquitto *mosq, struct mosquitto_message_all *message, enum mosquitto_msg_direction dir)
 {
+	struct mosquitto_message_all **bucket;
 	int rc = 0;
 
 	/* mosq->*_message_mutex should be locked before entering this function */
 	assert(mosq);
 	assert(message);
 
+	message->next = NULL;
+	message->hnext = NULL;
+	bucket = _mosquitto_mid_bucket(mosq, message->msg.mid, dir);
+	while (*bucket) {
+		bucket = &(*bucket)->hnext;
+	}
+	*bucket = message;
+
 	if (dir == mosq_md_out) {
 		mosq->out_queue_len++;
-		message->next = NULL;
+		message->prev = mosq->out_messages_last;
 		if (mosq->out_messages_last) {
 			mosq->out_messages_last->next = message;
 		} else {
@@ -172,7 +246,7 @@ int _mosquitto_message_queue(struct mosquitto *mosq, struct mosquitto_message_al
 		}
 	} else {
 		mosq->in_queue_len++;
-		message->next = NULL;
+		message->prev = mosq->in_messages_last;
 		if (mosq->in_messages_last) {
 			mosq->in_messages_last->next = message;
 		} else {
@@ -186,33 +260,25 @@ int _mosquitto_message_queue(struct mosquitto *mosq, struct mosquitto_message_al
 void _mosquitto_messages_reconnect_reset(struct mosquitto *mosq)
 {
 	struct mosquitto_message_all *message;
-	struct mosquitto_message_all *prev = NULL;
+	struct mosquitto_message_all *next;
 	assert(mosq);
 
 	pthread_mutex_lock(&mosq->in_message_mutex);
 	message = mosq->in_messages;
 	mosq->in_queue_len = 0;
 	while (message) {
-		mosq->in_queue_len++;
+		next = message->next;
 		message->timestamp = 0;
 		if (message->msg.qos != 2) {
-			if (prev) {
-				prev->next = message->next;
-				_mosquitto_message_cleanup(&message);
-				message = prev;
-			} else {
-				mosq->in_messages = message->next;
-				_mosquitto_message_cleanup(&message);
-				message = mosq->in_messages;
-			}
+			_mosquitto_message_unlink(mosq, message, mosq_md_in);
+			_mosquitto_message_cleanup(&message);
 		} else {
 			/* Message state can be preserved here because it should match
 			 * whatever the client has got. */
+			mosq->in_queue_len++;
 		}
-		prev = message;
-		message = message->next;
+		message = next;
 	}
-	mosq->in_messages_last = prev;
 	pthread_mutex_unlock(&mosq->in_message_mutex);
 
 	pthread_mutex_lock(&mosq->out_message_mutex);
@@ -235,103 +301,76 @@ void _mosquitto_messages_reconnect_reset(struct mosquitto *mosq)
 		} else {
 			message->state = mosq_ms_invalid;
 		}
-		prev = message;
 		message = message->next;
 	}
-	mosq->out_messages_last = prev;
 	pthread_mutex_unlock(&mosq->out_message_mutex);
 }
 
 int _mosquitto_message_remove(struct mosquitto *mosq, uint16_t mid, enum mosquitto_msg_direction dir, struct mosquitto_message_all **message)
 {
-	struct mosquitto_message_all *cur, *prev = NULL;
-	bool found = false;
+	struct mosquitto_message_all *cur;
 	int rc;
 	assert(mosq);
 	assert(message);
 
 	if (dir == mosq_md_out) {
 		pthread_mutex_lock(&mosq->out_message_mutex);
-		cur = mosq->out_messages;
-		while (cur) {
-			if (cur->msg.mid == mid) {
-				if (prev) {
-					prev->next = cur->next;
-				} else {
-					mosq->out_messages = cur->next;
-				}
-				*message = cur;
-				mosq->out_queue_len--;
-				if (cur->next == NULL) {
-					mosq->out_messages_last = prev;
-				} else if (!mosq->out_messages) {
-					mosq->out_messages_last = NULL;
-				}
-				if (cur->msg.qos > 0) {
-					mosq->inflight_messages--;
-				}
-				found = true;
-				break;
-			}
-			prev = cur;
-			cur = cur->next;
+		cur = _mosquitto_message_find(mosq, mid, dir);
+		if (!cur) {
+			pthread_mutex_unlock(&mosq->out_message_mutex);
+			return MOSQ_ERR_NOT_FOUND;
 		}
 
-		if (found) {
-			cur = mosq->out_messages;
-			while (cur) {
-				if (mosq->max_inflight_messages == 0 || mosq->inflight_messages < mosq->max_inflight_messages) {
-					if (cur->msg.qos > 0 && cur->state == mosq_ms_invalid) {
-						mosq->inflight_messages++;
-						if (cur->msg.qos == 1) {
-							cur->state = mosq_ms_wait_for_puback;
-						} else if (cur->msg.qos == 2) {
-							cur->state = mosq_ms_wait_for_pubrec;
-						}
-						rc = _mosquitto_send_publish(mosq, cur->msg.mid, cur->msg.topic, cur->msg.payloadlen, cur->msg.payload, cur->msg.qos, cur->msg.retain, cur->dup);
-						if (rc) {
-							pthread_mutex_unlock(&mosq->out_message_mutex);
-							return rc;
-						}
-					}
-				} else {
-					pthread_mutex_unlock(&mosq->out_message_mutex);
-					return MOSQ_ERR_SUCCESS;
-				}
-				cur = cur->next;
-			}
+		_mosquitto_message_unlink(mosq, cur, dir);
+		*message = cur;
+		mosq->out_queue_len--;
+		if (cur->msg.qos > 0) {
+			mosq->inflight_messages--;
+		}
+
+		/* Only QoS > 0 messages are queued, so every queued message beyond
+		 * inflight_messages is one still waiting for a slot; without any
+		 * there is nothing to start. */
+		if (mosq->out_queue_len <= mosq->inflight_messages) {
 			pthread_mutex_unlock(&mosq->out_message_mutex);
 			return MOSQ_ERR_SUCCESS;
-		} else {
-			pthread_mutex_unlock(&mosq->out_message_mutex);
-			return MOSQ_ERR_NOT_FOUND;
 		}
-	} else {
-		pthread_mutex_lock(&mosq->in_message_mutex);
-		cur = mosq->in_messages;
+
+		cur = mosq->out_messages;
 		while (cur) {
-			if (cur->msg.mid == mid) {
-				if (prev) {
-					prev->next = cur->next;
-				} else {
-					mosq->in_messages = cur->next;
-				}
-				*message = cur;
-				mosq->in_queue_len--;
-				if (cur->next == NULL) {
-					mosq->in_messages_last = prev;
-				} else if (!mosq->in_messages) {
-					mosq->in_messages_last = NULL;
+			if (mosq->max_inflight_messages == 0 || mosq->inflight_messages < mosq->max_inflight_messages) {
+				if (cur->msg.qos > 0 && cur->state == mosq_ms_invalid) {
+					mosq->inflight_messages++;
+					if (cur->msg.qos == 1) {
+						cur->state = mosq_ms_wait_for_puback;
+					} else if (cur->msg.qos == 2) {
+						cur->state = mosq_ms_wait_for_pubrec;
+					}
+					rc = _mosquitto_send_publish(mosq, cur->msg.mid, cur->msg.topic, cur->msg.payloadlen, cur->msg.payload, cur->msg.qos, cur->msg.retain, cur->dup);
+					if (rc) {
+						pthread_mutex_unlock(&mosq->out_message_mutex);
+						return rc;
+					}
 				}
-				found = true;
-				break;
+			} else {
+				pthread_mutex_unlock(&mosq->out_message_mutex);
+				return MOSQ_ERR_SUCCESS;
 			}
-			prev = cur;
 			cur = cur->next;
 		}
-
+		pthread_mutex_unlock(&mosq->out_message_mutex);
+		return MOSQ_ERR_SUCCESS;
+	} else {
+		pthread_mutex_lock(&mosq->in_message_mutex);
+		cur = _mosquitto_message_find(mosq, mid, dir);
+		if (cur) {
+			_mosquitto_message_unlink(mosq, cur, dir);
+			*message = cur;
+			mosq->in_queue_len--;
+		}
 		pthread_mutex_unlock(&mosq->in_message_mutex);
-		if (found) {
+
+		if (cur) {
 			return MOSQ_ERR_SUCCESS;
 		} else {
 			return MOSQ_ERR_NOT_FOUND;
@@ -407,18 +446,13 @@ int _mosquitto_message_out_update(struct mosquitto *mosq, uint16_t mid, enum mos
 	assert(mosq);
 
 	pthread_mutex_lock(&mosq->out_message_mutex);
-	message = mosq->out_messages;
-	while (message) {
-		if (message->msg.mid == mid) {
-			message->state = state;
-			message->timestamp = mosquitto_time();
-			pthread_mutex_unlock(&mosq->out_message_mutex);
-			return MOSQ_ERR_SUCCESS;
-		}
-		message = message->next;
+	message = _mosquitto_message_find(mosq, mid, mosq_md_out);
+	if (message) {
+		message->state = state;
+		message->timestamp = mosquitto_time();
 	}
 	pthread_mutex_unlock(&mosq->out_message_mutex);
-	return MOSQ_ERR_NOT_FOUND;
+	return message ? MOSQ_ERR_SUCCESS : MOSQ_ERR_NOT_FOUND;
 }
 
 int mosquitto_max_inflight_messages_set(struct mosquitto *mosq, unsigned int max_inflight_messages)
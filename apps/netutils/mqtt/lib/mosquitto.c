@@ -380,6 +380,12 @@ void _mosquitto_destroy(struct mosquitto *mosq)
 	}
 	_mosquitto_message_cleanup_all(mosq);
 	_mosquitto_will_clear(mosq);
+#if MOSQ_WRITE_BATCH > 1
+	if (mosq->write_buf) {
+		_mosquitto_free(mosq->write_buf);
+		mosq->write_buf = NULL;
+	}
+#endif
 #ifdef WITH_TLS
 	if (mosq->ssl) {
 		SSL_free(mosq->ssl);
@@ -1536,6 +1542,7 @@ int mosquitto_loop_read(struct mosquitto *mosq, int max_packets)
 
 int mosquitto_loop_write(struct mosquitto *mosq, int max_packets)
 {
+	bool pending;
 	int rc;
 	int i;
 	if (max_packets < 1) {
@@ -1561,6 +1568,15 @@ int mosquitto_loop_write(struct mosquitto *mosq, int max_packets)
 		if (rc || errno == EAGAIN || errno == COMPAT_EWOULDBLOCK) {
 			return _mosquitto_loop_rc_handle(mosq, rc);
 		}
+
+		/* Each call writes out the whole queue, so only go round again if
+		 * more was queued meanwhile rather than once per queued message. */
+		pthread_mutex_lock(&mosq->out_packet_mutex);
+		pending = mosq->out_packet != NULL;
+		pthread_mutex_unlock(&mosq->out_packet_mutex);
+		if (!pending) {
+			break;
+		}
 	}
 	return rc;
 }
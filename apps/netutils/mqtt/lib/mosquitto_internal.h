@@ -74,6 +74,7 @@ typedef unsigned long long uint64_t;
 #	include <stdint.h>
 #endif
 #if defined(__TINYARA__)
+#	include <tinyara/config.h>
 #	include <netdb.h>
 #endif
 
@@ -84,6 +85,30 @@ typedef unsigned long long uint64_t;
 struct mosquitto_client_msg;
 #endif
 
+/* Message ids are handed out sequentially, so the low bits of the mid
+ * spread the in-flight window evenly over the buckets.
+ */
+#ifndef CONFIG_NETUTILS_MQTT_MID_HASH_SIZE
+#	define CONFIG_NETUTILS_MQTT_MID_HASH_SIZE 16
+#endif
+#define MOSQ_MID_HASH_SIZE CONFIG_NETUTILS_MQTT_MID_HASH_SIZE
+#define MOSQ_MID_HASH(mid) ((mid) & (MOSQ_MID_HASH_SIZE - 1))
+#if MOSQ_MID_HASH_SIZE < 1 || (MOSQ_MID_HASH_SIZE & (MOSQ_MID_HASH_SIZE - 1)) != 0
+#	error "CONFIG_NETUTILS_MQTT_MID_HASH_SIZE must be a power of two"
+#endif
+
+/* Most packets _mosquitto_packet_write() hands to the socket at once, and
+ * the buffer they are merged in when they can't go out with sendmsg().
+ */
+#ifndef CONFIG_NETUTILS_MQTT_WRITE_BATCH
+#	define CONFIG_NETUTILS_MQTT_WRITE_BATCH 8
+#endif
+#define MOSQ_WRITE_BATCH CONFIG_NETUTILS_MQTT_WRITE_BATCH
+#ifndef CONFIG_NETUTILS_MQTT_WRITE_COALESCE
+#	define CONFIG_NETUTILS_MQTT_WRITE_COALESCE 512
+#endif
+#define MOSQ_WRITE_COALESCE CONFIG_NETUTILS_MQTT_WRITE_COALESCE
+
 #ifdef WIN32
 typedef SOCKET mosq_sock_t;
 #else
@@ -171,6 +196,8 @@ struct _mosquitto_packet {
 
 struct mosquitto_message_all {
 	struct mosquitto_message_all *next;
+	struct mosquitto_message_all *prev;
+	struct mosquitto_message_all *hnext;	/* Next in the same mid bucket */
 	time_t timestamp;
 	//enum mosquitto_msg_direction direction;
 	enum mosquitto_msg_state state;
@@ -197,6 +224,11 @@ struct mosquitto {
 	struct _mosquitto_packet in_packet;
 	struct _mosquitto_packet *current_out_packet;
 	struct _mosquitto_packet *out_packet;
+#if MOSQ_WRITE_BATCH > 1
+	uint8_t *write_buf;			/* MOSQ_WRITE_COALESCE bytes, allocated on first use */
+	uint8_t *write_retry;		/* Buffer of a TLS write that would block */
+	uint32_t write_retry_len;	/* and its length, to write it again as it was */
+#endif
 	struct mosquitto_message *will;
 #ifdef WITH_MBEDTLS
 	int mbedtls_state;
@@ -288,6 +320,8 @@ struct mosquitto {
 	struct mosquitto_message_all *in_messages_last;
 	struct mosquitto_message_all *out_messages;
 	struct mosquitto_message_all *out_messages_last;
+	struct mosquitto_message_all *in_mid_hash[MOSQ_MID_HASH_SIZE];
+	struct mosquitto_message_all *out_mid_hash[MOSQ_MID_HASH_SIZE];
 	void (*on_connect)(struct mosquitto *, void *userdata, int rc);
 	void (*on_disconnect)(struct mosquitto *, void *userdata, int rc);
 	void (*on_publish)(struct mosquitto *, void *userdata, int mid);
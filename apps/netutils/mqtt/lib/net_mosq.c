@@ -100,6 +100,10 @@ extern unsigned long g_pub_msgs_sent;
 
 #include "config.h"
 
+#if defined(WITH_MBEDTLS) && defined(CONFIG_TLS_SESSION_STORE)
+#	include <tls/tls_session_store.h>
+#endif
+
 #ifdef WITH_TLS
 int tls_ex_index_mosq = -1;
 #endif
@@ -247,6 +251,10 @@ int _mosquitto_socket_close(struct mosquitto *mosq)
 	}
 #endif
 
+#if MOSQ_WRITE_BATCH > 1
+	mosq->write_retry = NULL;
+#endif
+
 	if ((int)mosq->sock >= 0) {
 #ifdef WITH_BROKER
 		HASH_DELETE(hh_sock, db->contexts_by_sock, mosq);
@@ -538,9 +546,21 @@ int _mosquitto_socket_connect(struct mosquitto *mosq, const char *host, uint16_t
 		((mbedtls_net_context *)mosq->net)->fd = (int)sock;
 		mbedtls_ssl_set_bio(mosq->ssl_ctx, mosq->net, mbedtls_net_send, mbedtls_net_recv, NULL);
 
+#ifdef CONFIG_TLS_SESSION_STORE
+		/* Resume the last session with this broker, e.g. after a keepalive reconnect */
+		ret = tls_session_store_load(host, port, mosq->ssl_ctx);
 		if (mosquitto__socket_connect_tls(mosq)) {
+			if (ret == 0) {
+				tls_session_store_remove(host, port);
+			}
 			return MOSQ_ERR_TLS;
 		}
+		tls_session_store_save(host, port, mosq->ssl_ctx);
+#else
+		if (mosquitto__socket_connect_tls(mosq)) {
+			return MOSQ_ERR_TLS;
+		}
+#endif
 	}
 #endif
 
@@ -903,7 +923,16 @@ ssize_t _mosquitto_net_write(struct mosquitto *mosq, void *buf, size_t count)
 		if ((mosq->mbedtls_state == mosq_mbedtls_state_enabled) && mosq->ssl_ctx) {
 			ret = mbedtls_ssl_write(mosq->ssl_ctx, buf, count);
 			if (ret < 0) {
-				_mosquitto_log_printf(mosq, MOSQ_LOG_ERR, "mbedtls Write Error");
+				if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
+					ret = -1;
+					errno = EAGAIN;
+				} else if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+					ret = -1;
+					mosq->want_write = true;
+					errno = EAGAIN;
+				} else {
+					_mosquitto_log_printf(mosq, MOSQ_LOG_ERR, "mbedtls Write Error");
+				}
 			}
 			return (ssize_t)ret;
 		} else {
@@ -924,6 +953,135 @@ ssize_t _mosquitto_net_write(struct mosquitto *mosq, void *buf, size_t count)
 #endif
 }
 
+#if MOSQ_WRITE_BATCH > 1
+/* True when writes go through a TLS session rather than straight to the
+ * socket. */
+static bool _mosquitto_net_is_tls(struct mosquitto *mosq)
+{
+#ifdef WITH_TLS
+	if (mosq->ssl) {
+		return true;
+	}
+#endif
+#ifdef WITH_MBEDTLS
+	if ((mosq->mbedtls_state == mosq_mbedtls_state_enabled) && mosq->ssl_ctx) {
+		return true;
+	}
+#endif
+	return false;
+}
+#endif
+
+/* Write the unsent part of packet together with as many of the packets
+ * queued behind it as one call can take, and account the bytes written to
+ * each of them. On plain sockets the packets go out with one sendmsg();
+ * on TLS, or without sendmsg(), the small ones are merged into
+ * mosq->write_buf so they share a record (and a TCP segment) instead of
+ * costing one each. A DISCONNECT ends the batch, since the socket is closed
+ * after it.
+ *
+ * A TLS write that would block must be retried with the same buffer and
+ * length: the library sends the record it already built and reports that
+ * length as written. So the buffer is kept in mosq->write_retry and the
+ * next call writes it again instead of merging the queue afresh. It always
+ * holds the head of the queue, which is where the bytes are accounted.
+ *
+ * Only the writer, which holds current_out_packet_mutex, takes packets off
+ * the queue, so the batch stays valid after out_packet_mutex is dropped.
+ * Returns what _mosquitto_net_write() returns.
+ */
+static ssize_t _mosquitto_packet_write_batch(struct mosquitto *mosq, struct _mosquitto_packet *packet)
+{
+	ssize_t write_length;
+#if MOSQ_WRITE_BATCH > 1
+	struct _mosquitto_packet *batch[MOSQ_WRITE_BATCH];
+	struct _mosquitto_packet *next;
+	uint8_t *buf;
+	uint32_t len;
+	uint32_t n;
+	int count;
+	int i;
+#if defined(CONFIG_NET_SOCKET_SENDMSG) && !defined(WIN32)
+	struct iovec iov[MOSQ_WRITE_BATCH];
+	struct msghdr msg;
+#endif
+
+	count = 0;
+	batch[count++] = packet;
+	if ((packet->command & 0xF0) != DISCONNECT) {
+		pthread_mutex_lock(&mosq->out_packet_mutex);
+		for (next = mosq->out_packet; next && count < MOSQ_WRITE_BATCH; next = next->next) {
+			batch[count++] = next;
+			if ((next->command & 0xF0) == DISCONNECT) {
+				break;
+			}
+		}
+		pthread_mutex_unlock(&mosq->out_packet_mutex);
+	}
+
+#if defined(CONFIG_NET_SOCKET_SENDMSG) && !defined(WIN32)
+	if (count > 1 && !_mosquitto_net_is_tls(mosq)) {
+		for (i = 0; i < count; i++) {
+			iov[i].iov_base = &(batch[i]->payload[batch[i]->pos]);
+			iov[i].iov_len = batch[i]->to_process;
+		}
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = count;
+		errno = 0;
+		write_length = sendmsg(mosq->sock, &msg, 0);
+	} else
+#endif
+	{
+		if (mosq->write_retry) {
+			buf = mosq->write_retry;
+			len = mosq->write_retry_len;
+		} else if (count == 1 || packet->to_process >= MOSQ_WRITE_COALESCE || (!mosq->write_buf && !(mosq->write_buf = _mosquitto_malloc(MOSQ_WRITE_COALESCE)))) {
+			/* Alone, large enough to go out on its own, or no buffer to merge into */
+
+			buf = &(packet->payload[packet->pos]);
+			len = packet->to_process;
+		} else {
+			len = 0;
+			for (i = 0; i < count && len < MOSQ_WRITE_COALESCE; i++) {
+				n = batch[i]->to_process;
+				if (n > MOSQ_WRITE_COALESCE - len) {
+					n = MOSQ_WRITE_COALESCE - len;
+				}
+				memcpy(&mosq->write_buf[len], &(batch[i]->payload[batch[i]->pos]), n);
+				len += n;
+			}
+			buf = mosq->write_buf;
+		}
+
+		write_length = _mosquitto_net_write(mosq, buf, len);
+
+		mosq->write_retry = NULL;
+		if (write_length < 0 && errno == EAGAIN && _mosquitto_net_is_tls(mosq)) {
+			mosq->write_retry = buf;
+			mosq->write_retry_len = len;
+		}
+	}
+
+	if (write_length > 0) {
+		len = write_length;
+		for (i = 0; i < count && len > 0; i++) {
+			n = batch[i]->to_process < len ? batch[i]->to_process : len;
+			batch[i]->to_process -= n;
+			batch[i]->pos += n;
+			len -= n;
+		}
+	}
+#else
+	write_length = _mosquitto_net_write(mosq, &(packet->payload[packet->pos]), packet->to_process);
+	if (write_length > 0) {
+		packet->to_process -= write_length;
+		packet->pos += write_length;
+	}
+#endif
+	return write_length;
+}
+
 int _mosquitto_packet_write(struct mosquitto *mosq)
 {
 	ssize_t write_length;
@@ -956,13 +1114,11 @@ int _mosquitto_packet_write(struct mosquitto *mosq)
 		packet = mosq->current_out_packet;
 
 		while (packet->to_process > 0) {
-			write_length = _mosquitto_net_write(mosq, &(packet->payload[packet->pos]), packet->to_process);
+			write_length = _mosquitto_packet_write_batch(mosq, packet);
 			if (write_length > 0) {
 #if defined(WITH_BROKER) && defined(WITH_SYS_TREE)
 				g_bytes_sent += write_length;
 #endif
-				packet->to_process -= write_length;
-				packet->pos += write_length;
 			} else {
 #ifdef WIN32
 				errno = WSAGetLastError();
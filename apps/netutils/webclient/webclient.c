@@ -90,6 +90,9 @@
 #include "../webserver/http_string_util.h"
 #include "../webserver/http_client.h"
 #include <apps/netutils/webclient.h>
+#ifdef CONFIG_TLS_SESSION_STORE
+#include <tls/tls_session_store.h>
+#endif
 #if defined(CONFIG_NETUTILS_CODECS)
 #  if defined(CONFIG_CODECS_URLCODE)
 #    define WGET_USE_URLENCODE 1
@@ -591,9 +594,12 @@ void wget_tls_ssl_release(struct http_client_tls_t *client)
 	mbedtls_ssl_free(&(client->tls_ssl));
 }
 
-int wget_tls_handshake(struct http_client_tls_t *client, const char *hostname)
+int wget_tls_handshake(struct http_client_tls_t *client, const char *hostname, int port)
 {
 	int result = 0;
+#ifdef CONFIG_TLS_SESSION_STORE
+	int resume;
+#endif
 
 	mbedtls_ssl_conf_authmode(&(client->tls_conf), MBEDTLS_SSL_VERIFY_REQUIRED);
 
@@ -632,16 +638,29 @@ int wget_tls_handshake(struct http_client_tls_t *client, const char *hostname)
 	mbedtls_ssl_set_bio(&(client->tls_ssl), &(client->tls_client_fd),
 						mbedtls_net_send, mbedtls_net_recv, NULL);
 
+#ifdef CONFIG_TLS_SESSION_STORE
+	/* Resume the last session with this server if there is one */
+	resume = tls_session_store_load(hostname, port, &(client->tls_ssl)) == 0;
+#endif
+
 	/* Handshake */
 	while ((result = mbedtls_ssl_handshake(&(client->tls_ssl))) != 0) {
 		if (result != MBEDTLS_ERR_SSL_WANT_READ &&
 			result != MBEDTLS_ERR_SSL_WANT_WRITE) {
 			ndbg("Error: TLS Handshake fail returned %d\n", result);
+#ifdef CONFIG_TLS_SESSION_STORE
+			if (resume) {
+				tls_session_store_remove(hostname, port);
+			}
+#endif
 			goto HANDSHAKE_FAIL;
 		}
 	}
 
 	ndbg("TLS Handshake Success\n");
+#ifdef CONFIG_TLS_SESSION_STORE
+	tls_session_store_save(hostname, port, &(client->tls_ssl));
+#endif
 
 	return 0;
 HANDSHAKE_FAIL:
@@ -1000,7 +1019,7 @@ retry:
 
 #ifdef CONFIG_NET_SECURITY_TLS
 	client_tls->client_fd = sockfd;
-	if (param->tls && (ret = wget_tls_handshake(client_tls, ws.hostname))) {
+	if (param->tls && (ret = wget_tls_handshake(client_tls, ws.hostname, ws.port))) {
 		if (handshake_retry-- > 0) {
 			if (ret == MBEDTLS_ERR_NET_SEND_FAILED ||
 				ret == MBEDTLS_ERR_NET_RECV_FAILED ||
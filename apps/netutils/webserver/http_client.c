@@ -460,6 +460,14 @@ int http_recv_and_handle_request(struct http_client_t *client, struct http_keyva
 			mbedtls_ssl_set_bio(ws->tls_ssl, &ws->tls_net, mbedtls_net_send, mbedtls_net_recv, NULL);
 		}
 #endif
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+		/* The event loop owns the connection from here on, also when
+		 * starting it fails.
+		 */
+		if (websocket_server_init(ws) != WEBSOCKET_SUCCESS) {
+			HTTP_LOGE("Error: Cannot start websocket!!\n");
+		}
+#else
 		pthread_attr_init(&ws->thread_attr);
 		pthread_attr_setstacksize(&ws->thread_attr, WEBSOCKET_STACKSIZE);
 		pthread_attr_setschedpolicy(&ws->thread_attr, SCHED_RR);
@@ -471,6 +479,7 @@ int http_recv_and_handle_request(struct http_client_t *client, struct http_keyva
 		}
 		pthread_setname_np(ws->thread_id, "websocket handle server");
 		pthread_detach(ws->thread_id);
+#endif
 	} else
 #endif
 	{
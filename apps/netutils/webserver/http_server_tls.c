@@ -50,6 +50,9 @@ int http_tls_init(struct http_server_t *server, struct ssl_config_t *ssl_config)
 	mbedtls_ctr_drbg_init(&(server->tls_ctr_drbg));
 	mbedtls_net_init(&(server->tls_ctx));
 	mbedtls_ssl_cache_init(&(server->tls_cache));
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+	mbedtls_ssl_ticket_init(&(server->tls_ticket));
+#endif
 
 #ifdef MBEDTLS_DEBUG_C
 	mbedtls_debug_set_threshold(MBED_DEBUG_LEVEL);
@@ -127,6 +130,15 @@ int http_tls_init(struct http_server_t *server, struct ssl_config_t *ssl_config)
 
 	HTTP_LOGD("Ok\n");
 
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+	/* Let clients resume with a ticket instead of taking a cache entry */
+	if ((result = mbedtls_ssl_ticket_setup(&(server->tls_ticket), mbedtls_ctr_drbg_random, &(server->tls_ctr_drbg), MBEDTLS_CIPHER_AES_256_GCM, 86400)) != 0) {
+		HTTP_LOGE("Error: mbedtls_ssl_ticket_setup returned %d\n", result);
+		return HTTP_ERROR;
+	}
+	mbedtls_ssl_conf_session_tickets_cb(&(server->tls_conf), mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse, &(server->tls_ticket));
+#endif
+
 	mbedtls_ssl_conf_authmode(&server->tls_conf, ssl_config->auth_mode);
 
 	server->tls_init = 1;
@@ -138,6 +150,9 @@ int http_server_tls_release(struct http_server_t *server)
 	HTTP_LOGD("Server TLS Release...\n");
 
 	mbedtls_ssl_cache_free(&(server->tls_cache));
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+	mbedtls_ssl_ticket_free(&(server->tls_ticket));
+#endif
 	mbedtls_x509_crt_free(&(server->tls_srvcert));
 	mbedtls_pk_free(&(server->tls_pkey));
 	mbedtls_ssl_config_free(&(server->tls_conf));
@@ -27,6 +27,9 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -44,29 +47,59 @@
 #include <apps/netutils/websocket.h>
 #include <apps/netutils/wslay/wslay.h>
 
+#include <tinyara/clock.h>
 #include <tinyara/wqueue.h>
 
 /****************************************************************************
  * Definitions
  ****************************************************************************/
 
+/* websocket_t.loop_flags */
+
+#define WEBSOCKET_LOOP_READABLE    0x01	/* poll() reported input, one recv allowed */
+#define WEBSOCKET_LOOP_WRITABLE    0x02	/* poll() reported output space */
+#define WEBSOCKET_LOOP_STARVED     0x04	/* wslay wanted more input than was ready */
+#define WEBSOCKET_LOOP_PENDING     0x08	/* recv budget ran out with input left */
+#define WEBSOCKET_LOOP_HANDSHAKE   0x10	/* TLS or HTTP upgrade handshake not done */
+#define WEBSOCKET_LOOP_WANT_WRITE  0x20	/* the handshake waits for output space */
+#define WEBSOCKET_LOOP_OWNED       0x40	/* in g_ws_loop_conn, released by the loop */
+#define WEBSOCKET_LOOP_CLOSING     0x80	/* stopped, released on the next pass */
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static ssize_t websocket_server_reply(char *header);
+static int websocket_server_context(websocket_t *server);
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
 websocket_t ws_srv_table[WEBSOCKET_MAX_CLIENT];
 
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+/* Server connections handled by the event loop thread. The thread is
+ * started with the first connection and exits when the last one is gone.
+ */
+
+static pthread_mutex_t g_ws_loop_lock = PTHREAD_MUTEX_INITIALIZER;
+static websocket_t *g_ws_loop_conn[WEBSOCKET_MAX_CLIENT];
+static int g_ws_loop_nconn;
+static bool g_ws_loop_running;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
 /* common functions */
 
-int websocket_tls_handshake(websocket_t *data, char *hostname, int auth_mode)
+static int websocket_tls_setup(websocket_t *data, char *hostname, int auth_mode)
 {
 	int r;
 
@@ -98,6 +131,17 @@ int websocket_tls_handshake(websocket_t *data, char *hostname, int auth_mode)
 
 	mbedtls_ssl_set_bio(data->tls_ssl, &(data->tls_net), mbedtls_net_send, mbedtls_net_recv, NULL);
 
+	return WEBSOCKET_SUCCESS;
+}
+
+int websocket_tls_handshake(websocket_t *data, char *hostname, int auth_mode)
+{
+	int r;
+
+	if (websocket_tls_setup(data, hostname, auth_mode) != WEBSOCKET_SUCCESS) {
+		return -1;
+	}
+
 	/* Handshake */
 	WEBSOCKET_DEBUG("  . Performing the SSL/TLS handshake...");
 
@@ -236,6 +280,518 @@ int websocket_handler(websocket_t *websocket)
 	return WEBSOCKET_SUCCESS;
 }
 
+void websocket_socket_free(websocket_t *ctx)
+{
+	if (ctx == NULL) {
+		return;
+	}
+
+	if (ctx->fd >= 0) {
+		close(ctx->fd);
+		ctx->fd = -1;
+	}
+}
+
+/* Setting the state to WEBSOCKET_STOP frees the slot for the next client,
+ * so it is done last.
+ */
+
+static void websocket_server_release(websocket_t *server)
+{
+	websocket_socket_free(server);
+
+	if (server->tls_enabled) {
+		/* tls_net shares the socket closed above; closing it again could
+		 * close a socket just accepted with the same number.
+		 */
+		server->tls_net.fd = -1;
+		mbedtls_ssl_free(server->tls_ssl);
+		free(server->tls_ssl);
+		server->tls_ssl = NULL;
+	}
+	if (server->ctx) {
+		wslay_event_context_free(server->ctx);
+		server->ctx = NULL;
+	}
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+	if (server->loop_header) {
+		free(server->loop_header);
+		server->loop_header = NULL;
+	}
+	server->loop_flags = 0;
+#endif
+
+	websocket_update_state(server, WEBSOCKET_STOP);
+}
+
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+/* event loop sources
+ *
+ * All server connections share one thread that poll()s their sockets, which
+ * stay non-blocking so that a slow peer only holds up itself. The user
+ * callbacks are wrapped and only called when the socket is ready; otherwise,
+ * or when the socket runs dry within a call, e.g. on a partial TLS record,
+ * wslay gets WOULDBLOCK and the loop moves on to the next connection.
+ */
+
+static bool websocket_loop_wouldblock(websocket_t *websocket, ssize_t r)
+{
+	if (r >= 0) {
+		return false;
+	}
+	if (websocket->tls_enabled) {
+		return r == MBEDTLS_ERR_SSL_WANT_READ || r == MBEDTLS_ERR_SSL_WANT_WRITE;
+	}
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+static ssize_t websocket_loop_recv(websocket_context_ptr ctx, uint8_t *buf, size_t len, int flags, void *user_data)
+{
+	ssize_t r;
+	struct websocket_info_t *info = user_data;
+	websocket_t *websocket = info->data;
+
+	if (websocket->loop_flags & WEBSOCKET_LOOP_READABLE) {
+		websocket->loop_flags &= ~WEBSOCKET_LOOP_READABLE;
+	} else if (!websocket->tls_enabled || mbedtls_ssl_get_bytes_avail(websocket->tls_ssl) == 0) {
+		websocket->loop_flags |= WEBSOCKET_LOOP_STARVED;
+		wslay_event_set_error(ctx, WSLAY_ERR_WOULDBLOCK);
+		return -1;
+	}
+
+	r = websocket->cb->recv_callback(ctx, buf, len, flags, user_data);
+	if (websocket_loop_wouldblock(websocket, r)) {
+		websocket->loop_flags |= WEBSOCKET_LOOP_STARVED;
+		wslay_event_set_error(ctx, WSLAY_ERR_WOULDBLOCK);
+		return -1;
+	}
+
+	return r;
+}
+
+/* wslay also sends outside the POLLOUT handling, e.g. the reply to a
+ * close frame, so check the socket when the loop has not.
+ */
+
+static bool websocket_loop_writable(websocket_t *websocket)
+{
+	struct pollfd pfd;
+
+	if (websocket->loop_flags & WEBSOCKET_LOOP_WRITABLE) {
+		return true;
+	}
+
+	pfd.fd = websocket->fd;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+	return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLOUT);
+}
+
+static ssize_t websocket_loop_send(websocket_context_ptr ctx, const uint8_t *data, size_t len, int flags, void *user_data)
+{
+	ssize_t r;
+	struct websocket_info_t *info = user_data;
+	websocket_t *websocket = info->data;
+
+	if (!websocket_loop_writable(websocket)) {
+		wslay_event_set_error(ctx, WSLAY_ERR_WOULDBLOCK);
+		return -1;
+	}
+
+	r = websocket->cb->send_callback(ctx, data, len, flags, user_data);
+	if (websocket_loop_wouldblock(websocket, r)) {
+		wslay_event_set_error(ctx, WSLAY_ERR_WOULDBLOCK);
+		return -1;
+	}
+
+	return r;
+}
+
+static ssize_t websocket_loop_send_iov(websocket_context_ptr ctx, const struct wslay_iovec *iov, int iovcnt, int flags, void *user_data)
+{
+	ssize_t r;
+	struct websocket_info_t *info = user_data;
+	websocket_t *websocket = info->data;
+
+	if (!websocket_loop_writable(websocket)) {
+		wslay_event_set_error(ctx, WSLAY_ERR_WOULDBLOCK);
+		return -1;
+	}
+
+	r = websocket->cb->send_iov_callback(ctx, iov, iovcnt, flags, user_data);
+	if (websocket_loop_wouldblock(websocket, r)) {
+		wslay_event_set_error(ctx, WSLAY_ERR_WOULDBLOCK);
+		return -1;
+	}
+
+	return r;
+}
+
+static void websocket_loop_callbacks(websocket_cb_t *dst, const websocket_cb_t *src)
+{
+	memcpy(dst, src, sizeof(websocket_cb_t));
+	dst->recv_callback = websocket_loop_recv;
+	dst->send_callback = websocket_loop_send;
+	if (src->send_iov_callback) {
+		dst->send_iov_callback = websocket_loop_send_iov;
+	}
+}
+
+static bool websocket_in_loop(websocket_t *websocket)
+{
+	return websocket >= ws_srv_table && websocket < ws_srv_table + WEBSOCKET_MAX_CLIENT;
+}
+
+/* The TLS and HTTP upgrade handshakes of a new connection, run on the loop
+ * thread with the socket non-blocking so that a client that stalls only
+ * holds up itself. ping_time is the deadline of the whole handshake. The
+ * wslay context is created once the upgrade request is read, so while it is
+ * NULL the request is read into loop_header, and afterwards the reply in
+ * loop_header is sent.
+ */
+
+static void websocket_loop_handshake(websocket_t *websocket, short revents, clock_t now)
+{
+	ssize_t r;
+
+	if ((revents & POLLNVAL) || (int32_t)(now - websocket->ping_time) >= 0) {
+		WEBSOCKET_DEBUG("handshake failed or timed out, fd == %d\n", websocket->fd);
+		websocket_update_state(websocket, WEBSOCKET_STOP);
+		return;
+	}
+
+	if (!(revents & (POLLIN | POLLOUT | POLLERR | POLLHUP))) {
+		return;
+	}
+
+	websocket->loop_flags &= ~WEBSOCKET_LOOP_WANT_WRITE;
+
+	if (websocket->tls_enabled) {
+		/* returns 0 at once when the handshake is over */
+
+		r = mbedtls_ssl_handshake(websocket->tls_ssl);
+		if (r == MBEDTLS_ERR_SSL_WANT_READ || r == MBEDTLS_ERR_SSL_WANT_WRITE) {
+			if (r == MBEDTLS_ERR_SSL_WANT_WRITE) {
+				websocket->loop_flags |= WEBSOCKET_LOOP_WANT_WRITE;
+			}
+			return;
+		}
+		if (r != 0) {
+			WEBSOCKET_DEBUG("Error: mbedtls_ssl_handshake returned %d\n", (int)r);
+			websocket_update_state(websocket, WEBSOCKET_STOP);
+			return;
+		}
+	}
+
+	if (websocket->loop_header == NULL) {
+		websocket->loop_header = calloc(WEBSOCKET_HANDSHAKE_HEADER_SIZE, sizeof(char));
+		if (websocket->loop_header == NULL) {
+			WEBSOCKET_DEBUG("fail to allocate memory for header\n");
+			websocket_update_state(websocket, WEBSOCKET_STOP);
+			return;
+		}
+		websocket->loop_header_len = 0;
+	}
+
+	/* Read what has arrived of the upgrade request, TLS may hold more than
+	 * one record.
+	 */
+
+	while (websocket->ctx == NULL) {
+		if (websocket->tls_enabled) {
+			r = mbedtls_ssl_read(websocket->tls_ssl, (unsigned char *)(websocket->loop_header + websocket->loop_header_len), WEBSOCKET_HANDSHAKE_HEADER_SIZE - 1 - websocket->loop_header_len);
+			if (r == MBEDTLS_ERR_SSL_WANT_READ || r == MBEDTLS_ERR_SSL_WANT_WRITE) {
+				return;
+			}
+		} else {
+			r = read(websocket->fd, websocket->loop_header + websocket->loop_header_len, WEBSOCKET_HANDSHAKE_HEADER_SIZE - 1 - websocket->loop_header_len);
+			if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				return;
+			}
+		}
+		if (r <= 0) {
+			WEBSOCKET_DEBUG("HTTP Handshake: read failed or EOF, fd == %d\n", websocket->fd);
+			websocket_update_state(websocket, WEBSOCKET_STOP);
+			return;
+		}
+
+		websocket->loop_header_len += r;
+		if (websocket->loop_header_len >= 4 && memcmp(websocket->loop_header + websocket->loop_header_len - 4, "\r\n\r\n", 4) == 0) {
+			r = websocket_server_reply(websocket->loop_header);
+			if (r < 0 || websocket_server_context(websocket) != WEBSOCKET_SUCCESS) {
+				websocket_update_state(websocket, WEBSOCKET_STOP);
+				return;
+			}
+			websocket->loop_header_len = r;
+			websocket->loop_header_sent = 0;
+		} else if (websocket->loop_header_len >= WEBSOCKET_HANDSHAKE_HEADER_SIZE - 1) {
+			WEBSOCKET_DEBUG("HTTP Handshake: Too large HTTP headers\n");
+			websocket_update_state(websocket, WEBSOCKET_STOP);
+			return;
+		}
+	}
+
+	/* Send the reply as far as the socket takes it */
+
+	while (websocket->loop_header_sent < websocket->loop_header_len) {
+		if (websocket->tls_enabled) {
+			r = mbedtls_ssl_write(websocket->tls_ssl, (const unsigned char *)(websocket->loop_header + websocket->loop_header_sent), websocket->loop_header_len - websocket->loop_header_sent);
+			if (r == MBEDTLS_ERR_SSL_WANT_READ || r == MBEDTLS_ERR_SSL_WANT_WRITE) {
+				websocket->loop_flags |= WEBSOCKET_LOOP_WANT_WRITE;
+				return;
+			}
+		} else {
+			r = write(websocket->fd, websocket->loop_header + websocket->loop_header_sent, websocket->loop_header_len - websocket->loop_header_sent);
+			if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				websocket->loop_flags |= WEBSOCKET_LOOP_WANT_WRITE;
+				return;
+			}
+		}
+		if (r < 0) {
+			WEBSOCKET_DEBUG("fail to write socket errno = %d\n", errno);
+			websocket_update_state(websocket, WEBSOCKET_STOP);
+			return;
+		}
+		websocket->loop_header_sent += r;
+	}
+
+	free(websocket->loop_header);
+	websocket->loop_header = NULL;
+	websocket->loop_flags &= ~WEBSOCKET_LOOP_HANDSHAKE;
+	websocket->ping_time = now + WEBSOCKET_PING_INTERVAL;
+	WEBSOCKET_DEBUG("websocket server handshake done, fd == %d\n", websocket->fd);
+}
+
+static void websocket_loop_service(websocket_t *websocket, short revents, clock_t now)
+{
+	int budget;
+	wslay_event_context_ptr ctx = (wslay_event_context_ptr) websocket->ctx;
+
+	if (websocket->loop_flags & WEBSOCKET_LOOP_HANDSHAKE) {
+		websocket_loop_handshake(websocket, revents, now);
+		return;
+	}
+
+	if (revents & POLLNVAL) {
+		WEBSOCKET_DEBUG("socket fd is not exist, fd == %d\n", websocket->fd);
+		websocket_update_state(websocket, WEBSOCKET_STOP);
+		return;
+	}
+
+	if ((revents & (POLLIN | POLLERR | POLLHUP)) || (websocket->loop_flags & WEBSOCKET_LOOP_PENDING)) {
+		websocket->loop_flags &= ~WEBSOCKET_LOOP_PENDING;
+		if (revents & (POLLIN | POLLERR | POLLHUP)) {
+			websocket->loop_flags |= WEBSOCKET_LOOP_READABLE;
+		}
+
+		/* wslay_event_recv() returns after each message, so keep going
+		 * until it runs out of input, but give the other connections a
+		 * turn after a few messages.
+		 */
+
+		for (budget = WEBSOCKET_LOOP_RECV_BUDGET; budget > 0; budget--) {
+			websocket->loop_flags &= ~WEBSOCKET_LOOP_STARVED;
+			if (wslay_event_recv(ctx) != WEBSOCKET_SUCCESS) {
+				WEBSOCKET_DEBUG("fail to process recv event\n");
+				websocket_update_state(websocket, WEBSOCKET_STOP);
+				return;
+			}
+			if ((websocket->loop_flags & (WEBSOCKET_LOOP_STARVED | WEBSOCKET_LOOP_CLOSING)) || !wslay_event_get_read_enabled(ctx)) {
+				break;
+			}
+		}
+		if (budget == 0) {
+			websocket->loop_flags |= WEBSOCKET_LOOP_PENDING;
+		}
+		websocket->loop_flags &= ~WEBSOCKET_LOOP_READABLE;
+		websocket->ping_time = now + WEBSOCKET_PING_INTERVAL;
+	}
+
+	if ((revents & POLLOUT) && !(websocket->loop_flags & WEBSOCKET_LOOP_CLOSING)) {
+		websocket->loop_flags |= WEBSOCKET_LOOP_WRITABLE;
+		if (wslay_event_send(ctx) != WEBSOCKET_SUCCESS) {
+			WEBSOCKET_DEBUG("fail to process send event\n");
+			websocket_update_state(websocket, WEBSOCKET_STOP);
+			return;
+		}
+		websocket->loop_flags &= ~WEBSOCKET_LOOP_WRITABLE;
+		websocket->ping_time = now + WEBSOCKET_PING_INTERVAL;
+	}
+
+	if ((int32_t)(now - websocket->ping_time) >= 0) {
+		websocket->ping_time = now + WEBSOCKET_PING_INTERVAL;
+		websocket_ping_timer((void *)websocket);
+	}
+}
+
+static void websocket_loop_remove(websocket_t *websocket)
+{
+	int i;
+
+	pthread_mutex_lock(&g_ws_loop_lock);
+	for (i = 0; i < g_ws_loop_nconn; i++) {
+		if (g_ws_loop_conn[i] == websocket) {
+			g_ws_loop_conn[i] = g_ws_loop_conn[--g_ws_loop_nconn];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_ws_loop_lock);
+}
+
+static void *websocket_loop(void *arg)
+{
+	int i;
+	int n;
+	int r;
+	int timeout;
+	int32_t left;
+	clock_t now;
+	websocket_t *websocket;
+	websocket_t *conn[WEBSOCKET_MAX_CLIENT];
+	struct pollfd fds[WEBSOCKET_MAX_CLIENT];
+
+	for (;;) {
+		pthread_mutex_lock(&g_ws_loop_lock);
+		n = g_ws_loop_nconn;
+		if (n == 0) {
+			g_ws_loop_running = false;
+			pthread_mutex_unlock(&g_ws_loop_lock);
+			break;
+		}
+		memcpy(conn, g_ws_loop_conn, n * sizeof(websocket_t *));
+		pthread_mutex_unlock(&g_ws_loop_lock);
+
+		/* Sleep until the nearest ping is due, but no longer than the
+		 * handler timeout: new connections and messages queued by other
+		 * threads are only picked up when poll() returns.
+		 */
+
+		timeout = WEBSOCKET_HANDLER_TIMEOUT;
+		now = clock_systimer();
+		for (i = 0; i < n; i++) {
+			websocket = conn[i];
+			fds[i].fd = websocket->fd;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+			if (websocket->loop_flags & WEBSOCKET_LOOP_HANDSHAKE) {
+				if (websocket->loop_flags & WEBSOCKET_LOOP_WANT_WRITE) {
+					fds[i].events |= POLLOUT;
+				}
+			} else if (wslay_event_want_write(websocket->ctx)) {
+				fds[i].events |= POLLOUT;
+			}
+
+			left = (int32_t)(websocket->ping_time - now);
+			if (left <= 0 || (websocket->loop_flags & WEBSOCKET_LOOP_PENDING)) {
+				timeout = 0;
+			} else if (TICK2MSEC(left) < timeout) {
+				timeout = TICK2MSEC(left);
+			}
+		}
+
+		r = poll(fds, n, timeout);
+		if (r < 0) {
+			if (errno != EINTR) {
+				WEBSOCKET_DEBUG("poll function returned errno == %d\n", errno);
+				usleep(WEBSOCKET_HANDLER_TIMEOUT * 1000);
+			}
+			continue;
+		}
+
+		now = clock_systimer();
+		for (i = 0; i < n; i++) {
+			websocket = conn[i];
+			if (!(websocket->loop_flags & WEBSOCKET_LOOP_CLOSING)) {
+				websocket_loop_service(websocket, fds[i].revents, now);
+			}
+			if (websocket->loop_flags & WEBSOCKET_LOOP_CLOSING) {
+				websocket_loop_remove(websocket);
+				websocket_server_release(websocket);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Hand a connection to the event loop, starting the loop thread if needed.
+ * 'flags' are its initial loop_flags and 'due' when it needs attention even
+ * without input: its first ping, or the end of its handshake.
+ */
+
+static int websocket_loop_add(websocket_t *websocket, uint8_t flags, clock_t due)
+{
+	int r = WEBSOCKET_SUCCESS;
+	pthread_t thread_id;
+	pthread_attr_t attr;
+	struct sched_param ws_sparam;
+
+	websocket->loop_flags = flags | WEBSOCKET_LOOP_OWNED;
+	websocket->ping_time = due;
+
+	pthread_mutex_lock(&g_ws_loop_lock);
+	if (g_ws_loop_nconn == WEBSOCKET_MAX_CLIENT) {
+		websocket->loop_flags = 0;
+		pthread_mutex_unlock(&g_ws_loop_lock);
+		return WEBSOCKET_ALLOCATION_ERROR;
+	}
+	g_ws_loop_conn[g_ws_loop_nconn++] = websocket;
+
+	if (!g_ws_loop_running) {
+		pthread_attr_init(&attr);
+		pthread_attr_setstacksize(&attr, WEBSOCKET_STACKSIZE);
+		ws_sparam.sched_priority = WEBSOCKET_PRI;
+		pthread_attr_setschedparam(&attr, &ws_sparam);
+		pthread_attr_setschedpolicy(&attr, WEBSOCKET_SCHED_POLICY);
+		if (pthread_create(&thread_id, &attr, websocket_loop, NULL) != 0) {
+			WEBSOCKET_DEBUG("fail to create websocket event loop thread\n");
+			g_ws_loop_nconn--;
+			websocket->loop_flags = 0;
+			r = WEBSOCKET_ALLOCATION_ERROR;
+		} else {
+			g_ws_loop_running = true;
+			pthread_setname_np(thread_id, "websocket event loop");
+			pthread_detach(thread_id);
+		}
+	}
+	pthread_mutex_unlock(&g_ws_loop_lock);
+
+	return r;
+}
+
+/* Start a connection the accept loop took: the handshakes run in the loop */
+
+static int websocket_loop_start(websocket_t *server)
+{
+	int r;
+
+	if (server->tls_enabled) {
+		mbedtls_ssl_init(server->tls_ssl);
+		mbedtls_net_init(&(server->tls_net));
+
+		if (websocket_tls_setup(server, NULL, server->auth_mode) != WEBSOCKET_SUCCESS) {
+			r = WEBSOCKET_TLS_HANDSHAKE_ERROR;
+			goto EXIT_LOOP_START;
+		}
+	}
+
+	if (fcntl(server->fd, F_SETFL, fcntl(server->fd, F_GETFL, 0) | O_NONBLOCK) == -1) {
+		WEBSOCKET_DEBUG("fail to set TCP socket non-blocking\n");
+		r = WEBSOCKET_SOCKET_ERROR;
+		goto EXIT_LOOP_START;
+	}
+
+	r = websocket_loop_add(server, WEBSOCKET_LOOP_HANDSHAKE, clock_systimer() + MSEC2TICK(WEBSOCKET_SOCK_RCV_TIMEOUT));
+	if (r == WEBSOCKET_SUCCESS) {
+		return r;
+	}
+
+EXIT_LOOP_START:
+	websocket_server_release(server);
+	return r;
+}
+#endif							/* CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP */
+
 /* client oriented sources */
 
 int websocket_client_handshake(websocket_t *client, char *host, char *port, char *path)
@@ -336,18 +892,6 @@ EXIT_WEBSOCKET_HANDSHAKE_ERROR:
 	return WEBSOCKET_HANDSHAKE_ERROR;
 }
 
-void websocket_socket_free(websocket_t *ctx)
-{
-	if (ctx == NULL) {
-		return;
-	}
-
-	if (ctx->fd >= 0) {
-		close(ctx->fd);
-		ctx->fd = -1;
-	}
-}
-
 int connect_socket(websocket_t *client, const char *host, const char *port)
 {
 	int fd;
@@ -432,6 +976,44 @@ TLS_HS_RETRY:
 
 /* server oriented sources */
 
+/* Check the upgrade request in 'header', a buffer of
+ * WEBSOCKET_HANDSHAKE_HEADER_SIZE bytes, and put the reply in it. Returns
+ * the length of the reply.
+ */
+
+static ssize_t websocket_server_reply(char *header)
+{
+	char *keyhdstart, *keyhdend;
+	unsigned char client_key[WEBSOCKET_CLIENT_KEY_LEN];
+	unsigned char accept_key[WEBSOCKET_ACCEPT_KEY_LEN];
+
+	if (strstr(header, "Upgrade: websocket") == NULL || strstr(header, "Connection: Upgrade") == NULL) {
+		WEBSOCKET_DEBUG("HTTP handshake: Missing required header fields\n");
+		return WEBSOCKET_HANDSHAKE_ERROR;
+	}
+	if ((keyhdstart = strstr(header, "Sec-WebSocket-Key: ")) == NULL) {
+		WEBSOCKET_DEBUG("http_upgrade: missing required headers\n");
+		return WEBSOCKET_HANDSHAKE_ERROR;
+	}
+	keyhdstart += 19;
+
+	keyhdend = strstr(keyhdstart, "\r\n");
+	if (keyhdend == NULL) {
+		WEBSOCKET_DEBUG("http_upgrade: missing required headers\n");
+		return WEBSOCKET_HANDSHAKE_ERROR;
+	}
+
+	memset(client_key, 0, WEBSOCKET_CLIENT_KEY_LEN);
+	memcpy(client_key, keyhdstart, keyhdend - keyhdstart);
+	memset(accept_key, 0, WEBSOCKET_ACCEPT_KEY_LEN);
+	websocket_create_accept_key(accept_key, WEBSOCKET_ACCEPT_KEY_LEN, client_key, WEBSOCKET_CLIENT_KEY_LEN);
+
+	memset(header, 0, WEBSOCKET_HANDSHAKE_HEADER_SIZE);
+	snprintf(header, WEBSOCKET_HANDSHAKE_HEADER_SIZE, "HTTP/1.1 101 Switching Protocols\r\n" "Upgrade: websocket\r\n" "Connection: Upgrade\r\n" "Sec-WebSocket-Accept: %s\r\n" "\r\n", accept_key);
+
+	return strlen(header);
+}
+
 int websocket_server_handshake(websocket_t *server)
 {
 	int fd = server->fd;
@@ -439,9 +1021,6 @@ int websocket_server_handshake(websocket_t *server)
 	size_t header_sent = 0;
 	ssize_t r;
 	char *header = NULL;
-	char *keyhdstart, *keyhdend;
-	unsigned char client_key[WEBSOCKET_CLIENT_KEY_LEN];
-	unsigned char accept_key[WEBSOCKET_ACCEPT_KEY_LEN];
 
 	header = calloc(WEBSOCKET_HANDSHAKE_HEADER_SIZE, sizeof(char));
 	if (header == NULL) {
@@ -472,30 +1051,11 @@ int websocket_server_handshake(websocket_t *server)
 		}
 	}
 
-	if (strstr(header, "Upgrade: websocket") == NULL || strstr(header, "Connection: Upgrade") == NULL) {
-		WEBSOCKET_DEBUG("HTTP handshake: Missing required header fields\n");
-		goto EXIT_WEBSOCKET_HANDSHAKE_ERROR;
-	}
-	if ((keyhdstart = strstr(header, "Sec-WebSocket-Key: ")) == NULL) {
-		WEBSOCKET_DEBUG("http_upgrade: missing required headers\n");
-		goto EXIT_WEBSOCKET_HANDSHAKE_ERROR;
-	}
-	keyhdstart += 19;
-
-	keyhdend = strstr(keyhdstart, "\r\n");
-	if (keyhdend == NULL) {
-		WEBSOCKET_DEBUG("http_upgrade: missing required headers\n");
+	r = websocket_server_reply(header);
+	if (r < 0) {
 		goto EXIT_WEBSOCKET_HANDSHAKE_ERROR;
 	}
-
-	memset(client_key, 0, WEBSOCKET_CLIENT_KEY_LEN);
-	memcpy(client_key, keyhdstart, keyhdend - keyhdstart);
-	memset(accept_key, 0, WEBSOCKET_ACCEPT_KEY_LEN);
-	websocket_create_accept_key(accept_key, WEBSOCKET_ACCEPT_KEY_LEN, client_key, WEBSOCKET_CLIENT_KEY_LEN);
-
-	memset(header, 0, WEBSOCKET_HANDSHAKE_HEADER_SIZE);
-	snprintf(header, WEBSOCKET_HANDSHAKE_HEADER_SIZE, "HTTP/1.1 101 Switching Protocols\r\n" "Upgrade: websocket\r\n" "Connection: Upgrade\r\n" "Sec-WebSocket-Accept: %s\r\n" "\r\n", accept_key);
-	header_length = strlen(header);
+	header_length = r;
 
 	while (header_sent < header_length) {
 		if (server->tls_enabled) {
@@ -540,15 +1100,7 @@ int websocket_server_start(websocket_t *server)
 	return websocket_server_init(server);
 
 EXIT_SERVER_START:
-	websocket_socket_free(server);
-
-	if (server->tls_enabled) {
-		mbedtls_ssl_free(server->tls_ssl);
-		mbedtls_net_free(&(server->tls_net));
-		free(server->tls_ssl);
-	}
-
-	websocket_update_state(server, WEBSOCKET_STOP);
+	websocket_server_release(server);
 
 	return r;
 }
@@ -564,11 +1116,18 @@ int websocket_accept_loop(websocket_t *init_server)
 	socklen_t addrlen = sizeof(struct sockaddr);
 	struct timeval tv;
 	struct sockaddr_in clientaddr;
+#ifndef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
 	struct sched_param ws_sparam;
+#endif
 
 	for (i = 0; i < WEBSOCKET_MAX_CLIENT; i++) {
 		memcpy(&ws_srv_table[i], init_server, sizeof(websocket_t));
 		ws_srv_table[i].state = WEBSOCKET_STOP;
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+		ws_srv_table[i].ctx = NULL;
+		ws_srv_table[i].loop_flags = 0;
+		ws_srv_table[i].loop_header = NULL;
+#endif
 	}
 
 	init_server->state = WEBSOCKET_RUNNING;
@@ -646,6 +1205,13 @@ int websocket_accept_loop(websocket_t *init_server)
 			WEBSOCKET_DEBUG("accept client, fd == %d\n", accept_fd);
 			server_handler->fd = accept_fd;
 
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+			/* The event loop does the handshakes, so a client that stalls
+			 * in them does not hold up the next accept().
+			 */
+
+			websocket_loop_start(server_handler);
+#else
 			pthread_attr_init(&server_handler->thread_attr);
 			pthread_attr_setstacksize(&server_handler->thread_attr, WEBSOCKET_STACKSIZE);
 			ws_sparam.sched_priority = WEBSOCKET_PRI;
@@ -663,6 +1229,7 @@ int websocket_accept_loop(websocket_t *init_server)
 			pthread_setname_np(server_handler->thread_id, "websocket server handler");
 				/* Detach thread in order to avoid memory leaks. */
 			pthread_detach(server_handler->thread_id);
+#endif
 		}
 	}
 
@@ -853,30 +1420,52 @@ websocket_return_t websocket_server_open(websocket_t *init_server)
 	return WEBSOCKET_SUCCESS;
 }
 
-websocket_return_t websocket_server_init(websocket_t *server)
+/* Create the wslay context of a server connection that finished its
+ * handshake.
+ */
+
+static int websocket_server_context(websocket_t *server)
 {
-	int r = WEBSOCKET_SUCCESS;
 	struct websocket_info_t *socket_data = NULL;
-
-	if (server == NULL) {
-		WEBSOCKET_DEBUG("function returned for null parameter\n");
-		return WEBSOCKET_ALLOCATION_ERROR;
-	}
-
-	websocket_update_state(server, WEBSOCKET_RUNNING);
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+	websocket_cb_t cb;
+#endif
 
 	socket_data = malloc(sizeof(struct websocket_info_t));
 	if (socket_data == NULL) {
 		WEBSOCKET_DEBUG("fail to allocate memory\n");
-		r = WEBSOCKET_ALLOCATION_ERROR;
-		goto EXIT_SERVER_INIT;
+		return WEBSOCKET_ALLOCATION_ERROR;
 	}
 	memset(socket_data, 0, sizeof(struct websocket_info_t));
 	socket_data->data = server;
 
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+	websocket_loop_callbacks(&cb, server->cb);
+	if (wslay_event_context_server_init(&(server->ctx), &cb, socket_data) != WEBSOCKET_SUCCESS) {
+#else
 	if (wslay_event_context_server_init(&(server->ctx), server->cb, socket_data) != WEBSOCKET_SUCCESS) {
+#endif
 		WEBSOCKET_DEBUG("fail to initiate websocket server\n");
-		r = WEBSOCKET_INIT_ERROR;
+		free(socket_data);
+		return WEBSOCKET_INIT_ERROR;
+	}
+
+	return WEBSOCKET_SUCCESS;
+}
+
+websocket_return_t websocket_server_init(websocket_t *server)
+{
+	int r = WEBSOCKET_SUCCESS;
+
+	if (server == NULL) {
+		WEBSOCKET_DEBUG("function returned for null parameter\n");
+		return WEBSOCKET_ALLOCATION_ERROR;
+	}
+
+	websocket_update_state(server, WEBSOCKET_RUNNING);
+
+	r = websocket_server_context(server);
+	if (r != WEBSOCKET_SUCCESS) {
 		goto EXIT_SERVER_INIT;
 	}
 
@@ -885,23 +1474,21 @@ websocket_return_t websocket_server_init(websocket_t *server)
 		goto EXIT_SERVER_INIT;
 	}
 
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+	if (websocket_loop_add(server, 0, clock_systimer() + WEBSOCKET_PING_INTERVAL) != WEBSOCKET_SUCCESS) {
+		r = WEBSOCKET_ALLOCATION_ERROR;
+		goto EXIT_SERVER_INIT;
+	}
+
+	WEBSOCKET_DEBUG("websocket server added to event loop, fd == %d\n", server->fd);
+	return WEBSOCKET_SUCCESS;
+#else
 	WEBSOCKET_DEBUG("start websocket server handling loop\n");
 	r = websocket_handler(server);
+#endif
 
 EXIT_SERVER_INIT:
-	websocket_socket_free(server);
-
-	if (server->tls_enabled) {
-		mbedtls_net_free(&(server->tls_net));
-		mbedtls_ssl_free(server->tls_ssl);
-		free(server->tls_ssl);
-	}
-	if (server->ctx) {
-		wslay_event_context_free(server->ctx);
-		server->ctx = NULL;
-	}
-
-	websocket_update_state(server, WEBSOCKET_STOP);
+	websocket_server_release(server);
 
 	return r;
 }
@@ -911,6 +1498,15 @@ void websocket_register_cb(websocket_t *websocket, websocket_cb_t *cb)
 	if (websocket == NULL) {
 		WEBSOCKET_DEBUG("function returned for null parameter\n");
 	} else {
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+		websocket_cb_t loop_cb;
+
+		if (websocket_in_loop(websocket)) {
+			websocket->cb = cb;
+			websocket_loop_callbacks(&loop_cb, cb);
+			cb = &loop_cb;
+		}
+#endif
 		wslay_event_config_set_callbacks(websocket->ctx, cb);
 	}
 }
@@ -930,6 +1526,21 @@ websocket_return_t websocket_queue_msg(websocket_t *websocket, websocket_frame_t
 	return wslay_event_queue_msg(websocket->ctx, tx_frame);
 }
 
+websocket_return_t websocket_queue_msg_ref(websocket_t *websocket, websocket_frame_t *tx_frame, websocket_msg_free_cb free_cb)
+{
+	if (websocket == NULL || tx_frame == NULL || free_cb == NULL) {
+		WEBSOCKET_DEBUG("function returned for null parameter\n");
+		return WEBSOCKET_ALLOCATION_ERROR;
+	}
+
+	if (websocket->state == WEBSOCKET_STOP) {
+		WEBSOCKET_DEBUG("websocket is not running state.\n");
+		return WEBSOCKET_INIT_ERROR;
+	}
+
+	return wslay_event_queue_msg_ref(websocket->ctx, tx_frame, free_cb);
+}
+
 websocket_return_t websocket_queue_ping(websocket_t *websocket)
 {
 	websocket_frame_t tx_frame;
@@ -989,6 +1600,16 @@ void websocket_update_state(websocket_t *websocket, int state)
 		WEBSOCKET_DEBUG("function returned for null parameter\n");
 	} else {
 		if (WEBSOCKET_STOP <= state && state < WEBSOCKET_MAX_STATE) {
+#ifdef CONFIG_NETUTILS_WEBSOCKET_EVENT_LOOP
+			/* A stopped slot may be taken by the next client, so the event
+			 * loop only sets WEBSOCKET_STOP once it has let go of it.
+			 */
+
+			if (state == WEBSOCKET_STOP && (websocket->loop_flags & WEBSOCKET_LOOP_OWNED)) {
+				websocket->loop_flags |= WEBSOCKET_LOOP_CLOSING;
+				return;
+			}
+#endif
 			websocket->state = state;
 		} else {
 			WEBSOCKET_DEBUG("function returned for invalid parameter\n");
@@ -129,6 +129,12 @@ static ssize_t wslay_event_frame_send_callback(const uint8_t *data, size_t len,
 	return e->ctx->callbacks.send_callback(e->ctx, data, len, flags, e->user_data);
 }
 
+static ssize_t wslay_event_frame_send_iov_callback(const struct wslay_iovec *iov, int iovcnt, int flags, void *user_data)
+{
+	struct wslay_event_frame_user_data *e = (struct wslay_event_frame_user_data *)user_data;
+	return e->ctx->callbacks.send_iov_callback(e->ctx, iov, iovcnt, flags, e->user_data);
+}
+
 static int wslay_event_frame_genmask_callback(uint8_t *buf, size_t len, void *user_data)
 {
 	struct wslay_event_frame_user_data *e = (struct wslay_event_frame_user_data *)user_data;
@@ -213,7 +219,11 @@ static int wslay_event_imsg_append_chunk(struct wslay_event_imsg *m, size_t len)
 
 static int wslay_event_omsg_non_fragmented_init(struct wslay_event_omsg **m, uint8_t opcode, uint8_t rsv, const uint8_t *msg, size_t msg_length)
 {
-	*m = (struct wslay_event_omsg *)malloc(sizeof(struct wslay_event_omsg));
+	/*
+	 * The payload is stored right after the message with room for the
+	 * frame header in front of it, see WSLAY_FRAME_DATA_HEADROOM.
+	 */
+	*m = (struct wslay_event_omsg *)malloc(sizeof(struct wslay_event_omsg) + WSLAY_FRAME_HEADROOM + msg_length);
 	if (!*m) {
 		return WSLAY_ERR_NOMEM;
 	}
@@ -223,11 +233,7 @@ static int wslay_event_omsg_non_fragmented_init(struct wslay_event_omsg **m, uin
 	(*m)->rsv = rsv;
 	(*m)->type = WSLAY_NON_FRAGMENTED;
 	if (msg_length) {
-		(*m)->data = (uint8_t *)malloc(msg_length);
-		if (!(*m)->data) {
-			free(*m);
-			return WSLAY_ERR_NOMEM;
-		}
+		(*m)->data = (uint8_t *)(*m + 1) + WSLAY_FRAME_HEADROOM;
 		memcpy((*m)->data, msg, msg_length);
 		(*m)->data_length = msg_length;
 	}
@@ -249,12 +255,30 @@ static int wslay_event_omsg_fragmented_init(struct wslay_event_omsg **m, uint8_t
 	return 0;
 }
 
-static void wslay_event_omsg_free(struct wslay_event_omsg *m)
+static int wslay_event_omsg_ref_init(struct wslay_event_omsg **m, uint8_t opcode, const uint8_t *msg, size_t msg_length, wslay_event_msg_free_callback free_callback)
+{
+	*m = (struct wslay_event_omsg *)malloc(sizeof(struct wslay_event_omsg));
+	if (!*m) {
+		return WSLAY_ERR_NOMEM;
+	}
+	memset(*m, 0, sizeof(struct wslay_event_omsg));
+	(*m)->fin = 1;
+	(*m)->opcode = opcode;
+	(*m)->type = WSLAY_NON_FRAGMENTED;
+	(*m)->data = (uint8_t *)msg;
+	(*m)->data_length = msg_length;
+	(*m)->free_callback = free_callback;
+	return 0;
+}
+
+static void wslay_event_omsg_free(wslay_event_context_ptr ctx, struct wslay_event_omsg *m)
 {
 	if (!m) {
 		return;
 	}
-	free(m->data);
+	if (m->free_callback) {
+		m->free_callback(ctx, m->data, m->data_length, ctx->user_data);
+	}
 	free(m);
 }
 
@@ -264,7 +288,17 @@ static uint8_t *wslay_event_flatten_queue(struct wslay_queue *queue, size_t len)
 		return NULL;
 	} else {
 		size_t off = 0;
-		uint8_t *buf = (uint8_t *)malloc(len);
+		uint8_t *buf;
+		struct wslay_event_byte_chunk *chunk = wslay_queue_top(queue);
+		if (chunk->data_length == len) {
+			/* Unfragmented message, its only chunk is the message */
+			buf = chunk->data;
+			free(chunk);
+			wslay_queue_pop(queue);
+			assert(wslay_queue_empty(queue));
+			return buf;
+		}
+		buf = (uint8_t *)malloc(len);
 		if (!buf) {
 			return NULL;
 		}
@@ -366,6 +400,28 @@ int wslay_event_queue_msg_ex(wslay_event_context_ptr ctx, const struct wslay_eve
 	return 0;
 }
 
+int wslay_event_queue_msg_ref(wslay_event_context_ptr ctx, const struct wslay_event_msg *arg, wslay_event_msg_free_callback free_callback)
+{
+	int r;
+	struct wslay_event_omsg *omsg;
+	if (!wslay_event_is_msg_queueable(ctx)) {
+		return WSLAY_ERR_NO_MORE_MSG;
+	}
+	if (wslay_is_ctrl_frame(arg->opcode) || free_callback == NULL) {
+		return WSLAY_ERR_INVALID_ARGUMENT;
+	}
+	if ((r = wslay_event_omsg_ref_init(&omsg, arg->opcode, arg->msg, arg->msg_length, free_callback)) != 0) {
+		return r;
+	}
+	if ((r = wslay_queue_push(ctx->send_queue, omsg)) != 0) {
+		free(omsg);
+		return r;
+	}
+	++ctx->queued_msg_count;
+	ctx->queued_msg_length += arg->msg_length;
+	return 0;
+}
+
 int wslay_event_queue_fragmented_msg(wslay_event_context_ptr ctx, const struct wslay_event_fragmented_msg *arg)
 {
 	return wslay_event_queue_fragmented_msg_ex(ctx, arg, WSLAY_RSV_NONE);
@@ -394,6 +450,10 @@ int wslay_event_queue_fragmented_msg_ex(wslay_event_context_ptr ctx, const struc
 void wslay_event_config_set_callbacks(wslay_event_context_ptr ctx, const struct wslay_event_callbacks *callbacks)
 {
 	ctx->callbacks = *callbacks;
+	if (ctx->frame_ctx) {
+		/* The frame layer gathers header and payload only if it can */
+		ctx->frame_ctx->callbacks.send_iov_callback = callbacks->send_iov_callback ? wslay_event_frame_send_iov_callback : NULL;
+	}
 }
 
 static int wslay_event_context_init(wslay_event_context_ptr *ctx, const struct wslay_event_callbacks *callbacks, void *user_data)
@@ -402,14 +462,14 @@ static int wslay_event_context_init(wslay_event_context_ptr *ctx, const struct w
 	struct wslay_frame_callbacks frame_callbacks = {
 		wslay_event_frame_send_callback,
 		wslay_event_frame_recv_callback,
-		wslay_event_frame_genmask_callback
+		wslay_event_frame_genmask_callback,
+		NULL
 	};
 	*ctx = (wslay_event_context_ptr)malloc(sizeof(struct wslay_event_context));
 	if (!*ctx) {
 		return WSLAY_ERR_NOMEM;
 	}
 	memset(*ctx, 0, sizeof(struct wslay_event_context));
-	wslay_event_config_set_callbacks(*ctx, callbacks);
 	(*ctx)->user_data = user_data;
 	(*ctx)->frame_user_data.ctx = *ctx;
 	(*ctx)->frame_user_data.user_data = user_data;
@@ -417,6 +477,7 @@ static int wslay_event_context_init(wslay_event_context_ptr *ctx, const struct w
 		wslay_event_context_free(*ctx);
 		return r;
 	}
+	wslay_event_config_set_callbacks(*ctx, callbacks);
 	(*ctx)->read_enabled = (*ctx)->write_enabled = 1;
 	(*ctx)->send_queue = wslay_queue_new();
 	if (!(*ctx)->send_queue) {
@@ -439,7 +500,7 @@ static int wslay_event_context_init(wslay_event_context_ptr *ctx, const struct w
 		}
 	}
 	(*ctx)->imsg = &(*ctx)->imsgs[0];
-	(*ctx)->obufmark = (*ctx)->obuflimit = (*ctx)->obuf;
+	(*ctx)->obufmark = (*ctx)->obuflimit = (*ctx)->obuf + WSLAY_FRAME_HEADROOM;
 	(*ctx)->status_code_sent = WSLAY_CODE_ABNORMAL_CLOSURE;
 	(*ctx)->status_code_recv = WSLAY_CODE_ABNORMAL_CLOSURE;
 	(*ctx)->max_recv_msg_length = (1u << 31) - 1;
@@ -472,29 +533,30 @@ void wslay_event_context_free(wslay_event_context_ptr ctx)
 	if (!ctx) {
 		return;
 	}
-	if (ctx->user_data) {
-		free(ctx->user_data);
-	}
 	for (i = 0; i < 2; ++i) {
 		wslay_event_imsg_chunks_free(&ctx->imsgs[i]);
 		wslay_queue_free(ctx->imsgs[i].chunks);
 	}
 	if (ctx->send_queue) {
 		while (!wslay_queue_empty(ctx->send_queue)) {
-			wslay_event_omsg_free(wslay_queue_top(ctx->send_queue));
+			wslay_event_omsg_free(ctx, wslay_queue_top(ctx->send_queue));
 			wslay_queue_pop(ctx->send_queue);
 		}
 		wslay_queue_free(ctx->send_queue);
 	}
 	if (ctx->send_ctrl_queue) {
 		while (!wslay_queue_empty(ctx->send_ctrl_queue)) {
-			wslay_event_omsg_free(wslay_queue_top(ctx->send_ctrl_queue));
+			wslay_event_omsg_free(ctx, wslay_queue_top(ctx->send_ctrl_queue));
 			wslay_queue_pop(ctx->send_ctrl_queue);
 		}
 		wslay_queue_free(ctx->send_ctrl_queue);
 	}
 	wslay_frame_context_free(ctx->frame_ctx);
-	wslay_event_omsg_free(ctx->omsg);
+	wslay_event_omsg_free(ctx, ctx->omsg);
+	/* Freed last, the free callbacks above still get it */
+	if (ctx->user_data) {
+		free(ctx->user_data);
+	}
 	free(ctx);
 }
 
@@ -753,7 +815,7 @@ static struct wslay_event_omsg *wslay_event_send_ctrl_queue_pop(wslay_event_cont
 			if (msg->opcode == WSLAY_CONNECTION_CLOSE) {
 				return msg;
 			} else {
-				wslay_event_omsg_free(msg);
+				wslay_event_omsg_free(ctx, msg);
 			}
 		}
 		return NULL;
@@ -804,6 +866,16 @@ int wslay_event_send(wslay_event_context_ptr ctx)
 			iocb.data = ctx->omsg->data + ctx->opayloadoff;
 			iocb.data_length = ctx->opayloadlen - ctx->opayloadoff;
 			iocb.payload_length = ctx->opayloadlen;
+			/*
+			 * Copied payloads have headroom. Control frames are not
+			 * masked in place, the close status is read back below.
+			 */
+			if (!ctx->omsg->free_callback) {
+				iocb.data_flags = WSLAY_FRAME_DATA_HEADROOM;
+				if (!wslay_is_ctrl_frame(ctx->omsg->opcode)) {
+					iocb.data_flags |= WSLAY_FRAME_DATA_WRITABLE;
+				}
+			}
 			r = wslay_frame_send(ctx->frame_ctx, &iocb);
 			if (r >= 0) {
 				ctx->opayloadoff += r;
@@ -820,7 +892,7 @@ int wslay_event_send(wslay_event_context_ptr ctx)
 						}
 						ctx->status_code_sent = status_code == 0 ? WSLAY_CODE_NO_STATUS_RCVD : status_code;
 					}
-					wslay_event_omsg_free(ctx->omsg);
+					wslay_event_omsg_free(ctx, ctx->omsg);
 					ctx->omsg = NULL;
 				} else {
 					break;
@@ -835,14 +907,14 @@ int wslay_event_send(wslay_event_context_ptr ctx)
 		} else {
 			if (ctx->omsg->fin == 0 && ctx->obuflimit == ctx->obufmark) {
 				int eof = 0;
-				r = ctx->omsg->read_callback(ctx, ctx->obuf, sizeof(ctx->obuf), &ctx->omsg->source, &eof, ctx->user_data);
+				r = ctx->omsg->read_callback(ctx, ctx->obuf + WSLAY_FRAME_HEADROOM, sizeof(ctx->obuf) - WSLAY_FRAME_HEADROOM, &ctx->omsg->source, &eof, ctx->user_data);
 				if (r == 0) {
 					break;
 				} else if (r < 0) {
 					ctx->write_enabled = 0;
 					return WSLAY_ERR_CALLBACK_FAILURE;
 				}
-				ctx->obuflimit = ctx->obuf + r;
+				ctx->obuflimit = ctx->obufmark + r;
 				if (eof) {
 					ctx->omsg->fin = 1;
 				}
@@ -857,14 +929,15 @@ int wslay_event_send(wslay_event_context_ptr ctx)
 			iocb.data = ctx->obufmark;
 			iocb.data_length = ctx->obuflimit - ctx->obufmark;
 			iocb.payload_length = ctx->opayloadlen;
+			iocb.data_flags = WSLAY_FRAME_DATA_WRITABLE | WSLAY_FRAME_DATA_HEADROOM;
 			r = wslay_frame_send(ctx->frame_ctx, &iocb);
 			if (r >= 0) {
 				ctx->obufmark += r;
 				if (ctx->obufmark == ctx->obuflimit) {
-					ctx->obufmark = ctx->obuflimit = ctx->obuf;
+					ctx->obufmark = ctx->obuflimit = ctx->obuf + WSLAY_FRAME_HEADROOM;
 					if (ctx->omsg->fin) {
 						--ctx->queued_msg_count;
-						wslay_event_omsg_free(ctx->omsg);
+						wslay_event_omsg_free(ctx, ctx->omsg);
 						ctx->omsg = NULL;
 						break;
 					} else {
@@ -78,6 +78,10 @@ struct wslay_event_omsg {
 
 	union wslay_event_msg_source source;
 	wslay_event_fragmented_msg_callback read_callback;
+
+	/* Set if data belongs to the application, see
+	   wslay_event_queue_msg_ref() */
+	wslay_event_msg_free_callback free_callback;
 };
 
 struct wslay_event_frame_user_data {
@@ -139,8 +143,9 @@ struct wslay_event_context {
 	size_t queued_msg_count;
 	/* The sum of message length in send_queue */
 	size_t queued_msg_length;
-	/* Buffer used for fragmented messages */
-	uint8_t obuf[4096];
+	/* Buffer used for fragmented messages, data starts after
+	   WSLAY_FRAME_HEADROOM bytes */
+	uint8_t obuf[WSLAY_FRAME_HEADROOM + 4096];
 	uint8_t *obuflimit;
 	uint8_t *obufmark;
 	/* payload length of frame currently being sent. */
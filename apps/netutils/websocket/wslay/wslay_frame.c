@@ -42,6 +42,7 @@
 #include "wslay_frame.h"
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 
@@ -70,6 +71,108 @@ void wslay_frame_context_free(wslay_frame_context_ptr ctx)
 	free(ctx);
 }
 
+/*
+ * XOR len bytes of src with the masking key into dst, dst may be src.
+ * off is the payload offset of src[0], it selects the key byte to start
+ * with. The bulk is done a machine word at a time, 32 or 64 bits wide,
+ * once dst is word aligned.
+ */
+#if UINTPTR_MAX > 0xffffffffu
+typedef uint64_t wslay_word_t;
+#else
+typedef uint32_t wslay_word_t;
+#endif
+
+#define WSLAY_WORD_SIZE sizeof(wslay_word_t)
+#define WSLAY_WORD_ALIGNED(p) ((((uintptr_t)(p)) & (WSLAY_WORD_SIZE - 1)) == 0)
+
+static void wslay_mask(uint8_t *dst, const uint8_t *src, size_t len, const uint8_t *key, uint64_t off)
+{
+	uint8_t kbytes[WSLAY_WORD_SIZE];
+	wslay_word_t kword;
+	wslay_word_t w;
+	size_t i;
+
+	for (; len > 0 && !WSLAY_WORD_ALIGNED(dst); --len, ++off) {
+		*dst++ = *src++ ^ key[off % 4];
+	}
+
+	if (len >= WSLAY_WORD_SIZE) {
+		/* The key as it lines up with the next words, in memory order */
+		for (i = 0; i < WSLAY_WORD_SIZE; ++i) {
+			kbytes[i] = key[(off + i) % 4];
+		}
+		memcpy(&kword, kbytes, WSLAY_WORD_SIZE);
+
+		if (WSLAY_WORD_ALIGNED(src)) {
+			for (; len >= 2 * WSLAY_WORD_SIZE; len -= 2 * WSLAY_WORD_SIZE) {
+				((wslay_word_t *)dst)[0] = ((const wslay_word_t *)src)[0] ^ kword;
+				((wslay_word_t *)dst)[1] = ((const wslay_word_t *)src)[1] ^ kword;
+				dst += 2 * WSLAY_WORD_SIZE;
+				src += 2 * WSLAY_WORD_SIZE;
+			}
+			for (; len >= WSLAY_WORD_SIZE; len -= WSLAY_WORD_SIZE) {
+				*(wslay_word_t *)dst = *(const wslay_word_t *)src ^ kword;
+				dst += WSLAY_WORD_SIZE;
+				src += WSLAY_WORD_SIZE;
+			}
+		} else {
+			for (; len >= WSLAY_WORD_SIZE; len -= WSLAY_WORD_SIZE) {
+				memcpy(&w, src, WSLAY_WORD_SIZE);
+				*(wslay_word_t *)dst = w ^ kword;
+				dst += WSLAY_WORD_SIZE;
+				src += WSLAY_WORD_SIZE;
+			}
+		}
+		/* Whole words keep off % 4 as it was */
+	}
+
+	for (; len > 0; --len, ++off) {
+		*dst++ = *src++ ^ key[off % 4];
+	}
+}
+
+/*
+ * Send the rest of the header and payload bytes of data with one
+ * callback, either from the headroom in front of data or as two iovecs.
+ * Returns the number of payload bytes sent, like wslay_frame_send().
+ */
+static ssize_t wslay_frame_send_gather(wslay_frame_context_ptr ctx, const uint8_t *data, size_t data_length)
+{
+	size_t hdrem = ctx->oheaderlimit - ctx->oheadermark;
+	size_t len = hdrem + data_length;
+	struct wslay_iovec iov[2];
+	ssize_t r;
+
+	if (ctx->ocontig) {
+		r = ctx->callbacks.send_callback(data - hdrem, len, 0, ctx->user_data);
+	} else {
+		iov[0].base = ctx->oheadermark;
+		iov[0].len = hdrem;
+		iov[1].base = data;
+		iov[1].len = data_length;
+		r = ctx->callbacks.send_iov_callback(iov, 2, 0, ctx->user_data);
+	}
+	if (r <= 0) {
+		return WSLAY_ERR_WANT_WRITE;
+	}
+	if ((size_t)r > len) {
+		return WSLAY_ERR_INVALID_CALLBACK;
+	}
+	if ((size_t)r < hdrem) {
+		ctx->oheadermark += r;
+		return WSLAY_ERR_WANT_WRITE;
+	}
+	ctx->oheadermark = ctx->oheaderlimit;
+	ctx->ostate = SEND_PAYLOAD;
+	r -= hdrem;
+	ctx->opayloadoff += r;
+	if (ctx->opayloadoff == ctx->opayloadlen) {
+		ctx->ostate = PREP_HEADER;
+	}
+	return r;
+}
+
 ssize_t wslay_frame_send(wslay_frame_context_ptr ctx, struct wslay_frame_iocb *iocb)
 {
 	if (iocb->data_length > iocb->payload_length) {
@@ -105,6 +208,7 @@ ssize_t wslay_frame_send(wslay_frame_context_ptr ctx, struct wslay_frame_iocb *i
 			/* Too large payload length */
 			return WSLAY_ERR_INVALID_ARGUMENT;
 		}
+		ctx->omask = 0;
 		if (iocb->mask) {
 			if (ctx->callbacks.genmask_callback(ctx->omaskkey, 4, ctx->user_data) != 0) {
 				return WSLAY_ERR_INVALID_CALLBACK;
@@ -119,6 +223,31 @@ ssize_t wslay_frame_send(wslay_frame_context_ptr ctx, struct wslay_frame_iocb *i
 		ctx->oheaderlimit = hdptr;
 		ctx->opayloadlen = iocb->payload_length;
 		ctx->opayloadoff = 0;
+
+		/*
+		 * With the whole payload at hand, put the header in front of it
+		 * and mask it in place when that is allowed, so that the frame
+		 * goes out as one buffer without being copied.
+		 */
+		ctx->ocontig = 0;
+		if (iocb->data_length > 0 && iocb->data_length == iocb->payload_length && (iocb->data_flags & WSLAY_FRAME_DATA_HEADROOM) && (!ctx->omask || (iocb->data_flags & WSLAY_FRAME_DATA_WRITABLE))) {
+			if (ctx->omask) {
+				wslay_mask((uint8_t *)iocb->data, iocb->data, iocb->data_length, ctx->omaskkey, 0);
+			}
+			memcpy((uint8_t *)iocb->data - (hdptr - ctx->oheader), ctx->oheader, hdptr - ctx->oheader);
+			ctx->ocontig = 1;
+		}
+	}
+	if (ctx->ocontig && ctx->ostate != PREP_HEADER) {
+		/* Payload is in place and already masked */
+
+		if (iocb->data_length == 0) {
+			return WSLAY_ERR_WANT_WRITE;
+		}
+		return wslay_frame_send_gather(ctx, iocb->data, iocb->data_length);
+	}
+	if (ctx->ostate == SEND_HEADER && iocb->data_length > 0 && !ctx->omask && ctx->callbacks.send_iov_callback) {
+		return wslay_frame_send_gather(ctx, iocb->data, iocb->data_length);
 	}
 	if (ctx->ostate == SEND_HEADER) {
 		ptrdiff_t len = ctx->oheaderlimit - ctx->oheadermark;
@@ -154,10 +283,7 @@ ssize_t wslay_frame_send(wslay_frame_context_ptr ctx, struct wslay_frame_iocb *i
 					const uint8_t *writelimit = datamark + wslay_min(sizeof(temp), datalen);
 					size_t writelen = writelimit - datamark;
 					ssize_t r;
-					size_t i;
-					for (i = 0; i < writelen; ++i) {
-						temp[i] = datamark[i] ^ ctx->omaskkey[(ctx->opayloadoff + i) % 4];
-					}
+					wslay_mask(temp, datamark, writelen, ctx->omaskkey, ctx->opayloadoff);
 					r = ctx->callbacks.send_callback(temp, writelen, 0, ctx->user_data);
 					if (r > 0) {
 						if ((size_t)r > writelen) {
@@ -318,13 +444,10 @@ ssize_t wslay_frame_recv(wslay_frame_context_ptr ctx, struct wslay_frame_iocb *i
 		readmark = ctx->ibufmark;
 		readlimit = WSLAY_AVAIL_IBUF(ctx) < rempayloadlen ? ctx->ibuflimit : ctx->ibufmark + rempayloadlen;
 		if (ctx->imask) {
-			for (; ctx->ibufmark != readlimit; ++ctx->ibufmark, ++ctx->ipayloadoff) {
-				ctx->ibufmark[0] ^= ctx->imaskkey[ctx->ipayloadoff % 4];
-			}
-		} else {
-			ctx->ibufmark = readlimit;
-			ctx->ipayloadoff += readlimit - readmark;
+			wslay_mask(readmark, readmark, readlimit - readmark, ctx->imaskkey, ctx->ipayloadoff);
 		}
+		ctx->ibufmark = readlimit;
+		ctx->ipayloadoff += readlimit - readmark;
 		iocb->fin = ctx->iom.fin;
 		iocb->rsv = ctx->iom.rsv;
 		iocb->opcode = ctx->iom.opcode;
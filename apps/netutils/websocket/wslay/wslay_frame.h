@@ -81,6 +81,8 @@ struct wslay_frame_context {
 	uint64_t opayloadoff;
 	uint8_t omask;
 	uint8_t omaskkey[4];
+	/* 1 if the header was put in front of the (masked) payload */
+	uint8_t ocontig;
 	enum wslay_frame_state ostate;
 
 	struct wslay_frame_callbacks callbacks;
@@ -0,0 +1,633 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * apps/system/fota_hal/fota_decode.c
+ *
+ * Streaming decoder of packed FOTA images (see fota_decode.h): the image
+ * arrives in pieces cut anywhere, is decompressed in a window of bounded
+ * size and/or rebuilt from the running image, and leaves in pieces of
+ * CONFIG_SYSTEM_FOTA_HAL_DECODE_BUFSIZE bytes with its crc32() computed
+ * on the way.  Nothing is kept of the packed image but the state of the
+ * command being decoded.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <crc32.h>
+
+#include "fota_decode.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* States of the LZ stage, in the order of an LZ4 sequence */
+
+#define LZ_TOKEN      0
+#define LZ_LITLEN     1
+#define LZ_LITERALS   2
+#define LZ_OFFSET0    3
+#define LZ_OFFSET1    4
+#define LZ_MATCHLEN   5
+
+#define LZ_MINMATCH   4
+#define LZ_MAXLEN     0x01000000	/* Longer runs are taken as corruption */
+
+/* States of the delta stage */
+
+#define DELTA_OP      0
+#define DELTA_ARGS    1
+#define DELTA_DATA    2
+#define DELTA_ADD     3
+
+#define MIN(a, b)     ((a) < (b) ? (a) : (b))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint32_t fota_get32(FAR const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/****************************************************************************
+ * Name: fota_flush
+ *
+ * Description:
+ *   Write the image bytes buffered in dec->out.
+ *
+ ****************************************************************************/
+
+static int fota_flush(FAR struct fota_decode_s *dec)
+{
+	int ret;
+
+	if (dec->outlen == 0) {
+		return OK;
+	}
+
+	ret = dec->write(dec->arg, dec->out, dec->outlen);
+	if (ret != dec->outlen) {
+		return ret < 0 ? ret : -EIO;
+	}
+
+	dec->outlen = 0;
+	return OK;
+}
+
+/* Room left in dec->out, once flushed if it is full */
+
+static int fota_space(FAR struct fota_decode_s *dec)
+{
+	int ret;
+
+	if (dec->outlen == CONFIG_SYSTEM_FOTA_HAL_DECODE_BUFSIZE) {
+		ret = fota_flush(dec);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return CONFIG_SYSTEM_FOTA_HAL_DECODE_BUFSIZE - dec->outlen;
+}
+
+/* Account for n image bytes just placed at the end of dec->out */
+
+static void fota_commit(FAR struct fota_decode_s *dec, size_t n)
+{
+	dec->crc = crc32part(&dec->out[dec->outlen], n, dec->crc);
+	dec->outlen += n;
+	dec->total += n;
+}
+
+/****************************************************************************
+ * Name: fota_emit
+ *
+ * Description:
+ *   Append len image bytes to the output.
+ *
+ ****************************************************************************/
+
+static int fota_emit(FAR struct fota_decode_s *dec, FAR const uint8_t *data, size_t len)
+{
+	int space;
+
+	if (len > dec->size - dec->total) {
+		return -EINVAL;
+	}
+
+	while (len > 0) {
+		space = fota_space(dec);
+		if (space < 0) {
+			return space;
+		}
+
+		space = MIN(len, (size_t)space);
+		memcpy(&dec->out[dec->outlen], data, space);
+		fota_commit(dec, space);
+		data += space;
+		len -= space;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: fota_source
+ *
+ * Description:
+ *   Append len bytes of the source image at offset to the output.  With
+ *   diff, add diff[i] to each of them.
+ *
+ ****************************************************************************/
+
+static int fota_source(FAR struct fota_decode_s *dec, uint32_t offset, FAR const uint8_t *diff, size_t len)
+{
+	FAR uint8_t *out;
+	int space;
+	int ret;
+	int i;
+
+	while (len > 0) {
+		space = fota_space(dec);
+		if (space < 0) {
+			return space;
+		}
+
+		space = MIN(len, (size_t)space);
+		out = &dec->out[dec->outlen];
+		ret = dec->read(dec->arg, offset, out, space);
+		if (ret != space) {
+			return ret < 0 ? ret : -EIO;
+		}
+
+		if (diff) {
+			for (i = 0; i < space; i++) {
+				out[i] += diff[i];
+			}
+
+			diff += space;
+		}
+
+		fota_commit(dec, space);
+		offset += space;
+		len -= space;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: fota_command
+ *
+ * Description:
+ *   Start the delta command whose arguments were all received.
+ *
+ ****************************************************************************/
+
+static int fota_command(FAR struct fota_decode_s *dec)
+{
+	uint32_t offset = dec->args[0];
+	uint32_t len = dec->args[1];
+
+	if (dec->op == FOTA_DELTA_DATA) {
+		if (dec->args[0] > dec->size - dec->total) {
+			return -EINVAL;
+		}
+
+		dec->dstate = dec->args[0] ? DELTA_DATA : DELTA_OP;
+		return OK;
+	}
+
+	if (len > dec->size - dec->total || len > dec->srcsize || offset > dec->srcsize - len) {
+		return -EINVAL;
+	}
+
+	if (dec->op == FOTA_DELTA_COPY) {
+		dec->dstate = DELTA_OP;
+		return fota_source(dec, offset, NULL, len);
+	}
+
+	dec->dstate = len ? DELTA_ADD : DELTA_OP;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: fota_delta
+ *
+ * Description:
+ *   Run len bytes of delta commands.
+ *
+ ****************************************************************************/
+
+static int fota_delta(FAR struct fota_decode_s *dec, FAR const uint8_t *data, size_t len)
+{
+	uint32_t n;
+	uint8_t byte;
+	int ret = OK;
+
+	while (len > 0 && ret == OK) {
+		switch (dec->dstate) {
+		case DELTA_OP:
+			dec->op = *data++;
+			len--;
+			if (dec->op > FOTA_DELTA_ADD) {
+				return -EINVAL;
+			}
+
+			dec->nargs = dec->op == FOTA_DELTA_DATA ? 1 : 2;
+			dec->argn = 0;
+			dec->shift = 0;
+			dec->args[0] = 0;
+			dec->args[1] = 0;
+			dec->dstate = DELTA_ARGS;
+			break;
+
+		case DELTA_ARGS:
+			byte = *data++;
+			len--;
+			if (dec->shift > 28 || (dec->shift == 28 && (byte & 0x70) != 0)) {
+				return -EINVAL;
+			}
+
+			dec->args[dec->argn] |= (uint32_t)(byte & 0x7f) << dec->shift;
+			dec->shift += 7;
+			if ((byte & 0x80) == 0) {
+				dec->shift = 0;
+				if (++dec->argn == dec->nargs) {
+					ret = fota_command(dec);
+				}
+			}
+			break;
+
+		case DELTA_DATA:
+			n = MIN(len, dec->args[0]);
+			ret = fota_emit(dec, data, n);
+			data += n;
+			len -= n;
+			dec->args[0] -= n;
+			if (dec->args[0] == 0) {
+				dec->dstate = DELTA_OP;
+			}
+			break;
+
+		case DELTA_ADD:
+			n = MIN(len, dec->args[1]);
+			ret = fota_source(dec, dec->args[0], data, n);
+			data += n;
+			len -= n;
+			dec->args[0] += n;
+			dec->args[1] -= n;
+			if (dec->args[1] == 0) {
+				dec->dstate = DELTA_OP;
+			}
+			break;
+		}
+	}
+
+	return ret;
+}
+
+/* What the LZ stage decompresses, or the packed image itself without it */
+
+static int fota_unpacked(FAR struct fota_decode_s *dec, FAR const uint8_t *data, size_t len)
+{
+	if (dec->flags & FOTA_DECODE_DELTA) {
+		return fota_delta(dec, data, len);
+	}
+
+	return fota_emit(dec, data, len);
+}
+
+/****************************************************************************
+ * Name: fota_lzliterals
+ *
+ * Description:
+ *   Put len literal bytes in the window and pass them on.
+ *
+ ****************************************************************************/
+
+static int fota_lzliterals(FAR struct fota_decode_s *dec, FAR const uint8_t *data, size_t len)
+{
+	FAR uint8_t *dst;
+	uint32_t n;
+	int ret;
+
+	while (len > 0) {
+		dst = &dec->window[dec->wpos];
+		n = MIN(len, dec->wmask + 1 - dec->wpos);
+		memcpy(dst, data, n);
+		dec->wpos = (dec->wpos + n) & dec->wmask;
+		dec->wfill = MIN(dec->wfill + n, dec->wmask + 1);
+
+		ret = fota_unpacked(dec, dst, n);
+		if (ret < 0) {
+			return ret;
+		}
+
+		data += n;
+		len -= n;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: fota_lzmatch
+ *
+ * Description:
+ *   Repeat the dec->matchlen bytes at dec->offset back in the window and
+ *   pass them on.
+ *
+ ****************************************************************************/
+
+static int fota_lzmatch(FAR struct fota_decode_s *dec)
+{
+	FAR uint8_t *dst;
+	uint32_t len = dec->matchlen + LZ_MINMATCH;
+	uint32_t src;
+	uint32_t n;
+	uint32_t i;
+	int ret;
+
+	if (dec->offset == 0 || dec->offset > dec->wfill) {
+		return -EINVAL;
+	}
+
+	while (len > 0) {
+		dst = &dec->window[dec->wpos];
+		src = (dec->wpos - dec->offset) & dec->wmask;
+		n = MIN(len, dec->wmask + 1 - dec->wpos);
+
+		if (dec->offset >= n && src + n <= dec->wmask + 1) {
+			/* No byte of this piece is copied from itself, although the
+			 * window may wrap between them.
+			 */
+
+			memmove(dst, &dec->window[src], n);
+		} else {
+			/* A repeating pattern, or wrapping around the window */
+
+			for (i = 0; i < n; i++) {
+				dst[i] = dec->window[(src + i) & dec->wmask];
+			}
+		}
+
+		dec->wpos = (dec->wpos + n) & dec->wmask;
+		dec->wfill = MIN(dec->wfill + n, dec->wmask + 1);
+
+		ret = fota_unpacked(dec, dst, n);
+		if (ret < 0) {
+			return ret;
+		}
+
+		len -= n;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: fota_lz
+ *
+ * Description:
+ *   Decompress len bytes of LZ4 sequences.
+ *
+ ****************************************************************************/
+
+static int fota_lz(FAR struct fota_decode_s *dec, FAR const uint8_t *data, size_t len)
+{
+	uint32_t n;
+	uint8_t byte;
+	int ret = OK;
+
+	while (len > 0 && ret == OK) {
+		if (dec->lzstate == LZ_LITERALS) {
+			n = MIN(len, dec->litlen);
+			ret = fota_lzliterals(dec, data, n);
+			data += n;
+			len -= n;
+			dec->litlen -= n;
+			if (dec->litlen == 0) {
+				dec->lzstate = LZ_OFFSET0;
+			}
+			continue;
+		}
+
+		byte = *data++;
+		len--;
+
+		switch (dec->lzstate) {
+		case LZ_TOKEN:
+			dec->litlen = byte >> 4;
+			dec->matchlen = byte & 0x0f;
+			if (dec->litlen == 0x0f) {
+				dec->lzstate = LZ_LITLEN;
+			} else {
+				dec->lzstate = dec->litlen ? LZ_LITERALS : LZ_OFFSET0;
+			}
+			break;
+
+		case LZ_LITLEN:
+			dec->litlen += byte;
+			if (dec->litlen > LZ_MAXLEN) {
+				return -EINVAL;
+			}
+
+			if (byte != 0xff) {
+				dec->lzstate = LZ_LITERALS;
+			}
+			break;
+
+		case LZ_OFFSET0:
+			dec->offset = byte;
+			dec->lzstate = LZ_OFFSET1;
+			break;
+
+		case LZ_OFFSET1:
+			dec->offset |= (uint16_t)byte << 8;
+			if (dec->matchlen == 0x0f) {
+				dec->lzstate = LZ_MATCHLEN;
+			} else {
+				dec->lzstate = LZ_TOKEN;
+				ret = fota_lzmatch(dec);
+			}
+			break;
+
+		case LZ_MATCHLEN:
+			dec->matchlen += byte;
+			if (dec->matchlen > LZ_MAXLEN) {
+				return -EINVAL;
+			}
+
+			if (byte != 0xff) {
+				dec->lzstate = LZ_TOKEN;
+				ret = fota_lzmatch(dec);
+			}
+			break;
+		}
+	}
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: fota_header
+ *
+ * Description:
+ *   Check the header just received and set dec up for what follows.
+ *
+ ****************************************************************************/
+
+static int fota_header(FAR struct fota_decode_s *dec)
+{
+	uint8_t wlog = dec->hdr[6];
+
+	if (memcmp(dec->hdr, FOTA_DECODE_MAGIC, 4) != 0 || dec->hdr[4] != FOTA_DECODE_VERSION) {
+		return -EINVAL;
+	}
+
+	dec->flags = dec->hdr[5];
+	dec->size = fota_get32(&dec->hdr[8]);
+	dec->srcsize = fota_get32(&dec->hdr[12]);
+
+	if ((dec->flags & ~(FOTA_DECODE_LZ | FOTA_DECODE_DELTA)) != 0) {
+		return -EINVAL;
+	}
+
+	if ((dec->flags & FOTA_DECODE_DELTA) && dec->read == NULL) {
+		return -EINVAL;
+	}
+
+	if ((dec->flags & FOTA_DECODE_LZ) == 0) {
+		return wlog == 0 ? OK : -EINVAL;
+	}
+
+	if (wlog == 0 || wlog > 16) {
+		return -EINVAL;
+	}
+
+	if ((1ul << wlog) > CONFIG_SYSTEM_FOTA_HAL_DECODE_WINDOW) {
+		return -E2BIG;
+	}
+
+	dec->window = (FAR uint8_t *)malloc(1ul << wlog);
+	if (dec->window == NULL) {
+		return -ENOMEM;
+	}
+
+	dec->wmask = (1ul << wlog) - 1;
+	return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fota_decode_init
+ ****************************************************************************/
+
+void fota_decode_init(FAR struct fota_decode_s *dec, fota_decode_write_t write, fota_decode_read_t read, FAR void *arg)
+{
+	memset(dec, 0, sizeof(struct fota_decode_s));
+	dec->write = write;
+	dec->read = read;
+	dec->arg = arg;
+	dec->lzstate = LZ_TOKEN;
+	dec->dstate = DELTA_OP;
+}
+
+/****************************************************************************
+ * Name: fota_decode
+ ****************************************************************************/
+
+int fota_decode(FAR struct fota_decode_s *dec, FAR const uint8_t *data, size_t len)
+{
+	uint32_t n;
+	int ret;
+
+	if (dec->hdrlen < FOTA_DECODE_HDRSIZE) {
+		n = MIN(len, FOTA_DECODE_HDRSIZE - dec->hdrlen);
+		memcpy(&dec->hdr[dec->hdrlen], data, n);
+		dec->hdrlen += n;
+		data += n;
+		len -= n;
+
+		if (dec->hdrlen < FOTA_DECODE_HDRSIZE) {
+			return OK;
+		}
+
+		ret = fota_header(dec);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	if (dec->flags & FOTA_DECODE_LZ) {
+		return fota_lz(dec, data, len);
+	}
+
+	return fota_unpacked(dec, data, len);
+}
+
+/****************************************************************************
+ * Name: fota_decode_finish
+ ****************************************************************************/
+
+int fota_decode_finish(FAR struct fota_decode_s *dec)
+{
+	if (dec->hdrlen < FOTA_DECODE_HDRSIZE) {
+		return -EINVAL;
+	}
+
+	/* LZ4 sequences end with literals, or a match */
+
+	if ((dec->flags & FOTA_DECODE_LZ) && dec->lzstate != LZ_OFFSET0 && dec->lzstate != LZ_TOKEN) {
+		return -EINVAL;
+	}
+
+	if (dec->dstate != DELTA_OP || dec->total != dec->size) {
+		return -EINVAL;
+	}
+
+	return fota_flush(dec);
+}
+
+/****************************************************************************
+ * Name: fota_decode_release
+ ****************************************************************************/
+
+void fota_decode_release(FAR struct fota_decode_s *dec)
+{
+	if (dec->window) {
+		free(dec->window);
+		dec->window = NULL;
+	}
+}
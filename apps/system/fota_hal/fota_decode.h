@@ -0,0 +1,187 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_SYSTEM_FOTA_HAL_FOTA_DECODE_H
+#define __APPS_SYSTEM_FOTA_HAL_FOTA_DECODE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SYSTEM_FOTA_HAL_DECODE_WINDOW
+#define CONFIG_SYSTEM_FOTA_HAL_DECODE_WINDOW 4096
+#endif
+
+#ifndef CONFIG_SYSTEM_FOTA_HAL_DECODE_BUFSIZE
+#define CONFIG_SYSTEM_FOTA_HAL_DECODE_BUFSIZE 512
+#endif
+
+/* A packed image starts with a header of FOTA_DECODE_HDRSIZE bytes,
+ * little endian:
+ *
+ *   0-3:   FOTA_DECODE_MAGIC
+ *   4:     FOTA_DECODE_VERSION
+ *   5:     FOTA_DECODE_LZ and/or FOTA_DECODE_DELTA
+ *   6:     log2 of the LZ window, 0 without FOTA_DECODE_LZ
+ *   7:     Reserved, 0
+ *   8-11:  Size of the image
+ *   12-15: Size of the source image of a delta, 0 without FOTA_DECODE_DELTA
+ *
+ * With FOTA_DECODE_LZ, what follows is compressed as the sequences of an
+ * LZ4 block whose matches reach back no further than the window.  Once
+ * decompressed comes the image itself or, with FOTA_DECODE_DELTA, the
+ * commands rebuilding it from the source image: one byte each, followed
+ * by its arguments as LEB128 numbers.
+ */
+
+#define FOTA_DECODE_MAGIC     "FOTZ"
+#define FOTA_DECODE_VERSION   1
+#define FOTA_DECODE_HDRSIZE   16
+
+#define FOTA_DECODE_LZ        0x01
+#define FOTA_DECODE_DELTA     0x02
+
+#define FOTA_DELTA_DATA       0	/* len: the next len bytes are image bytes */
+#define FOTA_DELTA_COPY       1	/* offset, len: len bytes of the source at offset */
+#define FOTA_DELTA_ADD        2	/* offset, len: the next len bytes are added to
+								 * those of the source at offset */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Where the decoded image goes; return len, or a negated errno value */
+
+typedef int (*fota_decode_write_t)(FAR void *arg, FAR const uint8_t *buffer, size_t len);
+
+/* Where the source image of a delta is read; return len, or a negated
+ * errno value
+ */
+
+typedef int (*fota_decode_read_t)(FAR void *arg, uint32_t offset, FAR uint8_t *buffer, size_t len);
+
+struct fota_decode_s {
+	fota_decode_write_t write;
+	fota_decode_read_t read;
+	FAR void *arg;
+
+	uint8_t hdr[FOTA_DECODE_HDRSIZE];
+	uint8_t hdrlen;				/* Header bytes received */
+	uint8_t flags;				/* FOTA_DECODE_* of the header */
+	uint32_t size;				/* Image size in the header */
+	uint32_t srcsize;			/* Source image size in the header */
+	uint32_t total;				/* Image bytes decoded */
+	uint32_t crc;				/* crc32() of those bytes */
+
+	/* LZ stage: the window holds the last bytes decompressed */
+
+	FAR uint8_t *window;
+	uint32_t wmask;				/* Window size - 1 */
+	uint32_t wpos;				/* Where the next byte goes */
+	uint32_t wfill;				/* Bytes in the window, up to its size */
+	uint32_t litlen;
+	uint32_t matchlen;
+	uint16_t offset;
+	uint8_t lzstate;
+
+	/* Delta stage */
+
+	uint8_t dstate;
+	uint8_t op;
+	uint8_t nargs;				/* Number of arguments of op */
+	uint8_t argn;				/* Argument being received */
+	uint8_t shift;				/* Of its next 7 bits */
+	uint32_t args[2];
+
+	/* Image bytes not written yet */
+
+	uint16_t outlen;
+	uint8_t out[CONFIG_SYSTEM_FOTA_HAL_DECODE_BUFSIZE];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C" {
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: fota_decode_init
+ *
+ * Description:
+ *   Prepare dec for a new packed image.  read may be NULL if the image is
+ *   not a delta.
+ *
+ ****************************************************************************/
+
+void fota_decode_init(FAR struct fota_decode_s *dec, fota_decode_write_t write, fota_decode_read_t read, FAR void *arg);
+
+/****************************************************************************
+ * Name: fota_decode
+ *
+ * Description:
+ *   Decode the next len bytes of the packed image, which may be cut
+ *   anywhere.  Returns 0, -EINVAL if the image is corrupt, -E2BIG if its
+ *   window is larger than CONFIG_SYSTEM_FOTA_HAL_DECODE_WINDOW, -ENOMEM,
+ *   or the error of the write or read callback.
+ *
+ ****************************************************************************/
+
+int fota_decode(FAR struct fota_decode_s *dec, FAR const uint8_t *data, size_t len);
+
+/****************************************************************************
+ * Name: fota_decode_finish
+ *
+ * Description:
+ *   Write what is left of the image.  Returns -EINVAL if the packed image
+ *   was cut short.  dec->total and dec->crc are then those of the image.
+ *
+ ****************************************************************************/
+
+int fota_decode_finish(FAR struct fota_decode_s *dec);
+
+/****************************************************************************
+ * Name: fota_decode_release
+ *
+ * Description:
+ *   Free the window of dec.
+ *
+ ****************************************************************************/
+
+void fota_decode_release(FAR struct fota_decode_s *dec);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif							/* __APPS_SYSTEM_FOTA_HAL_FOTA_DECODE_H */
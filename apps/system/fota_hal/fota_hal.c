@@ -20,12 +20,19 @@
  ****************************************************************************/
 #include <stdio.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#include <crc32.h>
 #include <tinyara/config.h>
 #include <tinyara/fs/ioctl.h>
 #ifdef CONFIG_TASH
 #include <apps/shell/tash.h>
 #endif
 #include <apps/system/fota_hal.h>
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+#include "fota_decode.h"
+#endif
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -49,6 +56,18 @@ static bool g_binary_set = false;
 static char fota_driver_path[20] = "/dev/fota";
 static priv_fotahal_handle_t g_priv_handle;
 
+/* Size and crc32() of the binary written since fotahal_set_binary() */
+static uint32_t g_bin_written;
+static uint32_t g_bin_crc;
+
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+static fotahal_encoding_t g_encoding = FOTAHAL_ENCODING_RAW;
+static fotahal_source_t g_source;
+static void *g_source_arg;
+static struct fota_decode_s g_decoder;
+static bool g_write_failed;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -63,6 +82,29 @@ static int verify_fotahal_handle(fotahal_handle_t handle)
 	return ERROR;
 }
 
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+/* Where the decoder writes the binary */
+static int fotahal_decode_write(void *arg, const uint8_t *buffer, size_t len)
+{
+	int ret;
+
+	ret = write(g_fota_fd, buffer, len);
+	if (ret != len) {
+		g_write_failed = true;
+		return ret < 0 ? -errno : -EIO;
+	}
+
+	return ret;
+}
+
+static void fotahal_decode_start(void)
+{
+	fota_decode_release(&g_decoder);
+	fota_decode_init(&g_decoder, fotahal_decode_write, (fota_decode_read_t)g_source, g_source_arg);
+	g_write_failed = false;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -157,9 +199,48 @@ fotahal_return_t fotahal_set_binary(fotahal_handle_t handle, uint32_t bin_id)
 	}
 
 	g_binary_set = true;
+	g_bin_written = 0;
+	g_bin_crc = 0;
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+	if (g_encoding == FOTAHAL_ENCODING_PACKED) {
+		fotahal_decode_start();
+	}
+#endif
 	return FOTAHAL_RETURN_SUCCESS;
 }
 
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+/****************************************************************************
+ * Name: fotahal_set_encoding
+ *
+ * Description:
+ *   Set what the next fotahal_write() calls receive
+ ****************************************************************************/
+fotahal_return_t fotahal_set_encoding(fotahal_handle_t handle, fotahal_encoding_t encoding, fotahal_source_t source, void *arg)
+{
+	if (verify_fotahal_handle(handle) != OK) {
+		return FOTAHAL_RETURN_WRONGHANDLE;
+	}
+
+	if (encoding != FOTAHAL_ENCODING_RAW && encoding != FOTAHAL_ENCODING_PACKED) {
+		return FOTAHAL_RETURN_ERROR;
+	}
+
+	g_encoding = encoding;
+	g_source = source;
+	g_source_arg = arg;
+	g_bin_written = 0;
+	g_bin_crc = 0;
+	if (encoding == FOTAHAL_ENCODING_PACKED) {
+		fotahal_decode_start();
+	} else {
+		fota_decode_release(&g_decoder);
+	}
+
+	return FOTAHAL_RETURN_SUCCESS;
+}
+#endif
+
 /****************************************************************************
  * Name: fotahal_write
  *
@@ -182,12 +263,71 @@ fotahal_return_t fotahal_write(fotahal_handle_t handle, const char *buffer, uint
 		return FOTAHAL_RETURN_BIN_NOTSET;
 	}
 
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+	if (g_encoding == FOTAHAL_ENCODING_PACKED) {
+		ret = fota_decode(&g_decoder, (const uint8_t *)buffer, bin_size);
+		if (ret < 0) {
+			dbg("%s: fota decode failed: %d\n", __func__, ret);
+			return g_write_failed ? FOTAHAL_RETURN_WRITEFAIL : FOTAHAL_RETURN_DECODEFAIL;
+		}
+
+		return FOTAHAL_RETURN_SUCCESS;
+	}
+#endif
+
 	ret = write(g_fota_fd, buffer, bin_size);
 	if (ret != bin_size) {
 		dbg("%s: fota driver write failed\n", __func__);
 		return FOTAHAL_RETURN_WRITEFAIL;
 	}
 
+	g_bin_written += bin_size;
+	g_bin_crc = crc32part((const uint8_t *)buffer, bin_size, g_bin_crc);
+	return FOTAHAL_RETURN_SUCCESS;
+}
+
+/****************************************************************************
+ * Name: fotahal_verify
+ *
+ * Description:
+ *   Check the size and checksum of the binary written
+ ****************************************************************************/
+fotahal_return_t fotahal_verify(fotahal_handle_t handle, uint32_t bin_size, uint32_t checksum)
+{
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+	int ret;
+#endif
+
+	if (verify_fotahal_handle(handle) != OK) {
+		return FOTAHAL_RETURN_WRONGHANDLE;
+	}
+
+	if (g_binary_set == false) {
+		return FOTAHAL_RETURN_BIN_NOTSET;
+	}
+
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+	if (g_encoding == FOTAHAL_ENCODING_PACKED) {
+		ret = fota_decode_finish(&g_decoder);
+		fota_decode_release(&g_decoder);
+		if (ret < 0) {
+			dbg("%s: fota decode failed: %d\n", __func__, ret);
+			return g_write_failed ? FOTAHAL_RETURN_WRITEFAIL : FOTAHAL_RETURN_DECODEFAIL;
+		}
+
+		g_bin_written = g_decoder.total;
+		g_bin_crc = g_decoder.crc;
+	}
+#endif
+
+	if (g_bin_written != bin_size) {
+		return FOTAHAL_RETURN_WRONGSIZE;
+	}
+
+	if (g_bin_crc != checksum) {
+		return FOTAHAL_RETURN_CHECKSUMFAIL;
+	}
+
 	return FOTAHAL_RETURN_SUCCESS;
 }
 
@@ -229,6 +369,10 @@ fotahal_return_t fotahal_close(fotahal_handle_t handle)
 
 	close(g_fota_fd);
 
+#ifdef CONFIG_SYSTEM_FOTA_HAL_DECODE
+	fota_decode_release(&g_decoder);
+	g_encoding = FOTAHAL_ENCODING_RAW;
+#endif
 	g_partition_set = false;
 	g_binary_set = false;
 	priv_handle->priv = NULL;
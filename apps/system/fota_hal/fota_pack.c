@@ -0,0 +1,732 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Host tool making the packed images of fota_decode.h:
+ *
+ *   fota_pack [-z] [-w log2window] [-d running.bin] new.bin packed.bin
+ *
+ * -z compresses, -d makes a delta against the binary running on the device.
+ * The crc32() of new.bin, for fotahal_verify(), is printed.
+ *
+ *   fota_pack -t [seed]
+ *
+ * tests fota_decode.c: two firmware-like binaries are generated, the
+ * second one relinked after a few functions were added, removed and
+ * changed.  Each kind of packed image of the second one is decoded in
+ * pieces of random sizes and compared with it, then decoded again to
+ * measure the speed of the decoder.  Cut and damaged images must fail or
+ * at least stay within the size of the binary.  Built by Makefile.host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <crc32.h>
+
+#include "fota_decode.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define PACK_WLOG         12	/* 4 KiB window, the default of the target */
+#define PACK_CHAIN        32	/* LZ match candidates tried per position */
+#define PACK_HASHBITS     16
+#define PACK_DELTAMIN     16	/* Shortest exact match a delta starts from */
+#define PACK_COPYMIN      12	/* Shortest unchanged run made a COPY, uncompressed */
+#define PACK_EXTEND       64	/* Bytes an approximate match goes on without gain */
+
+#define TEST_WORDS        (64 * 1024)	/* 256 KiB binaries */
+#define TEST_BASE         0x04000000
+#define TEST_ROUNDS       20
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct pack_buf {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+};
+
+/* A word of a generated binary: an instruction, or the address of a word */
+
+struct test_word {
+	uint32_t value;
+	int32_t target;				/* Index of the word addressed, -1 if none */
+};
+
+struct test_sink {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+	const uint8_t *source;
+	size_t srcsize;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void buf_put(struct pack_buf *buf, const void *data, size_t len)
+{
+	if (buf->len + len > buf->size) {
+		buf->size = 2 * (buf->len + len);
+		buf->data = realloc(buf->data, buf->size);
+		if (buf->data == NULL) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+}
+
+static void buf_byte(struct pack_buf *buf, uint8_t byte)
+{
+	buf_put(buf, &byte, 1);
+}
+
+static void buf_leb128(struct pack_buf *buf, uint32_t value)
+{
+	while (value >= 0x80) {
+		buf_byte(buf, (value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+
+	buf_byte(buf, value);
+}
+
+static void buf_put32(struct pack_buf *buf, uint32_t value)
+{
+	uint8_t le[4] = { value, value >> 8, value >> 16, value >> 24 };
+
+	buf_put(buf, le, 4);
+}
+
+static uint32_t hash4(const uint8_t *p)
+{
+	return ((p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24) * 2654435761u) >> (32 - PACK_HASHBITS);
+}
+
+/* An LZ4 length beyond the 4 bits of the token */
+
+static void lz_length(struct pack_buf *out, size_t len)
+{
+	while (len >= 255) {
+		buf_byte(out, 255);
+		len -= 255;
+	}
+
+	buf_byte(out, len);
+}
+
+static void lz_sequence(struct pack_buf *out, const uint8_t *lit, size_t litlen, size_t offset, size_t matchlen)
+{
+	uint8_t token;
+
+	token = (litlen < 15 ? litlen : 15) << 4;
+	if (offset) {
+		token |= matchlen - 4 < 15 ? matchlen - 4 : 15;
+	}
+
+	buf_byte(out, token);
+	if (litlen >= 15) {
+		lz_length(out, litlen - 15);
+	}
+
+	buf_put(out, lit, litlen);
+	if (offset) {
+		buf_byte(out, offset);
+		buf_byte(out, offset >> 8);
+		if (matchlen - 4 >= 15) {
+			lz_length(out, matchlen - 4 - 15);
+		}
+	}
+}
+
+/* Compress in as LZ4 sequences whose matches stay within 1 << wlog bytes */
+
+static void lz_compress(const uint8_t *in, size_t len, int wlog, struct pack_buf *out)
+{
+	size_t window = (size_t)1 << wlog;
+	size_t maxoff = window < 65535 ? window : 65535;
+	int32_t *head;
+	int32_t *prev;
+	size_t anchor = 0;
+	size_t pos = 0;
+	size_t best;
+	size_t bestoff;
+	size_t n;
+	int32_t cand;
+	uint32_t h;
+	int chain;
+
+	head = malloc(sizeof(int32_t) << PACK_HASHBITS);
+	prev = malloc(sizeof(int32_t) * (len + 1));
+	memset(head, 0xff, sizeof(int32_t) << PACK_HASHBITS);
+
+	while (pos + 4 <= len) {
+		h = hash4(in + pos);
+		best = 0;
+		bestoff = 0;
+		for (cand = head[h], chain = 0; cand >= 0 && pos - cand <= maxoff && chain < PACK_CHAIN; cand = prev[cand], chain++) {
+			for (n = 0; pos + n < len && in[cand + n] == in[pos + n]; n++) ;
+			if (n > best) {
+				best = n;
+				bestoff = pos - cand;
+			}
+		}
+
+		prev[pos] = head[h];
+		head[h] = pos;
+
+		if (best < 4) {
+			pos++;
+			continue;
+		}
+
+		lz_sequence(out, in + anchor, pos - anchor, bestoff, best);
+		for (n = 1; n < best && pos + n + 4 <= len; n++) {
+			h = hash4(in + pos + n);
+			prev[pos + n] = head[h];
+			head[h] = pos + n;
+		}
+
+		pos += best;
+		anchor = pos;
+	}
+
+	lz_sequence(out, in + anchor, len - anchor, 0, 0);
+	free(head);
+	free(prev);
+}
+
+/* Emit new[ns..ne) as rebuilt from old at os: COPY for the unchanged runs
+ * of copymin bytes or more, ADD for the rest.
+ */
+
+static void delta_aligned(struct pack_buf *out, const uint8_t *old, const uint8_t *new, size_t os, size_t ns, size_t ne, size_t copymin)
+{
+	size_t start = ns;
+	size_t run;
+	size_t i;
+	size_t j;
+
+	for (i = ns; i < ne;) {
+		for (run = 0; i + run < ne && old[os + i - ns + run] == new[i + run]; run++) ;
+		if (run < copymin && i + run < ne) {
+			i += run + 1;
+			continue;
+		}
+
+		if (i > start) {
+			buf_byte(out, FOTA_DELTA_ADD);
+			buf_leb128(out, os + start - ns);
+			buf_leb128(out, i - start);
+			for (j = start; j < i; j++) {
+				buf_byte(out, new[j] - old[os + j - ns]);
+			}
+		}
+
+		if (run > 0) {
+			buf_byte(out, FOTA_DELTA_COPY);
+			buf_leb128(out, os + i - ns);
+			buf_leb128(out, run);
+		}
+
+		i += run;
+		start = i;
+	}
+}
+
+/* The commands rebuilding new from old, as bsdiff would find them: exact
+ * matches, extended both ways while more than half of the bytes agree.
+ */
+
+static void delta_make(const uint8_t *old, size_t oldlen, const uint8_t *new, size_t newlen, size_t copymin, struct pack_buf *out)
+{
+	int32_t *head;
+	size_t pending = 0;
+	size_t pos = 0;
+	size_t back;
+	size_t fwd;
+	size_t best;
+	size_t n;
+	int32_t cand;
+	int score;
+	int top;
+
+	head = malloc(sizeof(int32_t) << PACK_HASHBITS);
+	memset(head, 0xff, sizeof(int32_t) << PACK_HASHBITS);
+	for (n = 0; n + 4 <= oldlen; n += 2) {
+		head[hash4(old + n)] = n;
+	}
+
+	while (pos + 4 <= newlen) {
+		cand = head[hash4(new + pos)];
+		for (n = 0; cand >= 0 && cand + n < oldlen && pos + n < newlen && old[cand + n] == new[pos + n]; n++) ;
+		if (n < PACK_DELTAMIN) {
+			pos++;
+			continue;
+		}
+
+		/* Forward, then backward down to what is already emitted */
+
+		for (fwd = n, best = n, score = top = 0; cand + fwd < oldlen && pos + fwd < newlen && fwd - best < PACK_EXTEND; fwd++) {
+			score += old[cand + fwd] == new[pos + fwd] ? 1 : -1;
+			if (score > top) {
+				top = score;
+				best = fwd + 1;
+			}
+		}
+
+		fwd = best;
+		for (back = 0, best = 0, score = top = 0; back < pos - pending && back < (size_t)cand && back - best < PACK_EXTEND; back++) {
+			score += old[cand - back - 1] == new[pos - back - 1] ? 1 : -1;
+			if (score > top) {
+				top = score;
+				best = back + 1;
+			}
+		}
+
+		back = best;
+		if (pos - back > pending) {
+			buf_byte(out, FOTA_DELTA_DATA);
+			buf_leb128(out, pos - back - pending);
+			buf_put(out, new + pending, pos - back - pending);
+		}
+
+		delta_aligned(out, old, new, cand - back, pos - back, pos + fwd, copymin);
+		pos += fwd;
+		pending = pos;
+	}
+
+	if (newlen > pending) {
+		buf_byte(out, FOTA_DELTA_DATA);
+		buf_leb128(out, newlen - pending);
+		buf_put(out, new + pending, newlen - pending);
+	}
+
+	free(head);
+}
+
+/* Pack new, compressed if wlog is not 0, as a delta against old if any */
+
+static void pack(const uint8_t *old, size_t oldlen, const uint8_t *new, size_t newlen, int wlog, struct pack_buf *out)
+{
+	struct pack_buf delta = { 0 };
+	const uint8_t *body = new;
+	size_t bodylen = newlen;
+
+	out->len = 0;
+	buf_put(out, FOTA_DECODE_MAGIC, 4);
+	buf_byte(out, FOTA_DECODE_VERSION);
+	buf_byte(out, (wlog ? FOTA_DECODE_LZ : 0) | (old ? FOTA_DECODE_DELTA : 0));
+	buf_byte(out, wlog);
+	buf_byte(out, 0);
+	buf_put32(out, newlen);
+	buf_put32(out, old ? oldlen : 0);
+
+	/* Compressed, the runs of zeros of an ADD take less than the COPY
+	 * commands that would split it
+	 */
+
+	if (old) {
+		delta_make(old, oldlen, new, newlen, wlog ? SIZE_MAX : PACK_COPYMIN, &delta);
+		body = delta.data;
+		bodylen = delta.len;
+	}
+
+	if (wlog) {
+		lz_compress(body, bodylen, wlog, out);
+	} else {
+		buf_put(out, body, bodylen);
+	}
+
+	free(delta.data);
+}
+
+static int test_write(void *arg, const uint8_t *buffer, size_t len)
+{
+	struct test_sink *sink = arg;
+
+	if (len > sink->size - sink->len) {
+		return -ENOSPC;
+	}
+
+	memcpy(sink->data + sink->len, buffer, len);
+	sink->len += len;
+	return len;
+}
+
+static int test_read(void *arg, uint32_t offset, uint8_t *buffer, size_t len)
+{
+	struct test_sink *sink = arg;
+
+	if (offset > sink->srcsize || len > sink->srcsize - offset) {
+		return -EINVAL;
+	}
+
+	memcpy(buffer, sink->source + offset, len);
+	return len;
+}
+
+/* Decode packed in pieces of 1 to maxpiece bytes, random if seed is set */
+
+static int test_decode(const uint8_t *packed, size_t len, struct test_sink *sink, size_t maxpiece, uint32_t *seed)
+{
+	struct fota_decode_s dec;
+	size_t piece;
+	size_t pos;
+	int ret = 0;
+
+	sink->len = 0;
+	fota_decode_init(&dec, test_write, test_read, sink);
+	for (pos = 0; pos < len && ret == 0; pos += piece) {
+		piece = maxpiece;
+		if (seed) {
+			*seed = *seed * 1103515245 + 12345;
+			piece = 1 + (*seed >> 8) % maxpiece;
+		}
+
+		if (piece > len - pos) {
+			piece = len - pos;
+		}
+
+		ret = fota_decode(&dec, packed + pos, piece);
+	}
+
+	if (ret == 0) {
+		ret = fota_decode_finish(&dec);
+	}
+
+	if (ret == 0 && dec.crc != crc32(sink->data, sink->len)) {
+		ret = -EBADMSG;
+	}
+
+	fota_decode_release(&dec);
+	return ret;
+}
+
+static uint32_t test_rand(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 8;
+}
+
+/* Lay words out, resolving the addresses */
+
+static void test_layout(const struct test_word *words, size_t nwords, uint8_t *bin)
+{
+	uint32_t value;
+	size_t i;
+
+	for (i = 0; i < nwords; i++) {
+		value = words[i].target >= 0 ? TEST_BASE + 4 * words[i].target : words[i].value;
+		memcpy(bin + 4 * i, &value, 4);
+	}
+}
+
+/* A binary of nwords words: instructions out of a small set, with the
+ * addresses of other words among them
+ */
+
+static void test_generate(struct test_word *words, size_t nwords, uint32_t *seed)
+{
+	uint32_t opcodes[256];
+	size_t i;
+
+	for (i = 0; i < 256; i++) {
+		opcodes[i] = test_rand(seed) << 8 ^ test_rand(seed);
+	}
+
+	for (i = 0; i < nwords; i++) {
+		words[i].target = -1;
+		switch (test_rand(seed) % 8) {
+		case 0:
+			words[i].target = test_rand(seed) % nwords;
+			break;
+		case 1:
+			words[i].value = (opcodes[test_rand(seed) % 256] & 0xfffff000) | (test_rand(seed) % 4096);
+			break;
+		default:
+			words[i].value = opcodes[test_rand(seed) % 64];
+			break;
+		}
+	}
+}
+
+/* The next version: a function inserted, one removed, a few changed, and
+ * every address relinked
+ */
+
+static size_t test_update(const struct test_word *old, size_t nold, struct test_word *new, uint32_t *seed)
+{
+	int32_t *moved;
+	size_t insert = nold / 3;
+	size_t ninsert = 300 + test_rand(seed) % 300;
+	size_t remove = 2 * nold / 3;
+	size_t nremove = 200 + test_rand(seed) % 200;
+	size_t nnew = 0;
+	size_t i;
+	int k;
+
+	moved = malloc(sizeof(int32_t) * nold);
+	for (i = 0; i < nold; i++) {
+		if (i == insert) {
+			test_generate(new + nnew, ninsert, seed);
+			nnew += ninsert;
+		}
+
+		moved[i] = nnew;
+		if (i < remove || i >= remove + nremove) {
+			new[nnew++] = old[i];
+		}
+	}
+
+	for (i = 0; i < nnew; i++) {
+		if (new[i].target >= 0 && (i < insert || i >= insert + ninsert)) {
+			new[i].target = moved[new[i].target];
+		}
+	}
+
+	for (k = 0; k < 20; k++) {
+		i = test_rand(seed) % nnew;
+		new[i].target = -1;
+		new[i].value = test_rand(seed);
+	}
+
+	free(moved);
+	return nnew;
+}
+
+static double test_seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int test(uint32_t seed)
+{
+	static const struct {
+		const char *name;
+		int wlog;
+		int delta;
+	} kinds[] = {
+		{ "plain", 0, 0 },
+		{ "lz", PACK_WLOG, 0 },
+		{ "delta", 0, 1 },
+		{ "delta+lz", PACK_WLOG, 1 },
+	};
+	struct test_word *oldw;
+	struct test_word *neww;
+	struct pack_buf packed = { 0 };
+	struct test_sink sink;
+	uint8_t *old;
+	uint8_t *new;
+	size_t oldlen;
+	size_t newlen;
+	size_t cut;
+	size_t k;
+	uint8_t saved;
+	double t;
+	int failures = 0;
+	int round;
+	int ret;
+
+	oldw = malloc(sizeof(struct test_word) * TEST_WORDS);
+	neww = malloc(sizeof(struct test_word) * 2 * TEST_WORDS);
+	test_generate(oldw, TEST_WORDS, &seed);
+	oldlen = 4 * TEST_WORDS;
+	newlen = 4 * test_update(oldw, TEST_WORDS, neww, &seed);
+	old = malloc(oldlen);
+	new = malloc(newlen);
+	test_layout(oldw, TEST_WORDS, old);
+	test_layout(neww, newlen / 4, new);
+
+	sink.size = newlen;
+	sink.data = malloc(newlen);
+	sink.source = old;
+	sink.srcsize = oldlen;
+
+	printf("%zu byte binary, update %zu bytes, window %d bytes, output pieces %d bytes\n", oldlen, newlen, 1 << PACK_WLOG, CONFIG_SYSTEM_FOTA_HAL_DECODE_BUFSIZE);
+	for (k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+		pack(kinds[k].delta ? old : NULL, oldlen, new, newlen, kinds[k].wlog, &packed);
+
+		/* Decoded in random pieces, it must be the binary */
+
+		ret = test_decode(packed.data, packed.len, &sink, 1500, &seed);
+		if (ret != 0 || sink.len != newlen || memcmp(sink.data, new, newlen) != 0) {
+			printf("  %-9s FAILED: %d\n", kinds[k].name, ret);
+			failures++;
+			continue;
+		}
+
+		t = test_seconds();
+		for (round = 0; round < TEST_ROUNDS; round++) {
+			test_decode(packed.data, packed.len, &sink, 1024, NULL);
+		}
+		t = (test_seconds() - t) / TEST_ROUNDS;
+
+		printf("  %-9s %7zu bytes (%5.1f%%), decoded at %6.1f MB/s\n", kinds[k].name, packed.len, 100.0 * packed.len / newlen, newlen / t / 1e6);
+
+		/* Cut short, it must fail */
+
+		for (round = 0; round < 50; round++) {
+			cut = test_rand(&seed) % packed.len;
+			if (test_decode(packed.data, cut, &sink, 700, &seed) == 0) {
+				printf("  %-9s cut at %zu: not detected\n", kinds[k].name, cut);
+				failures++;
+			}
+		}
+
+		/* Damaged after the header, it may decode to something else but
+		 * never past the size of the binary, which the sink would refuse
+		 */
+
+		for (round = 0; round < 200; round++) {
+			cut = FOTA_DECODE_HDRSIZE + test_rand(&seed) % (packed.len - FOTA_DECODE_HDRSIZE);
+			saved = packed.data[cut];
+			packed.data[cut] ^= 1 << test_rand(&seed) % 8;
+			ret = test_decode(packed.data, packed.len, &sink, 700, &seed);
+			if (ret == -ENOSPC || (ret == 0 && sink.len != newlen)) {
+				printf("  %-9s damaged at %zu: %d, %zu bytes\n", kinds[k].name, cut, ret, sink.len);
+				failures++;
+			}
+			packed.data[cut] = saved;
+		}
+	}
+
+	/* A window larger than the decoder allows is refused */
+
+	pack(NULL, 0, new, newlen, 16, &packed);
+	ret = test_decode(packed.data, packed.len, &sink, 1024, NULL);
+	if (ret != -E2BIG) {
+		printf("  64 KiB window not refused: %d\n", ret);
+		failures++;
+	}
+
+	printf("%s\n", failures ? "FAILED" : "passed");
+	free(packed.data);
+	free(sink.data);
+	free(old);
+	free(new);
+	free(oldw);
+	free(neww);
+	return failures ? 1 : 0;
+}
+
+static uint8_t *load(const char *path, size_t *len)
+{
+	FILE *file;
+	uint8_t *data;
+	long size;
+
+	file = fopen(path, "rb");
+	if (file == NULL || fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0) {
+		perror(path);
+		exit(1);
+	}
+
+	rewind(file);
+	data = malloc(size + 1);
+	if (data == NULL || fread(data, 1, size, file) != (size_t)size) {
+		perror(path);
+		exit(1);
+	}
+
+	fclose(file);
+	*len = size;
+	return data;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: fota_pack [-z] [-w log2window] [-d running.bin] new.bin packed.bin\n");
+	fprintf(stderr, "       fota_pack -t [seed]\n");
+	exit(1);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	struct pack_buf packed = { 0 };
+	const char *running = NULL;
+	uint8_t *old = NULL;
+	uint8_t *new;
+	size_t oldlen = 0;
+	size_t newlen;
+	FILE *file;
+	int wlog = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "zw:d:t")) != -1) {
+		switch (opt) {
+		case 'z':
+			wlog = wlog ? wlog : PACK_WLOG;
+			break;
+		case 'w':
+			wlog = atoi(optarg);
+			if (wlog < 1 || wlog > 16) {
+				usage();
+			}
+			break;
+		case 'd':
+			running = optarg;
+			break;
+		case 't':
+			return test(optind < argc ? strtoul(argv[optind], NULL, 0) : 1);
+		default:
+			usage();
+		}
+	}
+
+	if (argc - optind != 2) {
+		usage();
+	}
+
+	if (running) {
+		old = load(running, &oldlen);
+	}
+
+	new = load(argv[optind], &newlen);
+	pack(old, oldlen, new, newlen, wlog, &packed);
+
+	file = fopen(argv[optind + 1], "wb");
+	if (file == NULL || fwrite(packed.data, 1, packed.len, file) != packed.len || fclose(file) != 0) {
+		perror(argv[optind + 1]);
+		return 1;
+	}
+
+	printf("%s: %zu bytes packed to %zu, crc32 0x%08x\n", argv[optind], newlen, packed.len, crc32(new, newlen));
+	return 0;
+}
@@ -51,6 +51,46 @@ static void kdbg_heapinfo_task(FAR struct tcb_s *tcb, FAR void *arg)
 #endif
 	printf(")\n");
 }
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+static int kdbg_heapinfo_sites(struct mm_heap_s *heap)
+{
+	struct mm_heapsite_s *sites;
+	struct mm_heapsite_s site;
+	int nsites;
+	int i;
+	int j;
+
+	/* Copy the table out first; nothing is printed with the heap locked */
+
+	sites = (struct mm_heapsite_s *)malloc(sizeof(struct mm_heapsite_s) * (CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES + 1));
+	if (sites == NULL) {
+		printf("heapinfo: out of memory\n");
+		return ERROR;
+	}
+	nsites = heapinfo_profile_snapshot(heap, sites, CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES + 1);
+
+	/* Largest live size first */
+
+	for (i = 1; i < nsites; i++) {
+		site = sites[i];
+		for (j = i; j > 0 && sites[j - 1].live_size < site.live_size; j--) {
+			sites[j] = sites[j - 1];
+		}
+		sites[j] = site;
+	}
+
+	printf("Heap Allocation Sites (Size in Bytes, Owner 0 : others)\n");
+	printf("  Owner        Live  Count     Peak   Allocs\n");
+	printf("-----------------------------------------------\n");
+	for (i = 0; i < nsites; i++) {
+		printf("0x%08x %8u %6u %8u %8u\n", sites[i].addr, sites[i].live_size, sites[i].live_count, sites[i].peak_size, sites[i].total_count);
+	}
+
+	free(sites);
+	return OK;
+}
+#endif
 #endif
 int kdbg_heapinfo(int argc, char **args)
 {
@@ -59,7 +99,7 @@ int kdbg_heapinfo(int argc, char **args)
 	int mode = HEAPINFO_SIMPLE;
 	int pid = HEAPINFO_PID_NOTNEEDED;
 	struct mm_heap_s *user_heap = mm_get_heap_info();
-	while ((option = getopt(argc, args, "iap:fh")) != ERROR) {
+	while ((option = getopt(argc, args, "iap:fsh")) != ERROR) {
 		switch (option) {
 		case 'i':
 			sched_foreach(kdbg_heapinfo_init, NULL);
@@ -77,6 +117,10 @@ int kdbg_heapinfo(int argc, char **args)
 			mode = HEAPINFO_DETAIL_FREE;
 			pid = HEAPINFO_PID_NOTNEEDED;
 			break;
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+		case 's':
+			return kdbg_heapinfo_sites(user_heap);
+#endif
 		case 'h':
 		case '?':
 		default:
@@ -85,6 +129,9 @@ int kdbg_heapinfo(int argc, char **args)
 			printf(" -a : show the all allocation details\n");
 			printf(" -p[pid] : show the specific pid allocation details \n");
 			printf(" -f : show the free list \n");
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+			printf(" -s : show the allocation sites, largest live size first\n");
+#endif
 			return OK;
 		}
 	}
@@ -30,7 +30,6 @@
 
 #include "cathreadpool.h"
 #include "camutex.h"
-#include "uarraylist.h"
 #include "cacommon.h"
 
 /** IP, EDR, LE. **/
@@ -47,6 +46,17 @@
 /** check period is 1 sec. **/
 #define RETRANSMISSION_CHECK_PERIOD_SEC     1
 
+/** number of message id hash buckets, must be a power of 2. **/
+#ifndef CA_RETRANSMISSION_HASH_SIZE
+#define CA_RETRANSMISSION_HASH_SIZE     32
+#endif
+
+/** initial capacity of the retransmission heap. **/
+#define CA_RETRANSMISSION_HEAP_INIT_SIZE    8
+
+/** retransmission data, defined in caretransmission.c. **/
+struct CARetransmissionData;
+
 /** retransmission data send method type. **/
 typedef CAResult_t (*CADataSendMethod_t)(const CAEndpoint_t *endpoint,
                                          const void *pdu,
@@ -90,8 +100,17 @@ typedef struct
   /** Variable to inform the thread to stop. **/
   bool isStop;
 
-  /** array list on which the thread is operating. **/
-  u_arraylist_t *dataList;
+  /** binary min-heap of pending data ordered by next timeout. **/
+  struct CARetransmissionData **dataHeap;
+
+  /** number of pending data in dataHeap. **/
+  uint32_t dataCount;
+
+  /** allocated slots of dataHeap. **/
+  uint32_t dataCapacity;
+
+  /** pending data hashed by coap message id. **/
+  struct CARetransmissionData *dataHash[CA_RETRANSMISSION_HASH_SIZE];
 
 } CARetransmission_t;
 
@@ -965,7 +965,7 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
 
 #ifdef ARDUINO
   // If max retransmission queue is reached, then don't handle new request
-  if (CA_MAX_RT_ARRAY_SIZE == u_arraylist_length(g_retransmissionContext.dataList))
+  if (CA_MAX_RT_ARRAY_SIZE == g_retransmissionContext.dataCount)
   {
     OIC_LOG(ERROR, TAG, "max RT queue size reached!");
     return CA_SEND_FAILED;
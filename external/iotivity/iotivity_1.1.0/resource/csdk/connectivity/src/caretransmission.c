@@ -63,12 +63,15 @@
 
 #define TAG "OIC_CA_RETRANS"
 
-typedef struct
+typedef struct CARetransmissionData
 {
   uint64_t timeStamp;                 /**< last sent time. microseconds */
 #ifndef SINGLE_THREAD
   uint64_t timeout;                   /**< timeout value. microseconds */
 #endif
+  uint64_t deadline;                  /**< next retransmission time. microseconds */
+  uint32_t heapIndex;                 /**< position in the retransmission heap */
+  struct CARetransmissionData *hashNext;  /**< next data in the same hash bucket */
   uint8_t triedCount;                 /**< retransmission count */
   uint16_t messageId;                 /**< coap PDU message id */
   CAEndpoint_t *endpoint;             /**< remote endpoint */
@@ -76,6 +79,8 @@ typedef struct
   uint32_t size;                      /**< coap PDU size */
 } CARetransmissionData_t;
 
+#define CA_RETRANSMISSION_HASH(id) ((id) & (CA_RETRANSMISSION_HASH_SIZE - 1))
+
 static const uint64_t USECS_PER_SEC = 1000000;
 
 /**
@@ -131,36 +136,169 @@ CAResult_t CARetransmissionStart(CARetransmission_t *context)
 #endif
 
 /**
- * @brief   check timeout routine
- * @param   currentTime     [IN]microseconds
+ * @brief   calculate next timeout of retransmission data
  * @param   retData         [IN]retransmission data
- * @return  true if the timeout period has elapsed, false otherwise
+ * @return  time in microseconds at which the data must be sent again
  */
-static bool CACheckTimeout(uint64_t currentTime, CARetransmissionData_t *retData)
+static uint64_t CAGetNextTimeout(const CARetransmissionData_t *retData)
 {
 #ifndef SINGLE_THREAD
-  // #1. calculate timeout
   uint32_t milliTimeoutValue = retData->timeout * 0.001;
   uint64_t timeout = (milliTimeoutValue << retData->triedCount) * (uint64_t) 1000;
+#else
+  uint64_t timeout = (2 << retData->triedCount) * 1000000;
+#endif
+  return retData->timeStamp + timeout;
+}
 
-  if (currentTime >= retData->timeStamp + timeout)
+static void CASwapHeapData(CARetransmission_t *context, uint32_t a, uint32_t b)
+{
+  CARetransmissionData_t *tmp = context->dataHeap[a];
+
+  context->dataHeap[a] = context->dataHeap[b];
+  context->dataHeap[b] = tmp;
+  context->dataHeap[a]->heapIndex = a;
+  context->dataHeap[b]->heapIndex = b;
+}
+
+static void CAHeapSiftUp(CARetransmission_t *context, uint32_t index)
+{
+  while (index > 0)
   {
-    OIC_LOG_V(DEBUG, TAG, "%llu microseconds time out!!, tried count(%d)",
-              timeout, retData->triedCount);
-    return true;
+    uint32_t parent = (index - 1) / 2;
+    if (context->dataHeap[parent]->deadline <= context->dataHeap[index]->deadline)
+    {
+      break;
+    }
+    CASwapHeapData(context, parent, index);
+    index = parent;
   }
-#else
-  // #1. calculate timeout
-  uint64_t timeOut = (2 << retData->triedCount) * 1000000;
+}
 
-  if (currentTime >= retData->timeStamp + timeOut)
+static void CAHeapSiftDown(CARetransmission_t *context, uint32_t index)
+{
+  for (;;)
   {
-    OIC_LOG_V(DEBUG, TAG, "timeout=%d, tried cnt=%d",
-              (2 << retData->triedCount), retData->triedCount);
-    return true;
+    uint32_t smallest = index;
+    uint32_t left = 2 * index + 1;
+    uint32_t right = left + 1;
+
+    if (left < context->dataCount
+        && context->dataHeap[left]->deadline < context->dataHeap[smallest]->deadline)
+    {
+      smallest = left;
+    }
+    if (right < context->dataCount
+        && context->dataHeap[right]->deadline < context->dataHeap[smallest]->deadline)
+    {
+      smallest = right;
+    }
+    if (smallest == index)
+    {
+      break;
+    }
+    CASwapHeapData(context, index, smallest);
+    index = smallest;
   }
-#endif
-  return false;
+}
+
+/**
+ * @brief   add retransmission data to the heap and the message id hash
+ * @param   context         [IN]context for retransmission
+ * @param   retData         [IN]retransmission data
+ * @return  ::CA_STATUS_OK or ::CA_MEMORY_ALLOC_FAILED
+ */
+static CAResult_t CAAddRetransmissionData(CARetransmission_t *context,
+                                          CARetransmissionData_t *retData)
+{
+  if (context->dataCount == context->dataCapacity)
+  {
+    uint32_t capacity = context->dataCapacity ?
+                        context->dataCapacity * 2 : CA_RETRANSMISSION_HEAP_INIT_SIZE;
+    CARetransmissionData_t **heap = (CARetransmissionData_t **) OICRealloc(
+                                      context->dataHeap, capacity * sizeof(*heap));
+    if (NULL == heap)
+    {
+      OIC_LOG(ERROR, TAG, "memory error");
+      return CA_MEMORY_ALLOC_FAILED;
+    }
+    context->dataHeap = heap;
+    context->dataCapacity = capacity;
+  }
+
+  retData->deadline = CAGetNextTimeout(retData);
+  retData->heapIndex = context->dataCount;
+  context->dataHeap[context->dataCount++] = retData;
+  CAHeapSiftUp(context, retData->heapIndex);
+
+  uint32_t bucket = CA_RETRANSMISSION_HASH(retData->messageId);
+  retData->hashNext = context->dataHash[bucket];
+  context->dataHash[bucket] = retData;
+
+  return CA_STATUS_OK;
+}
+
+/**
+ * @brief   find retransmission data by message id and transport adapter
+ * @param   context         [IN]context for retransmission
+ * @param   messageId       [IN]coap message id
+ * @param   adapter         [IN]transport adapter of the remote endpoint
+ * @return  retransmission data or NULL if not found
+ */
+static CARetransmissionData_t *CAFindRetransmissionData(CARetransmission_t *context,
+                                                        uint16_t messageId,
+                                                        CATransportAdapter_t adapter)
+{
+  CARetransmissionData_t *retData = context->dataHash[CA_RETRANSMISSION_HASH(messageId)];
+
+  for (; NULL != retData; retData = retData->hashNext)
+  {
+    if (NULL != retData->endpoint && retData->messageId == messageId
+        && retData->endpoint->adapter == adapter)
+    {
+      break;
+    }
+  }
+
+  return retData;
+}
+
+/**
+ * @brief   unlink retransmission data from the heap and the message id hash
+ * @param   context         [IN]context for retransmission
+ * @param   retData         [IN]retransmission data
+ */
+static void CARemoveRetransmissionData(CARetransmission_t *context,
+                                       CARetransmissionData_t *retData)
+{
+  CARetransmissionData_t **link = &context->dataHash[CA_RETRANSMISSION_HASH(retData->messageId)];
+
+  while (*link != retData)
+  {
+    link = &(*link)->hashNext;
+  }
+  *link = retData->hashNext;
+  retData->hashNext = NULL;
+
+  uint32_t index = retData->heapIndex;
+  uint32_t last = --context->dataCount;
+
+  if (index != last)
+  {
+    CARetransmissionData_t *moved = context->dataHeap[last];
+
+    CASwapHeapData(context, index, last);
+    CAHeapSiftUp(context, index);
+    CAHeapSiftDown(context, moved->heapIndex);
+  }
+  context->dataHeap[last] = NULL;
+}
+
+static void CAFreeRetransmissionData(CARetransmissionData_t *retData)
+{
+  CAFreeEndpoint(retData->endpoint);
+  OICFree(retData->pdu);
+  OICFree(retData);
 }
 
 static void CACheckRetransmissionList(CARetransmission_t *context)
@@ -174,64 +312,47 @@ static void CACheckRetransmissionList(CARetransmission_t *context)
   // mutex lock
   ca_mutex_lock(context->threadMutex);
 
-  uint32_t i = 0;
-  uint32_t len = u_arraylist_length(context->dataList);
+  uint64_t currentTime = getCurrentTimeInMicroSeconds();
 
-  for (i = 0; i < len; i++)
+  // only the data at the top of the heap can be due.
+  while (context->dataCount > 0 && currentTime >= context->dataHeap[0]->deadline)
   {
-    CARetransmissionData_t *retData = u_arraylist_get(context->dataList, i);
+    CARetransmissionData_t *retData = context->dataHeap[0];
 
-    if (NULL == retData)
-    {
-      continue;
-    }
-
-    uint64_t currentTime = getCurrentTimeInMicroSeconds();
+    OIC_LOG_V(DEBUG, TAG, "%llu microseconds time out!!, tried count(%d)",
+              retData->deadline - retData->timeStamp, retData->triedCount);
 
-    if (CACheckTimeout(currentTime, retData))
+    // #2. if time's up, send the data.
+    if (NULL != context->dataSendMethod)
     {
-      // #2. if time's up, send the data.
-      if (NULL != context->dataSendMethod)
-      {
-        OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
-                  retData->messageId);
-        context->dataSendMethod(retData->endpoint, retData->pdu, retData->size);
-      }
-
-      // #3. increase the retransmission count and update timestamp.
-      retData->timeStamp = currentTime;
-      retData->triedCount++;
+      OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
+                retData->messageId);
+      context->dataSendMethod(retData->endpoint, retData->pdu, retData->size);
     }
 
+    // #3. increase the retransmission count and update timestamp.
+    retData->timeStamp = currentTime;
+    retData->triedCount++;
+
     // #4. if tried count is max, remove the retransmission data from list.
     if (retData->triedCount >= context->config.tryingCount)
     {
-      CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-      if (NULL == removedData)
-      {
-        OIC_LOG(ERROR, TAG, "Removed data is NULL");
-        // mutex unlock
-        ca_mutex_unlock(context->threadMutex);
-        return;
-      }
+      CARemoveRetransmissionData(context, retData);
       OIC_LOG_V(DEBUG, TAG, "max trying count, remove RTCON data,"
-                "msgid=%d", removedData->messageId);
+                "msgid=%d", retData->messageId);
 
       // callback for retransmit timeout
       if (NULL != context->timeoutCallback)
       {
-        context->timeoutCallback(removedData->endpoint, removedData->pdu,
-                                 removedData->size);
+        context->timeoutCallback(retData->endpoint, retData->pdu, retData->size);
       }
 
-      CAFreeEndpoint(removedData->endpoint);
-      OICFree(removedData->pdu);
-
-      OICFree(removedData);
-
-      // modify loop value.
-      len = u_arraylist_length(context->dataList);
-      --i;
+      CAFreeRetransmissionData(retData);
+    }
+    else
+    {
+      retData->deadline = CAGetNextTimeout(retData);
+      CAHeapSiftDown(context, 0);
     }
   }
 
@@ -266,7 +387,7 @@ void CARetransmissionBaseRoutine(void *threadValue)
     // mutex lock
     ca_mutex_lock(context->threadMutex);
 
-    if (!context->isStop && u_arraylist_length(context->dataList) <= 0)
+    if (!context->isStop && 0 == context->dataCount)
     {
       // if list is empty, thread will wait
       /* To avoid too many logs */
@@ -282,15 +403,14 @@ void CARetransmissionBaseRoutine(void *threadValue)
     }
     else if (!context->isStop)
     {
-      // check each RETRANSMISSION_CHECK_PERIOD_SEC time.
-#if 0
-      OIC_LOG_V(DEBUG, TAG, "wait..(%lld)microseconds",
-                RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC);
-#endif
+      // sleep until the earliest retransmission data is due.
+      uint64_t currentTime = getCurrentTimeInMicroSeconds();
+      uint64_t deadline = context->dataHeap[0]->deadline;
 
-      // wait
-      uint64_t absTime = RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC;
-      ca_cond_wait_for(context->threadCond, context->threadMutex, absTime);
+      if (deadline > currentTime)
+      {
+        ca_cond_wait_for(context->threadCond, context->threadMutex, deadline - currentTime);
+      }
     }
     else
     {
@@ -357,7 +477,6 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
   context->timeoutCallback = timeoutCallback;
   context->config = cfg;
   context->isStop = false;
-  context->dataList = u_arraylist_create();
 
   return CA_STATUS_OK;
 }
@@ -435,45 +554,42 @@ CAResult_t CARetransmissionSentData(CARetransmission_t *context,
   // mutex lock
   ca_mutex_lock(context->threadMutex);
 
-  uint32_t i = 0;
-  uint32_t len = u_arraylist_length(context->dataList);
-
   // #3. add data into list
-  for (i = 0; i < len; i++)
+  if (NULL != CAFindRetransmissionData(context, messageId, endpoint->adapter))
   {
-    CARetransmissionData_t *currData = u_arraylist_get(context->dataList, i);
+    OIC_LOG(ERROR, TAG, "Duplicate message ID");
 
-    if (NULL == currData)
-    {
-      continue;
-    }
+    // mutex unlock
+    ca_mutex_unlock(context->threadMutex);
 
-    // found index
-    if (NULL != currData->endpoint && currData->messageId == messageId
-        && (currData->endpoint->adapter == endpoint->adapter))
-    {
-      OIC_LOG(ERROR, TAG, "Duplicate message ID");
+    CAFreeRetransmissionData(retData);
+    return CA_STATUS_FAILED;
+  }
 
-      // mutex unlock
-      ca_mutex_unlock(context->threadMutex);
+  if (CA_STATUS_OK != CAAddRetransmissionData(context, retData))
+  {
+    // mutex unlock
+    ca_mutex_unlock(context->threadMutex);
 
-      OICFree(retData);
-      OICFree(pduData);
-      OICFree(remoteEndpoint);
-      return CA_STATUS_FAILED;
-    }
+    CAFreeRetransmissionData(retData);
+    return CA_MEMORY_ALLOC_FAILED;
   }
 
-  u_arraylist_add(context->dataList, (void *) retData);
-
-  // notify the thread
-  ca_cond_signal(context->threadCond);
+  // notify the thread only if the new data is due before the one it sleeps on
+  if (0 == retData->heapIndex)
+  {
+    ca_cond_signal(context->threadCond);
+  }
 
   // mutex unlock
   ca_mutex_unlock(context->threadMutex);
 
 #else
-  u_arraylist_add(context->dataList, (void *) retData);
+  if (CA_STATUS_OK != CAAddRetransmissionData(context, retData))
+  {
+    CAFreeRetransmissionData(retData);
+    return CA_MEMORY_ALLOC_FAILED;
+  }
 
   CACheckRetransmissionList(context);
 #endif
@@ -515,75 +631,47 @@ CAResult_t CARetransmissionReceivedData(CARetransmission_t *context,
 
   // mutex lock
   ca_mutex_lock(context->threadMutex);
-  uint32_t len = u_arraylist_length(context->dataList);
 
-  // find index
-  uint32_t i;
-  for (i = 0; i < len; i++)
+  // find data
+  CARetransmissionData_t *retData = CAFindRetransmissionData(context, messageId,
+                                                             endpoint->adapter);
+  if (NULL != retData)
   {
-    CARetransmissionData_t *retData = (CARetransmissionData_t *) u_arraylist_get(
-                                        context->dataList, i);
-
-    if (NULL == retData)
+    // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
+    // if retransmission was finish..token will be unavailable.
+    if (CA_EMPTY == code)
     {
-      continue;
-    }
+      OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
 
-    // found index
-    if (NULL != retData->endpoint && retData->messageId == messageId
-        && (retData->endpoint->adapter == endpoint->adapter))
-    {
-      // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
-      // if retransmission was finish..token will be unavailable.
-      if (CA_EMPTY == CAGetCodeFromPduBinaryData(pdu, size))
+      if (NULL == retData->pdu)
       {
-        OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
-
-        if (NULL == retData->pdu)
-        {
-          OIC_LOG(ERROR, TAG, "retData->pdu is null");
-          OICFree(retData);
-          // mutex unlock
-          ca_mutex_unlock(context->threadMutex);
-
-          return CA_STATUS_FAILED;
-        }
-
-        // copy PDU data
-        (*retransmissionPdu) = (void *) OICCalloc(1, retData->size);
-        if ((*retransmissionPdu) == NULL)
-        {
-          OICFree(retData);
-          OIC_LOG(ERROR, TAG, "memory error");
-
-          // mutex unlock
-          ca_mutex_unlock(context->threadMutex);
-
-          return CA_MEMORY_ALLOC_FAILED;
-        }
-        memcpy((*retransmissionPdu), retData->pdu, retData->size);
+        OIC_LOG(ERROR, TAG, "retData->pdu is null");
+        // mutex unlock
+        ca_mutex_unlock(context->threadMutex);
+
+        return CA_STATUS_FAILED;
       }
 
-      // #2. remove data from list
-      CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-      if (NULL == removedData)
+      // copy PDU data
+      (*retransmissionPdu) = (void *) OICCalloc(1, retData->size);
+      if ((*retransmissionPdu) == NULL)
       {
-        OIC_LOG(ERROR, TAG, "Removed data is NULL");
+        OIC_LOG(ERROR, TAG, "memory error");
 
         // mutex unlock
         ca_mutex_unlock(context->threadMutex);
 
-        return CA_STATUS_FAILED;
+        return CA_MEMORY_ALLOC_FAILED;
       }
+      memcpy((*retransmissionPdu), retData->pdu, retData->size);
+    }
 
-      OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
+    // #2. remove data from list
+    CARemoveRetransmissionData(context, retData);
 
-      CAFreeEndpoint(removedData->endpoint);
-      OICFree(removedData->pdu);
-      OICFree(removedData);
+    OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
 
-      break;
-    }
+    CAFreeRetransmissionData(retData);
   }
 
   // mutex unlock
@@ -633,7 +721,17 @@ CAResult_t CARetransmissionDestroy(CARetransmission_t *context)
   ca_mutex_free(context->threadMutex);
   context->threadMutex = NULL;
   ca_cond_free(context->threadCond);
-  u_arraylist_free(&context->dataList);
+
+  uint32_t i;
+  for (i = 0; i < context->dataCount; i++)
+  {
+    CAFreeRetransmissionData(context->dataHeap[i]);
+  }
+  OICFree(context->dataHeap);
+  context->dataHeap = NULL;
+  context->dataCount = 0;
+  context->dataCapacity = 0;
+  memset(context->dataHash, 0, sizeof(context->dataHash));
 
   return CA_STATUS_OK;
 }
@@ -199,6 +199,12 @@ typedef struct OCChildResource
   struct OCChildResource *next;
 } OCChildResource;
 
+/** Resource has the oic.if.baseline interface.*/
+#define OC_RESOURCE_IF_BASELINE     (1 << 0)
+
+/** Resource has the oic.if.ll interface.*/
+#define OC_RESOURCE_IF_LL           (1 << 1)
+
 /**
  * Data structure for holding data type and definition for OIC resource.
  */
@@ -249,6 +255,15 @@ typedef struct OCResource
 
   /** Pointer of ActionSet which to support group action.*/
   OCActionSet *actionsetHead;
+
+  /** Next resource in the same URI hash bucket.*/
+  struct OCResource *uriNext;
+
+  /** One bit per resource type name (name hash modulo 32); a clear bit rules the type out.*/
+  uint32_t rsrcTypeBits;
+
+  /** OC_RESOURCE_IF_* flags of the interfaces bound to the resource.*/
+  uint8_t rsrcInterfaceBits;
 } OCResource;
 
 
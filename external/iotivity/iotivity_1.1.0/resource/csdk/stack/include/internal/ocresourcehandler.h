@@ -44,6 +44,13 @@
 #define OC_RESOURCE_OBSERVABLE   1
 #define OC_RESOURCE_SECURE       1
 
+/**
+ * Number of buckets of the resource URI index, must be a power of 2.
+ */
+#ifndef OC_RESOURCE_URI_HASH_SIZE
+#define OC_RESOURCE_URI_HASH_SIZE   64
+#endif
+
 /**
  *  OIC Virtual resources supported by every OIC device.
  */
@@ -116,6 +123,23 @@ OCEntityHandlerResult defaultResourceEHandler(OCEntityHandlerFlag flag,
  */
 OCResource *FindResourceByUri(const char *resourceUri);
 
+/**
+ * Add a resource to the URI index searched by FindResourceByUri.
+ * The URI of the resource must not change while it is indexed.
+ */
+void InsertResourceUri(OCResource *resource);
+
+/**
+ * Remove a resource from the URI index; does nothing if it is not indexed.
+ */
+void RemoveResourceUri(OCResource *resource);
+
+/**
+ * Recompute the resource type and interface bits used by the discovery filters.
+ * Must be called whenever the type or interface list of a resource changes.
+ */
+void UpdateResourceFilterBits(OCResource *resource);
+
 /**
  * This function checks whether the specified resource URI aligns with a pre-existing
  * virtual resource; returns false otherwise.
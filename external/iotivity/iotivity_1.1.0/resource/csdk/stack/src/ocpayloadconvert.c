@@ -32,7 +32,8 @@
 
 #define TAG "OIC_RI_PAYLOADCONVERT"
 
-// Arbitrarily chosen size that seems to contain the majority of packages
+// Arbitrarily chosen size that seems to contain the majority of packages,
+// only used for payloads that cannot be sized before encoding (RD)
 #define INIT_SIZE (255)
 
 // Discovery Links Map Length.
@@ -72,7 +73,7 @@ OCStackResult OCConvertPayload(OCPayload *payload, uint8_t **outPayload, size_t
   OCStackResult ret = OC_STACK_INVALID_PARAM;
   int64_t err;
   uint8_t *out = NULL;
-  size_t curSize = INIT_SIZE;
+  size_t curSize = 0;
 
   VERIFY_PARAM_NON_NULL(TAG, payload, "Input param, payload is NULL");
   VERIFY_PARAM_NON_NULL(TAG, outPayload, "OutPayload parameter is NULL");
@@ -81,46 +82,42 @@ OCStackResult OCConvertPayload(OCPayload *payload, uint8_t **outPayload, size_t
   OIC_LOG_V(INFO, TAG, "Converting payload of type %d", payload->type);
   if (PAYLOAD_TYPE_SECURITY == payload->type)
   {
-    size_t securityPayloadSize = ((OCSecurityPayload *)payload)->payloadSize;
-    if (securityPayloadSize > 0)
-    {
-      out = (uint8_t *)OICCalloc(1, ((OCSecurityPayload *)payload)->payloadSize);
-      VERIFY_PARAM_NON_NULL(TAG, out, "Failed to allocate security payload");
-    }
+    curSize = ((OCSecurityPayload *)payload)->payloadSize;
+  }
+  else if (PAYLOAD_TYPE_RD == payload->type)
+  {
+    // The RD encoder needs a buffer to run, so it keeps the trial size.
+    curSize = INIT_SIZE;
   }
-  if (out == NULL)
+  else
   {
-    out = (uint8_t *)OICCalloc(1, curSize);
-    VERIFY_PARAM_NON_NULL(TAG, out, "Failed to allocate payload");
+    // Size pass: without a buffer tinycbor only counts the bytes it would write,
+    // so the payload is allocated once with its exact size and encoded once more.
+    err = OCConvertPayloadHelper(payload, NULL, &curSize);
+    if (err != CborNoError && err != CborErrorOutOfMemory)
+    {
+      ret = (OCStackResult) - err;
+      goto exit;
+    }
   }
+
+  out = (uint8_t *)OICMalloc(curSize ? curSize : 1);
+  VERIFY_PARAM_NON_NULL(TAG, out, "Failed to allocate payload");
+
   err = OCConvertPayloadHelper(payload, out, &curSize);
   ret = OC_STACK_NO_MEMORY;
 
-  if (err == CborErrorOutOfMemory)
+  while (err == CborErrorOutOfMemory)
   {
     // reallocate "out" and try again!
     uint8_t *out2 = (uint8_t *)OICRealloc(out, curSize);
     VERIFY_PARAM_NON_NULL(TAG, out2, "Failed to increase payload size");
     out = out2;
     err = OCConvertPayloadHelper(payload, out, &curSize);
-    while (err == CborErrorOutOfMemory)
-    {
-      uint8_t *out2 = (uint8_t *)OICRealloc(out, curSize);
-      VERIFY_PARAM_NON_NULL(TAG, out2, "Failed to increase payload size");
-      out = out2;
-      err = OCConvertPayloadHelper(payload, out, &curSize);
-    }
   }
 
   if (err == CborNoError)
   {
-    if (curSize < INIT_SIZE && PAYLOAD_TYPE_SECURITY != payload->type)
-    {
-      uint8_t *out2 = (uint8_t *)OICRealloc(out, curSize);
-      VERIFY_PARAM_NON_NULL(TAG, out2, "Failed to increase payload size");
-      out = out2;
-    }
-
     *size = curSize;
     *outPayload = out;
     OIC_LOG_V(DEBUG, TAG, "Payload Size: %zd Payload : ", *size);
@@ -299,11 +296,9 @@ static int64_t OCConvertDiscoveryPayload(OCDiscoveryPayload *payload, uint8_t *o
     err |= cbor_encoder_create_array(&rootMap, &linkArray, resourceCount);
     VERIFY_CBOR_SUCCESS(TAG, err, "Failed setting links array");
 
-    for (size_t i = 0; i < resourceCount; ++i)
+    for (OCResourcePayload *resource = payload->resources; resource; resource = resource->next)
     {
       CborEncoder linkMap;
-      OCResourcePayload *resource = OCDiscoveryPayloadGetResource(payload, i);
-      VERIFY_PARAM_NON_NULL(TAG, resource, "Failed retrieving resource");
 
       // resource map inside the links array.
       err |= cbor_encoder_create_map(&linkArray, &linkMap, LINKS_MAP_LEN);
@@ -722,7 +717,7 @@ static int64_t OCConvertRepPayload(OCRepPayload *payload, uint8_t *outPayload, s
     VERIFY_CBOR_SUCCESS(TAG, err, "Failed adding rep root map");
   }
 
-  while (payload != NULL && (err == CborNoError))
+  while (payload != NULL && (err == CborNoError || err == CborErrorOutOfMemory))
   {
     CborEncoder rootMap;
     err |= cbor_encoder_create_map(((arrayCount == 1) ? &encoder : &rootArray),
@@ -819,11 +814,12 @@ static int64_t AddTextStringToMap(CborEncoder *map, const char *key, size_t keyl
                                   const char *value)
 {
   int64_t err = cbor_encode_text_string(map, key, keylen);
-  if (CborNoError != err)
+  // Keep going when out of memory so that the value is counted in the needed size.
+  if (CborNoError != err && CborErrorOutOfMemory != err)
   {
     return err;
   }
-  return cbor_encode_text_string(map, value, strlen(value));
+  return err | cbor_encode_text_string(map, value, strlen(value));
 }
 
 static int64_t ConditionalAddTextStringToMap(CborEncoder *map, const char *key, size_t keylen,
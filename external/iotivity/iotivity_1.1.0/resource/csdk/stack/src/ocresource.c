@@ -65,6 +65,7 @@
              TAG, #arg " is NULL"); return (retVal); } }
 
 extern OCResource *headResource;
+static OCResource *resourceUriHash[OC_RESOURCE_URI_HASH_SIZE];
 static OCPlatformInfo savedPlatformInfo = {0};
 static OCDeviceInfo savedDeviceInfo = {0};
 
@@ -324,6 +325,94 @@ uint8_t IsCollectionResource(OCResource *resource)
   return 0;
 }
 
+/*
+ * FNV-1a string hash shared by the URI index and the resource type bits.
+ */
+static uint32_t GetStringHash(const char *str)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*str)
+  {
+    hash = (hash ^ (uint8_t) *str++) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t GetResourceTypeBit(const char *resourceTypeName)
+{
+  return (uint32_t) 1 << (GetStringHash(resourceTypeName) & 31);
+}
+
+static uint8_t GetResourceInterfaceBit(const char *interfaceName)
+{
+  if (strcmp(interfaceName, OC_RSRVD_INTERFACE_DEFAULT) == 0)
+  {
+    return OC_RESOURCE_IF_BASELINE;
+  }
+  if (strcmp(interfaceName, OC_RSRVD_INTERFACE_LL) == 0)
+  {
+    return OC_RESOURCE_IF_LL;
+  }
+  return 0;
+}
+
+void InsertResourceUri(OCResource *resource)
+{
+  if (!resource || !resource->uri)
+  {
+    return;
+  }
+
+  OCResource **bucket =
+    &resourceUriHash[GetStringHash(resource->uri) & (OC_RESOURCE_URI_HASH_SIZE - 1)];
+
+  resource->uriNext = *bucket;
+  *bucket = resource;
+}
+
+void RemoveResourceUri(OCResource *resource)
+{
+  if (!resource || !resource->uri)
+  {
+    return;
+  }
+
+  OCResource **pointer =
+    &resourceUriHash[GetStringHash(resource->uri) & (OC_RESOURCE_URI_HASH_SIZE - 1)];
+
+  while (*pointer)
+  {
+    if (*pointer == resource)
+    {
+      *pointer = resource->uriNext;
+      resource->uriNext = NULL;
+      return;
+    }
+    pointer = &(*pointer)->uriNext;
+  }
+}
+
+void UpdateResourceFilterBits(OCResource *resource)
+{
+  if (!resource)
+  {
+    return;
+  }
+
+  resource->rsrcTypeBits = 0;
+  for (OCResourceType *type = resource->rsrcType; type; type = type->next)
+  {
+    resource->rsrcTypeBits |= GetResourceTypeBit(type->resourcetypename);
+  }
+
+  resource->rsrcInterfaceBits = 0;
+  for (OCResourceInterface *itf = resource->rsrcInterface; itf; itf = itf->next)
+  {
+    resource->rsrcInterfaceBits |= GetResourceInterfaceBit(itf->name);
+  }
+}
+
 OCResource *FindResourceByUri(const char *resourceUri)
 {
   if (!resourceUri)
@@ -331,14 +420,15 @@ OCResource *FindResourceByUri(const char *resourceUri)
     return NULL;
   }
 
-  OCResource *pointer = headResource;
+  OCResource *pointer =
+    resourceUriHash[GetStringHash(resourceUri) & (OC_RESOURCE_URI_HASH_SIZE - 1)];
   while (pointer)
   {
     if (strcmp(resourceUri, pointer->uri) == 0)
     {
       return pointer;
     }
-    pointer = pointer->next;
+    pointer = pointer->uriNext;
   }
   OIC_LOG_V(INFO, TAG, "Resource %s not found", resourceUri);
   return NULL;
@@ -453,7 +543,8 @@ OCStackResult EntityHandlerCodeToOCStackCode(OCEntityHandlerResult ehResult)
   return result;
 }
 
-static bool resourceMatchesRTFilter(OCResource *resource, char *resourceTypeFilter)
+static bool resourceMatchesRTFilter(OCResource *resource, char *resourceTypeFilter,
+                                    uint32_t resourceTypeBit)
 {
   if (!resource)
   {
@@ -466,6 +557,13 @@ static bool resourceMatchesRTFilter(OCResource *resource, char *resourceTypeFilt
     return true;
   }
 
+  // A clear bit means none of the resource types can match.
+  if (!(resource->rsrcTypeBits & resourceTypeBit))
+  {
+    OIC_LOG_V(INFO, TAG, "%s does not contain rt=%s.", resource->uri, resourceTypeFilter);
+    return false;
+  }
+
   OCResourceType *resourceTypePtr = resource->rsrcType;
 
   while (resourceTypePtr)
@@ -481,7 +579,8 @@ static bool resourceMatchesRTFilter(OCResource *resource, char *resourceTypeFilt
   return false;
 }
 
-static bool resourceMatchesIFFilter(OCResource *resource, char *interfaceFilter)
+static bool resourceMatchesIFFilter(OCResource *resource, char *interfaceFilter,
+                                    uint8_t interfaceBit)
 {
   if (!resource)
   {
@@ -494,17 +593,10 @@ static bool resourceMatchesIFFilter(OCResource *resource, char *interfaceFilter)
     return true;
   }
 
-  OCResourceInterface *interfacePtr = resource->rsrcInterface;
-
-  while (interfacePtr)
+  // Only oic.if.ll and oic.if.baseline are matched, both are precomputed bits.
+  if (resource->rsrcInterfaceBits & interfaceBit)
   {
-    if ((strcmp(interfacePtr->name, interfaceFilter) == 0) &&
-        (strcmp(OC_RSRVD_INTERFACE_LL, interfaceFilter) == 0 ||
-         strcmp(OC_RSRVD_INTERFACE_DEFAULT, interfaceFilter) == 0))
-    {
-      return true;
-    }
-    interfacePtr = interfacePtr->next;
+    return true;
   }
 
   OIC_LOG_V(INFO, TAG, "%s does not contain if=%s.", resource->uri, interfaceFilter);
@@ -515,10 +607,11 @@ static bool resourceMatchesIFFilter(OCResource *resource, char *interfaceFilter)
  * If the filters are null, they will be assumed to NOT be present
  * and the resource will not be matched against them.
  * Function will return true if all non null AND non empty filters passed in find a match.
+ * The filter bits are GetResourceInterfaceBit() and GetResourceTypeBit() of the filters.
  */
 static bool includeThisResourceInResponse(OCResource *resource,
-                                          char *interfaceFilter,
-                                          char *resourceTypeFilter)
+                                          char *interfaceFilter, uint8_t interfaceBit,
+                                          char *resourceTypeFilter, uint32_t resourceTypeBit)
 {
   if (!resource)
   {
@@ -546,8 +639,8 @@ static bool includeThisResourceInResponse(OCResource *resource,
     return false;
   }
 
-  return resourceMatchesIFFilter(resource, interfaceFilter) &&
-         resourceMatchesRTFilter(resource, resourceTypeFilter);
+  return resourceMatchesIFFilter(resource, interfaceFilter, interfaceBit) &&
+         resourceMatchesRTFilter(resource, resourceTypeFilter, resourceTypeBit);
 
 }
 
@@ -698,6 +791,10 @@ static OCStackResult HandleVirtualResource(OCServerRequest *request, OCResource
       interfaceQuery = OICStrdup(OC_RSRVD_INTERFACE_LL);
     }
 
+    // Hash the filters once instead of for every resource.
+    uint8_t interfaceBit = interfaceQuery ? GetResourceInterfaceBit(interfaceQuery) : 0;
+    uint32_t resourceTypeBit = resourceTypeQuery ? GetResourceTypeBit(resourceTypeQuery) : 0;
+
     if (discoveryResult == OC_STACK_OK)
     {
       payload = (OCPayload *)OCDiscoveryPayloadCreate();
@@ -720,7 +817,8 @@ static OCStackResult HandleVirtualResource(OCServerRequest *request, OCResource
             bool result = false;
             if (resource->resourceProperties & OC_EXPLICIT_DISCOVERABLE)
             {
-              if (resourceTypeQuery && resourceMatchesRTFilter(resource, resourceTypeQuery))
+              if (resourceTypeQuery && resourceMatchesRTFilter(resource, resourceTypeQuery,
+                                                                resourceTypeBit))
               {
                 result = true;
               }
@@ -794,7 +892,8 @@ static OCStackResult HandleVirtualResource(OCServerRequest *request, OCResource
               foundResourceAtRD = true;
             }
 #endif
-            if (!foundResourceAtRD && includeThisResourceInResponse(resource, interfaceQuery, resourceTypeQuery))
+            if (!foundResourceAtRD && includeThisResourceInResponse(resource, interfaceQuery, interfaceBit,
+                                                                    resourceTypeQuery, resourceTypeBit))
             {
               discoveryResult = BuildVirtualResourceResponse(resource,
                                                              discPayload, &request->devAddr, false);
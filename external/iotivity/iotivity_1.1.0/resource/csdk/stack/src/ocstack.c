@@ -3064,6 +3064,7 @@ OCStackResult OCSetDeviceInfo(OCDeviceInfo deviceInfo)
     }
     deleteResourceType(resource->rsrcType);
     resource->rsrcType = NULL;
+    UpdateResourceFilterBits(resource);
 
     while (type)
     {
@@ -3118,21 +3119,11 @@ OCStackResult OCCreateResource(OCResourceHandle *handle,
     return OC_STACK_INVALID_PARAM;
   }
 
-  // If the headResource is NULL, then no resources have been created...
-  pointer = headResource;
-  if (pointer)
+  // Repeated URLs are not allowed.  If a repeat is found, exit with an error
+  if (FindResourceByUri(uri))
   {
-    // At least one resources is in the resource list, so we need to search for
-    // repeated URLs, which are not allowed.  If a repeat is found, exit with an error
-    while (pointer)
-    {
-      if (strncmp(uri, pointer->uri, MAX_URI_LENGTH) == 0)
-      {
-        OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
-        return OC_STACK_INVALID_PARAM;
-      }
-      pointer = pointer->next;
-    }
+    OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
+    return OC_STACK_INVALID_PARAM;
   }
   // Create the pointer and insert it into the resource list
   pointer = (OCResource *) OICCalloc(1, sizeof(OCResource));
@@ -3152,6 +3143,7 @@ OCStackResult OCCreateResource(OCResourceHandle *handle,
     result = OC_STACK_NO_MEMORY;
     goto exit;
   }
+  InsertResourceUri(pointer);
 
   // Set properties.  Set OC_ACTIVE
   pointer->resourceProperties = (OCResourceProperty)(resourceProperties
@@ -3426,6 +3418,7 @@ OCStackResult BindResourceTypeToResource(OCResource *resource,
   pointer->next = NULL;
 
   insertResourceType(resource, pointer);
+  UpdateResourceFilterBits(resource);
   result = OC_STACK_OK;
 
 exit:
@@ -3472,6 +3465,7 @@ OCStackResult BindResourceInterfaceToResource(OCResource *resource,
 
   // Bind the resourceinterface to the resource
   insertResourceInterface(resource, pointer);
+  UpdateResourceFilterBits(resource);
 
   result = OC_STACK_OK;
 
@@ -4175,6 +4169,7 @@ OCStackResult deleteResource(OCResource *resource)
         prev->next = temp->next;
       }
 
+      RemoveResourceUri(temp);
       deleteResourceElements(temp);
       OICFree(temp);
       return OC_STACK_OK;
@@ -164,6 +164,15 @@ static void prv_deleteObservedList(lwm2m_context_t * contextP)
 
         lwm2m_free(targetP);
     }
+    memset(contextP->observedHash, 0, sizeof(contextP->observedHash));
+    if (contextP->observeQueue != NULL)
+    {
+        lwm2m_free(contextP->observeQueue);
+        contextP->observeQueue = NULL;
+    }
+    contextP->observeQueueCount = 0;
+    contextP->observeQueueSize = 0;
+    contextP->watcherCount = 0;
 }
 #endif
 
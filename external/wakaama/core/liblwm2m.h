@@ -610,6 +610,9 @@ typedef struct _lwm2m_watcher_
         int64_t asInteger;
         double  asFloat;
     } lastValue;
+    struct _lwm2m_observed_ * observed; // observed URI this watcher belongs to
+    time_t deadline;                    // next time observe_step() has to look at this watcher
+    size_t queueIndex;                  // position + 1 in the context observe queue, 0 if not queued
 } lwm2m_watcher_t;
 
 typedef struct _lwm2m_observed_
@@ -618,8 +621,14 @@ typedef struct _lwm2m_observed_
 
     lwm2m_uri_t uri;
     lwm2m_watcher_t * watcherList;
+    struct _lwm2m_observed_ * hashNext;
 } lwm2m_observed_t;
 
+// Number of buckets of the URI index of observed resources
+#ifndef LWM2M_OBSERVED_HASH_SIZE
+#define LWM2M_OBSERVED_HASH_SIZE 32
+#endif
+
 #ifdef LWM2M_CLIENT_MODE
 
 typedef enum
@@ -659,6 +668,11 @@ typedef struct
     lwm2m_server_t *     serverList;
     lwm2m_object_t *     objectList;
     lwm2m_observed_t *   observedList;
+    lwm2m_observed_t *   observedHash[LWM2M_OBSERVED_HASH_SIZE];
+    lwm2m_watcher_t **   observeQueue;      // min-heap of active watchers ordered by deadline
+    size_t               observeQueueCount;
+    size_t               observeQueueSize;  // one slot is reserved for each watcher
+    size_t               watcherCount;
 #endif
 #ifdef LWM2M_SERVER_MODE
     lwm2m_client_t *        clientList;
@@ -52,19 +52,48 @@
 
 
 #ifdef LWM2M_CLIENT_MODE
+static size_t prv_hashUri(lwm2m_uri_t * uriP)
+{
+    uint32_t hash;
+
+    hash = uriP->objectId;
+    if (LWM2M_URI_IS_SET_INSTANCE(uriP))
+    {
+        hash = hash * 31 + uriP->instanceId + 1;
+    }
+    if (LWM2M_URI_IS_SET_RESOURCE(uriP))
+    {
+        hash = hash * 31 + uriP->resourceId + 1;
+    }
+
+    return hash % LWM2M_OBSERVED_HASH_SIZE;
+}
+
+static bool prv_isSameUri(lwm2m_uri_t * uri1P,
+                          lwm2m_uri_t * uri2P)
+{
+    if (uri1P->objectId != uri2P->objectId) return false;
+    if (LWM2M_URI_IS_SET_INSTANCE(uri1P) != LWM2M_URI_IS_SET_INSTANCE(uri2P)) return false;
+    if (LWM2M_URI_IS_SET_INSTANCE(uri1P) && uri1P->instanceId != uri2P->instanceId) return false;
+    if (LWM2M_URI_IS_SET_RESOURCE(uri1P) != LWM2M_URI_IS_SET_RESOURCE(uri2P)) return false;
+    if (LWM2M_URI_IS_SET_RESOURCE(uri1P) && uri1P->resourceId != uri2P->resourceId) return false;
+
+    return true;
+}
+
 static lwm2m_observed_t * prv_findObserved(lwm2m_context_t * contextP,
                                            lwm2m_uri_t * uriP)
 {
     lwm2m_observed_t * targetP;
 
-    targetP = contextP->observedList;
+    targetP = contextP->observedHash[prv_hashUri(uriP)];
     while (targetP != NULL
         && (targetP->uri.objectId != uriP->objectId
          || targetP->uri.flag != uriP->flag
          || (LWM2M_URI_IS_SET_INSTANCE(uriP) && targetP->uri.instanceId != uriP->instanceId)
          || (LWM2M_URI_IS_SET_RESOURCE(uriP) && targetP->uri.resourceId != uriP->resourceId)))
     {
-        targetP = targetP->next;
+        targetP = targetP->hashNext;
     }
 
     return targetP;
@@ -73,6 +102,8 @@ static lwm2m_observed_t * prv_findObserved(lwm2m_context_t * contextP,
 static void prv_unlinkObserved(lwm2m_context_t * contextP,
                                lwm2m_observed_t * observedP)
 {
+    lwm2m_observed_t ** bucketP;
+
     if (contextP->observedList == observedP)
     {
         contextP->observedList = contextP->observedList->next;
@@ -92,6 +123,188 @@ static void prv_unlinkObserved(lwm2m_context_t * contextP,
             parentP->next = parentP->next->next;
         }
     }
+
+    bucketP = &(contextP->observedHash[prv_hashUri(&(observedP->uri))]);
+    while (*bucketP != NULL && *bucketP != observedP)
+    {
+        bucketP = &((*bucketP)->hashNext);
+    }
+    if (*bucketP != NULL)
+    {
+        *bucketP = observedP->hashNext;
+    }
+}
+
+/*
+ * The observe queue is a binary min-heap of the active watchers ordered by
+ * the next time observe_step() has something to do for them: a pending
+ * change to notify or a minimum/maximum period to reach. Each watcher has
+ * a slot reserved when it is created so queueing never allocates.
+ */
+
+static void prv_queueSet(lwm2m_context_t * contextP,
+                         size_t index,
+                         lwm2m_watcher_t * watcherP)
+{
+    contextP->observeQueue[index] = watcherP;
+    watcherP->queueIndex = index + 1;
+}
+
+static void prv_queueSiftUp(lwm2m_context_t * contextP,
+                            size_t index)
+{
+    lwm2m_watcher_t * watcherP;
+
+    watcherP = contextP->observeQueue[index];
+    while (index > 0)
+    {
+        size_t parent;
+
+        parent = (index - 1) / 2;
+        if (contextP->observeQueue[parent]->deadline <= watcherP->deadline) break;
+        prv_queueSet(contextP, index, contextP->observeQueue[parent]);
+        index = parent;
+    }
+    prv_queueSet(contextP, index, watcherP);
+}
+
+static void prv_queueSiftDown(lwm2m_context_t * contextP,
+                              size_t index)
+{
+    lwm2m_watcher_t * watcherP;
+
+    watcherP = contextP->observeQueue[index];
+    while (2 * index + 1 < contextP->observeQueueCount)
+    {
+        size_t child;
+
+        child = 2 * index + 1;
+        if (child + 1 < contextP->observeQueueCount
+         && contextP->observeQueue[child + 1]->deadline < contextP->observeQueue[child]->deadline)
+        {
+            child++;
+        }
+        if (watcherP->deadline <= contextP->observeQueue[child]->deadline) break;
+        prv_queueSet(contextP, index, contextP->observeQueue[child]);
+        index = child;
+    }
+    prv_queueSet(contextP, index, watcherP);
+}
+
+static bool prv_reserveQueueSlot(lwm2m_context_t * contextP)
+{
+    lwm2m_watcher_t ** queueP;
+    size_t size;
+
+    if (contextP->watcherCount < contextP->observeQueueSize) return true;
+
+    size = contextP->observeQueueSize == 0 ? 8 : 2 * contextP->observeQueueSize;
+    queueP = (lwm2m_watcher_t **)lwm2m_malloc(size * sizeof(lwm2m_watcher_t *));
+    if (queueP == NULL) return false;
+    if (contextP->observeQueue != NULL)
+    {
+        memcpy(queueP, contextP->observeQueue, contextP->observeQueueCount * sizeof(lwm2m_watcher_t *));
+        lwm2m_free(contextP->observeQueue);
+    }
+    contextP->observeQueue = queueP;
+    contextP->observeQueueSize = size;
+
+    return true;
+}
+
+static void prv_queueWatcher(lwm2m_context_t * contextP,
+                             lwm2m_watcher_t * watcherP,
+                             time_t deadline)
+{
+    if (watcherP->queueIndex == 0)
+    {
+        watcherP->deadline = deadline;
+        contextP->observeQueue[contextP->observeQueueCount] = watcherP;
+        prv_queueSiftUp(contextP, contextP->observeQueueCount++);
+    }
+    else if (deadline < watcherP->deadline)
+    {
+        watcherP->deadline = deadline;
+        prv_queueSiftUp(contextP, watcherP->queueIndex - 1);
+    }
+    else
+    {
+        watcherP->deadline = deadline;
+        prv_queueSiftDown(contextP, watcherP->queueIndex - 1);
+    }
+}
+
+static void prv_dequeueWatcher(lwm2m_context_t * contextP,
+                               lwm2m_watcher_t * watcherP)
+{
+    lwm2m_watcher_t * lastP;
+    size_t index;
+
+    if (watcherP->queueIndex == 0) return;
+
+    index = watcherP->queueIndex - 1;
+    watcherP->queueIndex = 0;
+    contextP->observeQueueCount--;
+    if (index != contextP->observeQueueCount)
+    {
+        lastP = contextP->observeQueue[contextP->observeQueueCount];
+        prv_queueSet(contextP, index, lastP);
+        prv_queueSiftUp(contextP, index);
+        prv_queueSiftDown(contextP, lastP->queueIndex - 1);
+    }
+}
+
+static bool prv_getDeadline(lwm2m_watcher_t * watcherP,
+                            time_t * deadlineP)
+{
+    bool found = false;
+
+    if (watcherP->parameters == NULL) return false;
+
+    if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+    {
+        *deadlineP = watcherP->lastTime + watcherP->parameters->maxPeriod;
+        found = true;
+    }
+    // A pending change is notified at the latest when the minimum period elapses
+    if (watcherP->update == true
+     && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
+    {
+        time_t deadline;
+
+        deadline = watcherP->lastTime + watcherP->parameters->minPeriod;
+        if (found == false || deadline < *deadlineP) *deadlineP = deadline;
+        found = true;
+    }
+
+    return found;
+}
+
+static void prv_scheduleWatcher(lwm2m_context_t * contextP,
+                                lwm2m_watcher_t * watcherP,
+                                bool changed)
+{
+    time_t deadline;
+
+    if (watcherP->active == false)
+    {
+        prv_dequeueWatcher(contextP, watcherP);
+    }
+    else if (changed == true
+          && (watcherP->parameters == NULL
+           || (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MIN_PERIOD) == 0))
+    {
+        // evaluate the change at the next observe_step()
+        prv_queueWatcher(contextP, watcherP, 0);
+    }
+    else if (prv_getDeadline(watcherP, &deadline))
+    {
+        prv_queueWatcher(contextP, watcherP, deadline);
+    }
+    else
+    {
+        prv_dequeueWatcher(contextP, watcherP);
+    }
 }
 
 static lwm2m_watcher_t * prv_findWatcher(lwm2m_observed_t * observedP,
@@ -127,14 +340,15 @@ static lwm2m_watcher_t * prv_getWatcher(lwm2m_context_t * contextP,
         allocatedObserver = true;
         memset(observedP, 0, sizeof(lwm2m_observed_t));
         memcpy(&(observedP->uri), uriP, sizeof(lwm2m_uri_t));
-        observedP->next = contextP->observedList;
-        contextP->observedList = observedP;
     }
 
     watcherP = prv_findWatcher(observedP, serverP);
     if (watcherP == NULL)
     {
-        watcherP = (lwm2m_watcher_t *)lwm2m_malloc(sizeof(lwm2m_watcher_t));
+        if (prv_reserveQueueSlot(contextP) == true)
+        {
+            watcherP = (lwm2m_watcher_t *)lwm2m_malloc(sizeof(lwm2m_watcher_t));
+        }
         if (watcherP == NULL)
         {
             if (allocatedObserver == true)
@@ -146,8 +360,21 @@ static lwm2m_watcher_t * prv_getWatcher(lwm2m_context_t * contextP,
         memset(watcherP, 0, sizeof(lwm2m_watcher_t));
         watcherP->active = false;
         watcherP->server = serverP;
+        watcherP->observed = observedP;
         watcherP->next = observedP->watcherList;
         observedP->watcherList = watcherP;
+        contextP->watcherCount++;
+    }
+
+    if (allocatedObserver == true)
+    {
+        size_t bucket;
+
+        bucket = prv_hashUri(uriP);
+        observedP->hashNext = contextP->observedHash[bucket];
+        contextP->observedHash[bucket] = observedP;
+        observedP->next = contextP->observedList;
+        contextP->observedList = observedP;
     }
 
     return watcherP;
@@ -182,6 +409,7 @@ coap_status_t observe_handleRequest(lwm2m_context_t * contextP,
         memcpy(watcherP->token, message->token, message->token_len);
         watcherP->active = true;
         watcherP->lastTime = lwm2m_gettime();
+        prv_scheduleWatcher(contextP, watcherP, watcherP->update);
 
         if (LWM2M_URI_IS_SET_RESOURCE(uriP))
         {
@@ -251,6 +479,9 @@ void observe_cancel(lwm2m_context_t * contextP,
         }
         if (targetP != NULL)
         {
+            prv_dequeueWatcher(contextP, targetP);
+            contextP->watcherCount--;
+            if (targetP->parameters != NULL) lwm2m_free(targetP->parameters);
             lwm2m_free(targetP);
             if (observedP->watcherList == NULL)
             {
@@ -360,6 +591,8 @@ coap_status_t observe_setParameters(lwm2m_context_t * contextP,
     LOG_ARG("Final toSet: %08X, minPeriod: %d, maxPeriod: %d, greaterThan: %f, lessThan: %f, step: %f",
             watcherP->parameters->toSet, watcherP->parameters->minPeriod, watcherP->parameters->maxPeriod, watcherP->parameters->greaterThan, watcherP->parameters->lessThan, watcherP->parameters->step);
 
+    prv_scheduleWatcher(contextP, watcherP, watcherP->update);
+
     return COAP_204_CHANGED;
 }
 
@@ -369,36 +602,79 @@ lwm2m_observed_t * observe_findByUri(lwm2m_context_t * contextP,
     lwm2m_observed_t * targetP;
 
     LOG_URI(uriP);
-    targetP = contextP->observedList;
+    targetP = contextP->observedHash[prv_hashUri(uriP)];
     while (targetP != NULL)
     {
-        if (targetP->uri.objectId == uriP->objectId)
+        if (prv_isSameUri(&(targetP->uri), uriP))
         {
-            if ((!LWM2M_URI_IS_SET_INSTANCE(uriP) && !LWM2M_URI_IS_SET_INSTANCE(&(targetP->uri)))
-             || (LWM2M_URI_IS_SET_INSTANCE(uriP) && LWM2M_URI_IS_SET_INSTANCE(&(targetP->uri)) && (uriP->instanceId == targetP->uri.instanceId)))
-             {
-                 if ((!LWM2M_URI_IS_SET_RESOURCE(uriP) && !LWM2M_URI_IS_SET_RESOURCE(&(targetP->uri)))
-                     || (LWM2M_URI_IS_SET_RESOURCE(uriP) && LWM2M_URI_IS_SET_RESOURCE(&(targetP->uri)) && (uriP->resourceId == targetP->uri.resourceId)))
-                 {
-                     LOG_ARG("Found one with%s observers.", targetP->watcherList ? "" : " no");
-                     LOG_URI(&(targetP->uri));
-                     return targetP;
-                 }
-             }
+            LOG_ARG("Found one with%s observers.", targetP->watcherList ? "" : " no");
+            LOG_URI(&(targetP->uri));
+            return targetP;
         }
-        targetP = targetP->next;
+        targetP = targetP->hashNext;
     }
 
     LOG("Found nothing");
     return NULL;
 }
 
+static void prv_tagObserved(lwm2m_context_t * contextP,
+                            lwm2m_observed_t * targetP)
+{
+    lwm2m_watcher_t * watcherP;
+
+    LOG("Found an observation");
+    LOG_URI(&(targetP->uri));
+
+    for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        if (watcherP->active == true)
+        {
+            LOG("Tagging a watcher");
+            // Several changes before the next notification are sent as one
+            watcherP->update = true;
+            prv_scheduleWatcher(contextP, watcherP, true);
+        }
+    }
+}
+
+static void prv_tagObservedUri(lwm2m_context_t * contextP,
+                               lwm2m_uri_t * uriP)
+{
+    lwm2m_observed_t * targetP;
+
+    for (targetP = contextP->observedHash[prv_hashUri(uriP)] ; targetP != NULL ; targetP = targetP->hashNext)
+    {
+        if (prv_isSameUri(&(targetP->uri), uriP)) prv_tagObserved(contextP, targetP);
+    }
+}
+
 void lwm2m_resource_value_changed(lwm2m_context_t * contextP,
                                   lwm2m_uri_t * uriP)
 {
     lwm2m_observed_t * targetP;
 
     LOG_URI(uriP);
+    if (LWM2M_URI_IS_SET_INSTANCE(uriP) && LWM2M_URI_IS_SET_RESOURCE(uriP))
+    {
+        lwm2m_uri_t uri;
+
+        // Only the object, the instance and the resource itself can be observed
+        memset(&uri, 0, sizeof(lwm2m_uri_t));
+        uri.flag = LWM2M_URI_FLAG_OBJECT_ID;
+        uri.objectId = uriP->objectId;
+        uri.instanceId = LWM2M_MAX_ID;
+        uri.resourceId = LWM2M_MAX_ID;
+        prv_tagObservedUri(contextP, &uri);
+        uri.flag |= LWM2M_URI_FLAG_INSTANCE_ID;
+        uri.instanceId = uriP->instanceId;
+        prv_tagObservedUri(contextP, &uri);
+        uri.flag |= LWM2M_URI_FLAG_RESOURCE_ID;
+        uri.resourceId = uriP->resourceId;
+        prv_tagObservedUri(contextP, &uri);
+        return;
+    }
+
     targetP = contextP->observedList;
     while (targetP != NULL)
     {
@@ -412,19 +688,7 @@ void lwm2m_resource_value_changed(lwm2m_context_t * contextP,
                  || (targetP->uri.flag & LWM2M_URI_FLAG_RESOURCE_ID) == 0
                  || uriP->resourceId == targetP->uri.resourceId)
                 {
-                    lwm2m_watcher_t * watcherP;
-
-                    LOG("Found an observation");
-                    LOG_URI(&(targetP->uri));
-
-                    for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
-                    {
-                        if (watcherP->active == true)
-                        {
-                            LOG("Tagging a watcher");
-                            watcherP->update = true;
-                        }
-                    }
+                    prv_tagObserved(contextP, targetP);
                 }
             }
         }
@@ -432,266 +696,299 @@ void lwm2m_resource_value_changed(lwm2m_context_t * contextP,
     }
 }
 
-void observe_step(lwm2m_context_t * contextP,
-                  time_t currentTime,
-                  time_t * timeoutP)
+static bool prv_notifyObserved(lwm2m_context_t * contextP,
+                               lwm2m_observed_t * targetP,
+                               time_t currentTime)
 {
-    lwm2m_observed_t * targetP;
     coap_protocol_t proto = contextP->protocol;
-
-    LOG("Entering");
-    for (targetP = contextP->observedList ; targetP != NULL ; targetP = targetP->next)
+    lwm2m_watcher_t * watcherP;
+    uint8_t * buffer = NULL;
+    size_t length = 0;
+    lwm2m_data_t * dataP = NULL;
+    int size = 0;
+    double floatValue = 0;
+    int64_t integerValue = 0;
+    bool storeValue = false;
+    bool result = true;
+    lwm2m_media_type_t format = LWM2M_CONTENT_TEXT;
+    coap_packet_t message[1];
+
+    LOG_URI(&(targetP->uri));
+    if (LWM2M_URI_IS_SET_RESOURCE(&targetP->uri))
     {
-        lwm2m_watcher_t * watcherP;
-        uint8_t * buffer = NULL;
-        size_t length = 0;
-        lwm2m_data_t * dataP = NULL;
-        int size = 0;
-        double floatValue = 0;
-        int64_t integerValue = 0;
-        bool storeValue = false;
-        lwm2m_media_type_t format = LWM2M_CONTENT_TEXT;
-        coap_packet_t message[1];
-        time_t interval;
-
-        LOG_URI(&(targetP->uri));
-        if (LWM2M_URI_IS_SET_RESOURCE(&targetP->uri))
+        if (COAP_205_CONTENT != object_readData(contextP, &targetP->uri, &size, &dataP)) return false;
+        switch (dataP->type)
         {
-            if (COAP_205_CONTENT != object_readData(contextP, &targetP->uri, &size, &dataP)) continue;
-            switch (dataP->type)
-            {
-            case LWM2M_TYPE_INTEGER:
-                if (1 != lwm2m_data_decode_int(dataP, &integerValue)) continue;
-                storeValue = true;
-                break;
-            case LWM2M_TYPE_FLOAT:
-                if (1 != lwm2m_data_decode_float(dataP, &floatValue)) continue;
-                storeValue = true;
-                break;
-            default:
-                break;
-            }
+        case LWM2M_TYPE_INTEGER:
+            if (1 != lwm2m_data_decode_int(dataP, &integerValue)) result = false;
+            storeValue = true;
+            break;
+        case LWM2M_TYPE_FLOAT:
+            if (1 != lwm2m_data_decode_float(dataP, &floatValue)) result = false;
+            storeValue = true;
+            break;
+        default:
+            break;
         }
-        for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+        if (result == false)
         {
-            if (watcherP->active == true)
+            lwm2m_data_free(size, dataP);
+            return false;
+        }
+    }
+    for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+    {
+        if (watcherP->active == true)
+        {
+            bool notify = false;
+
+            if (watcherP->update == true)
             {
-                bool notify = false;
+                // value changed, should we notify the server ?
 
-                if (watcherP->update == true)
+                if (watcherP->parameters == NULL || watcherP->parameters->toSet == 0)
                 {
-                    // value changed, should we notify the server ?
-
-                    if (watcherP->parameters == NULL || watcherP->parameters->toSet == 0)
-                    {
-                        // no conditions
-                        notify = true;
-                        LOG("Notify with no conditions");
-                        LOG_URI(&(targetP->uri));
-                    }
+                    // no conditions
+                    notify = true;
+                    LOG("Notify with no conditions");
+                    LOG_URI(&(targetP->uri));
+                }
 
-                    if (notify == false
-                     && watcherP->parameters != NULL
-                     && (watcherP->parameters->toSet & ATTR_FLAG_NUMERIC) != 0)
+                if (notify == false
+                 && watcherP->parameters != NULL
+                 && (watcherP->parameters->toSet & ATTR_FLAG_NUMERIC) != 0)
+                {
+                    if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_LESS_THAN) != 0)
                     {
-                        if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_LESS_THAN) != 0)
+                        LOG("Checking lower treshold");
+                        // Did we cross the lower treshold ?
+                        switch (dataP->type)
                         {
-                            LOG("Checking lower treshold");
-                            // Did we cross the lower treshold ?
-                            switch (dataP->type)
+                        case LWM2M_TYPE_INTEGER:
+                            if ((integerValue <= watcherP->parameters->lessThan
+                              && watcherP->lastValue.asInteger > watcherP->parameters->lessThan)
+                             || (integerValue >= watcherP->parameters->lessThan
+                              && watcherP->lastValue.asInteger < watcherP->parameters->lessThan))
                             {
-                            case LWM2M_TYPE_INTEGER:
-                                if ((integerValue <= watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asInteger > watcherP->parameters->lessThan)
-                                 || (integerValue >= watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asInteger < watcherP->parameters->lessThan))
-                                {
-                                    LOG("Notify on lower treshold crossing");
-                                    notify = true;
-                                }
-                                break;
-                            case LWM2M_TYPE_FLOAT:
-                                if ((floatValue <= watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asFloat > watcherP->parameters->lessThan)
-                                 || (floatValue >= watcherP->parameters->lessThan
-                                  && watcherP->lastValue.asFloat < watcherP->parameters->lessThan))
-                                {
-                                    LOG("Notify on lower treshold crossing");
-                                    notify = true;
-                                }
-                                break;
-                            default:
-                                break;
+                                LOG("Notify on lower treshold crossing");
+                                notify = true;
                             }
-                        }
-                        if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_GREATER_THAN) != 0)
-                        {
-                            LOG("Checking upper treshold");
-                            // Did we cross the upper treshold ?
-                            switch (dataP->type)
+                            break;
+                        case LWM2M_TYPE_FLOAT:
+                            if ((floatValue <= watcherP->parameters->lessThan
+                              && watcherP->lastValue.asFloat > watcherP->parameters->lessThan)
+                             || (floatValue >= watcherP->parameters->lessThan
+                              && watcherP->lastValue.asFloat < watcherP->parameters->lessThan))
                             {
-                            case LWM2M_TYPE_INTEGER:
-                                if ((integerValue <= watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asInteger > watcherP->parameters->greaterThan)
-                                 || (integerValue >= watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asInteger < watcherP->parameters->greaterThan))
-                                {
-                                    LOG("Notify on lower upper crossing");
-                                    notify = true;
-                                }
-                                break;
-                            case LWM2M_TYPE_FLOAT:
-                                if ((floatValue <= watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asFloat > watcherP->parameters->greaterThan)
-                                 || (floatValue >= watcherP->parameters->greaterThan
-                                  && watcherP->lastValue.asFloat < watcherP->parameters->greaterThan))
-                                {
-                                    LOG("Notify on lower upper crossing");
-                                    notify = true;
-                                }
-                                break;
-                            default:
-                                break;
+                                LOG("Notify on lower treshold crossing");
+                                notify = true;
                             }
+                            break;
+                        default:
+                            break;
                         }
-                        if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_STEP) != 0)
+                    }
+                    if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_GREATER_THAN) != 0)
+                    {
+                        LOG("Checking upper treshold");
+                        // Did we cross the upper treshold ?
+                        switch (dataP->type)
                         {
-                            LOG("Checking step");
-
-                            switch (dataP->type)
-                            {
-                            case LWM2M_TYPE_INTEGER:
+                        case LWM2M_TYPE_INTEGER:
+                            if ((integerValue <= watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asInteger > watcherP->parameters->greaterThan)
+                             || (integerValue >= watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asInteger < watcherP->parameters->greaterThan))
                             {
-                                int64_t diff;
-
-                                diff = integerValue - watcherP->lastValue.asInteger;
-                                if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
-                                 || (diff >= 0 && diff >= watcherP->parameters->step))
-                                {
-                                    LOG("Notify on step condition");
-                                    notify = true;
-                                }
+                                LOG("Notify on lower upper crossing");
+                                notify = true;
                             }
-                                break;
-                            case LWM2M_TYPE_FLOAT:
+                            break;
+                        case LWM2M_TYPE_FLOAT:
+                            if ((floatValue <= watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asFloat > watcherP->parameters->greaterThan)
+                             || (floatValue >= watcherP->parameters->greaterThan
+                              && watcherP->lastValue.asFloat < watcherP->parameters->greaterThan))
                             {
-                                double diff;
-
-                                diff = floatValue - watcherP->lastValue.asFloat;
-                                if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
-                                 || (diff >= 0 && diff >= watcherP->parameters->step))
-                                {
-                                    LOG("Notify on step condition");
-                                    notify = true;
-                                }
-                            }
-                                break;
-                            default:
-                                break;
+                                LOG("Notify on lower upper crossing");
+                                notify = true;
                             }
+                            break;
+                        default:
+                            break;
                         }
                     }
-
-                    if (watcherP->parameters != NULL
-                     && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
+                    if ((watcherP->parameters->toSet & LWM2M_ATTR_FLAG_STEP) != 0)
                     {
-                        LOG_ARG("Checking minimal period (%d s)", watcherP->parameters->minPeriod);
+                        LOG("Checking step");
 
-                        if (watcherP->lastTime + watcherP->parameters->minPeriod > currentTime)
+                        switch (dataP->type)
                         {
-                            // Minimum Period did not elapse yet
-                            interval = watcherP->lastTime + watcherP->parameters->minPeriod - currentTime;
-                            if (*timeoutP > interval) *timeoutP = interval;
-                            notify = false;
+                        case LWM2M_TYPE_INTEGER:
+                        {
+                            int64_t diff;
+
+                            diff = integerValue - watcherP->lastValue.asInteger;
+                            if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
+                             || (diff >= 0 && diff >= watcherP->parameters->step))
+                            {
+                                LOG("Notify on step condition");
+                                notify = true;
+                            }
                         }
-                        else
+                            break;
+                        case LWM2M_TYPE_FLOAT:
                         {
-                            LOG("Notify on minimal period");
-                            notify = true;
+                            double diff;
+
+                            diff = floatValue - watcherP->lastValue.asFloat;
+                            if ((diff < 0 && (0 - diff) >= watcherP->parameters->step)
+                             || (diff >= 0 && diff >= watcherP->parameters->step))
+                            {
+                                LOG("Notify on step condition");
+                                notify = true;
+                            }
+                        }
+                            break;
+                        default:
+                            break;
                         }
                     }
                 }
 
-                // Is the Maximum Period reached ?
-                if (notify == false
-                 && watcherP->parameters != NULL
-                 && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+                if (watcherP->parameters != NULL
+                 && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
                 {
-                    LOG_ARG("Checking maximal period (%d s)", watcherP->parameters->minPeriod);
+                    LOG_ARG("Checking minimal period (%d s)", watcherP->parameters->minPeriod);
 
-                    if (watcherP->lastTime + watcherP->parameters->maxPeriod <= currentTime)
+                    if (watcherP->lastTime + watcherP->parameters->minPeriod > currentTime)
                     {
-                        LOG("Notify on maximal period");
+                        // Minimum Period did not elapse yet
+                        notify = false;
+                    }
+                    else
+                    {
+                        LOG("Notify on minimal period");
                         notify = true;
                     }
                 }
+            }
 
-                if (notify == true)
+            // Is the Maximum Period reached ?
+            if (notify == false
+             && watcherP->parameters != NULL
+             && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+            {
+                LOG_ARG("Checking maximal period (%d s)", watcherP->parameters->minPeriod);
+
+                if (watcherP->lastTime + watcherP->parameters->maxPeriod <= currentTime)
                 {
-                    if (buffer == NULL)
-                    {
-                        if (dataP != NULL)
-                        {
-                            int res;
+                    LOG("Notify on maximal period");
+                    notify = true;
+                }
+            }
 
-                            res = lwm2m_data_serialize(&targetP->uri, size, dataP, &format, &buffer);
-                            if (res < 0)
-                            {
-                                break;
-                            }
-                            else
-                            {
-                                length = (size_t)res;
-                            }
+            if (notify == true)
+            {
+                if (buffer == NULL)
+                {
+                    if (dataP != NULL)
+                    {
+                        int res;
 
+                        res = lwm2m_data_serialize(&targetP->uri, size, dataP, &format, &buffer);
+                        if (res < 0)
+                        {
+                            result = false;
+                            break;
                         }
                         else
                         {
-                            if (COAP_205_CONTENT != object_read(contextP, &targetP->uri, &format, &buffer, &length))
-                            {
-                                buffer = NULL;
-                                break;
-                            }
+                            length = (size_t)res;
                         }
-                        coap_init_message(message, proto, COAP_TYPE_NON, COAP_205_CONTENT, 0);
-                        coap_set_header_content_type(message, format);
-                        coap_set_payload(message, buffer, length);
-                    }
-                    watcherP->lastTime = currentTime;
-                    watcherP->lastMid = contextP->nextMID++;
-                    message->mid = watcherP->lastMid;
-                    coap_set_header_token(message, watcherP->token, watcherP->tokenLen);
-                    coap_set_header_observe(message, watcherP->counter++);
-                    (void)message_send(contextP, message, watcherP->server->sessionH);
-                    watcherP->update = false;
-                }
 
-                // Store this value
-                if (notify == true && storeValue == true)
-                {
-                    switch (dataP->type)
+                    }
+                    else
                     {
-                    case LWM2M_TYPE_INTEGER:
-                        watcherP->lastValue.asInteger = integerValue;
-                        break;
-                    case LWM2M_TYPE_FLOAT:
-                        watcherP->lastValue.asFloat = floatValue;
-                        break;
-                    default:
-                        break;
+                        if (COAP_205_CONTENT != object_read(contextP, &targetP->uri, &format, &buffer, &length))
+                        {
+                            buffer = NULL;
+                            result = false;
+                            break;
+                        }
                     }
+                    coap_init_message(message, proto, COAP_TYPE_NON, COAP_205_CONTENT, 0);
+                    coap_set_header_content_type(message, format);
+                    coap_set_payload(message, buffer, length);
                 }
+                watcherP->lastTime = currentTime;
+                watcherP->lastMid = contextP->nextMID++;
+                message->mid = watcherP->lastMid;
+                coap_set_header_token(message, watcherP->token, watcherP->tokenLen);
+                coap_set_header_observe(message, watcherP->counter++);
+                (void)message_send(contextP, message, watcherP->server->sessionH);
+                watcherP->update = false;
+            }
 
-                if (watcherP->parameters != NULL && (watcherP->parameters->toSet & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+            // Store this value
+            if (notify == true && storeValue == true)
+            {
+                switch (dataP->type)
                 {
-                    // update timers
-                    interval = watcherP->lastTime + watcherP->parameters->maxPeriod - currentTime;
-                    if (*timeoutP > interval) *timeoutP = interval;
+                case LWM2M_TYPE_INTEGER:
+                    watcherP->lastValue.asInteger = integerValue;
+                    break;
+                case LWM2M_TYPE_FLOAT:
+                    watcherP->lastValue.asFloat = floatValue;
+                    break;
+                default:
+                    break;
                 }
             }
         }
-        if (dataP != NULL) lwm2m_data_free(size, dataP);
-        if (buffer != NULL) lwm2m_free(buffer);
+    }
+    if (dataP != NULL) lwm2m_data_free(size, dataP);
+    if (buffer != NULL) lwm2m_free(buffer);
+
+    return result;
+}
+
+void observe_step(lwm2m_context_t * contextP,
+                  time_t currentTime,
+                  time_t * timeoutP)
+{
+    LOG("Entering");
+    // Only the observed URIs with a due watcher are read and notified
+    while (contextP->observeQueueCount > 0
+        && contextP->observeQueue[0]->deadline <= currentTime)
+    {
+        lwm2m_observed_t * targetP;
+        lwm2m_watcher_t * watcherP;
+        bool notified;
+
+        targetP = contextP->observeQueue[0]->observed;
+        notified = prv_notifyObserved(contextP, targetP, currentTime);
+
+        for (watcherP = targetP->watcherList ; watcherP != NULL ; watcherP = watcherP->next)
+        {
+            if (notified == true)
+            {
+                prv_scheduleWatcher(contextP, watcherP, false);
+            }
+            // On failure or with a null period, try again at the next second
+            if (watcherP->queueIndex != 0 && watcherP->deadline <= currentTime)
+            {
+                prv_queueWatcher(contextP, watcherP, currentTime + 1);
+            }
+        }
+    }
+
+    if (contextP->observeQueueCount > 0)
+    {
+        time_t interval;
+
+        interval = contextP->observeQueue[0]->deadline - currentTime;
+        if (*timeoutP > interval) *timeoutP = interval;
     }
 }
 
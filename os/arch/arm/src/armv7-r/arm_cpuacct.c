@@ -0,0 +1,74 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * arch/arm/src/armv7-r/arm_cpuacct.c
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+
+#include <tinyara/arch.h>
+
+#include "sctlr.h"
+
+#ifdef CONFIG_SCHED_CPUACCT
+
+/****************************************************************************
+ * Public functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_cpuacct_initialize
+ *
+ * Description:
+ *   Reset the cycle counter (PMCCNTR) of the Performance Monitors and let
+ *   it count every CPU cycle.
+ *
+ ****************************************************************************/
+
+void up_cpuacct_initialize(void)
+{
+	unsigned int pmcr;
+
+	pmcr = cp15_rdpmcr();
+	pmcr &= ~PCMR_D;
+	pmcr |= PCMR_E | PCMR_C;
+	cp15_wrpmcr(pmcr);
+
+	cp15_wrpmcntenset(PMCNTEN_C);
+}
+
+/****************************************************************************
+ * Name: up_cpuacct_cycles
+ *
+ * Description:
+ *   Read the cycle counter of the Performance Monitors.
+ *
+ ****************************************************************************/
+
+uint32_t up_cpuacct_cycles(void)
+{
+	return cp15_rdpmccntr();
+}
+
+#endif							/* CONFIG_SCHED_CPUACCT */
@@ -72,14 +72,22 @@
 
 #ifdef CONFIG_STACK_COLORATION
 
+#ifndef CONFIG_STACK_COLORATION_GAP
+#define CONFIG_STACK_COLORATION_GAP 0
+#endif
+
 /****************************************************************************
- * Public Data
+ * Private Data
  ****************************************************************************/
 
+#if CONFIG_ARCH_INTERRUPTSTACK > 3
+static size_t g_intstack_hwm;
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
-static size_t do_stackcheck(uintptr_t alloc, size_t size);
+static size_t do_stackcheck(uintptr_t alloc, size_t size, size_t known);
 
 /****************************************************************************
  * Name: do_stackcheck
@@ -89,21 +97,29 @@ static size_t do_stackcheck(uintptr_t alloc, size_t size);
  *   stack memory for a high water mark.  That is, the deepest level of the
  *   stack that clobbered some recognizable marker in the stack memory.
  *
+ *   The stack only ever gets deeper, so the search starts at the mark found
+ *   the last time and goes down from there.  It stops after
+ *   CONFIG_STACK_COLORATION_GAP bytes that still have the marker, instead
+ *   of going through all of the stack that was never used.  A zero gap
+ *   searches all of it, up to the known mark.
+ *
  * Input Parameters:
  *   alloc - Allocation base address of the stack
  *   size - The size of the stack in bytes
+ *   known - The amount of stack space known to have been used
  *
  * Returned value:
  *   The estimated amount of stack space used.
  *
  ****************************************************************************/
 
-static size_t do_stackcheck(uintptr_t alloc, size_t size)
+static size_t do_stackcheck(uintptr_t alloc, size_t size, size_t known)
 {
 	FAR uintptr_t start;
 	FAR uintptr_t end;
 	FAR uint32_t *ptr;
 	size_t mark;
+	size_t nclean;
 
 	/* Get aligned addresses and adjusted sizes */
 
@@ -111,13 +127,35 @@ static size_t do_stackcheck(uintptr_t alloc, size_t size)
 	end = (alloc + size + 3) & ~3;
 	size = end - start;
 
+	mark = known >> 2;
+	if (mark > (size >> 2)) {
+		mark = size >> 2;
+	}
+
 	/* The ARM uses a push-down stack:  the stack grows toward lower addresses
-	 * in memory.  We need to start at the lowest address in the stack memory
-	 * allocation and search to higher addresses.  The first word we encounter
-	 * that does not have the magic value is the high water mark.
+	 * in memory.  Search from the deepest word known to be used toward lower
+	 * addresses.  The lowest word we encounter that does not have the magic
+	 * value is the high water mark.
 	 */
 
-	for (ptr = (FAR uint32_t *)start, mark = (size >> 2); *ptr == STACK_COLOR && mark > 0; ptr++, mark--) ;
+#if CONFIG_STACK_COLORATION_GAP > 0
+	for (ptr = (FAR uint32_t *)end - mark, nclean = 0; ptr > (FAR uint32_t *)start && nclean < (CONFIG_STACK_COLORATION_GAP >> 2);) {
+		if (*--ptr != STACK_COLOR) {
+			mark = (FAR uint32_t *)end - ptr;
+			nclean = 0;
+		} else {
+			nclean++;
+		}
+	}
+#else
+	/* Without a gap, search from the lowest address instead, up to the
+	 * first word that does not have the magic value or to the known mark.
+	 */
+
+	for (ptr = (FAR uint32_t *)start, nclean = (size >> 2); nclean > mark && *ptr == STACK_COLOR; ptr++, nclean--) ;
+
+	mark = nclean;
+#endif
 
 	/* If the stack is completely used, then this might mean that the stack
 	 * overflowed from above (meaning that the stack is too small), or may
@@ -178,7 +216,11 @@ static size_t do_stackcheck(uintptr_t alloc, size_t size)
 
 size_t up_check_tcbstack(FAR struct tcb_s *tcb)
 {
-	return do_stackcheck((uintptr_t)tcb->stack_alloc_ptr, tcb->adj_stack_size);
+	size_t mark;
+
+	mark = do_stackcheck((uintptr_t)tcb->stack_alloc_ptr, tcb->adj_stack_size, tcb->stack_hwm);
+	tcb->stack_hwm = mark;
+	return mark;
 }
 
 ssize_t up_check_tcbstack_remain(FAR struct tcb_s *tcb)
@@ -199,7 +241,8 @@ ssize_t up_check_stack_remain(void)
 #if CONFIG_ARCH_INTERRUPTSTACK > 3
 size_t up_check_intstack(void)
 {
-	return do_stackcheck((uintptr_t)&g_intstackalloc, (CONFIG_ARCH_INTERRUPTSTACK & ~3));
+	g_intstack_hwm = do_stackcheck((uintptr_t)&g_intstackalloc, (CONFIG_ARCH_INTERRUPTSTACK & ~3), g_intstack_hwm);
+	return g_intstack_hwm;
 }
 
 size_t up_check_intstack_remain(void)
@@ -235,6 +235,7 @@ int up_create_stack(FAR struct tcb_s *tcb, size_t stack_size, uint8_t ttype)
 
 #ifdef CONFIG_STACK_COLORATION
 		up_stack_color(tcb->stack_alloc_ptr, tcb->adj_stack_size);
+		tcb->stack_hwm = 0;
 #endif
 
 		board_led_on(LED_STACKCREATED);
@@ -0,0 +1,978 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * drivers/bcache.c
+ *
+ * Each block of the device can only be cached in one set of
+ * CONFIG_DRVR_BCACHE_WAYS slots, chosen by its number, and replaces the
+ * least recently used slot of that set.  Consecutive blocks fall in
+ * consecutive sets, so several files read or written at the same time do
+ * not evict each other as they did the single buffers this replaces.
+ *
+ * Writes only modify the cache.  Dirty blocks are written back when they
+ * are evicted, on bcache_flush() and CONFIG_DRVR_BCACHE_WRDELAY ms after a
+ * write, and each write-back takes the dirty blocks cached around the one
+ * written back along, in a single transfer.
+ *
+ * The readers are told apart by the block each of them is expected to read
+ * next.  Once a reader has read two pieces in a row, the blocks after it are
+ * read ahead, in a window that doubles while it keeps reading in order.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/clock.h>
+#include <tinyara/kmalloc.h>
+#include <tinyara/wqueue.h>
+#include <tinyara/bcache.h>
+
+#ifdef CONFIG_DRVR_BCACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SCHED_WORKQUEUE
+#error "Worker thread support is required (CONFIG_SCHED_WORKQUEUE)"
+#endif
+
+#define BCACHE_NOBLOCK  ((off_t)-1)
+
+/* Slot flags */
+
+#define BCACHE_DIRTY    (1 << 0)	/* Newer than the device */
+#define BCACHE_PREFETCH (1 << 1)	/* Read ahead and not used yet */
+
+#define bcache_set(bc, block)   (&(bc)->slots[((block) % (bc)->nsets) * CONFIG_DRVR_BCACHE_WAYS])
+#define bcache_data(bc, slot)   ((bc)->data + ((slot) - (bc)->slots) * (bc)->blocksize)
+#define bcache_nslots(bc)       ((bc)->nsets * CONFIG_DRVR_BCACHE_WAYS)
+#define bcache_semgive(bc)      sem_post(&(bc)->sem)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bcache_slot_s {
+	off_t block;				/* Block in the slot, or BCACHE_NOBLOCK */
+	uint32_t stamp;				/* Value of the clock at the last use */
+	uint8_t flags;				/* BCACHE_DIRTY, BCACHE_PREFETCH */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* All caches, for /proc/bcache */
+
+static FAR struct bcache_s *g_bcaches;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bcache_semtake
+ ****************************************************************************/
+
+static void bcache_semtake(FAR struct bcache_s *bc)
+{
+	while (sem_wait(&bc->sem) != 0) {
+		/* The only case that an error should occur here is if
+		 * the wait was awakened by a signal.
+		 */
+
+		ASSERT(get_errno() == EINTR);
+	}
+}
+
+/****************************************************************************
+ * Name: bcache_lookup
+ *
+ * Description:
+ *   Return the slot holding block, or NULL if it is not cached.
+ *
+ ****************************************************************************/
+
+static FAR struct bcache_slot_s *bcache_lookup(FAR struct bcache_s *bc, off_t block)
+{
+	FAR struct bcache_slot_s *slot = bcache_set(bc, block);
+	int way;
+
+	for (way = 0; way < CONFIG_DRVR_BCACHE_WAYS; way++, slot++) {
+		if (slot->block == block) {
+			return slot;
+		}
+	}
+
+	return NULL;
+}
+
+/****************************************************************************
+ * Name: bcache_use
+ *
+ * Description:
+ *   Account a hit on a slot and make it the most recently used of its set.
+ *
+ ****************************************************************************/
+
+static void bcache_use(FAR struct bcache_s *bc, FAR struct bcache_slot_s *slot)
+{
+	if ((slot->flags & BCACHE_PREFETCH) != 0) {
+		slot->flags &= ~BCACHE_PREFETCH;
+		bc->stats.rahits++;
+	}
+
+	slot->stamp = ++bc->clock;
+	bc->stats.hits++;
+}
+
+/****************************************************************************
+ * Name: bcache_writeback
+ *
+ * Description:
+ *   Write a dirty slot back to the device, with the dirty blocks cached
+ *   just before and after it, up to xferblocks blocks in one write.
+ *
+ ****************************************************************************/
+
+static int bcache_writeback(FAR struct bcache_s *bc, FAR struct bcache_slot_s *slot)
+{
+	FAR struct bcache_slot_s *next;
+	FAR const uint8_t *buffer;
+	off_t first = slot->block;
+	off_t last = slot->block;
+	size_t n = 1;
+	size_t i;
+	ssize_t ret;
+
+	while (n < bc->xferblocks && first > 0 && (next = bcache_lookup(bc, first - 1)) != NULL && (next->flags & BCACHE_DIRTY) != 0) {
+		first--;
+		n++;
+	}
+
+	while (n < bc->xferblocks && (next = bcache_lookup(bc, last + 1)) != NULL && (next->flags & BCACHE_DIRTY) != 0) {
+		last++;
+		n++;
+	}
+
+	if (n == 1) {
+		buffer = bcache_data(bc, slot);
+	} else {
+		for (i = 0; i < n; i++) {
+			memcpy(bc->xfer + i * bc->blocksize, bcache_data(bc, bcache_lookup(bc, first + i)), bc->blocksize);
+		}
+
+		buffer = bc->xfer;
+	}
+
+	ret = bc->write(bc->dev, buffer, first, n);
+	bc->stats.wrcalls++;
+	if (ret != (ssize_t)n) {
+		fdbg("ERROR: write-back of %d blocks at %ld failed: %d\n", n, (long)first, ret);
+		return ret < 0 ? ret : -EIO;
+	}
+
+	bc->stats.wrblocks += n;
+	for (i = 0; i < n; i++) {
+		bcache_lookup(bc, first + i)->flags &= ~BCACHE_DIRTY;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_flushall
+ ****************************************************************************/
+
+static int bcache_flushall(FAR struct bcache_s *bc)
+{
+	FAR struct bcache_slot_s *slot;
+	int result = OK;
+	int ret;
+	size_t i;
+
+	for (i = 0, slot = bc->slots; i < bcache_nslots(bc); i++, slot++) {
+		if (slot->block != BCACHE_NOBLOCK && (slot->flags & BCACHE_DIRTY) != 0) {
+			ret = bcache_writeback(bc, slot);
+			if (ret < 0) {
+				result = ret;
+			}
+		}
+	}
+
+	return result;
+}
+
+/****************************************************************************
+ * Name: bcache_victim
+ *
+ * Description:
+ *   Make room for block in its set: take an empty slot or the least
+ *   recently used one, written back first if it is dirty.  The slot is
+ *   returned clean and assigned to block, its data undefined.
+ *
+ ****************************************************************************/
+
+static int bcache_victim(FAR struct bcache_s *bc, off_t block, FAR struct bcache_slot_s **slotp)
+{
+	FAR struct bcache_slot_s *slot = bcache_set(bc, block);
+	FAR struct bcache_slot_s *victim = NULL;
+	int way;
+	int ret;
+
+	for (way = 0; way < CONFIG_DRVR_BCACHE_WAYS; way++, slot++) {
+		if (slot->block == BCACHE_NOBLOCK) {
+			victim = slot;
+			break;
+		}
+
+		if (victim == NULL || bc->clock - slot->stamp > bc->clock - victim->stamp) {
+			victim = slot;
+		}
+	}
+
+	if (victim->block != BCACHE_NOBLOCK && (victim->flags & BCACHE_DIRTY) != 0) {
+		ret = bcache_writeback(bc, victim);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	victim->block = block;
+	victim->flags = 0;
+	victim->stamp = ++bc->clock;
+	*slotp = victim;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_fetch
+ *
+ * Description:
+ *   Return the slot of block, reading it from the device if needed.
+ *
+ ****************************************************************************/
+
+static int bcache_fetch(FAR struct bcache_s *bc, off_t block, FAR struct bcache_slot_s **slotp)
+{
+	FAR struct bcache_slot_s *slot;
+	ssize_t ret;
+
+	slot = bcache_lookup(bc, block);
+	if (slot != NULL) {
+		bcache_use(bc, slot);
+		*slotp = slot;
+		return OK;
+	}
+
+	ret = bcache_victim(bc, block, &slot);
+	if (ret < 0) {
+		return ret;
+	}
+
+	bc->stats.misses++;
+	ret = bc->read(bc->dev, bcache_data(bc, slot), block, 1);
+	if (ret != 1) {
+		slot->block = BCACHE_NOBLOCK;
+		return ret < 0 ? ret : -EIO;
+	}
+
+	*slotp = slot;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_copyin
+ *
+ * Description:
+ *   Read whole blocks through the cache.  Each run of blocks that are not
+ *   cached is read from the device in one transfer, then cached.
+ *
+ ****************************************************************************/
+
+static int bcache_copyin(FAR struct bcache_s *bc, off_t startblock, size_t nblocks, FAR uint8_t *buffer)
+{
+	FAR struct bcache_slot_s *slot;
+	size_t run;
+	size_t i;
+	size_t j;
+	ssize_t ret;
+
+	if (nblocks > bc->xferblocks) {
+		/* Too large to cache: read it all from the device, then take the
+		 * blocks the cache has newer copies of from the cache.
+		 */
+
+		ret = bc->read(bc->dev, buffer, startblock, nblocks);
+		if (ret != (ssize_t)nblocks) {
+			return ret < 0 ? ret : -EIO;
+		}
+
+		bc->stats.misses += nblocks;
+		for (i = 0; i < nblocks; i++) {
+			slot = bcache_lookup(bc, startblock + i);
+			if (slot != NULL && (slot->flags & BCACHE_DIRTY) != 0) {
+				memcpy(buffer + i * bc->blocksize, bcache_data(bc, slot), bc->blocksize);
+			}
+		}
+
+		return OK;
+	}
+
+	for (i = 0; i < nblocks; i += run) {
+		slot = bcache_lookup(bc, startblock + i);
+		if (slot != NULL) {
+			memcpy(buffer + i * bc->blocksize, bcache_data(bc, slot), bc->blocksize);
+			bcache_use(bc, slot);
+			run = 1;
+			continue;
+		}
+
+		for (run = 1; i + run < nblocks && bcache_lookup(bc, startblock + i + run) == NULL; run++) ;
+
+		ret = bc->read(bc->dev, buffer + i * bc->blocksize, startblock + i, run);
+		if (ret != (ssize_t)run) {
+			return ret < 0 ? ret : -EIO;
+		}
+
+		bc->stats.misses += run;
+		for (j = i; j < i + run; j++) {
+			ret = bcache_victim(bc, startblock + j, &slot);
+			if (ret < 0) {
+				return ret;
+			}
+
+			memcpy(bcache_data(bc, slot), buffer + j * bc->blocksize, bc->blocksize);
+		}
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_copyout
+ *
+ * Description:
+ *   Write whole blocks into the cache, or straight to the device if they
+ *   are too many to cache.
+ *
+ ****************************************************************************/
+
+static int bcache_copyout(FAR struct bcache_s *bc, off_t startblock, size_t nblocks, FAR const uint8_t *buffer)
+{
+	FAR struct bcache_slot_s *slot;
+	size_t i;
+	ssize_t ret;
+
+	if (nblocks > bc->xferblocks) {
+		/* The cached copies, dirty or not, are all overwritten */
+
+		for (i = 0; i < nblocks; i++) {
+			slot = bcache_lookup(bc, startblock + i);
+			if (slot != NULL) {
+				slot->block = BCACHE_NOBLOCK;
+				slot->flags = 0;
+			}
+		}
+
+		ret = bc->write(bc->dev, buffer, startblock, nblocks);
+		bc->stats.wrcalls++;
+		if (ret != (ssize_t)nblocks) {
+			return ret < 0 ? ret : -EIO;
+		}
+
+		bc->stats.wrblocks += nblocks;
+		return OK;
+	}
+
+	for (i = 0; i < nblocks; i++) {
+		slot = bcache_lookup(bc, startblock + i);
+		if (slot != NULL) {
+			bcache_use(bc, slot);
+		} else {
+			ret = bcache_victim(bc, startblock + i, &slot);
+			if (ret < 0) {
+				return ret;
+			}
+		}
+
+		memcpy(bcache_data(bc, slot), buffer + i * bc->blocksize, bc->blocksize);
+		slot->flags |= BCACHE_DIRTY;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_invalidate_locked
+ ****************************************************************************/
+
+static void bcache_invalidate_locked(FAR struct bcache_s *bc, off_t startblock, size_t nblocks)
+{
+	FAR struct bcache_slot_s *slot;
+	size_t i;
+
+	for (i = 0, slot = bc->slots; i < bcache_nslots(bc); i++, slot++) {
+		if (slot->block != BCACHE_NOBLOCK && slot->block >= startblock && slot->block < startblock + (off_t)nblocks) {
+			slot->block = BCACHE_NOBLOCK;
+			slot->flags = 0;
+		}
+	}
+}
+
+#if CONFIG_DRVR_BCACHE_WRDELAY > 0
+/****************************************************************************
+ * Name: bcache_timeout
+ *
+ * Description:
+ *   Write the dirty blocks back, CONFIG_DRVR_BCACHE_WRDELAY ms after the
+ *   first write that found the cache clean.  Runs on the work queue.
+ *
+ *   If bcache_uninitialize() has started, it has flushed the cache and
+ *   waits for this to let go of bc.  The scheduler stays locked until then
+ *   so that bc is not freed while sem_post() still uses it.
+ *
+ ****************************************************************************/
+
+static void bcache_timeout(FAR void *arg)
+{
+	FAR struct bcache_s *bc = (FAR struct bcache_s *)arg;
+	uint8_t closing;
+
+	bcache_semtake(bc);
+	closing = bc->closing;
+	if (!closing) {
+		(void)bcache_flushall(bc);
+	}
+	bc->wbqueued = 0;
+
+	sched_lock();
+	bcache_semgive(bc);
+	if (closing) {
+		sem_post(&bc->wbdone);
+	}
+	sched_unlock();
+}
+#endif
+
+/****************************************************************************
+ * Name: bcache_startflush
+ ****************************************************************************/
+
+static void bcache_startflush(FAR struct bcache_s *bc)
+{
+#if CONFIG_DRVR_BCACHE_WRDELAY > 0
+	if (!bc->wbqueued && work_queue(LPWORK, &bc->work, bcache_timeout, (FAR void *)bc, MSEC2TICK(CONFIG_DRVR_BCACHE_WRDELAY)) == OK) {
+		bc->wbqueued = 1;
+	}
+#endif
+}
+
+#ifdef CONFIG_DRVR_BCACHE_READAHEAD
+/****************************************************************************
+ * Name: bcache_readahead
+ *
+ * Description:
+ *   Make sure that the window blocks from block on are cached.  Nothing
+ *   is read while more than half of them are, so that the read-ahead is
+ *   done in transfers of at least half a window.  window is at most
+ *   xferblocks, half the cache.
+ *
+ ****************************************************************************/
+
+static void bcache_readahead(FAR struct bcache_s *bc, off_t block, size_t window)
+{
+	FAR struct bcache_slot_s *slot;
+	size_t ahead;
+	size_t n;
+	size_t i;
+
+	for (ahead = 0; ahead < window && block + ahead < bc->nblocks && bcache_lookup(bc, block + ahead) != NULL; ahead++) ;
+
+	if (ahead > window / 2 || block + ahead >= bc->nblocks) {
+		return;
+	}
+
+	block += ahead;
+	for (n = 0; ahead + n < window && block + n < bc->nblocks && bcache_lookup(bc, block + n) == NULL; n++) ;
+
+	/* Take the slots first: a write-back of the blocks they held would use
+	 * xfer.  A slot can be taken again by a later block of the same set,
+	 * so the blocks are looked up again once read.  Failures are left for
+	 * the read of these blocks to report.
+	 */
+
+	for (i = 0; i < n; i++) {
+		if (bcache_victim(bc, block + i, &slot) < 0) {
+			n = i;
+			break;
+		}
+	}
+
+	if (n == 0 || bc->read(bc->dev, bc->xfer, block, n) != (ssize_t)n) {
+		bcache_invalidate_locked(bc, block, n);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		slot = bcache_lookup(bc, block + i);
+		if (slot != NULL) {
+			memcpy(bcache_data(bc, slot), bc->xfer + i * bc->blocksize, bc->blocksize);
+			slot->flags = BCACHE_PREFETCH;
+			bc->stats.rablocks++;
+		}
+	}
+}
+
+/****************************************************************************
+ * Name: bcache_access
+ *
+ * Description:
+ *   Follow the readers after a read of blocks startblock to
+ *   startblock + nblocks - 1, and read ahead of the sequential ones.  A
+ *   read that starts where a reader stopped, or in the last block it read
+ *   as small reads do, is that reader's; any other read starts a new
+ *   reader in place of the least recently seen one.
+ *
+ ****************************************************************************/
+
+static void bcache_access(FAR struct bcache_s *bc, off_t startblock, size_t nblocks)
+{
+	FAR struct bcache_stream_s *stream = NULL;
+	FAR struct bcache_stream_s *lru = NULL;
+	off_t end = startblock + nblocks;
+	size_t maxwindow;
+	int nsequential = 0;
+	int i;
+
+	for (i = 0; i < CONFIG_DRVR_BCACHE_STREAMS; i++) {
+		if (bc->streams[i].window > 0) {
+			nsequential++;
+		}
+
+		if (stream == NULL && (bc->streams[i].next == startblock || bc->streams[i].next == startblock + 1)) {
+			stream = &bc->streams[i];
+		} else if (lru == NULL || bc->clock - bc->streams[i].stamp > bc->clock - lru->stamp) {
+			lru = &bc->streams[i];
+		}
+	}
+
+	if (stream == NULL) {
+		lru->next = end;
+		lru->window = 0;
+		lru->stamp = bc->clock;
+		return;
+	}
+
+	/* The window grows each time the reader moves on to new blocks.  The
+	 * sequential readers share half the cache between their windows.
+	 */
+
+	if (end > stream->next) {
+		if (stream->window == 0) {
+			stream->window = nblocks > 2 ? nblocks : 2;
+			nsequential++;
+		} else {
+			stream->window <<= 1;
+		}
+
+		maxwindow = bc->xferblocks / nsequential;
+		if (stream->window > maxwindow) {
+			stream->window = maxwindow > 0 ? maxwindow : 1;
+		}
+
+		stream->next = end;
+	}
+
+	stream->stamp = bc->clock;
+	if (stream->window > 0) {
+		bcache_readahead(bc, stream->next, stream->window);
+	}
+}
+#else
+#define bcache_access(bc, startblock, nblocks)
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bcache_initialize
+ ****************************************************************************/
+
+int bcache_initialize(FAR struct bcache_s *bc, FAR const char *name)
+{
+	FAR const char *basename;
+	size_t nslots;
+	size_t i;
+
+	DEBUGASSERT(bc != NULL && bc->blocksize > 0 && bc->nblocks > 0 && bc->read != NULL);
+
+	/* Whole sets of at least one block each */
+
+	bc->nsets = (CONFIG_DRVR_BCACHE_SIZE * 1024) / (bc->blocksize * CONFIG_DRVR_BCACHE_WAYS);
+	if (bc->nsets == 0) {
+		bc->nsets = 1;
+	}
+
+	nslots = bcache_nslots(bc);
+
+	/* A transfer, or a read-ahead, never takes more than half the cache */
+
+	bc->xferblocks = CONFIG_DRVR_BCACHE_XFERBLOCKS;
+	if (bc->xferblocks > nslots / 2) {
+		bc->xferblocks = nslots > 1 ? nslots / 2 : 1;
+	}
+
+	bc->slots = (FAR struct bcache_slot_s *)kmm_malloc(nslots * sizeof(struct bcache_slot_s));
+	bc->data = (FAR uint8_t *)kmm_malloc(nslots * bc->blocksize);
+	bc->xfer = (FAR uint8_t *)kmm_malloc(bc->xferblocks * bc->blocksize);
+	if (bc->slots == NULL || bc->data == NULL || bc->xfer == NULL) {
+		fdbg("ERROR: cannot allocate %d blocks of %d bytes\n", nslots, bc->blocksize);
+		kmm_free(bc->slots);
+		kmm_free(bc->data);
+		kmm_free(bc->xfer);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nslots; i++) {
+		bc->slots[i].block = BCACHE_NOBLOCK;
+		bc->slots[i].stamp = 0;
+		bc->slots[i].flags = 0;
+	}
+
+#ifdef CONFIG_DRVR_BCACHE_READAHEAD
+	for (i = 0; i < CONFIG_DRVR_BCACHE_STREAMS; i++) {
+		bc->streams[i].next = BCACHE_NOBLOCK;
+		bc->streams[i].window = 0;
+		bc->streams[i].stamp = 0;
+	}
+#endif
+
+	memset(&bc->stats, 0, sizeof(struct bcache_stats_s));
+	memset(&bc->work, 0, sizeof(struct work_s));
+	bc->wbqueued = 0;
+	bc->closing = 0;
+	bc->clock = 0;
+	sem_init(&bc->sem, 0, 1);
+	sem_init(&bc->wbdone, 0, 0);
+
+	/* Name it after the last component of the device path */
+
+	basename = name != NULL ? strrchr(name, '/') : NULL;
+	basename = basename != NULL ? basename + 1 : name;
+	strncpy(bc->name, basename != NULL ? basename : "", BCACHE_NAMELEN - 1);
+	bc->name[BCACHE_NAMELEN - 1] = '\0';
+
+	sched_lock();
+	bc->flink = g_bcaches;
+	g_bcaches = bc;
+	sched_unlock();
+
+	fvdbg("%s: %d sets of %d blocks, transfers of up to %d blocks\n", bc->name, bc->nsets, CONFIG_DRVR_BCACHE_WAYS, bc->xferblocks);
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_uninitialize
+ ****************************************************************************/
+
+void bcache_uninitialize(FAR struct bcache_s *bc)
+{
+	FAR struct bcache_s **prev;
+	uint8_t wait;
+
+	/* work_cancel() fails once the work queue has taken the write-back.
+	 * bcache_timeout() may then be waiting for the semaphore, so wait for it
+	 * to finish before bc goes away.
+	 */
+
+	bcache_semtake(bc);
+	if (bc->wbqueued && work_cancel(LPWORK, &bc->work) == OK) {
+		bc->wbqueued = 0;
+	}
+	bc->closing = 1;
+	(void)bcache_flushall(bc);
+	wait = bc->wbqueued;
+	bcache_semgive(bc);
+
+	if (wait) {
+		while (sem_wait(&bc->wbdone) != 0) {
+			ASSERT(get_errno() == EINTR);
+		}
+	}
+
+	sched_lock();
+	for (prev = &g_bcaches; *prev != NULL; prev = &(*prev)->flink) {
+		if (*prev == bc) {
+			*prev = bc->flink;
+			break;
+		}
+	}
+	sched_unlock();
+
+	sem_destroy(&bc->sem);
+	sem_destroy(&bc->wbdone);
+	kmm_free(bc->slots);
+	kmm_free(bc->data);
+	kmm_free(bc->xfer);
+	bc->slots = NULL;
+	bc->data = NULL;
+	bc->xfer = NULL;
+}
+
+/****************************************************************************
+ * Name: bcache_read
+ ****************************************************************************/
+
+ssize_t bcache_read(FAR struct bcache_s *bc, off_t startblock, size_t nblocks, FAR uint8_t *buffer)
+{
+	int ret;
+
+	if (startblock < 0 || startblock + nblocks > bc->nblocks) {
+		return -EINVAL;
+	}
+
+	bcache_semtake(bc);
+	ret = bcache_copyin(bc, startblock, nblocks, buffer);
+	if (ret >= 0) {
+		bcache_access(bc, startblock, nblocks);
+	}
+	bcache_semgive(bc);
+
+	return ret < 0 ? ret : (ssize_t)nblocks;
+}
+
+/****************************************************************************
+ * Name: bcache_write
+ ****************************************************************************/
+
+ssize_t bcache_write(FAR struct bcache_s *bc, off_t startblock, size_t nblocks, FAR const uint8_t *buffer)
+{
+	int ret;
+
+	if (bc->write == NULL) {
+		return -EACCES;
+	}
+
+	if (startblock < 0 || startblock + nblocks > bc->nblocks) {
+		return -EINVAL;
+	}
+
+	bcache_semtake(bc);
+	ret = bcache_copyout(bc, startblock, nblocks, buffer);
+	bcache_startflush(bc);
+	bcache_semgive(bc);
+
+	return ret < 0 ? ret : (ssize_t)nblocks;
+}
+
+/****************************************************************************
+ * Name: bcache_readbytes
+ ****************************************************************************/
+
+ssize_t bcache_readbytes(FAR struct bcache_s *bc, off_t offset, size_t nbytes, FAR uint8_t *buffer)
+{
+	FAR struct bcache_slot_s *slot;
+	off_t devsize = (off_t)bc->nblocks * bc->blocksize;
+	off_t first;
+	off_t block;
+	size_t blkoffset;
+	size_t remaining;
+	size_t chunk;
+	int ret = OK;
+
+	if (offset < 0 || offset >= devsize || nbytes == 0) {
+		return 0;
+	}
+
+	if (nbytes > devsize - offset) {
+		nbytes = devsize - offset;
+	}
+
+	bcache_semtake(bc);
+
+	first = offset / bc->blocksize;
+	block = first;
+	blkoffset = offset - block * bc->blocksize;
+	for (remaining = nbytes; remaining > 0; remaining -= chunk, buffer += chunk) {
+		if (blkoffset > 0 || remaining < bc->blocksize) {
+			/* A partial block, from the cache */
+
+			ret = bcache_fetch(bc, block, &slot);
+			if (ret < 0) {
+				goto errout;
+			}
+
+			chunk = bc->blocksize - blkoffset;
+			if (chunk > remaining) {
+				chunk = remaining;
+			}
+
+			memcpy(buffer, bcache_data(bc, slot) + blkoffset, chunk);
+			blkoffset = 0;
+			block++;
+		} else {
+			/* Whole blocks */
+
+			chunk = remaining / bc->blocksize;
+			ret = bcache_copyin(bc, block, chunk, buffer);
+			if (ret < 0) {
+				goto errout;
+			}
+
+			block += chunk;
+			chunk *= bc->blocksize;
+		}
+	}
+
+	bcache_access(bc, first, block - first);
+
+errout:
+	bcache_semgive(bc);
+	return ret < 0 ? ret : (ssize_t)nbytes;
+}
+
+/****************************************************************************
+ * Name: bcache_writebytes
+ ****************************************************************************/
+
+ssize_t bcache_writebytes(FAR struct bcache_s *bc, off_t offset, size_t nbytes, FAR const uint8_t *buffer)
+{
+	FAR struct bcache_slot_s *slot;
+	off_t devsize = (off_t)bc->nblocks * bc->blocksize;
+	off_t block;
+	size_t blkoffset;
+	size_t remaining;
+	size_t chunk;
+	int ret = OK;
+
+	if (bc->write == NULL) {
+		return -EACCES;
+	}
+
+	if (offset < 0 || offset >= devsize || nbytes == 0) {
+		return 0;
+	}
+
+	if (nbytes > devsize - offset) {
+		nbytes = devsize - offset;
+	}
+
+	bcache_semtake(bc);
+
+	block = offset / bc->blocksize;
+	blkoffset = offset - block * bc->blocksize;
+	for (remaining = nbytes; remaining > 0; remaining -= chunk, buffer += chunk) {
+		if (blkoffset > 0 || remaining < bc->blocksize) {
+			/* A partial block, modified in the cache */
+
+			ret = bcache_fetch(bc, block, &slot);
+			if (ret < 0) {
+				goto errout;
+			}
+
+			chunk = bc->blocksize - blkoffset;
+			if (chunk > remaining) {
+				chunk = remaining;
+			}
+
+			memcpy(bcache_data(bc, slot) + blkoffset, buffer, chunk);
+			slot->flags |= BCACHE_DIRTY;
+			blkoffset = 0;
+			block++;
+		} else {
+			/* Whole blocks */
+
+			chunk = remaining / bc->blocksize;
+			ret = bcache_copyout(bc, block, chunk, buffer);
+			if (ret < 0) {
+				goto errout;
+			}
+
+			block += chunk;
+			chunk *= bc->blocksize;
+		}
+	}
+
+errout:
+	bcache_startflush(bc);
+	bcache_semgive(bc);
+	return ret < 0 ? ret : (ssize_t)nbytes;
+}
+
+/****************************************************************************
+ * Name: bcache_flush
+ ****************************************************************************/
+
+int bcache_flush(FAR struct bcache_s *bc)
+{
+	int ret;
+
+	bcache_semtake(bc);
+	ret = bcache_flushall(bc);
+	bcache_semgive(bc);
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_invalidate
+ ****************************************************************************/
+
+int bcache_invalidate(FAR struct bcache_s *bc, off_t startblock, size_t nblocks)
+{
+	bcache_semtake(bc);
+	bcache_invalidate_locked(bc, startblock, nblocks);
+	bcache_semgive(bc);
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_foreach
+ ****************************************************************************/
+
+void bcache_foreach(void (*handler)(FAR struct bcache_s *bc, FAR void *arg), FAR void *arg)
+{
+	FAR struct bcache_s *bc;
+
+	sched_lock();
+	for (bc = g_bcaches; bc != NULL; bc = bc->flink) {
+		handler(bc, arg);
+	}
+	sched_unlock();
+}
+
+#endif							/* CONFIG_DRVR_BCACHE */
@@ -62,6 +62,7 @@
 #include <stdbool.h>
 #include <semaphore.h>
 #include <tinyara/fs/fs.h>
+#include <tinyara/bcache.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -84,6 +85,9 @@ struct bchlib_s
 	bool readonly;				/* true: Only read operations are supported */
 	bool unlinked;				/* true: The driver has been unlinked */
 	FAR uint8_t *buffer;		/* One sector buffer */
+#ifdef CONFIG_DRVR_BCACHE
+	struct bcache_s cache;		/* Sector cache, in place of the buffer */
+#endif
 
 #if defined(CONFIG_BCH_ENCRYPTION)
 	uint8_t key[CONFIG_BCH_ENCRYPTION_KEY_SIZE];	/* Encryption key */
@@ -109,6 +113,9 @@ EXTERN const struct file_operations bch_fops;
 EXTERN void bchlib_semtake(FAR struct bchlib_s *bch);
 EXTERN int  bchlib_flushsector(FAR struct bchlib_s *bch);
 EXTERN int  bchlib_readsector(FAR struct bchlib_s *bch, size_t sector);
+#ifdef CONFIG_DRVR_BCACHE
+EXTERN int  bchlib_cacheinit(FAR struct bchlib_s *bch, FAR const char *blkdev);
+#endif
 
 #undef EXTERN
 #if defined(__cplusplus)
@@ -57,6 +57,7 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -88,16 +89,16 @@ static void bch_xor(uint32_t *R, uint32_t *A, uint32_t *B)
  * Name: bch_cypher
  ****************************************************************************/
 #if defined(CONFIG_BCH_ENCRYPTION)
-static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
+static int bch_cypher(FAR struct bchlib_s *bch, FAR uint8_t *sectbuf, size_t sector, int encrypt)
 {
 	int blocks = bch->sectsize / 16;
-	FAR uint32_t *buffer = (FAR uint32_t *)bch->buffer;
+	FAR uint32_t *buffer = (FAR uint32_t *)sectbuf;
 	int i;
 
 	for (i = 0; i < blocks; i++, buffer += 16 / sizeof(uint32_t)) {
 		uint32_t T[4];
 		uint32_t X[4] = {
-			bch->sector, 0, 0, i
+			sector, 0, 0, i
 		};
 
 		aes_cypher(X, X, 16, NULL, bch->key, CONFIG_BCH_ENCRYPTION_KEY_SIZE,
@@ -114,9 +115,100 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
 }
 #endif
 
+#ifdef CONFIG_DRVR_BCACHE
+/****************************************************************************
+ * Name: bchlib_cacheread
+ *
+ * Description:
+ *   Read sectors from the block driver into the sector cache
+ *
+ ****************************************************************************/
+static ssize_t bchlib_cacheread(FAR void *dev, FAR uint8_t *buffer, off_t startblock, size_t nblocks)
+{
+	FAR struct bchlib_s *bch = (FAR struct bchlib_s *)dev;
+	ssize_t ret;
+#if defined(CONFIG_BCH_ENCRYPTION)
+	ssize_t i;
+#endif
+
+	ret = bch->inode->u.i_bops->read(bch->inode, buffer, startblock, nblocks);
+	if (ret < 0) {
+		fdbg("Read failed: %d\n", ret);
+	}
+
+#if defined(CONFIG_BCH_ENCRYPTION)
+	for (i = 0; i < ret; i++) {
+		bch_cypher(bch, buffer + i * bch->sectsize, startblock + i, CYPHER_DECRYPT);
+	}
+#endif
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: bchlib_cachewrite
+ *
+ * Description:
+ *   Write sectors of the sector cache back to the block driver
+ *
+ ****************************************************************************/
+static ssize_t bchlib_cachewrite(FAR void *dev, FAR const uint8_t *buffer, off_t startblock, size_t nblocks)
+{
+	FAR struct bchlib_s *bch = (FAR struct bchlib_s *)dev;
+	FAR struct inode *inode = bch->inode;
+	ssize_t ret;
+#if defined(CONFIG_BCH_ENCRYPTION)
+	size_t i;
+
+	/*
+	 * The cache keeps the plain text: each sector is encrypted in the
+	 * sector buffer and written alone.
+	 */
+	for (i = 0; i < nblocks; i++) {
+		memcpy(bch->buffer, buffer + i * bch->sectsize, bch->sectsize);
+		bch_cypher(bch, bch->buffer, startblock + i, CYPHER_ENCRYPT);
+		ret = inode->u.i_bops->write(inode, bch->buffer, startblock + i, 1);
+		if (ret < 0) {
+			fdbg("Write failed: %d\n", ret);
+			return ret;
+		}
+	}
+
+	ret = nblocks;
+#else
+	ret = inode->u.i_bops->write(inode, buffer, startblock, nblocks);
+	if (ret < 0) {
+		fdbg("Write failed: %d\n", ret);
+	}
+#endif
+
+	return ret;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
+#ifdef CONFIG_DRVR_BCACHE
+/****************************************************************************
+ * Name: bchlib_cacheinit
+ *
+ * Description:
+ *   Set up the sector cache of a BCH device, once its geometry is known
+ *
+ ****************************************************************************/
+int bchlib_cacheinit(FAR struct bchlib_s *bch, FAR const char *blkdev)
+{
+	bch->cache.blocksize = bch->sectsize;
+	bch->cache.nblocks   = bch->nsectors;
+	bch->cache.dev       = bch;
+	bch->cache.read      = bchlib_cacheread;
+	bch->cache.write     = bch->readonly ? NULL : bchlib_cachewrite;
+
+	return bcache_initialize(&bch->cache, blkdev);
+}
+#endif
+
 /****************************************************************************
  * Name: bchlib_flushsector
  *
@@ -127,6 +219,13 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
  *   Caller must assume mutual exclusion
  *
  ****************************************************************************/
+#ifdef CONFIG_DRVR_BCACHE
+int bchlib_flushsector(FAR struct bchlib_s *bch)
+{
+	/* The dirty sectors are all in the sector cache */
+	return bcache_flush(&bch->cache);
+}
+#else
 int bchlib_flushsector(FAR struct bchlib_s *bch)
 {
 	FAR struct inode *inode;
@@ -141,7 +240,7 @@ int bchlib_flushsector(FAR struct bchlib_s *bch)
 
 #if defined(CONFIG_BCH_ENCRYPTION)
 		/* Encrypt data as necessary */
-		bch_cypher(bch, CYPHER_ENCRYPT);
+		bch_cypher(bch, bch->buffer, bch->sector, CYPHER_ENCRYPT);
 #endif
 
 		/* Write the sector to the media */
@@ -155,7 +254,7 @@ int bchlib_flushsector(FAR struct bchlib_s *bch)
 		 * Computation overhead to save memory for extra sector buffer
 		 * TODO: Add configuration switch for extra sector buffer
 		 */
-		bch_cypher(bch, CYPHER_DECRYPT);
+		bch_cypher(bch, bch->buffer, bch->sector, CYPHER_DECRYPT);
 #endif
 
 		/* The sector is now in sync with the media */
@@ -164,6 +263,7 @@ int bchlib_flushsector(FAR struct bchlib_s *bch)
 
 	return (int)ret;
 }
+#endif
 
 /****************************************************************************
  * Name: bchlib_readsector
@@ -192,7 +292,7 @@ int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 		}
 		bch->sector = sector;
 #if defined(CONFIG_BCH_ENCRYPTION)
-		bch_cypher(bch, CYPHER_DECRYPT);
+		bch_cypher(bch, bch->buffer, bch->sector, CYPHER_DECRYPT);
 #endif
 	}
 	return (int)ret;
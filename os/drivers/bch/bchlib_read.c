@@ -92,6 +92,15 @@
  *   character device.
  *
  ****************************************************************************/
+#ifdef CONFIG_DRVR_BCACHE
+ssize_t bchlib_read(FAR void *handle, FAR char *buffer, size_t offset, size_t len)
+{
+	FAR struct bchlib_s *bch = (FAR struct bchlib_s *)handle;
+
+	/* The sector cache returns end-of-file past the last sector */
+	return bcache_readbytes(&bch->cache, offset, len, (FAR uint8_t *)buffer);
+}
+#else
 ssize_t bchlib_read(FAR void *handle, FAR char *buffer, size_t offset, size_t len)
 {
 	FAR struct bchlib_s *bch = (FAR struct bchlib_s *)handle;
@@ -188,3 +197,4 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, size_t offset, size_t le
 
 	return bytesread;
 }
+#endif
@@ -139,6 +139,16 @@ int bchlib_setup(const char *blkdev, bool readonly, FAR void **handle)
 		goto errout_with_bch;
 	}
 
+#ifdef CONFIG_DRVR_BCACHE
+	/* Set up the sector cache */
+	ret = bchlib_cacheinit(bch, blkdev);
+	if (ret < 0) {
+		fdbg("ERROR: Failed to allocate sector cache\n");
+		kmm_free(bch->buffer);
+		goto errout_with_bch;
+	}
+#endif
+
 	*handle = bch;
 	return OK;
 
@@ -90,6 +90,10 @@ int bchlib_teardown(FAR void *handle)
 	/* Flush any pending data to the block driver */
 	bchlib_flushsector(bch);
 
+#ifdef CONFIG_DRVR_BCACHE
+	bcache_uninitialize(&bch->cache);
+#endif
+
 	/* Close the block driver */
 	(void)close_blockdriver(bch->inode);
 
@@ -79,6 +79,22 @@
  *   character device.
  *
  ****************************************************************************/
+#ifdef CONFIG_DRVR_BCACHE
+ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, size_t len)
+{
+	FAR struct bchlib_s *bch = (FAR struct bchlib_s *)handle;
+
+	if (len > 0 && offset / bch->sectsize >= bch->nsectors) {
+		return -EFBIG;
+	}
+
+	/*
+	 * The data stays in the sector cache, to be written back when the
+	 * sectors are evicted, on close, or after CONFIG_DRVR_BCACHE_WRDELAY.
+	 */
+	return bcache_writebytes(&bch->cache, offset, len, (FAR const uint8_t *)buffer);
+}
+#else
 ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, size_t len)
 {
 	FAR struct bchlib_s *bch = (FAR struct bchlib_s *)handle;
@@ -184,4 +200,5 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, si
 
 	return byteswritten;
 }
+#endif
 
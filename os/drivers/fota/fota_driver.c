@@ -91,11 +91,12 @@ static ssize_t fota_write(FAR struct file *filep, FAR const char *buffer, size_t
 	}
 
 	ret = dev->fota_write(buffer, buflen);
-	if (ret == OK && !g_fota_dev_written) {
-		g_fota_dev_written = true;
+	if (ret != OK) {
+		return ret;
 	}
 
-	return ret;
+	g_fota_dev_written = true;
+	return buflen;
 }
 
 /************************************************************************************
@@ -70,6 +70,7 @@
 #include <tinyara/kmalloc.h>
 #include <tinyara/wqueue.h>
 #include <tinyara/rwbuffer.h>
+#include <tinyara/bcache.h>
 
 #if defined(CONFIG_DRVR_WRITEBUFFER) || defined(CONFIG_DRVR_READAHEAD)
 
@@ -99,6 +100,105 @@
  * Public Variables
  ****************************************************************************/
 
+#ifdef CONFIG_DRVR_BCACHE
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* With CONFIG_DRVR_BCACHE, the write buffer and the read-ahead buffer are
+ * replaced by a block cache: wrflush and rhreload transfer its blocks.
+ */
+
+/****************************************************************************
+ * Name: rwb_initialize
+ ****************************************************************************/
+
+int rwb_initialize(FAR struct rwbuffer_s *rwb)
+{
+	DEBUGASSERT(rwb != NULL && rwb->dev != NULL);
+
+	rwb->cache.blocksize = rwb->blocksize;
+	rwb->cache.nblocks = rwb->nblocks;
+	rwb->cache.dev = rwb->dev;
+	rwb->cache.read = rwb->rhreload;
+	rwb->cache.write = rwb->wrflush;
+	return bcache_initialize(&rwb->cache, "rwbuffer");
+}
+
+/****************************************************************************
+ * Name: rwb_uninitialize
+ ****************************************************************************/
+
+void rwb_uninitialize(FAR struct rwbuffer_s *rwb)
+{
+	bcache_uninitialize(&rwb->cache);
+}
+
+/****************************************************************************
+ * Name: rwb_read
+ ****************************************************************************/
+
+ssize_t rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock, size_t nblocks, FAR uint8_t *rdbuffer)
+{
+	return bcache_read(&rwb->cache, startblock, nblocks, rdbuffer);
+}
+
+/****************************************************************************
+ * Name: rwb_write
+ ****************************************************************************/
+
+ssize_t rwb_write(FAR struct rwbuffer_s *rwb, off_t startblock, size_t nblocks, FAR const uint8_t *wrbuffer)
+{
+	return bcache_write(&rwb->cache, startblock, nblocks, wrbuffer);
+}
+
+/****************************************************************************
+ * Name: rwb_readbytes
+ *
+ * Description:
+ *   Character-oriented read
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DRVR_READBYTES
+ssize_t rwb_readbytes(FAR struct rwbuffer_s *dev, off_t offset, size_t nbytes, FAR uint8_t *buffer)
+{
+	return bcache_readbytes(&dev->cache, offset, nbytes, buffer);
+}
+#endif
+
+/****************************************************************************
+ * Name: rwb_mediaremoved
+ *
+ * Description:
+ *   The following function is called when media is removed
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DRVR_REMOVABLE
+int rwb_mediaremoved(FAR struct rwbuffer_s *rwb)
+{
+	return bcache_invalidate(&rwb->cache, 0, rwb->nblocks);
+}
+#endif
+
+/****************************************************************************
+ * Name: rwb_invalidate
+ *
+ * Description:
+ *   Invalidate a region of the caches
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DRVR_INVALIDATE
+int rwb_invalidate(FAR struct rwbuffer_s *rwb, off_t startblock, size_t blockcount)
+{
+	return bcache_invalidate(&rwb->cache, startblock, blockcount);
+}
+#endif
+
+#else							/* CONFIG_DRVR_BCACHE */
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -961,4 +1061,5 @@ int rwb_invalidate(FAR struct rwbuffer_s *rwb, off_t startblock, size_t blockcou
 }
 #endif
 
+#endif							/* CONFIG_DRVR_BCACHE */
 #endif							/* CONFIG_DRVR_WRITEBUFFER || CONFIG_DRVR_READAHEAD */
@@ -90,6 +90,41 @@
 #error AIO needs file and/or socket descriptors
 #endif
 
+/* AIO runs either on threads of its own or on the low priority work queue.
+ * Only the work queue has its priority boosted to that of the client.
+ */
+
+#ifndef CONFIG_FS_AIO_NWORKERS
+#define CONFIG_FS_AIO_NWORKERS 0
+#endif
+
+#undef AIO_HAVE_WORKERS
+#undef AIO_HAVE_PRIOINHERIT
+
+#if CONFIG_FS_AIO_NWORKERS > 0
+#define AIO_HAVE_WORKERS
+#elif defined(CONFIG_PRIORITY_INHERITANCE)
+#define AIO_HAVE_PRIOINHERIT
+#endif
+
+#ifdef AIO_HAVE_WORKERS
+#ifndef CONFIG_FS_AIO_PRIORITY
+#define CONFIG_FS_AIO_PRIORITY SCHED_PRIORITY_DEFAULT
+#endif
+
+#ifndef CONFIG_FS_AIO_STACKSIZE
+#define CONFIG_FS_AIO_STACKSIZE 2048
+#endif
+
+#ifndef CONFIG_FS_AIO_MERGE_SIZE
+#define CONFIG_FS_AIO_MERGE_SIZE 1024
+#endif
+
+/* Most requests merged into one transfer */
+
+#define AIO_MERGE_MAX 8
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -109,8 +144,12 @@ struct aio_container_s {
 		FAR void *ptr;			/* Generic pointer to FAR data */
 	} u;
 	struct work_s aioc_work;	/* Used to defer I/O to the work thread */
+#ifdef AIO_HAVE_WORKERS
+	worker_t aioc_worker;		/* I/O to perform; NULL once an AIO thread took it */
+#endif
 	pid_t aioc_pid;				/* ID of the waiting task */
-#ifdef CONFIG_PRIORITY_INHERITANCE
+	uint8_t aioc_opcode;		/* LIO_READ, LIO_WRITE, or LIO_NOP for others */
+#ifdef AIO_HAVE_PRIOINHERIT
 	uint8_t aioc_prio;			/* Priority of the waiting task */
 #endif
 };
@@ -250,7 +289,8 @@ FAR struct aiocb *aioc_decant(FAR struct aio_container_s *aioc);
  * Name: aio_queue
  *
  * Description:
- *   Schedule the asynchronous I/O on the low priority work queue
+ *   Schedule the asynchronous I/O on the AIO threads, or on the low
+ *   priority work queue if there are none
  *
  * Input Parameters:
  *   arg - Worker argument.  In this case, a pointer to an instance of
@@ -264,6 +304,62 @@ FAR struct aiocb *aioc_decant(FAR struct aio_container_s *aioc);
 
 int aio_queue(FAR struct aio_container_s *aioc, worker_t worker);
 
+/****************************************************************************
+ * Name: aio_unqueue
+ *
+ * Description:
+ *   Take an I/O that has not started yet off the AIO threads or the work
+ *   queue, as aio_cancel() does.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container of the I/O
+ *
+ * Returned Value:
+ *   Zero (OK) if the I/O will not be performed; a negated errno value if it
+ *   has already started or completed.
+ *
+ ****************************************************************************/
+
+int aio_unqueue(FAR struct aio_container_s *aioc);
+
+#ifdef AIO_HAVE_WORKERS
+/****************************************************************************
+ * Name: aio_workers_start
+ *
+ * Description:
+ *   Start the AIO threads, if they are not running yet.  They are started
+ *   with the first I/O rather than at initialization, which happens before
+ *   threads can be created.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   Zero (OK) if the AIO threads are running.  Otherwise, a negated errno
+ *   value.
+ *
+ ****************************************************************************/
+
+int aio_workers_start(void);
+
+/****************************************************************************
+ * Name: aio_workers_signal
+ *
+ * Description:
+ *   Wake up an idle AIO thread after an I/O has been queued.  The caller
+ *   holds the AIO lock.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void aio_workers_signal(void);
+#endif
+
 /****************************************************************************
  * Name: aio_signal
  *
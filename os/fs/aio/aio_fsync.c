@@ -109,8 +109,9 @@ static void aio_fsync_worker(FAR void *arg)
 {
 	FAR struct aio_container_s *aioc = (FAR struct aio_container_s *)arg;
 	FAR struct aiocb *aiocbp;
+	FAR struct file *filep;
 	pid_t pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	uint8_t prio;
 #endif
 	int ret;
@@ -122,14 +123,15 @@ static void aio_fsync_worker(FAR void *arg)
 
 	DEBUGASSERT(aioc && aioc->aioc_aiocbp);
 	pid = aioc->aioc_pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	prio = aioc->aioc_prio;
 #endif
+	filep = aioc->u.aioc_filep;
 	aiocbp = aioc_decant(aioc);
 
-	/* Perform the fsync using u.aioc_filep */
+	/* Perform the fsync using the file structure pointer */
 
-	ret = file_fsync(aioc->u.aioc_filep);
+	ret = file_fsync(filep);
 	if (ret < 0) {
 		int errcode = get_errno();
 		fdbg("ERROR: fsync failed: %d\n", errcode);
@@ -143,7 +145,7 @@ static void aio_fsync_worker(FAR void *arg)
 
 	(void)aio_signal(pid, aiocbp);
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	/* Restore the low priority worker thread default priority */
 
 	lpwork_restorepriority(prio);
@@ -91,11 +91,12 @@
  * Name: aio_queue
  *
  * Description:
- *   Schedule the asynchronous I/O on the low priority work queue
+ *   Schedule the asynchronous I/O on the AIO threads, or on the low
+ *   priority work queue if there are none
  *
  * Input Parameters:
- *   arg - Worker argument.  In this case, a pointer to an instance of
- *     struct aiocb cast to void *.
+ *   aioc - The AIO container of the I/O, already on the pending list
+ *   worker - The function performing the I/O, given aioc
  *
  * Returned Value:
  *   Zero (OK) on success.  Otherwise, -1 is returned and the errno is set
@@ -105,9 +106,27 @@
 
 int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
 {
+	FAR struct aiocb *aiocbp = aioc->aioc_aiocbp;
 	int ret;
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_WORKERS
+	/* The container is on the pending list already; giving it its worker
+	 * makes it visible to the AIO threads, which take pending I/O in order.
+	 */
+
+	ret = aio_workers_start();
+	if (ret >= 0) {
+		aio_lock();
+		aioc->aioc_worker = worker;
+		aio_workers_signal();
+		aio_unlock();
+	} else {
+		/* This frees the container */
+
+		aiocbp = aioc_decant(aioc);
+	}
+#else
+#ifdef AIO_HAVE_PRIOINHERIT
 	/* Prohibit context switches until we complete the queuing */
 
 	sched_lock();
@@ -122,15 +141,15 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
 	/* Schedule the work on the low priority worker thread */
 
 	ret = work_queue(LPWORK, &aioc->aioc_work, worker, aioc, 0);
+#endif
 	if (ret < 0) {
-		FAR struct aiocb *aiocbp = aioc->aioc_aiocbp;
 		DEBUGASSERT(aiocbp);
 
 		aiocbp->aio_result = ret;
 		set_errno(-ret);
 		ret = ERROR;
 	}
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	/* Now the low-priority work queue might run at its new priority */
 
 	sched_unlock();
@@ -138,4 +157,38 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
 	return ret;
 }
 
+/****************************************************************************
+ * Name: aio_unqueue
+ *
+ * Description:
+ *   Take an I/O that has not started yet off the AIO threads or the work
+ *   queue, as aio_cancel() does.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container of the I/O
+ *
+ * Returned Value:
+ *   Zero (OK) if the I/O will not be performed; a negated errno value if it
+ *   has already started or completed.
+ *
+ ****************************************************************************/
+
+int aio_unqueue(FAR struct aio_container_s *aioc)
+{
+#ifdef AIO_HAVE_WORKERS
+	int ret = -ENOENT;
+
+	aio_lock();
+	if (aioc->aioc_worker != NULL) {
+		aioc->aioc_worker = NULL;
+		ret = OK;
+	}
+	aio_unlock();
+
+	return ret;
+#else
+	return work_cancel(LPWORK, &aioc->aioc_work);
+#endif
+}
+
 #endif							/* CONFIG_FS_AIO */
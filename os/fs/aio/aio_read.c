@@ -109,8 +109,11 @@ static void aio_read_worker(FAR void *arg)
 {
 	FAR struct aio_container_s *aioc = (FAR struct aio_container_s *)arg;
 	FAR struct aiocb *aiocbp;
+#ifdef AIO_HAVE_FILEP
+	FAR struct file *filep;
+#endif
 	pid_t pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	uint8_t prio;
 #endif
 	ssize_t nread = 0;
@@ -122,8 +125,11 @@ static void aio_read_worker(FAR void *arg)
 
 	DEBUGASSERT(aioc && aioc->aioc_aiocbp);
 	pid = aioc->aioc_pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	prio = aioc->aioc_prio;
+#endif
+#ifdef AIO_HAVE_FILEP
+	filep = aioc->u.aioc_filep;
 #endif
 	aiocbp = aioc_decant(aioc);
 
@@ -131,13 +137,13 @@ static void aio_read_worker(FAR void *arg)
 	{
 		/* Perform the file read using:
 		 *
-		 *   u.aioc_filep - File structure pointer
+		 *   filep        - File structure pointer
 		 *   aio_buf      - Location of buffer
 		 *   aio_nbytes   - Length of transfer
 		 *   aio_offset   - File offset
 		 */
 
-		nread = file_pread(aioc->u.aioc_filep, (FAR void *)aiocbp->aio_buf, aiocbp->aio_nbytes, aiocbp->aio_offset);
+		nread = file_pread(filep, (FAR void *)aiocbp->aio_buf, aiocbp->aio_nbytes, aiocbp->aio_offset);
 	}
 #endif
 
@@ -156,7 +162,7 @@ static void aio_read_worker(FAR void *arg)
 
 	(void)aio_signal(pid, aiocbp);
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	/* Restore the low priority worker thread default priority */
 
 	lpwork_restorepriority(prio);
@@ -289,6 +295,7 @@ int aio_read(FAR struct aiocb *aiocbp)
 
 	/* Defer the work to the worker thread */
 
+	aioc->aioc_opcode = LIO_READ;
 	ret = aio_queue(aioc, aio_read_worker);
 	if (ret < 0) {
 		/* The result and the errno have already been set */
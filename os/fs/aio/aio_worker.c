@@ -0,0 +1,396 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * fs/aio/aio_worker.c
+ *
+ * The AIO threads.  Each one takes the oldest pending I/O whose file no
+ * other AIO thread is working on, so I/O on one file is performed in the
+ * order it was requested while I/O on different files goes on in parallel.
+ * Reads or writes that follow it on the same file, each starting where the
+ * previous one ends, are merged into it and performed as one transfer
+ * through a buffer of the thread.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <aio.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/fs/fs.h>
+#include <tinyara/kmalloc.h>
+#include <tinyara/kthread.h>
+
+#include "aio/aio.h"
+
+#if defined(CONFIG_FS_AIO) && defined(AIO_HAVE_WORKERS)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct aio_worker_s {
+	FAR struct file *filep;		/* File of the I/O in progress, or NULL */
+	FAR uint8_t *buffer;		/* Merged transfers, or NULL if none */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* All of these are protected by the AIO lock */
+
+static struct aio_worker_s g_aio_workers[CONFIG_FS_AIO_NWORKERS];
+static uint8_t g_aio_nworkers;	/* AIO threads that have started */
+static uint8_t g_aio_nidle;		/* AIO threads waiting on g_aio_worksem */
+static bool g_aio_started;		/* The AIO threads have been created */
+
+/* Posted once for each idle AIO thread to wake up */
+
+static sem_t g_aio_worksem;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aio_worker_busy
+ *
+ * Description:
+ *   Return true if an AIO thread is performing I/O on filep.
+ *
+ ****************************************************************************/
+
+static bool aio_worker_busy(FAR struct file *filep)
+{
+	int i;
+
+	for (i = 0; i < g_aio_nworkers; i++) {
+		if (g_aio_workers[i].filep == filep) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/****************************************************************************
+ * Name: aio_worker_pick
+ *
+ * Description:
+ *   Take the next I/O for an AIO thread, with the I/O merged into it, off
+ *   the pending list.  The caller holds the AIO lock.
+ *
+ * Input Parameters:
+ *   self   - The AIO thread
+ *   batch  - Returns the containers of the I/O, in file order
+ *   worker - Returns the function performing the first I/O alone
+ *
+ * Returned Value:
+ *   The number of containers in batch; zero if there is no I/O to do.
+ *
+ ****************************************************************************/
+
+static int aio_worker_pick(FAR struct aio_worker_s *self, FAR struct aio_container_s **batch, FAR worker_t *worker)
+{
+	FAR struct aio_container_s *aioc;
+#if CONFIG_FS_AIO_MERGE_SIZE > 0
+	FAR struct aio_container_s *next;
+	FAR struct aiocb *aiocbp;
+	size_t total;
+	off_t end;
+#endif
+	int n = 1;
+
+	/* The oldest I/O, not taken yet, whose file is not in use.  An older
+	 * I/O on the same file would have been found first.
+	 */
+
+	for (aioc = (FAR struct aio_container_s *)g_aio_pending.head; aioc; aioc = (FAR struct aio_container_s *)aioc->aioc_link.flink) {
+		if (aioc->aioc_worker != NULL && !aio_worker_busy(aioc->u.aioc_filep)) {
+			break;
+		}
+	}
+
+	if (aioc == NULL) {
+		return 0;
+	}
+
+	*worker = aioc->aioc_worker;
+	aioc->aioc_worker = NULL;
+	self->filep = aioc->u.aioc_filep;
+	batch[0] = aioc;
+
+#if CONFIG_FS_AIO_MERGE_SIZE > 0
+	/* Merge the reads or writes that continue it.  Appending writes go to
+	 * the end of the file whatever their offset, so they are left alone.
+	 * The search stops at the first other I/O on the file, which keeps them
+	 * in order.
+	 */
+
+	if (self->buffer == NULL || aioc->aioc_opcode == LIO_NOP || (aioc->aioc_opcode == LIO_WRITE && (self->filep->f_oflags & O_APPEND) != 0)) {
+		return 1;
+	}
+
+	total = aioc->aioc_aiocbp->aio_nbytes;
+	end = aioc->aioc_aiocbp->aio_offset + total;
+
+	for (next = (FAR struct aio_container_s *)aioc->aioc_link.flink; next && n < AIO_MERGE_MAX; next = (FAR struct aio_container_s *)next->aioc_link.flink) {
+		if (next->u.aioc_filep != self->filep) {
+			continue;
+		}
+
+		aiocbp = next->aioc_aiocbp;
+		if (next->aioc_worker == NULL || next->aioc_opcode != aioc->aioc_opcode || aiocbp->aio_offset != end || total + aiocbp->aio_nbytes > CONFIG_FS_AIO_MERGE_SIZE) {
+			break;
+		}
+
+		next->aioc_worker = NULL;
+		batch[n++] = next;
+		total += aiocbp->aio_nbytes;
+		end += aiocbp->aio_nbytes;
+	}
+#endif
+
+	return n;
+}
+
+#if CONFIG_FS_AIO_MERGE_SIZE > 0
+/****************************************************************************
+ * Name: aio_worker_merged
+ *
+ * Description:
+ *   Perform merged reads or writes as one transfer through the buffer of
+ *   the AIO thread, and complete each of them.
+ *
+ ****************************************************************************/
+
+static void aio_worker_merged(FAR struct aio_worker_s *self, FAR struct aio_container_s **batch, int n)
+{
+	FAR struct aiocb *aiocbp[AIO_MERGE_MAX];
+	pid_t pid[AIO_MERGE_MAX];
+	uint8_t opcode = batch[0]->aioc_opcode;
+	size_t total = 0;
+	size_t nbytes;
+	ssize_t nxfer;
+	int errcode = 0;
+	int i;
+
+	/* Free the containers before starting any I/O, as the single I/O
+	 * workers do.
+	 */
+
+	for (i = 0; i < n; i++) {
+		pid[i] = batch[i]->aioc_pid;
+		aiocbp[i] = aioc_decant(batch[i]);
+	}
+
+	if (opcode == LIO_WRITE) {
+		for (i = 0; i < n; i++) {
+			memcpy(self->buffer + total, (FAR const void *)aiocbp[i]->aio_buf, aiocbp[i]->aio_nbytes);
+			total += aiocbp[i]->aio_nbytes;
+		}
+
+		nxfer = file_pwrite(self->filep, self->buffer, total, aiocbp[0]->aio_offset);
+	} else {
+		for (i = 0; i < n; i++) {
+			total += aiocbp[i]->aio_nbytes;
+		}
+
+		nxfer = file_pread(self->filep, self->buffer, total, aiocbp[0]->aio_offset);
+	}
+
+	if (nxfer < 0) {
+		errcode = get_errno();
+		fdbg("ERROR: merged transfer of %d bytes failed: %d\n", total, errcode);
+		DEBUGASSERT(errcode > 0);
+	}
+
+	/* Share out the bytes transferred, in file order: a short transfer ends
+	 * in one of the requests and leaves nothing for those after it.
+	 */
+
+	total = 0;
+	for (i = 0; i < n; i++) {
+		if (nxfer < 0) {
+			aiocbp[i]->aio_result = -errcode;
+		} else {
+			nbytes = aiocbp[i]->aio_nbytes;
+			if (total + nbytes > (size_t)nxfer) {
+				nbytes = total < (size_t)nxfer ? (size_t)nxfer - total : 0;
+			}
+
+			if (opcode == LIO_READ) {
+				memcpy((FAR void *)aiocbp[i]->aio_buf, self->buffer + total, nbytes);
+			}
+
+			aiocbp[i]->aio_result = nbytes;
+			total += nbytes;
+		}
+
+		(void)aio_signal(pid[i], aiocbp[i]);
+	}
+}
+#endif
+
+/****************************************************************************
+ * Name: aio_worker_thread
+ *
+ * Description:
+ *   The AIO thread: perform pending I/O until there is none left, then
+ *   wait for more.
+ *
+ ****************************************************************************/
+
+static int aio_worker_thread(int argc, FAR char *argv[])
+{
+	FAR struct aio_container_s *batch[AIO_MERGE_MAX];
+	FAR struct aio_worker_s *self;
+	worker_t worker;
+	int n;
+
+	aio_lock();
+	self = &g_aio_workers[g_aio_nworkers++];
+	aio_unlock();
+
+#if CONFIG_FS_AIO_MERGE_SIZE > 0
+	/* Without a buffer, this thread performs every I/O alone */
+
+	self->buffer = (FAR uint8_t *)kmm_malloc(CONFIG_FS_AIO_MERGE_SIZE);
+#endif
+
+	for (;;) {
+		aio_lock();
+		n = aio_worker_pick(self, batch, &worker);
+		if (n == 0) {
+			g_aio_nidle++;
+			aio_unlock();
+
+			while (sem_wait(&g_aio_worksem) < 0) {
+				DEBUGASSERT(get_errno() == EINTR);
+			}
+
+			continue;
+		}
+		aio_unlock();
+
+#if CONFIG_FS_AIO_MERGE_SIZE > 0
+		if (n > 1) {
+			aio_worker_merged(self, batch, n);
+		} else
+#endif
+		{
+			worker(batch[0]);
+		}
+
+		aio_lock();
+		self->filep = NULL;
+		aio_unlock();
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aio_workers_start
+ *
+ * Description:
+ *   Start the AIO threads, if they are not running yet.  They are started
+ *   with the first I/O rather than at initialization, which happens before
+ *   threads can be created.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   Zero (OK) if the AIO threads are running.  Otherwise, a negated errno
+ *   value.
+ *
+ ****************************************************************************/
+
+int aio_workers_start(void)
+{
+	int ret = OK;
+	int pid;
+	int i;
+
+	aio_lock();
+	if (!g_aio_started) {
+		(void)sem_init(&g_aio_worksem, 0, 0);
+
+		for (i = 0; i < CONFIG_FS_AIO_NWORKERS; i++) {
+			pid = kernel_thread("aio", CONFIG_FS_AIO_PRIORITY, CONFIG_FS_AIO_STACKSIZE, (main_t)aio_worker_thread, (FAR char *const *)NULL);
+			if (pid < 0) {
+				ret = -get_errno();
+				fdbg("ERROR: cannot start AIO thread %d: %d\n", i, ret);
+				break;
+			}
+		}
+
+		/* Carry on with fewer threads if some could be started */
+
+		if (i > 0) {
+			g_aio_started = true;
+			ret = OK;
+		}
+	}
+	aio_unlock();
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: aio_workers_signal
+ *
+ * Description:
+ *   Wake up an idle AIO thread after an I/O has been queued.  The caller
+ *   holds the AIO lock.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void aio_workers_signal(void)
+{
+	if (g_aio_nidle > 0) {
+		g_aio_nidle--;
+		sem_post(&g_aio_worksem);
+	}
+}
+
+#endif							/* CONFIG_FS_AIO && AIO_HAVE_WORKERS */
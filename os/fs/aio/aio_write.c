@@ -126,8 +126,11 @@ static void aio_write_worker(FAR void *arg)
 {
 	FAR struct aio_container_s *aioc = (FAR struct aio_container_s *)arg;
 	FAR struct aiocb *aiocbp;
+#ifdef AIO_HAVE_FILEP
+	FAR struct file *filep;
+#endif
 	pid_t pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	uint8_t prio;
 #endif
 	ssize_t nwritten = 0;
@@ -142,8 +145,11 @@ static void aio_write_worker(FAR void *arg)
 
 	DEBUGASSERT(aioc && aioc->aioc_aiocbp);
 	pid = aioc->aioc_pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	prio = aioc->aioc_prio;
+#endif
+#ifdef AIO_HAVE_FILEP
+	filep = aioc->u.aioc_filep;
 #endif
 	aiocbp = aioc_decant(aioc);
 
@@ -151,7 +157,7 @@ static void aio_write_worker(FAR void *arg)
 	{
 		/* Call fcntl(F_GETFL) to get the file open mode. */
 
-		oflags = file_fcntl(aioc->u.aioc_filep, F_GETFL);
+		oflags = file_fcntl(filep, F_GETFL);
 		if (oflags < 0) {
 			int errcode = get_errno();
 			fdbg("ERROR: fcntl failed: %d\n", errcode);
@@ -161,7 +167,7 @@ static void aio_write_worker(FAR void *arg)
 
 		/* Perform the write using:
 		 *
-		 *   u.aioc_filep - File structure pointer
+		 *   filep        - File structure pointer
 		 *   aio_buf      - Location of buffer
 		 *   aio_nbytes   - Length of transfer
 		 *   aio_offset   - File offset
@@ -172,9 +178,9 @@ static void aio_write_worker(FAR void *arg)
 		if ((oflags & O_APPEND) != 0) {
 			/* Append to the current file position */
 
-			nwritten = file_write(aioc->u.aioc_filep, (FAR const void *)aiocbp->aio_buf, aiocbp->aio_nbytes);
+			nwritten = file_write(filep, (FAR const void *)aiocbp->aio_buf, aiocbp->aio_nbytes);
 		} else {
-			nwritten = file_pwrite(aioc->u.aioc_filep, (FAR const void *)aiocbp->aio_buf, aiocbp->aio_nbytes, aiocbp->aio_offset);
+			nwritten = file_pwrite(filep, (FAR const void *)aiocbp->aio_buf, aiocbp->aio_nbytes, aiocbp->aio_offset);
 		}
 	}
 #endif
@@ -198,7 +204,7 @@ errout:
 
 	(void)aio_signal(pid, aiocbp);
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	/* Restore the low priority worker thread default priority */
 
 	lpwork_restorepriority(prio);
@@ -333,6 +339,7 @@ int aio_write(FAR struct aiocb *aiocbp)
 
 	/* Defer the work to the worker thread */
 
+	aioc->aioc_opcode = LIO_WRITE;
 	ret = aio_queue(aioc, aio_write_worker);
 	if (ret < 0) {
 		/* The result and the errno have already been set */
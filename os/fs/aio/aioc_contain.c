@@ -118,7 +118,7 @@ FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
 #endif
 		FAR void *ptr;
 	} u;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	struct sched_param param;
 #endif
 
@@ -149,7 +149,7 @@ FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
 	aioc->u.ptr = u.ptr;
 	aioc->aioc_pid = getpid();
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_PRIOINHERIT
 	DEBUGVERIFY(sched_getparam(aioc->aioc_pid, &param));
 	aioc->aioc_prio = param.sched_priority;
 #endif
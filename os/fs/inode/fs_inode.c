@@ -59,6 +59,7 @@
 #include <assert.h>
 #include <semaphore.h>
 #include <errno.h>
+#include <string.h>
 
 #include <tinyara/kmalloc.h>
 #include <tinyara/fs/fs.h>
@@ -288,6 +289,27 @@ FAR struct inode *inode_search(FAR const char **path, FAR struct inode **peer, F
 	FAR struct inode *node = root_inode;
 	FAR struct inode *left = NULL;
 	FAR struct inode *above = NULL;
+#ifdef CONFIG_FS_INODE_CACHE
+	FAR const char *end;
+
+	/* A plain lookup may be answered by the cache.  The peer and parent are
+	 * not cached: they are wanted to change the tree.
+	 */
+
+	if (!peer && !parent) {
+		node = inode_cache_lookup(*path, &name);
+		if (node) {
+			if (relpath) {
+				*relpath = name;
+			}
+
+			*path = name;
+			return node;
+		}
+
+		node = root_inode;
+	}
+#endif
 
 	while (node) {
 		int result = _inode_compare(name, node);
@@ -323,6 +345,9 @@ FAR struct inode *inode_search(FAR const char **path, FAR struct inode **peer, F
 			 *       below this one
 			 */
 
+#ifdef CONFIG_FS_INODE_CACHE
+			end = name + strlen(node->i_name);
+#endif
 			name = inode_nextname(name);
 			if (!*name || INODE_IS_MOUNTPT(node)) {
 				/* Either (1) we are at the end of the path, so this must be the
@@ -333,6 +358,11 @@ FAR struct inode *inode_search(FAR const char **path, FAR struct inode **peer, F
 				if (relpath) {
 					*relpath = name;
 				}
+#ifdef CONFIG_FS_INODE_CACHE
+				if (!peer && !parent) {
+					inode_cache_add(*path, end - *path, node);
+				}
+#endif
 				break;
 			} else {
 				/* More to go, keep looking at the next level "down" */
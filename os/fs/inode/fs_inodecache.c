@@ -0,0 +1,240 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * fs/inode/fs_inodecache.c
+ *
+ * A small hash table from path prefixes to the inodes inode_search() found
+ * for them: the node at the end of the path, or the mountpoint that takes
+ * the rest of it.  A lookup hashes the path once, probing the table at the
+ * end of each segment, instead of comparing names along the peer list of
+ * every level of the tree.
+ *
+ * Only paths that were found are cached.  Adding a node cannot change what
+ * such a path resolves to, so only inode_unlink() flushes the table.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <tinyara/fs/fs.h>
+
+#include "inode/inode.h"
+
+#ifdef CONFIG_FS_INODE_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_FS_INODE_CACHE_SIZE
+#define CONFIG_FS_INODE_CACHE_SIZE 16
+#endif
+
+#ifndef CONFIG_FS_INODE_CACHE_PATHLEN
+#define CONFIG_FS_INODE_CACHE_PATHLEN 32
+#endif
+
+#if (CONFIG_FS_INODE_CACHE_SIZE & (CONFIG_FS_INODE_CACHE_SIZE - 1)) != 0
+#error "CONFIG_FS_INODE_CACHE_SIZE must be a power of two"
+#endif
+
+#if CONFIG_FS_INODE_CACHE_PATHLEN > 255
+#error "CONFIG_FS_INODE_CACHE_PATHLEN must be less than 256"
+#endif
+
+/* FNV-1a */
+
+#define INODE_HASH_BASIS 2166136261u
+#define INODE_HASH_PRIME 16777619u
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct inode_cache_s {
+	FAR struct inode *node;		/* The inode found, NULL if the entry is free */
+	uint32_t hash;				/* Hash of path[0..len) */
+	uint8_t len;				/* Length of the path prefix */
+	char path[CONFIG_FS_INODE_CACHE_PATHLEN];	/* The prefix, not terminated */
+};
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+static struct inode_cache_s g_inode_cache[CONFIG_FS_INODE_CACHE_SIZE];
+static struct inode_cachestats_s g_inode_cachestats;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static inline uint32_t inode_cache_hash(uint32_t hash, char ch)
+{
+	return (hash ^ (uint8_t)ch) * INODE_HASH_PRIME;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_cache_lookup
+ *
+ * Description:
+ *   Look for the longest cached prefix of path that resolves it: the whole
+ *   path, or a mountpoint at its start.  On a hit, *relpath is set to what
+ *   follows the prefix, as inode_search() would set it.
+ *
+ * Assumptions:
+ *   The caller holds the inode semaphore
+ *
+ ****************************************************************************/
+
+FAR struct inode *inode_cache_lookup(FAR const char *path, FAR const char **relpath)
+{
+	FAR struct inode_cache_s *entry;
+	FAR struct inode *found = NULL;
+	FAR const char *rest = NULL;
+	FAR const char *ptr;
+	FAR const char *tail;
+	uint32_t hash = INODE_HASH_BASIS;
+	size_t len;
+
+	for (ptr = path;; ptr++) {
+		/* Probe at the end of each segment */
+
+		if ((*ptr == '/' || *ptr == '\0') && ptr > path && ptr[-1] != '/') {
+			len = ptr - path;
+			if (len > CONFIG_FS_INODE_CACHE_PATHLEN) {
+				break;
+			}
+
+			entry = &g_inode_cache[hash & (CONFIG_FS_INODE_CACHE_SIZE - 1)];
+			if (entry->node != NULL && entry->hash == hash && entry->len == len && memcmp(entry->path, path, len) == 0) {
+				/* As in inode_search(), one separator is skipped.  A prefix
+				 * naming a node only resolves the path if nothing follows
+				 * that; a mountpoint takes the rest.
+				 */
+
+				tail = *ptr == '/' ? ptr + 1 : ptr;
+				if (*tail == '\0' || INODE_IS_MOUNTPT(entry->node)) {
+					found = entry->node;
+					rest = tail;
+					break;
+				}
+			}
+		}
+
+		if (*ptr == '\0') {
+			break;
+		}
+
+		hash = inode_cache_hash(hash, *ptr);
+	}
+
+	if (found == NULL) {
+		g_inode_cachestats.misses++;
+		return NULL;
+	}
+
+	g_inode_cachestats.hits++;
+	*relpath = rest;
+	return found;
+}
+
+/****************************************************************************
+ * Name: inode_cache_add
+ *
+ * Description:
+ *   Remember that the first len characters of path resolved to node.
+ *   Prefixes longer than CONFIG_FS_INODE_CACHE_PATHLEN are not cached.
+ *
+ * Assumptions:
+ *   The caller holds the inode semaphore
+ *
+ ****************************************************************************/
+
+void inode_cache_add(FAR const char *path, size_t len, FAR struct inode *node)
+{
+	FAR struct inode_cache_s *entry;
+	uint32_t hash = INODE_HASH_BASIS;
+	size_t i;
+
+	if (len == 0 || len > CONFIG_FS_INODE_CACHE_PATHLEN) {
+		return;
+	}
+
+	for (i = 0; i < len; i++) {
+		hash = inode_cache_hash(hash, path[i]);
+	}
+
+	entry = &g_inode_cache[hash & (CONFIG_FS_INODE_CACHE_SIZE - 1)];
+	entry->node = node;
+	entry->hash = hash;
+	entry->len = len;
+	memcpy(entry->path, path, len);
+}
+
+/****************************************************************************
+ * Name: inode_cache_flush
+ *
+ * Description:
+ *   Forget every cached path.  Called when a node is unlinked from the
+ *   tree, which takes its subtree with it.
+ *
+ * Assumptions:
+ *   The caller holds the inode semaphore
+ *
+ ****************************************************************************/
+
+void inode_cache_flush(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_FS_INODE_CACHE_SIZE; i++) {
+		g_inode_cache[i].node = NULL;
+	}
+
+	g_inode_cachestats.flushes++;
+}
+
+/****************************************************************************
+ * Name: inode_getcachestats
+ *
+ * Description:
+ *   Return the counters of the path lookup cache.
+ *
+ ****************************************************************************/
+
+void inode_getcachestats(FAR struct inode_cachestats_s *stats)
+{
+	inode_semtake();
+	*stats = g_inode_cachestats;
+	inode_semgive();
+}
+
+#endif							/* CONFIG_FS_INODE_CACHE */
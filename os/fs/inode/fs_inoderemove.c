@@ -136,6 +136,12 @@ FAR struct inode *inode_unlink(FAR const char *path)
 		}
 
 		node->i_peer = NULL;
+
+#ifdef CONFIG_FS_INODE_CACHE
+		/* The cache may hold the node or one of its children */
+
+		inode_cache_flush();
+#endif
 	}
 
 	return node;
@@ -207,6 +207,50 @@ void inode_free(FAR struct inode *node);
 
 const char *inode_nextname(FAR const char *name);
 
+#ifdef CONFIG_FS_INODE_CACHE
+/* fs_inodecache.c **********************************************************/
+/****************************************************************************
+ * Name: inode_cache_lookup
+ *
+ * Description:
+ *   Look for the longest cached prefix of path that resolves it: the whole
+ *   path, or a mountpoint at its start.  On a hit, *relpath is set to what
+ *   follows the prefix, as inode_search() would set it.
+ *
+ * Assumptions:
+ *   The caller holds the inode semaphore
+ *
+ ****************************************************************************/
+
+FAR struct inode *inode_cache_lookup(FAR const char *path, FAR const char **relpath);
+
+/****************************************************************************
+ * Name: inode_cache_add
+ *
+ * Description:
+ *   Remember that the first len characters of path resolved to node.
+ *
+ * Assumptions:
+ *   The caller holds the inode semaphore
+ *
+ ****************************************************************************/
+
+void inode_cache_add(FAR const char *path, size_t len, FAR struct inode *node);
+
+/****************************************************************************
+ * Name: inode_cache_flush
+ *
+ * Description:
+ *   Forget every cached path.
+ *
+ * Assumptions:
+ *   The caller holds the inode semaphore
+ *
+ ****************************************************************************/
+
+void inode_cache_flush(void);
+#endif
+
 /* fs_inodereserver.c *******************************************************/
 /****************************************************************************
  * Name: inode_reserve
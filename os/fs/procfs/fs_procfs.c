@@ -96,6 +96,8 @@ extern const struct procfs_operations proc_operations;
 extern const struct procfs_operations cpuload_operations;
 extern const struct procfs_operations uptime_operations;
 extern const struct procfs_operations version_operations;
+extern const struct procfs_operations heapprof_operations;
+extern const struct procfs_operations bcache_operations;
 
 /* This is not good.  These are implemented in drivers/mtd.  Having to
  * deal with them here is not a good coupling.
@@ -123,7 +125,7 @@ static const struct procfs_entry_s g_procfsentries[] = {
 	{"[0-9]*", &proc_operations},
 #endif
 
-#if defined(CONFIG_SCHED_CPULOAD) && !defined(CONFIG_FS_PROCFS_EXCLUDE_CPULOAD)
+#if (defined(CONFIG_SCHED_CPULOAD) || defined(CONFIG_SCHED_CPUACCT)) && !defined(CONFIG_FS_PROCFS_EXCLUDE_CPULOAD)
 	{"cpuload", &cpuload_operations},
 #endif
 
@@ -143,6 +145,14 @@ static const struct procfs_entry_s g_procfsentries[] = {
 	{"power/domains**", &power_procfsoperations},
 #endif
 
+#if defined(CONFIG_DEBUG_MM_HEAPINFO_PROFILE) && !defined(CONFIG_BUILD_PROTECTED) && !defined(CONFIG_FS_PROCFS_EXCLUDE_HEAPPROF)
+	{"heapprof", &heapprof_operations},
+#endif
+
+#if defined(CONFIG_DRVR_BCACHE) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+	{"bcache", &bcache_operations},
+#endif
+
 #if !defined(CONFIG_FS_PROCFS_EXCLUDE_UPTIME)
 	{"uptime", &uptime_operations},
 #endif
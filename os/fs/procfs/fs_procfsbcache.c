@@ -0,0 +1,299 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <sys/statfs.h>
+#include <sys/stat.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/kmalloc.h>
+#include <tinyara/bcache.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/procfs.h>
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS)
+#if defined(CONFIG_DRVR_BCACHE) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BCACHE_LINELEN  96		/* Longest line of the file */
+#define BCACHE_FILESIZE 1024	/* Caches that do not fit are left out */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* This structure describes one open "file" */
+
+struct bcstats_file_s {
+	struct procfs_file_s base;	/* Base open file structure */
+	size_t size;				/* Number of valid bytes in data[] */
+	char data[BCACHE_FILESIZE];	/* The text, formatted at open */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/* File system methods */
+
+static int bcstats_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode);
+static int bcstats_close(FAR struct file *filep);
+static ssize_t bcstats_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+
+static int bcstats_dup(FAR const struct file *oldp, FAR struct file *newp);
+
+static int bcstats_stat(FAR const char *relpath, FAR struct stat *buf);
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/* See fs_mount.c -- this structure is explicitly externed there.
+ * We use the old-fashioned kind of initializers so that this will compile
+ * with any compiler.
+ */
+
+const struct procfs_operations bcache_operations = {
+	bcstats_open,				/* open */
+	bcstats_close,				/* close */
+	bcstats_read,				/* read */
+	NULL,						/* write */
+
+	bcstats_dup,				/* dup */
+
+	NULL,						/* opendir */
+	NULL,						/* closedir */
+	NULL,						/* readdir */
+	NULL,						/* rewinddir */
+
+	bcstats_stat				/* stat */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bcstats_line
+ *
+ * Description:
+ *   bcache_foreach() callback appending the line of one cache.  It runs
+ *   with the scheduler locked, so it only formats the counters.
+ *
+ ****************************************************************************/
+
+static void bcstats_line(FAR struct bcache_s *bc, FAR void *arg)
+{
+	FAR struct bcstats_file_s *attr = (FAR struct bcstats_file_s *)arg;
+	FAR struct bcache_stats_s *stats = &bc->stats;
+	uint32_t accesses;
+	unsigned int kb;
+
+	if (attr->size + BCACHE_LINELEN > BCACHE_FILESIZE) {
+		return;
+	}
+
+	accesses = stats->hits + stats->misses;
+	kb = (bc->nsets * CONFIG_DRVR_BCACHE_WAYS * bc->blocksize) / 1024;
+	attr->size += snprintf(&attr->data[attr->size], BCACHE_LINELEN, "%-10s %4u %9lu %9lu %3lu%% %9lu %9lu %9lu %9lu\n", bc->name, kb, (unsigned long)stats->hits, (unsigned long)stats->misses, accesses != 0 ? (unsigned long)((uint64_t)stats->hits * 100 / accesses) : 0UL, (unsigned long)stats->rablocks, (unsigned long)stats->rahits, (unsigned long)stats->wrcalls, (unsigned long)stats->wrblocks);
+}
+
+/****************************************************************************
+ * Name: bcstats_open
+ ****************************************************************************/
+
+static int bcstats_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode)
+{
+	FAR struct bcstats_file_s *attr;
+
+	fvdbg("Open '%s'\n", relpath);
+
+	/* PROCFS is read-only.  Any attempt to open with any kind of write
+	 * access is not permitted.
+	 */
+
+	if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0) {
+		fdbg("ERROR: Only O_RDONLY supported\n");
+		return -EACCES;
+	}
+
+	/* "bcache" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "bcache") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* Allocate a container to hold the file attributes and the text */
+
+	attr = (FAR struct bcstats_file_s *)kmm_zalloc(sizeof(struct bcstats_file_s));
+	if (!attr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* Format the counters now so that every read of this open file sees
+	 * the same data, however small the reads are.
+	 */
+
+	attr->size = snprintf(attr->data, BCACHE_LINELEN, "%-10s %4s %9s %9s %4s %9s %9s %9s %9s\n", "DEVICE", "KB", "HITS", "MISSES", "HIT", "RABLOCKS", "RAHITS", "WRCALLS", "WRBLOCKS");
+	bcache_foreach(bcstats_line, attr);
+
+	/* Save the attributes as the open-specific state in filep->f_priv */
+
+	filep->f_priv = (FAR void *)attr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcstats_close
+ ****************************************************************************/
+
+static int bcstats_close(FAR struct file *filep)
+{
+	FAR struct bcstats_file_s *attr;
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct bcstats_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* Release the file attributes structure */
+
+	kmm_free(attr);
+	filep->f_priv = NULL;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcstats_read
+ ****************************************************************************/
+
+static ssize_t bcstats_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	FAR struct bcstats_file_s *attr;
+	off_t offset;
+	ssize_t ret;
+
+	fvdbg("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct bcstats_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* Transfer the text formatted at open to user receive buffer */
+
+	offset = filep->f_pos;
+	ret = procfs_memcpy(attr->data, attr->size, buffer, buflen, &offset);
+
+	/* Update the file offset */
+
+	if (ret > 0) {
+		filep->f_pos += ret;
+	}
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: bcstats_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int bcstats_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+	FAR struct bcstats_file_s *oldattr;
+	FAR struct bcstats_file_s *newattr;
+
+	fvdbg("Dup %p->%p\n", oldp, newp);
+
+	/* Recover our private data from the old struct file instance */
+
+	oldattr = (FAR struct bcstats_file_s *)oldp->f_priv;
+	DEBUGASSERT(oldattr);
+
+	/* Allocate a new container to hold the task and attribute selection */
+
+	newattr = (FAR struct bcstats_file_s *)kmm_malloc(sizeof(struct bcstats_file_s));
+	if (!newattr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* The copy the file attributes from the old attributes to the new */
+
+	memcpy(newattr, oldattr, sizeof(struct bcstats_file_s));
+
+	/* Save the new attributes in the new file structure */
+
+	newp->f_priv = (FAR void *)newattr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: bcstats_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int bcstats_stat(const char *relpath, struct stat *buf)
+{
+	/* "bcache" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "bcache") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* "bcache" is the name for a read-only file */
+
+	buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+	buf->st_size = 0;
+	buf->st_blksize = 0;
+	buf->st_blocks = 0;
+	return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#endif							/* CONFIG_DRVR_BCACHE && !CONFIG_FS_PROCFS_EXCLUDE_BCACHE */
+#endif							/* !CONFIG_DISABLE_MOUNTPOINT && CONFIG_FS_PROCFS */
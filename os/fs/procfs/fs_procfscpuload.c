@@ -76,8 +76,12 @@
 #include <tinyara/fs/fs.h>
 #include <tinyara/fs/procfs.h>
 
+#ifdef CONFIG_SCHED_CPUACCT
+#include <arch/irq.h>
+#endif
+
 #if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS)
-#if defined(CONFIG_SCHED_CPULOAD) && !defined(CONFIG_FS_PROCFS_EXCLUDE_CPULOAD)
+#if (defined(CONFIG_SCHED_CPULOAD) || defined(CONFIG_SCHED_CPUACCT)) && !defined(CONFIG_FS_PROCFS_EXCLUDE_CPULOAD)
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -87,6 +91,7 @@
  */
 
 #define CPULOAD_LINELEN 16
+#define CPUACCT_LINELEN 40
 
 /****************************************************************************
  * Private Types
@@ -112,6 +117,12 @@ static ssize_t cpuload_read(FAR struct file *filep, FAR char *buffer, size_t buf
 static int cpuload_dup(FAR const struct file *oldp, FAR struct file *newp);
 static int cpuload_stat(FAR const char *relpath, FAR struct stat *buf);
 
+/* Helpers */
+
+#ifdef CONFIG_SCHED_CPUACCT
+static size_t cpuload_irqs(FAR char *buffer, size_t buflen, off_t offset);
+#endif
+
 /****************************************************************************
  * Private Variables
  ****************************************************************************/
@@ -145,6 +156,80 @@ const struct procfs_operations cpuload_operations = {
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: cpuload_irqs
+ *
+ * Description:
+ *   Format the CPU cycles accounted to each interrupt that was raised, to
+ *   the IDLE thread and to everything, skipping the first offset bytes.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CPUACCT
+static size_t cpuload_irqs(FAR char *buffer, size_t buflen, off_t offset)
+{
+	struct cpuacct_s cpuacct;
+	char line[CPUACCT_LINELEN];
+	size_t remaining;
+	size_t linesize;
+	size_t copysize;
+	size_t totalsize;
+	int irq;
+
+	remaining = buflen;
+	totalsize = 0;
+
+	linesize = snprintf(line, CPUACCT_LINELEN, "%-5s %10s %20s\n", "IRQ", "COUNT", "CYCLES");
+	copysize = procfs_memcpy(line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	buffer += copysize;
+	remaining -= copysize;
+
+	for (irq = 0; irq < NR_IRQS; irq++) {
+		if (totalsize >= buflen) {
+			return totalsize;
+		}
+
+		if (clock_irqacct(irq, &cpuacct) < 0 || cpuacct.count == 0) {
+			continue;
+		}
+
+		linesize = snprintf(line, CPUACCT_LINELEN, "%5d %10lu %20llu\n", irq, (unsigned long)cpuacct.count, (unsigned long long)cpuacct.active);
+		copysize = procfs_memcpy(line, linesize, buffer, remaining, &offset);
+
+		totalsize += copysize;
+		buffer += copysize;
+		remaining -= copysize;
+	}
+
+	if (totalsize >= buflen) {
+		return totalsize;
+	}
+
+	/* The IDLE thread, then everything */
+
+	DEBUGVERIFY(clock_cpuacct(0, &cpuacct));
+
+	linesize = snprintf(line, CPUACCT_LINELEN, "%-5s %10s %20llu\n", "idle", "", (unsigned long long)cpuacct.active);
+	copysize = procfs_memcpy(line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	buffer += copysize;
+	remaining -= copysize;
+
+	if (totalsize >= buflen) {
+		return totalsize;
+	}
+
+	linesize = snprintf(line, CPUACCT_LINELEN, "%-5s %10s %20llu\n", "all", "", (unsigned long long)cpuacct.total);
+	copysize = procfs_memcpy(line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	return totalsize;
+}
+#endif
+
 /****************************************************************************
  * Name: cpuload_open
  ****************************************************************************/
@@ -233,6 +318,7 @@ static ssize_t cpuload_read(FAR struct file *filep, FAR char *buffer, size_t buf
 	 */
 
 	if (filep->f_pos == 0) {
+#ifdef CONFIG_SCHED_CPULOAD
 		struct cpuload_s cpuload;
 		uint32_t intpart;
 		uint32_t fracpart;
@@ -259,7 +345,16 @@ static ssize_t cpuload_read(FAR struct file *filep, FAR char *buffer, size_t buf
 			fracpart = 0;
 		}
 
+#ifdef CONFIG_SCHED_CPUACCT
+		/* The interrupt table follows on the next lines */
+
+		linesize = snprintf(attr->line, CPULOAD_LINELEN, "%3d.%01d%%\n", intpart, fracpart);
+#else
 		linesize = snprintf(attr->line, CPULOAD_LINELEN, "%3d.%01d%%", intpart, fracpart);
+#endif
+#else
+		linesize = 0;
+#endif
 
 		/* Save the linesize in case we are re-entered with f_pos > 0 */
 
@@ -271,6 +366,14 @@ static ssize_t cpuload_read(FAR struct file *filep, FAR char *buffer, size_t buf
 	offset = filep->f_pos;
 	ret = procfs_memcpy(attr->line, attr->linesize, buffer, buflen, &offset);
 
+#ifdef CONFIG_SCHED_CPUACCT
+	/* Then the cycles accounted to each interrupt, sampled on each read */
+
+	if ((size_t)ret < buflen) {
+		ret += cpuload_irqs(buffer + ret, buflen - ret, offset);
+	}
+#endif
+
 	/* Update the file offset */
 
 	if (ret > 0) {
@@ -0,0 +1,305 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <sys/statfs.h>
+#include <sys/stat.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/kmalloc.h>
+#include <tinyara/mm/mm.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/procfs.h>
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS)
+#if defined(CONFIG_DEBUG_MM_HEAPINFO_PROFILE) && !defined(CONFIG_BUILD_PROTECTED) && !defined(CONFIG_FS_PROCFS_EXCLUDE_HEAPPROF)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+/* The file is a heapprof_hdr_s followed by nsites struct mm_heapsite_s, in
+ * the byte order of the target.  tools/heapprof.py reads this layout.
+ */
+
+#define HEAPPROF_MAGIC   0x46525048	/* "HPRF" */
+#define HEAPPROF_VERSION 1
+#define HEAPPROF_NSITES  (CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES + 1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct heapprof_hdr_s {
+	uint32_t magic;				/* HEAPPROF_MAGIC */
+	uint16_t version;			/* HEAPPROF_VERSION */
+	uint16_t entry_size;		/* sizeof(struct mm_heapsite_s) */
+	uint32_t nsites;			/* Number of entries that follow */
+	uint32_t heap_size;			/* Size of the heap */
+	uint32_t alloc_size;		/* Currently allocated node size */
+	uint32_t peak_size;			/* Peak allocated node size */
+};
+
+/* This structure describes one open "file" */
+
+struct heapprof_file_s {
+	struct procfs_file_s base;	/* Base open file structure */
+	size_t size;				/* Number of valid bytes in data[] */
+	struct heapprof_hdr_s hdr;	/* Snapshot header ... */
+	struct mm_heapsite_s data[HEAPPROF_NSITES];	/* ... and the sites, contiguous */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/* File system methods */
+
+static int heapprof_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode);
+static int heapprof_close(FAR struct file *filep);
+static ssize_t heapprof_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+
+static int heapprof_dup(FAR const struct file *oldp, FAR struct file *newp);
+
+static int heapprof_stat(FAR const char *relpath, FAR struct stat *buf);
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/* See fs_mount.c -- this structure is explicitly externed there.
+ * We use the old-fashioned kind of initializers so that this will compile
+ * with any compiler.
+ */
+
+const struct procfs_operations heapprof_operations = {
+	heapprof_open,				/* open */
+	heapprof_close,				/* close */
+	heapprof_read,				/* read */
+	NULL,						/* write */
+
+	heapprof_dup,				/* dup */
+
+	NULL,						/* opendir */
+	NULL,						/* closedir */
+	NULL,						/* readdir */
+	NULL,						/* rewinddir */
+
+	heapprof_stat				/* stat */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: heapprof_open
+ ****************************************************************************/
+
+static int heapprof_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode)
+{
+	FAR struct heapprof_file_s *attr;
+	FAR struct mm_heap_s *heap;
+	int nsites;
+
+	fvdbg("Open '%s'\n", relpath);
+
+	/* PROCFS is read-only.  Any attempt to open with any kind of write
+	 * access is not permitted.
+	 */
+
+	if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0) {
+		fdbg("ERROR: Only O_RDONLY supported\n");
+		return -EACCES;
+	}
+
+	/* "heapprof" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "heapprof") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* Allocate a container to hold the file attributes and the snapshot.
+	 * This is done first so that the snapshot includes this allocation
+	 * rather than being invalidated by it.
+	 */
+
+	attr = (FAR struct heapprof_file_s *)kmm_zalloc(sizeof(struct heapprof_file_s));
+	if (!attr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* Take the snapshot now so that every read of this open file sees the
+	 * same data, however small the reads are.  Nothing is formatted while
+	 * the heap semaphore is held.
+	 */
+
+	heap = mm_get_heap_info();
+	nsites = heapinfo_profile_snapshot(heap, attr->data, HEAPPROF_NSITES);
+
+	attr->hdr.magic = HEAPPROF_MAGIC;
+	attr->hdr.version = HEAPPROF_VERSION;
+	attr->hdr.entry_size = sizeof(struct mm_heapsite_s);
+	attr->hdr.nsites = nsites;
+	attr->hdr.heap_size = heap->mm_heapsize;
+	attr->hdr.alloc_size = heap->total_alloc_size + SIZEOF_MM_ALLOCNODE * 2;
+	attr->hdr.peak_size = heap->peak_alloc_size;
+	attr->size = sizeof(struct heapprof_hdr_s) + nsites * sizeof(struct mm_heapsite_s);
+
+	/* Save the attributes as the open-specific state in filep->f_priv */
+
+	filep->f_priv = (FAR void *)attr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: heapprof_close
+ ****************************************************************************/
+
+static int heapprof_close(FAR struct file *filep)
+{
+	FAR struct heapprof_file_s *attr;
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct heapprof_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* Release the file attributes structure */
+
+	kmm_free(attr);
+	filep->f_priv = NULL;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: heapprof_read
+ ****************************************************************************/
+
+static ssize_t heapprof_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	FAR struct heapprof_file_s *attr;
+	off_t offset;
+	ssize_t ret;
+
+	fvdbg("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct heapprof_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* Transfer the snapshot taken at open to user receive buffer */
+
+	offset = filep->f_pos;
+	ret = procfs_memcpy((FAR const char *)&attr->hdr, attr->size, buffer, buflen, &offset);
+
+	/* Update the file offset */
+
+	if (ret > 0) {
+		filep->f_pos += ret;
+	}
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: heapprof_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int heapprof_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+	FAR struct heapprof_file_s *oldattr;
+	FAR struct heapprof_file_s *newattr;
+
+	fvdbg("Dup %p->%p\n", oldp, newp);
+
+	/* Recover our private data from the old struct file instance */
+
+	oldattr = (FAR struct heapprof_file_s *)oldp->f_priv;
+	DEBUGASSERT(oldattr);
+
+	/* Allocate a new container to hold the task and attribute selection */
+
+	newattr = (FAR struct heapprof_file_s *)kmm_malloc(sizeof(struct heapprof_file_s));
+	if (!newattr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* The copy the file attributes from the old attributes to the new */
+
+	memcpy(newattr, oldattr, sizeof(struct heapprof_file_s));
+
+	/* Save the new attributes in the new file structure */
+
+	newp->f_priv = (FAR void *)newattr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: heapprof_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int heapprof_stat(const char *relpath, struct stat *buf)
+{
+	/* "heapprof" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "heapprof") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* "heapprof" is the name for a read-only file */
+
+	buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+	buf->st_size = 0;
+	buf->st_blksize = 0;
+	buf->st_blocks = 0;
+	return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#endif							/* CONFIG_DEBUG_MM_HEAPINFO_PROFILE && !CONFIG_FS_PROCFS_EXCLUDE_HEAPPROF */
+#endif							/* !CONFIG_DISABLE_MOUNTPOINT && CONFIG_FS_PROCFS */
@@ -78,7 +78,7 @@
 #include <tinyara/fs/procfs.h>
 #include <tinyara/fs/dirent.h>
 
-#ifdef CONFIG_SCHED_CPULOAD
+#if defined(CONFIG_SCHED_CPULOAD) || defined(CONFIG_SCHED_CPUACCT)
 #include <tinyara/clock.h>
 #endif
 
@@ -94,7 +94,7 @@
  * to handle the longest line generated by this logic.
  */
 
-#define STATUS_LINELEN 32
+#define STATUS_LINELEN 40
 
 /****************************************************************************
  * Private Types
@@ -109,6 +109,9 @@ enum proc_node_e {
 	PROC_CMDLINE,				/* Task command line */
 #ifdef CONFIG_SCHED_CPULOAD
 	PROC_LOADAVG,				/* Average CPU utilization */
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+	PROC_CPUTIME,				/* CPU cycles used */
 #endif
 	PROC_STACK,					/* Task stack info */
 	PROC_GROUP,					/* Group directory */
@@ -155,6 +158,9 @@ static ssize_t proc_cmdline(FAR struct proc_file_s *procfile, FAR struct tcb_s *
 #ifdef CONFIG_SCHED_CPULOAD
 static ssize_t proc_loadavg(FAR struct proc_file_s *procfile, FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen, off_t offset);
 #endif
+#ifdef CONFIG_SCHED_CPUACCT
+static ssize_t proc_cputime(FAR struct proc_file_s *procfile, FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen, off_t offset);
+#endif
 static ssize_t proc_stack(FAR struct proc_file_s *procfile, FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen, off_t offset);
 static ssize_t proc_groupstatus(FAR struct proc_file_s *procfile, FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen, off_t offset);
 static ssize_t proc_groupfd(FAR struct proc_file_s *procfile, FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen, off_t offset);
@@ -223,6 +229,12 @@ static const struct proc_node_s g_loadavg = {
 };
 #endif
 
+#ifdef CONFIG_SCHED_CPUACCT
+static const struct proc_node_s g_cputime = {
+	"cputime", "cputime", (uint8_t)PROC_CPUTIME, DTYPE_FILE	/* CPU cycles used */
+};
+#endif
+
 static const struct proc_node_s g_stack = {
 	"stack", "stack", (uint8_t)PROC_STACK, DTYPE_FILE	/* Task stack info */
 };
@@ -246,6 +258,9 @@ static FAR const struct proc_node_s *const g_nodeinfo[] = {
 	&g_cmdline,					/* Task command line */
 #ifdef CONFIG_SCHED_CPULOAD
 	&g_loadavg,					/* Average CPU utilization */
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+	&g_cputime,					/* CPU cycles used */
 #endif
 	&g_stack,					/* Task stack info */
 	&g_group,					/* Group directory */
@@ -262,6 +277,9 @@ static const struct proc_node_s *const g_level0info[] = {
 	&g_cmdline,					/* Task command line */
 #ifdef CONFIG_SCHED_CPULOAD
 	&g_loadavg,					/* Average CPU utilization */
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+	&g_cputime,					/* CPU cycles used */
 #endif
 	&g_stack,					/* Task stack info */
 	&g_group,					/* Group directory */
@@ -547,6 +565,80 @@ static ssize_t proc_loadavg(FAR struct proc_file_s *procfile, FAR struct tcb_s *
 }
 #endif
 
+/****************************************************************************
+ * Name: proc_cputime
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CPUACCT
+static ssize_t proc_cputime(FAR struct proc_file_s *procfile, FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen, off_t offset)
+{
+	struct cpuacct_s cpuacct;
+	uint32_t intpart;
+	uint32_t fracpart;
+	size_t remaining;
+	size_t linesize;
+	size_t copysize;
+	size_t totalsize;
+
+	/* Sample the cycles of the thread.  clock_cpuacct should only fail if
+	 * the PID is not valid.  This could happen if the thread exited sometime
+	 * after the procfs entry was opened.
+	 */
+
+	if (clock_cpuacct(procfile->pid, &cpuacct) < 0) {
+		return 0;
+	}
+
+	remaining = buflen;
+	totalsize = 0;
+
+	/* Show the CPU cycles used by the thread */
+
+	linesize = snprintf(procfile->line, STATUS_LINELEN, "%-12s%llu\n", "Cycles:", (unsigned long long)cpuacct.active);
+	copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	buffer += copysize;
+	remaining -= copysize;
+
+	if (totalsize >= buflen) {
+		return totalsize;
+	}
+
+	/* Show how many times it was switched to */
+
+	linesize = snprintf(procfile->line, STATUS_LINELEN, "%-12s%lu\n", "Switches:", (unsigned long)cpuacct.count);
+	copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	buffer += copysize;
+	remaining -= copysize;
+
+	if (totalsize >= buflen) {
+		return totalsize;
+	}
+
+	/* Show its share of all the cycles accounted */
+
+	if (cpuacct.total > 0) {
+		uint32_t tmp;
+
+		tmp = (uint32_t)((1000 * cpuacct.active) / cpuacct.total);
+		intpart = tmp / 10;
+		fracpart = tmp - 10 * intpart;
+	} else {
+		intpart = 0;
+		fracpart = 0;
+	}
+
+	linesize = snprintf(procfile->line, STATUS_LINELEN, "%-12s%3d.%01d%%\n", "Share:", intpart, fracpart);
+	copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	return totalsize;
+}
+#endif
+
 /****************************************************************************
  * Name: proc_stack
  ****************************************************************************/
@@ -557,6 +649,10 @@ static ssize_t proc_stack(FAR struct proc_file_s *procfile, FAR struct tcb_s *tc
 	size_t linesize;
 	size_t copysize;
 	size_t totalsize;
+#ifdef CONFIG_SCHED_STACKSAMPLE
+	int ndx;
+	int i;
+#endif
 
 	remaining = buflen;
 	totalsize = 0;
@@ -583,12 +679,12 @@ static ssize_t proc_stack(FAR struct proc_file_s *procfile, FAR struct tcb_s *tc
 	buffer += copysize;
 	remaining -= copysize;
 
-#ifdef CONFIG_DEBUG_COLORATION
+#ifdef CONFIG_STACK_COLORATION
 	if (totalsize >= buflen) {
 		return totalsize;
 	}
 
-	/* Show the stack size */
+	/* Show the stack high water mark */
 
 	linesize = snprintf(procfile->line, STATUS_LINELEN, "%-12s%ld\n", "StackUsed:", (long)up_check_tcbstack(tcb));
 	copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
@@ -598,6 +694,48 @@ static ssize_t proc_stack(FAR struct proc_file_s *procfile, FAR struct tcb_s *tc
 	remaining -= copysize;
 #endif
 
+#ifdef CONFIG_SCHED_STACKSAMPLE
+	if (totalsize >= buflen) {
+		return totalsize;
+	}
+
+	/* Show the high water marks of the last samples, oldest first */
+
+	linesize = snprintf(procfile->line, STATUS_LINELEN, "%-12s", "StackHist:");
+	copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	buffer += copysize;
+	remaining -= copysize;
+
+	for (i = 0; i < tcb->stack_nsamples; i++) {
+		if (totalsize >= buflen) {
+			return totalsize;
+		}
+
+		ndx = tcb->stack_sampleidx + CONFIG_SCHED_STACKSAMPLE_NSAMPLES - tcb->stack_nsamples + i;
+		ndx %= CONFIG_SCHED_STACKSAMPLE_NSAMPLES;
+
+		linesize = snprintf(procfile->line, STATUS_LINELEN, " %lu", (unsigned long)tcb->stack_samples[ndx]);
+		copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+		totalsize += copysize;
+		buffer += copysize;
+		remaining -= copysize;
+	}
+
+	if (totalsize >= buflen) {
+		return totalsize;
+	}
+
+	linesize = snprintf(procfile->line, STATUS_LINELEN, "\n");
+	copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+	totalsize += copysize;
+	buffer += copysize;
+	remaining -= copysize;
+#endif
+
 	return totalsize;
 }
 
@@ -972,6 +1110,11 @@ static ssize_t proc_read(FAR struct file *filep, FAR char *buffer, size_t buflen
 	case PROC_LOADAVG:			/* Average CPU utilization */
 		ret = proc_loadavg(procfile, tcb, buffer, buflen, filep->f_pos);
 		break;
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+	case PROC_CPUTIME:			/* CPU cycles used */
+		ret = proc_cputime(procfile, tcb, buffer, buflen, filep->f_pos);
+		break;
 #endif
 	case PROC_STACK:			/* Task stack info */
 		ret = proc_stack(procfile, tcb, buffer, buflen, filep->f_pos);
@@ -374,6 +374,17 @@ static ssize_t romfs_read(FAR struct file *filep, FAR char *buffer, size_t bufle
 		buflen = bytesleft;
 	}
 
+	/* In XIP mode the whole file is in memory: copy it in one go rather
+	 * than sector by sector.
+	 */
+
+	if (rm->rm_xipbase) {
+		memcpy(userbuffer, rm->rm_xipbase + rf->rf_startoffset + filep->f_pos, buflen);
+		filep->f_pos += buflen;
+		romfs_semgive(rm);
+		return buflen;
+	}
+
 	/* Loop until either (1) all data has been transferred, or (2) an
 	 * error occurs.
 	 */
@@ -901,6 +912,14 @@ static int romfs_bind(FAR struct inode *blkdriver, FAR const void *data, FAR voi
 		goto errout_with_buffer;
 	}
 
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+	/* Index the directories.  Without the index, they are searched entry
+	 * by entry.
+	 */
+
+	(void)romfs_buildindex(rm);
+#endif
+
 	/* Mounted! */
 
 	*handle = (void *)rm;
@@ -971,6 +990,9 @@ static int romfs_unbind(FAR void *handle, FAR struct inode **blkdriver)
 
 		/* Release the mountpoint private data */
 
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+		romfs_freeindex(rm);
+#endif
 		if (!rm->rm_xipbase && rm->rm_buffer) {
 			kmm_free(rm->rm_buffer);
 		}
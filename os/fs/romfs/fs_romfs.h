@@ -146,6 +146,18 @@
  * Public Types
  ****************************************************************************/
 
+/* One entry of the directory index: the directory entry at offset, in the
+ * directory whose first entry is at dir, has a name hashing to hash.
+ */
+
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+struct romfs_indexent_s {
+	uint32_t hash;				/* Hash of dir and the name */
+	uint32_t dir;				/* Offset of the first entry of the directory */
+	uint32_t offset;			/* Offset of the entry header */
+};
+#endif
+
 /* This structure represents the overall mountpoint state.  An instance of this
  * structure is retained as inode private data on each mountpoint that is
  * mounted with a fat32 filesystem.
@@ -167,6 +179,11 @@ struct romfs_mountpt_s {
 	uint32_t rm_cachesector;	/* Current sector in the rm_buffer */
 	uint8_t *rm_xipbase;		/* Base address of directly accessible media */
 	uint8_t *rm_buffer;			/* Device sector buffer, allocated if rm_xipbase==0 */
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+	struct romfs_indexent_s *rm_index;	/* Every entry of the volume, NULL if not indexed */
+	uint16_t *rm_slots;			/* Hash table of rm_index positions + 1, 0 if free */
+	uint16_t rm_slotmask;		/* Number of slots - 1 */
+#endif
 };
 
 /* This structure represents on open file under the mountpoint.  An instance
@@ -228,6 +245,10 @@ EXTERN int romfs_finddirentry(struct romfs_mountpt_s *rm, struct romfs_dirinfo_s
 EXTERN int romfs_parsedirentry(struct romfs_mountpt_s *rm, uint32_t offset, uint32_t *poffset, uint32_t *pnext, uint32_t *pinfo, uint32_t *psize);
 EXTERN int romfs_parsefilename(struct romfs_mountpt_s *rm, uint32_t offset, char *pname);
 EXTERN int romfs_datastart(struct romfs_mountpt_s *rm, uint32_t offset, uint32_t *start);
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+EXTERN int romfs_buildindex(struct romfs_mountpt_s *rm);
+EXTERN void romfs_freeindex(struct romfs_mountpt_s *rm);
+#endif
 
 #undef EXTERN
 #if defined(__cplusplus)
@@ -74,6 +74,21 @@
 
 #include "fs_romfs.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+#ifndef CONFIG_FS_ROMFS_DIRINDEX_MAXENTRIES
+#define CONFIG_FS_ROMFS_DIRINDEX_MAXENTRIES 1024
+#endif
+
+/* FNV-1a */
+
+#define ROMFS_HASH_BASIS 2166136261u
+#define ROMFS_HASH_PRIME 16777619u
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -289,6 +304,70 @@ static int romfs_followhardlinks(struct romfs_mountpt_s *rm, uint32_t offset, ui
 	return -ELOOP;
 }
 
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+/****************************************************************************
+ * Name: romfs_hashname
+ *
+ * Desciption:
+ *   Hash the name of an entry together with the offset of the first entry
+ *   of its directory.
+ *
+ ****************************************************************************/
+
+static uint32_t romfs_hashname(uint32_t dir, const char *name, int namelen)
+{
+	uint32_t hash = ROMFS_HASH_BASIS;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		hash = (hash ^ (dir & 0xff)) * ROMFS_HASH_PRIME;
+		dir >>= 8;
+	}
+
+	for (i = 0; i < namelen; i++) {
+		hash = (hash ^ (uint8_t)name[i]) * ROMFS_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+/****************************************************************************
+ * Name: romfs_searchindex
+ *
+ * Desciption:
+ *   romfs_searchdir() with the directory index: only the entries of the
+ *   directory whose name hashes the same are read from the media.
+ *
+ ****************************************************************************/
+
+static int romfs_searchindex(struct romfs_mountpt_s *rm, const char *entryname, int entrylen, struct romfs_dirinfo_s *dirinfo)
+{
+	struct romfs_indexent_s *entry;
+	uint32_t dir = dirinfo->rd_dir.fr_firstoffset;
+	uint32_t hash;
+	uint32_t slot;
+	int ret;
+
+	hash = romfs_hashname(dir, entryname, entrylen);
+
+	/* The entries with the same hash were inserted in the order of the
+	 * directories, so the first match is the one romfs_searchdir() finds.
+	 */
+
+	for (slot = hash & rm->rm_slotmask; rm->rm_slots[slot] != 0; slot = (slot + 1) & rm->rm_slotmask) {
+		entry = &rm->rm_index[rm->rm_slots[slot] - 1];
+		if (entry->hash == hash && entry->dir == dir) {
+			ret = romfs_checkentry(rm, entry->offset, entryname, entrylen, dirinfo);
+			if (ret == OK) {
+				return OK;
+			}
+		}
+	}
+
+	return -ENOENT;
+}
+#endif
+
 /****************************************************************************
  * Name: romfs_searchdir
  *
@@ -305,6 +384,14 @@ static inline int romfs_searchdir(struct romfs_mountpt_s *rm, const char *entryn
 	int16_t ndx;
 	int ret;
 
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+	/* Every directory is in the index, if there is one */
+
+	if (rm->rm_index) {
+		return romfs_searchindex(rm, entryname, entrylen, dirinfo);
+	}
+#endif
+
 	/* Then loop through the current directory until the directory
 	 * with the matching name is found.  Or until all of the entries
 	 * the directory have been examined.
@@ -908,3 +995,163 @@ int romfs_datastart(struct romfs_mountpt_s *rm, uint32_t offset, uint32_t *start
 
 	return -EINVAL;				/* Won't get here */
 }
+
+#ifdef CONFIG_FS_ROMFS_DIRINDEX
+/****************************************************************************
+ * Name: romfs_buildindex
+ *
+ * Desciption:
+ *   This function is called as part of the ROMFS mount operation.  It
+ *   walks every directory of the volume, breadth first, and builds the
+ *   hash table romfs_searchdir() uses instead of reading each directory.
+ *   The volume is left unindexed if it has more than
+ *   CONFIG_FS_ROMFS_DIRINDEX_MAXENTRIES entries.
+ *
+ ****************************************************************************/
+
+int romfs_buildindex(struct romfs_mountpt_s *rm)
+{
+	struct romfs_indexent_s *index = NULL;
+	struct romfs_indexent_s *tmp;
+	char name[NAME_MAX + 1];
+	uint32_t linkoffset;
+	uint32_t offset;
+	uint32_t dir;
+	uint32_t next;
+	uint32_t info;
+	uint32_t size;
+	uint32_t slot;
+	int nentries = 0;
+	int nalloc = 0;
+	int nslots;
+	int walked = 0;
+	int16_t ndx;
+	int ret;
+	int i;
+
+	dir = rm->rm_rootoffset;
+	for (;;) {
+		/* Add every file and directory entry of dir to the index */
+
+		offset = dir;
+		do {
+			/* Entries that cannot be parsed, as broken hard links, are
+			 * skipped: romfs_searchdir() never matches them either.
+			 */
+
+			ret = romfs_parsedirentry(rm, offset, &linkoffset, &next, &info, &size);
+			if (ret < 0) {
+				ndx = romfs_devcacheread(rm, offset);
+				if (ndx < 0) {
+					ret = ndx;
+					goto errout;
+				}
+
+				next = romfs_devread32(rm, ndx + ROMFS_FHDR_NEXT);
+			} else if (IS_DIRECTORY(next) || IS_FILE(next)) {
+				if (nentries >= CONFIG_FS_ROMFS_DIRINDEX_MAXENTRIES) {
+					ret = -E2BIG;
+					goto errout;
+				}
+
+				if (nentries == nalloc) {
+					nalloc = nalloc ? 2 * nalloc : 32;
+					tmp = (struct romfs_indexent_s *)kmm_realloc(index, nalloc * sizeof(struct romfs_indexent_s));
+					if (!tmp) {
+						ret = -ENOMEM;
+						goto errout;
+					}
+
+					index = tmp;
+				}
+
+				ret = romfs_parsefilename(rm, offset, name);
+				if (ret < 0) {
+					goto errout;
+				}
+
+				index[nentries].hash = romfs_hashname(dir, name, strlen(name));
+				index[nentries].dir = dir;
+				index[nentries].offset = offset;
+				nentries++;
+			}
+
+			offset = next & RFNEXT_OFFSETMASK;
+		} while (offset != 0);
+
+		/* Then walk the next directory that was added.  Hard links, as
+		 * "." and "..", and directories already walked are skipped.
+		 */
+
+		dir = 0;
+		while (walked < nentries && dir == 0) {
+			ndx = romfs_devcacheread(rm, index[walked].offset);
+			if (ndx < 0) {
+				ret = ndx;
+				goto errout;
+			}
+
+			if (IS_DIRECTORY(romfs_devread32(rm, ndx + ROMFS_FHDR_NEXT))) {
+				dir = romfs_devread32(rm, ndx + ROMFS_FHDR_INFO);
+				for (i = 0; i < nentries && dir != 0; i++) {
+					if (index[i].dir == dir) {
+						dir = 0;
+					}
+				}
+			}
+
+			walked++;
+		}
+
+		if (dir == 0) {
+			break;
+		}
+	}
+
+	/* Size the hash table for a load of one half at most */
+
+	for (nslots = 16; nslots < 2 * nentries; nslots <<= 1) ;
+
+	rm->rm_slots = (uint16_t *)kmm_zalloc(nslots * sizeof(uint16_t));
+	if (!rm->rm_slots) {
+		ret = -ENOMEM;
+		goto errout;
+	}
+
+	for (i = 0; i < nentries; i++) {
+		for (slot = index[i].hash & (nslots - 1); rm->rm_slots[slot] != 0; slot = (slot + 1) & (nslots - 1)) ;
+		rm->rm_slots[slot] = i + 1;
+	}
+
+	rm->rm_index = index;
+	rm->rm_slotmask = nslots - 1;
+	fvdbg("Indexed %d entries in %d slots\n", nentries, nslots);
+	return OK;
+
+errout:
+	fdbg("Not indexed: %d\n", ret);
+	if (index) {
+		kmm_free(index);
+	}
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: romfs_freeindex
+ *
+ * Desciption:
+ *   Free the directory index on unmount.
+ *
+ ****************************************************************************/
+
+void romfs_freeindex(struct romfs_mountpt_s *rm)
+{
+	if (rm->rm_index) {
+		kmm_free(rm->rm_index);
+		kmm_free(rm->rm_slots);
+		rm->rm_index = NULL;
+		rm->rm_slots = NULL;
+	}
+}
+#endif
@@ -169,6 +169,43 @@ int mq_setattr(mqd_t mqdes, FAR const struct mq_attr *mq_stat, FAR struct mq_att
  */
 int mq_getattr(mqd_t mqdes, FAR struct mq_attr *mq_stat);
 
+#ifdef CONFIG_MQ_ZEROCOPY
+/* Non-standard interfaces passing messages by reference.  A buffer taken
+ * from the shared pool with mq_bufalloc() belongs to the message queue once
+ * it is sent with mq_sendbuf(), and to the receiver once mq_receivebuf()
+ * returns it; the receiver gives it back with mq_buffree().
+ */
+
+/**
+ * @brief  Take a buffer of at least size bytes from the shared message buffer pool
+ * @details [NON-STANDARD API] Returns NULL with errno EMSGSIZE if size exceeds
+ *          CONFIG_MQ_ZEROCOPY_BUFSIZE, or ENOMEM if the pool is empty.
+ * @since Tizen RT v1.0
+ */
+FAR void *mq_bufalloc(size_t size);
+/**
+ * @brief  Give back a buffer obtained from mq_bufalloc() or mq_receivebuf()
+ * @details [NON-STANDARD API]
+ * @since Tizen RT v1.0
+ */
+void mq_buffree(FAR void *buf);
+/**
+ * @brief  Queue a buffer from mq_bufalloc() holding buflen bytes, without copying it
+ * @details [NON-STANDARD API] Fails as mq_send() does; the buffer still belongs
+ *          to the caller then.
+ * @since Tizen RT v1.0
+ */
+int mq_sendbuf(mqd_t mqdes, FAR void *buf, size_t buflen, int prio);
+/**
+ * @brief  Take the next message and return its buffer in *buf
+ * @details [NON-STANDARD API] Returns the length of the message.  A message sent
+ *          with mq_send() is copied into a new buffer.  Fails as mq_receive()
+ *          does, or with ENOMEM if no buffer is left for a copied message.
+ * @since Tizen RT v1.0
+ */
+ssize_t mq_receivebuf(mqd_t mqdes, FAR void **buf, FAR int *prio);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -147,6 +147,19 @@ struct api_msg_msg;
 typedef void (*netconn_callback)(struct netconn *, enum netconn_evt, u16_t len);
 
 /** A netconn descriptor */
+/** Called in tcpip_thread context when the data of a zero-copy write has been
+    acknowledged by the peer (err == ERR_OK) or the connection was lost. */
+typedef void (*netconn_sent_fn)(void *arg, err_t err);
+
+/** A zero-copy write whose data still references the application buffer */
+struct netconn_zc_req {
+	struct netconn_zc_req *next;
+	/** sequence number following the last byte of the write */
+	u32_t end_seq;
+	netconn_sent_fn sent;
+	void *arg;
+};
+
 struct netconn {
 	/** type of the netconn (TCP, UDP or RAW) */
 	enum netconn_type type;
@@ -208,6 +221,10 @@ struct netconn {
 	    Also used during connect and close. */
 	struct api_msg_msg *current_msg;
 #endif							/* LWIP_TCP */
+#if LWIP_NETCONN_ZEROCOPY_TX
+	/** TCP: zero-copy writes not yet acknowledged, oldest first */
+	struct netconn_zc_req *zc_pending;
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 	/** A callback function that is informed about events for this netconn */
 	netconn_callback callback;
 };
@@ -256,6 +273,9 @@ err_t netconn_send(struct netconn *conn, struct netbuf *buf);
 err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written);
 #define netconn_write(conn, dataptr, size, apiflags) \
 	netconn_write_partly(conn, dataptr, size, apiflags, NULL)
+#if LWIP_NETCONN_ZEROCOPY_TX
+err_t netconn_write_zc(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written, netconn_sent_fn sent, void *arg);
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 err_t netconn_close(struct netconn *conn);
 err_t netconn_shutdown(struct netconn *conn, u8_t shut_rx, u8_t shut_tx);
 
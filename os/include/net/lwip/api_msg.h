@@ -109,6 +109,10 @@ struct api_msg_msg {
 #if LWIP_SO_SNDTIMEO
 			systime_t time_started;
 #endif							/* LWIP_SO_SNDTIMEO */
+#if LWIP_NETCONN_ZEROCOPY_TX
+			/** completion record for zero-copy writes, taken over by do_writemore */
+			struct netconn_zc_req *zc_req;
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 		} w;
 		/** used for do_recv */
 		struct {
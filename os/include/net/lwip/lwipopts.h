@@ -144,6 +144,19 @@
 #define IP_DEFAULT_TTL                 CONFIG_NET_IP_DEFAULT_TTL
 #endif
 
+#ifdef CONFIG_NET_LWIP_CHKSUM_ALGORITHM
+#define LWIP_CHKSUM_ALGORITHM          CONFIG_NET_LWIP_CHKSUM_ALGORITHM
+#endif
+
+#ifdef CONFIG_NET_LWIP_CHECKSUM_ON_COPY
+#define LWIP_CHECKSUM_ON_COPY          1
+#define LWIP_CHKSUM_COPY_ALGORITHM     2
+#endif
+
+#ifdef CONFIG_NET_LWIP_NETIF_TX_SINGLE_PBUF
+#define LWIP_NETIF_TX_SINGLE_PBUF      1
+#endif
+
 /* ---------- IP options ---------- */
 
 
@@ -494,6 +507,18 @@
 #define SO_REUSE	CONFIG_NET_SO_REUSE
 #endif
 
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_RECV
+#define LWIP_SOCKET_ZEROCOPY_RECV	CONFIG_NET_SOCKET_ZEROCOPY_RECV
+#endif
+
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+#define LWIP_NETCONN_ZEROCOPY_TX	CONFIG_NET_SOCKET_ZEROCOPY_SEND
+#endif
+
+#ifdef CONFIG_NET_SOCKET_SENDMSG
+#define LWIP_SOCKET_SENDMSG	CONFIG_NET_SOCKET_SENDMSG
+#endif
+
 #ifdef CONFIG_NET_SO_REUSE_RXTOALL
 #define SO_REUSE_RXTOALL	CONFIG_NET_SO_REUSE_RXTOALL
 #endif
@@ -1448,6 +1448,31 @@
 #define LWIP_SO_RCVTIMEO                0
 #endif
 
+/**
+ * LWIP_SOCKET_ZEROCOPY_RECV==1: Enable lwip_recv_zc() and
+ * lwip_recv_zc_release(), which lend received pbuf payloads to the
+ * application instead of copying them out.
+ */
+#ifndef LWIP_SOCKET_ZEROCOPY_RECV
+#define LWIP_SOCKET_ZEROCOPY_RECV       0
+#endif
+
+/**
+ * LWIP_NETCONN_ZEROCOPY_TX==1: Enable netconn_write_zc() and lwip_send_zc(),
+ * which queue application buffers by reference and report when the peer
+ * has acknowledged them.
+ */
+#ifndef LWIP_NETCONN_ZEROCOPY_TX
+#define LWIP_NETCONN_ZEROCOPY_TX        0
+#endif
+
+/**
+ * LWIP_SOCKET_SENDMSG==1: Enable lwip_sendmsg() (scatter-gather transmit).
+ */
+#ifndef LWIP_SOCKET_SENDMSG
+#define LWIP_SOCKET_SENDMSG             0
+#endif
+
 /**
  * LWIP_SO_RCVBUF==1: Enable SO_RCVBUF processing.
  */
@@ -62,6 +62,12 @@
 #endif
 #include <sys/sock_internal.h>
 #include <netinet/in.h>
+#if LWIP_SOCKET_ZEROCOPY_RECV || LWIP_SOCKET_SENDMSG
+#include <uio.h>
+#endif
+#if LWIP_NETCONN_ZEROCOPY_TX
+#include <net/lwip/api.h>
+#endif
 
 #include <net/lwip/ipv4/ip_addr.h>
 #include <net/lwip/ipv4/inet.h>
@@ -241,6 +247,16 @@ int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptse
 int lwip_poll(int fd, struct pollfd *fds, bool setup);
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
+#if LWIP_SOCKET_ZEROCOPY_RECV
+int lwip_recv_zc(int s, struct iovec *iov, int *iovcnt, size_t len, int flags);
+int lwip_recv_zc_release(int s, size_t consumed);
+#endif							/* LWIP_SOCKET_ZEROCOPY_RECV */
+#if LWIP_SOCKET_SENDMSG
+int lwip_sendmsg(int s, const struct msghdr *msg, int flags);
+#endif							/* LWIP_SOCKET_SENDMSG */
+#if LWIP_NETCONN_ZEROCOPY_TX
+int lwip_send_zc(int s, const void *dataptr, size_t size, int flags, netconn_sent_fn sent, void *arg);
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 
 #if LWIP_POSIX_SOCKETS_IO_NAMES
 #define read(a, b, c)         lwip_read(a, b, c)
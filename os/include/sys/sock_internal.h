@@ -60,7 +60,7 @@
 #include <tinyara/config.h>
 #include <sys/types.h>
 
-#ifdef CONFIG_ENABLE_IOTIVITY
+#if defined(CONFIG_ENABLE_IOTIVITY) || defined(CONFIG_NET_SOCKET_SENDMSG)
 
 #include <uio.h>
 
@@ -115,7 +115,7 @@ static inline struct cmsghdr *cmsg_nxthdr(struct msghdr *__msg, struct cmsghdr *
 {
 	return __cmsg_nxthdr(__msg->msg_control, __msg->msg_controllen, __cmsg);
 }
-#endif							/* CONFIG_ENABLE_IOTIVITY */
+#endif							/* CONFIG_ENABLE_IOTIVITY || CONFIG_NET_SOCKET_SENDMSG */
 
 /****************************************************************************
  * Definitions
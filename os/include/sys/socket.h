@@ -257,6 +257,73 @@ int getsockname(int sockfd, FAR struct sockaddr *addr, FAR socklen_t *addrlen);
 */
 int getpeername(int s, struct sockaddr *name, socklen_t *namelen);
 
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_RECV
+/**
+* @brief   receive data on a socket without copying it
+*
+* @details The payload of the received pbufs is described by iov and stays owned
+*          by the socket. It remains valid until recv_zc_release() or another
+*          receive call is made on the same socket.
+* @param[in] sockfd the file descriptor of the socket
+* @param[out] iov array receiving the payload segments
+* @param[inout] iovcnt on input the number of entries in iov, on output the number of entries filled
+* @param[in] len maximum number of bytes to describe
+* @param[in] flags MSG_DONTWAIT is supported
+* @return On success, the number of bytes described by iov. 0 if the peer has closed the connection. On failure, -1 is returned.
+* @since Tizen RT v1.0
+*/
+ssize_t recv_zc(int sockfd, FAR struct iovec *iov, FAR int *iovcnt, size_t len, int flags);
+
+/**
+* @brief   release data lent by recv_zc()
+*
+* @param[in] sockfd the file descriptor of the socket
+* @param[in] consumed the number of bytes processed by the application. Stream sockets keep the rest for the next receive call.
+* @return On success, 0 is returned. On failure, -1 is returned.
+* @since Tizen RT v1.0
+*/
+int recv_zc_release(int sockfd, size_t consumed);
+#endif
+
+#ifdef CONFIG_NET_SOCKET_SENDMSG
+/**
+* @brief   send a message gathered from several buffers on a socket
+*
+* @details On stream sockets the buffers are queued as one stream. On datagram
+*          sockets they are sent as a single datagram to msg_name (or the
+*          connected peer if msg_name is NULL) without being copied first.
+* @param[in] sockfd the file descriptor of the socket
+* @param[in] msg message header describing the buffers and the destination
+* @param[in] flags MSG_DONTWAIT and MSG_MORE are supported
+* @return On success, the number of bytes sent. On failure, -1 is returned.
+* @since Tizen RT v1.0
+*/
+ssize_t sendmsg(int sockfd, FAR const struct msghdr *msg, int flags);
+#endif
+
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+/**
+* @brief   send data on a stream socket without copying it
+*
+* @details The buffer is referenced by the queued segments and must not be
+*          modified or freed until sent is called. sent runs in the network
+*          thread with ERR_OK once the peer has acknowledged the data, or with
+*          the connection error if the connection is lost first.
+* @param[in] sockfd the file descriptor of the socket
+* @param[in] buf the data to send
+* @param[in] len the number of bytes to send
+* @param[in] flags MSG_DONTWAIT and MSG_MORE are supported
+* @param[in] sent completion callback, may be NULL
+* @param[in] arg argument passed to sent
+* @return On success, the number of bytes queued, which may be less than len with
+*         MSG_DONTWAIT or if the connection failed during the write; sent is
+*         called for them. On failure, -1 is returned, nothing is queued and
+*         sent is not called.
+* @since Tizen RT v1.0
+*/
+ssize_t send_zc(int sockfd, FAR const void *buf, size_t len, int flags, netconn_sent_fn sent, FAR void *arg);
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
@@ -128,7 +128,6 @@
 #ifdef CONFIG_ENABLE_IOTIVITY
 
 typedef int wint_t;
-typedef unsigned long __kernel_size_t;
 typedef unsigned short __kernel_sa_family_t;
 typedef unsigned short __u16;
 
@@ -151,6 +150,9 @@ struct ifinfomsg {
 };
 #endif
 
+/* Used by struct iovec and struct msghdr */
+
+typedef unsigned long __kernel_size_t;
 typedef unsigned int __u32;
 
 /* Floating point types */
@@ -1785,6 +1785,9 @@ void irq_dispatch(int irq, FAR void *context);
  *   stack memory for a high water mark.  That is, the deepest level of the
  *   stack that clobbered some recognizable marker in the stack memory.
  *
+ *   up_check_tcbstack() keeps the mark in tcb->stack_hwm and the next check
+ *   only searches below it (see CONFIG_STACK_COLORATION_GAP).
+ *
  * Input Parameters:
  *   None
  *
@@ -1805,6 +1808,22 @@ size_t up_check_intstack_remain(void);
 #endif
 #endif
 
+/****************************************************************************
+ * Name: up_cpuacct_initialize and up_cpuacct_cycles
+ *
+ * Description:
+ *   Start the free running 32-bit cycle counter of the CPU and read it.
+ *   Used by CONFIG_SCHED_CPUACCT to account the cycles spent by each
+ *   thread and interrupt handler.  up_cpuacct_cycles() is called on every
+ *   context switch and interrupt, and must be fast.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CPUACCT
+void up_cpuacct_initialize(void);
+uint32_t up_cpuacct_cycles(void);
+#endif
+
 /****************************************************************************
  * Name: up_rtc_initialize
  *
@@ -0,0 +1,247 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * include/tinyara/bcache.h
+ *
+ * A set associative, write-back LRU cache of the blocks of a block device.
+ * rwbuffer and BCH use one per device when CONFIG_DRVR_BCACHE is selected.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_TINYARA_BCACHE_H
+#define __INCLUDE_TINYARA_BCACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <semaphore.h>
+#include <tinyara/wqueue.h>
+
+#ifdef CONFIG_DRVR_BCACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_DRVR_BCACHE_SIZE
+#define CONFIG_DRVR_BCACHE_SIZE 8
+#endif
+
+#ifndef CONFIG_DRVR_BCACHE_WAYS
+#define CONFIG_DRVR_BCACHE_WAYS 4
+#endif
+
+#ifndef CONFIG_DRVR_BCACHE_XFERBLOCKS
+#define CONFIG_DRVR_BCACHE_XFERBLOCKS 8
+#endif
+
+#ifndef CONFIG_DRVR_BCACHE_STREAMS
+#define CONFIG_DRVR_BCACHE_STREAMS 4
+#endif
+
+#ifndef CONFIG_DRVR_BCACHE_WRDELAY
+#define CONFIG_DRVR_BCACHE_WRDELAY 350
+#endif
+
+#define BCACHE_NAMELEN 16
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Transfers to and from the device, in whole blocks.  Both return the
+ * number of blocks transferred or a negated errno value.
+ */
+
+typedef ssize_t (*bcache_read_t)(FAR void *dev, FAR uint8_t *buffer, off_t startblock, size_t nblocks);
+typedef ssize_t (*bcache_write_t)(FAR void *dev, FAR const uint8_t *buffer, off_t startblock, size_t nblocks);
+
+/* Counters, in blocks unless noted */
+
+struct bcache_stats_s {
+	uint32_t hits;				/* Blocks read or written in the cache */
+	uint32_t misses;			/* Blocks that had to be read from the device */
+	uint32_t rablocks;			/* Blocks read ahead */
+	uint32_t rahits;			/* Blocks read ahead and then used */
+	uint32_t wrblocks;			/* Blocks written to the device */
+	uint32_t wrcalls;			/* Writes to the device (calls) */
+};
+
+/* A sequential reader: the block it is expected to read next and how far
+ * ahead of it to read.
+ */
+
+struct bcache_stream_s {
+	off_t next;					/* Block after the last one read */
+	uint16_t window;			/* Blocks to read ahead, 0 until sequential */
+	uint32_t stamp;				/* Last use, for replacement */
+};
+
+struct bcache_slot_s;
+
+/* The cache of one device.  The user provides the first fields and calls
+ * bcache_initialize():
+ *
+ *   priv->cache.blocksize = ...;
+ *   priv->cache.nblocks   = ...;
+ *   priv->cache.dev       = priv;
+ *   priv->cache.read      = foo_readblocks;
+ *   priv->cache.write     = foo_writeblocks;
+ *   ret = bcache_initialize(&priv->cache, "foo");
+ */
+
+struct bcache_s {
+	/* These values must be provided by the user */
+
+	uint16_t blocksize;			/* The size of one block */
+	size_t nblocks;				/* The total number blocks of the device */
+	FAR void *dev;				/* Passed to read and write */
+	bcache_read_t read;			/* Reads blocks from the device */
+	bcache_write_t write;		/* Writes blocks to the device, or NULL */
+
+	/* The user should never modify any of the remaining fields */
+
+	FAR struct bcache_s *flink;	/* Next cache, for /proc/bcache */
+	char name[BCACHE_NAMELEN];	/* Device name, for /proc/bcache */
+	sem_t sem;					/* Exclusive access to the cache */
+	FAR struct bcache_slot_s *slots;	/* nsets * CONFIG_DRVR_BCACHE_WAYS slots */
+	FAR uint8_t *data;			/* The data of the slots, in the same order */
+	FAR uint8_t *xfer;			/* Coalesced write-back and read-ahead */
+	size_t nsets;				/* Number of sets */
+	uint16_t xferblocks;		/* Size of xfer in blocks */
+	uint32_t clock;				/* Incremented on each use of a slot */
+	struct work_s work;			/* Delayed write-back */
+	uint8_t wbqueued;			/* work queued and not finished yet */
+	uint8_t closing;			/* bcache_uninitialize() has started */
+	sem_t wbdone;				/* Posted when work finishes while closing */
+#ifdef CONFIG_DRVR_BCACHE_READAHEAD
+	struct bcache_stream_s streams[CONFIG_DRVR_BCACHE_STREAMS];
+#endif
+	struct bcache_stats_s stats;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C" {
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: bcache_initialize
+ *
+ * Description:
+ *   Allocate CONFIG_DRVR_BCACHE_SIZE KB of blocks for the cache of a device
+ *   and list it in /proc/bcache under name.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOMEM if the cache cannot be allocated.
+ *
+ ****************************************************************************/
+
+int bcache_initialize(FAR struct bcache_s *bc, FAR const char *name);
+
+/****************************************************************************
+ * Name: bcache_uninitialize
+ *
+ * Description:
+ *   Write the dirty blocks back and free the cache.
+ *
+ ****************************************************************************/
+
+void bcache_uninitialize(FAR struct bcache_s *bc);
+
+/****************************************************************************
+ * Name: bcache_read, bcache_write
+ *
+ * Description:
+ *   Block oriented transfers through the cache, with the same arguments and
+ *   return values as the read and write methods of a block driver.
+ *   Transfers larger than CONFIG_DRVR_BCACHE_XFERBLOCKS go straight to the
+ *   device.
+ *
+ ****************************************************************************/
+
+ssize_t bcache_read(FAR struct bcache_s *bc, off_t startblock, size_t nblocks, FAR uint8_t *buffer);
+ssize_t bcache_write(FAR struct bcache_s *bc, off_t startblock, size_t nblocks, FAR const uint8_t *buffer);
+
+/****************************************************************************
+ * Name: bcache_readbytes, bcache_writebytes
+ *
+ * Description:
+ *   Byte oriented transfers through the cache.  Partial blocks are read
+ *   into the cache and, for writes, modified there.
+ *
+ * Returned Value:
+ *   The number of bytes transferred, which is less than nbytes at the end
+ *   of the device, or a negated errno value.
+ *
+ ****************************************************************************/
+
+ssize_t bcache_readbytes(FAR struct bcache_s *bc, off_t offset, size_t nbytes, FAR uint8_t *buffer);
+ssize_t bcache_writebytes(FAR struct bcache_s *bc, off_t offset, size_t nbytes, FAR const uint8_t *buffer);
+
+/****************************************************************************
+ * Name: bcache_flush
+ *
+ * Description:
+ *   Write all dirty blocks back to the device.
+ *
+ ****************************************************************************/
+
+int bcache_flush(FAR struct bcache_s *bc);
+
+/****************************************************************************
+ * Name: bcache_invalidate
+ *
+ * Description:
+ *   Drop the cached copies of a range of blocks, dirty or not, as when the
+ *   media is erased or removed.
+ *
+ ****************************************************************************/
+
+int bcache_invalidate(FAR struct bcache_s *bc, off_t startblock, size_t nblocks);
+
+/****************************************************************************
+ * Name: bcache_foreach
+ *
+ * Description:
+ *   Call handler for each cache with the scheduler locked, as for
+ *   /proc/bcache.  handler must not block.
+ *
+ ****************************************************************************/
+
+void bcache_foreach(void (*handler)(FAR struct bcache_s *bc, FAR void *arg), FAR void *arg);
+
+#undef EXTERN
+#if defined(__cplusplus)
+}
+#endif
+
+#endif							/* CONFIG_DRVR_BCACHE */
+#endif							/* __INCLUDE_TINYARA_BCACHE_H */
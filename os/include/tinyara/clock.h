@@ -203,6 +203,18 @@ struct cpuload_s {
 };
 #endif
 
+/* This structure is used to report the CPU cycles used by a particular
+ * thread or interrupt
+ */
+
+#ifdef CONFIG_SCHED_CPUACCT
+struct cpuacct_s {
+	uint64_t total;				/* Cycles accounted to all threads and interrupts */
+	uint64_t active;			/* Cycles accounted to this thread or interrupt */
+	uint32_t count;				/* Times it was switched to or raised */
+};
+#endif
+
 /* This type is the natural with of the system timer */
 
 #ifdef CONFIG_SYSTEM_TIME64
@@ -369,6 +381,35 @@ int clock_cpuload(int pid, FAR struct cpuload_s *cpuload);
  */
 #endif
 
+/****************************************************************************
+ * Function:  clock_cpuacct and clock_irqacct
+ *
+ * Description:
+ *   Return the CPU cycles accounted to the select PID or IRQ number.
+ *
+ * Parameters:
+ *   pid - The task ID of the thread of interest.  pid == 0 is the IDLE thread.
+ *   irq - The number of the interrupt of interest.
+ *   cpuacct - The location to return the cycles
+ *
+ * Return Value:
+ *   OK (0) on success; -ESRCH if 'pid' does not refer to a valid thread or
+ *   -EINVAL if 'irq' is not a valid IRQ number.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CPUACCT
+/**
+ * @cond
+ * @internal
+ */
+int clock_cpuacct(int pid, FAR struct cpuacct_s *cpuacct);
+int clock_irqacct(int irq, FAR struct cpuacct_s *cpuacct);
+/**
+ * @endcond
+ */
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
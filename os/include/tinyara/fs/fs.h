@@ -344,6 +344,16 @@ struct statfs;					/* Forward reference */
 typedef int (*foreach_mountpoint_t)(FAR const char *mountpoint, FAR struct statfs *statbuf, FAR void *arg);
 #endif
 
+/* Counters of the path lookup cache of the inode tree */
+
+#ifdef CONFIG_FS_INODE_CACHE
+struct inode_cachestats_s {
+	uint32_t hits;				/* Lookups answered by the cache */
+	uint32_t misses;			/* Lookups that walked the tree */
+	uint32_t flushes;			/* Times the cache was emptied */
+};
+#endif
+
 /****************************************************************************
  * Global Function Prototypes
  ****************************************************************************/
@@ -480,6 +490,19 @@ int unregister_blockdriver(const char *path);
 
 int inode_checkflags(FAR struct inode *inode, int oflags);
 
+/* fs_inodecache.c **********************************************************/
+/****************************************************************************
+ * Name: inode_getcachestats
+ *
+ * Description:
+ *   Return the counters of the path lookup cache.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_CACHE
+void inode_getcachestats(FAR struct inode_cachestats_s *stats);
+#endif
+
 /* fs_files.c ***************************************************************/
 /****************************************************************************
  * Name: files_initlist
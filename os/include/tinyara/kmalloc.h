@@ -122,10 +122,22 @@ extern "C" {
  * directly callable.
  */
 
+#ifdef CONFIG_MM_SUBHEAP
+/* The kernel allocates user memory, such as task stacks, for the task
+ * that happens to be running.  It must not come from the sub-heap that
+ * task is bound to; see kmm_malloc() below.
+ */
+
+#define kumm_malloc(s)          kmm_malloc(s)
+#define kumm_zalloc(s)          kmm_zalloc(s)
+#define kumm_realloc(p, s)      kmm_realloc(p, s)
+#define kumm_memalign(a, s)     kmm_memalign(a, s)
+#else
 #define kumm_malloc(s)          malloc(s)
 #define kumm_zalloc(s)          zalloc(s)
 #define kumm_realloc(p, s)      realloc(p, s)
 #define kumm_memalign(a, s)     memalign(a, s)
+#endif
 #define kumm_free(p)            free(p)
 #define kumm_mallinfo()         mallinfo()
 
@@ -143,10 +155,22 @@ extern "C" {
 #define kmm_trysemaphore()     umm_trysemaphore()
 #define kmm_givesemaphore()    umm_givesemaphore()
 
+#ifdef CONFIG_MM_SUBHEAP
+/* Kernel memory comes from the user heap itself, never from the sub-heap
+ * the calling task is bound to, which may be reset under it.  These are
+ * in umm_subheap.c.
+ */
+
+FAR void *kmm_malloc(size_t size);
+FAR void *kmm_zalloc(size_t size);
+FAR void *kmm_realloc(FAR void *oldmem, size_t newsize);
+FAR void *kmm_memalign(size_t alignment, size_t size);
+#else
 #define kmm_malloc(s)          malloc(s)
 #define kmm_zalloc(s)          zalloc(s)
 #define kmm_realloc(p, s)      realloc(p, s)
 #define kmm_memalign(a, s)     memalign(a, s)
+#endif
 #define kmm_free(p)            free(p)
 #define kmm_mallinfo()         mallinfo()
 
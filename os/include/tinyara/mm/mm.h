@@ -292,6 +292,20 @@ struct mm_freenode_s {
 #define CHECK_FREENODE_SIZE \
 	DEBUGASSERT(sizeof(struct mm_freenode_s) == SIZEOF_MM_FREENODE)
 
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+/* This describes the allocations made from one caller address.  Sizes are
+ * chunk sizes, allocation node included, as in the rest of the heap info.
+ */
+
+struct mm_heapsite_s {
+	mmaddress_t addr;			/* malloc caller address, 0 for the others */
+	uint32_t live_size;			/* Bytes currently allocated */
+	uint32_t live_count;		/* Chunks currently allocated */
+	uint32_t peak_size;			/* Largest live_size seen */
+	uint32_t total_count;		/* Allocations made so far */
+};
+#endif
+
 /* This describes one heap (possibly with multiple regions) */
 
 struct mm_heap_s {
@@ -310,6 +324,11 @@ struct mm_heap_s {
 	int peak_alloc_size;
 	int total_alloc_size;
 #endif
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+	/* Allocation sites, hashed by caller address, plus the overflow entry */
+
+	struct mm_heapsite_s mm_sites[CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES + 1];
+#endif
 
 	/* This is the first and last nodes of the heap */
 
@@ -328,6 +347,21 @@ struct mm_heap_s {
 	struct mm_freenode_s mm_nodelist[MM_NNODES];
 };
 
+#ifdef CONFIG_MM_SUBHEAP
+/* This describes one sub-heap.  It is the head of the chunk allocated for
+ * it from the parent heap; the memory it manages follows it.
+ */
+
+struct mm_subheap_s {
+	FAR struct mm_subheap_s *flink;	/* Next sub-heap, for address lookups */
+	FAR struct mm_heap_s *parent;	/* Heap the sub-heap was carved from */
+	FAR void *start;			/* Memory managed by the sub-heap */
+	size_t size;				/* and its size */
+	unsigned int nresets;		/* Number of mm_subheap_reset() */
+	struct mm_heap_s heap;		/* The sub-heap itself */
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -369,6 +403,7 @@ EXTERN struct mm_heap_s g_kmmheap;
 
 void mm_initialize(FAR struct mm_heap_s *heap, FAR void *heap_start, size_t heap_size);
 void mm_addregion(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heapsize);
+void mm_reset(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heapsize);
 
 /* Functions contained in umm_initialize.c **********************************/
 
@@ -578,6 +613,27 @@ int kmm_mallinfo(struct mallinfo *info);
 #endif
 #endif							/* CONFIG_CAN_PASS_STRUCTS */
 
+/* Functions contained in mm_subheap.c **************************************/
+
+#ifdef CONFIG_MM_SUBHEAP
+FAR struct mm_subheap_s *mm_subheap_create(FAR struct mm_heap_s *parent, size_t size);
+void mm_subheap_destroy(FAR struct mm_subheap_s *subheap);
+void mm_subheap_reset(FAR struct mm_subheap_s *subheap);
+int mm_subheap_mallinfo(FAR struct mm_subheap_s *subheap, FAR struct mallinfo *info);
+int mm_subheap_bind(pid_t pid, FAR struct mm_subheap_s *subheap);
+FAR struct mm_subheap_s *mm_subheap_member(FAR void *mem);
+FAR struct mm_heap_s *mm_subheap_allocheap(FAR struct mm_heap_s *heap);
+FAR struct mm_heap_s *mm_subheap_ownerheap(FAR struct mm_heap_s *heap, FAR void *mem);
+
+/* The heap a user allocation comes from, and the heap a chunk goes back to */
+
+#define UMM_ALLOCHEAP(heap)      mm_subheap_allocheap(heap)
+#define UMM_OWNERHEAP(heap, mem) mm_subheap_ownerheap(heap, mem)
+#else
+#define UMM_ALLOCHEAP(heap)      (heap)
+#define UMM_OWNERHEAP(heap, mem) (heap)
+#endif
+
 /* Functions contained in mm_shrinkchunk.c **********************************/
 
 void mm_shrinkchunk(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node, size_t size);
@@ -601,6 +657,19 @@ void heapinfo_subtract_size(int16_t pid, size_t size);
 void heapinfo_update_total_size(struct mm_heap_s *heap, int size);
 #endif
 
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+/* Functions to account a chunk to the allocation site recorded in it */
+void heapinfo_profile_add(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node);
+void heapinfo_profile_subtract(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node);
+void heapinfo_profile_resize(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node);
+/* Function to copy the allocation sites in use without stalling allocators */
+int heapinfo_profile_snapshot(FAR struct mm_heap_s *heap, FAR struct mm_heapsite_s *sites, int nsites);
+#elif defined(CONFIG_DEBUG_MM_HEAPINFO)
+#define heapinfo_profile_add(heap, node)
+#define heapinfo_profile_subtract(heap, node)
+#define heapinfo_profile_resize(heap, node)
+#endif
+
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 /* Functions to get heap information */
 struct mm_heap_s *mm_get_heap_info(void);
@@ -72,6 +72,14 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+#ifndef CONFIG_MQ_PRIO_BUCKETS
+#define CONFIG_MQ_PRIO_BUCKETS 8
+#endif
+
+#if CONFIG_MQ_PRIO_BUCKETS < 1 || CONFIG_MQ_PRIO_BUCKETS > 32
+#error "CONFIG_MQ_PRIO_BUCKETS must be 1 to 32"
+#endif
+
 /****************************************************************************
  * Global Type Declarations
  ****************************************************************************/
@@ -82,7 +90,8 @@ struct mq_des;					/* forward reference */
 
 struct mqueue_inode_s {
 	FAR struct inode *inode;	/* Containing inode */
-	sq_queue_t msglist;			/* Prioritized message list */
+	sq_queue_t msglist[CONFIG_MQ_PRIO_BUCKETS];	/* Prioritized message lists, by priority range */
+	uint32_t msgmap;			/* Bit n is set if msglist[n] is not empty */
 	int16_t maxmsgs;			/* Maximum number of messages in the queue */
 	int16_t nmsgs;				/* Number of message in the queue */
 	int16_t nwaitnotfull;		/* Number tasks waiting for not full */
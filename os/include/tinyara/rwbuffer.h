@@ -62,6 +62,7 @@
 #include <stdint.h>
 #include <semaphore.h>
 #include <tinyara/wqueue.h>
+#include <tinyara/bcache.h>
 
 #if defined(CONFIG_DRVR_WRITEBUFFER) || defined(CONFIG_DRVR_READAHEAD)
 
@@ -119,7 +120,8 @@ struct rwbuffer_s {
 
 	/* Read-ahead/Write buffer sizes.  Buffering can be disabled (even if it
 	 * is enabled in the configuration) by setting the buffer size to zero
-	 * blocks.
+	 * blocks.  With CONFIG_DRVR_BCACHE, both buffers are replaced by the
+	 * block cache and these sizes are ignored.
 	 */
 
 #ifdef CONFIG_DRVR_WRITEBUFFER
@@ -146,6 +148,10 @@ struct rwbuffer_s {
 	/********************************************************************/
 	/* The user should never modify any of the remaining fields */
 
+#ifdef CONFIG_DRVR_BCACHE
+	struct bcache_s cache;		/* Block cache, in place of the buffers */
+#endif
+
 	/* This is the state of the write buffering */
 
 #ifdef CONFIG_DRVR_WRITEBUFFER
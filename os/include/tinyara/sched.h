@@ -520,6 +520,11 @@ struct tcb_s {
 #endif
 	FAR struct wdog_s *waitdog;	/* All timed waits used this wdog      */
 
+#ifdef CONFIG_SCHED_CPUACCT
+	uint64_t cpuacct_cycles;	/* CPU cycles used by the thread       */
+	uint32_t cpuacct_count;		/* Times it was switched to            */
+#endif
+
 	/* Stack-Related Fields ****************************************************** */
 
 	size_t adj_stack_size;		/* Stack size after adjustment         */
@@ -529,6 +534,15 @@ struct tcb_s {
 	/* Need to deallocate stack            */
 	FAR void *adj_stack_ptr;	/* Adjusted stack_alloc_ptr for HW     */
 	/* The initial stack pointer value     */
+#ifdef CONFIG_STACK_COLORATION
+	size_t stack_hwm;			/* Stack used, as last checked         */
+#endif
+#ifdef CONFIG_SCHED_STACKSAMPLE
+	uint32_t stack_samples[CONFIG_SCHED_STACKSAMPLE_NSAMPLES];
+	/* stack_hwm of the last samples       */
+	uint8_t stack_nsamples;		/* Number of samples taken, saturated  */
+	uint8_t stack_sampleidx;	/* Where the next sample goes          */
+#endif
 
 #ifdef CONFIG_MPU_STACKGUARD
 	FAR void *stack_guard;          /* address of the stack guard */
@@ -579,6 +593,10 @@ struct tcb_s {
 	int peak_alloc_size;
 	int num_alloc_free;
 #endif
+
+#ifdef CONFIG_MM_SUBHEAP
+	FAR struct mm_subheap_s *subheap;	/* Sub-heap malloc() uses, NULL for the user heap */
+#endif
 };
 
 /* struct task_tcb_s *************************************************************/
@@ -588,7 +588,31 @@
 #define MULADDC_CANNOT_USE_R7
 #endif
 
-#if defined(__arm__) && !defined(MULADDC_CANNOT_USE_R7)
+#if defined(__arm__) && defined(__ARM_ARCH) && (__ARM_ARCH >= 6) && \
+	defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+/*
+ * ARMv6 and later with the DSP extension (Cortex-R4/R5, Cortex-M4/M7, ...):
+ * UMAAL computes r1 + c + b * r0 in a single instruction, leaving the high
+ * word in c, which is exactly one step of the multiply-accumulate loop.
+ * The compiler picks the registers, so no need to avoid r7.
+ */
+#define MULADDC_INIT                                    \
+	asm(
+
+#define MULADDC_CORE                                    \
+			"ldr    r0, [%0], #4                \n\t"   \
+			"ldr    r1, [%1]                    \n\t"   \
+			"umaal  r1, %2, %3, r0              \n\t"   \
+			"str    r1, [%1], #4                \n\t"
+
+#define MULADDC_STOP                                    \
+		 : "=r" (s),  "=r" (d), "=r" (c)        \
+		 : "r" (b), "0" (s), "1" (d), "2" (c)   \
+		 : "r0", "r1", "memory"                 \
+		 );
+
+#elif defined(__arm__) && !defined(MULADDC_CANNOT_USE_R7)
 
 #if defined(__thumb__) && !defined(__thumb2__)
 
@@ -154,7 +154,7 @@ typedef struct {
 	int (*t_post)(mbedtls_ecp_point *, void *);	/*!< unused                         */
 	void *t_data;			/*!< unused                         */
 	mbedtls_ecp_point *T;	/*!<  pre-computed points for ecp_mul_comb()        */
-	size_t T_size;			/*!<  number for pre-computed points                */
+	size_t T_size;			/*!<  number for pre-computed points, 0 if static   */
 #if defined(CONFIG_HW_ECDH_PARAM)
 	unsigned char *key_buf;
 #endif
@@ -0,0 +1,90 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __TLS_SESSION_STORE_H
+#define __TLS_SESSION_STORE_H
+
+#include <tinyara/config.h>
+
+#include <tls/config.h>
+#include <tls/ssl.h>
+
+#ifdef CONFIG_TLS_SESSION_STORE
+
+/*
+ * Client-side store of TLS sessions, keyed by "host:port" and by how the
+ * ssl configuration verifies the server: its authmode, verify callback,
+ * trusted CAs and CRLs. A resumed session skips certificate verification,
+ * so it is only offered to a connection that would have verified the
+ * server the same way.
+ *
+ * The last CONFIG_TLS_SESSION_STORE_ENTRIES sessions are kept in RAM and
+ * replaced in least-recently-used order. With CONFIG_TLS_SESSION_STORE_PERSIST
+ * they are also written to CONFIG_TLS_SESSION_STORE_PATH so that a device
+ * can resume sessions after a reboot.
+ *
+ * The peer certificate is kept with the session, so
+ * mbedtls_ssl_get_peer_cert() also works on a resumed connection.
+ */
+
+/**
+ * @brief tls_session_store_load() offers a stored session for host:port to
+ *        the handshake. Call it after mbedtls_ssl_setup() and before
+ *        mbedtls_ssl_handshake(), with the CA chain already configured.
+ *
+ * @param[in] host	host name or address of the server
+ * @param[in] port	port of the server
+ * @param[in] ssl	the ssl context about to do the handshake
+ * @return 0 if a session was set, -1 if none is stored for host:port and
+ *         this configuration
+ * @since Tizen RT v1.0
+ */
+int tls_session_store_load(const char *host, unsigned short port, mbedtls_ssl_context *ssl);
+
+/**
+ * @brief tls_session_store_save() stores the session of a completed handshake.
+ *        Sessions whose peer certificate failed verification are not stored.
+ *
+ * @param[in] host	host name or address of the server
+ * @param[in] port	port of the server
+ * @param[in] ssl	the ssl context that finished the handshake
+ * @return 0 on success, -1 on failure
+ * @since Tizen RT v1.0
+ */
+int tls_session_store_save(const char *host, unsigned short port, const mbedtls_ssl_context *ssl);
+
+/**
+ * @brief tls_session_store_remove() forgets the sessions for host:port. Call
+ *        it when a handshake with a loaded session fails.
+ *
+ * @param[in] host	host name or address of the server
+ * @param[in] port	port of the server
+ * @since Tizen RT v1.0
+ */
+void tls_session_store_remove(const char *host, unsigned short port);
+
+/**
+ * @brief tls_session_store_clear() forgets all sessions, in RAM and on flash.
+ *
+ * @since Tizen RT v1.0
+ */
+void tls_session_store_clear(void);
+
+#endif							/* CONFIG_TLS_SESSION_STORE */
+
+#endif							/* __TLS_SESSION_STORE_H */
@@ -52,7 +52,7 @@
 #ifndef __OS_INCLUDE_UIO_H
 #define __OS_INCLUDE_UIO_H
 
-#ifdef CONFIG_ENABLE_IOTIVITY
+#if defined(CONFIG_ENABLE_IOTIVITY) || defined(CONFIG_NET_SOCKET_ZEROCOPY_RECV) || defined(CONFIG_NET_SOCKET_SENDMSG)
 #include <sys/types.h>
 
 struct iovec {
@@ -72,6 +72,7 @@
 #ifdef CONFIG_LOGM
 #include <tinyara/logm.h>
 #endif
+#include "sched/sched.h"
 #include "wqueue/wqueue.h"
 #include "init/init.h"
 #ifdef CONFIG_PAGING
@@ -223,6 +224,12 @@ static inline void os_workqueues(void)
 
 	(void)work_lpstart();
 
+#ifdef CONFIG_SCHED_STACKSAMPLE
+	/* Start sampling the stack usage of all tasks on it */
+
+	(void)sched_stacksample_start();
+#endif
+
 #endif							/* CONFIG_SCHED_LPWORK */
 }
 
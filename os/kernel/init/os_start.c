@@ -499,6 +499,12 @@ void os_start(void)
 
 	up_initialize();
 
+#ifdef CONFIG_SCHED_CPUACCT
+	/* Start accounting the CPU cycles used by each thread and interrupt */
+
+	sched_cpuacct_initialize();
+#endif
+
 #ifdef CONFIG_MM_SHM
 	/* Initialize shared memory support */
 
@@ -61,6 +61,9 @@
 #include <tinyara/irq.h>
 
 #include "irq/irq.h"
+#ifdef CONFIG_SCHED_CPUACCT
+#include "sched/sched.h"
+#endif
 
 /****************************************************************************
  * Definitions
@@ -99,6 +102,9 @@ void irq_dispatch(int irq, FAR void *context)
 {
 	xcpt_t vector;
 	FAR void *arg;
+#ifdef CONFIG_SCHED_CPUACCT
+	int outer;
+#endif
 
 	/* Perform some sanity checks */
 
@@ -117,5 +123,11 @@ void irq_dispatch(int irq, FAR void *context)
 
 	/* Then dispatch to the interrupt handler */
 
+#ifdef CONFIG_SCHED_CPUACCT
+	outer = sched_cpuacct_irqenter(irq);
 	vector(irq, context, arg);
+	sched_cpuacct_irqleave(outer);
+#else
+	vector(irq, context, arg);
+#endif
 }
@@ -152,6 +152,9 @@ static struct mqueue_msg_s *mq_msgblockalloc(FAR sq_queue_t *queue, uint16_t nms
 
 		for (i = 0; i < nmsgs; i++) {
 			mqmsg->type = alloc_type;
+#ifdef CONFIG_MQ_ZEROCOPY
+			mqmsg->mailref = NULL;
+#endif
 			sq_addlast((FAR sq_entry_t *)mqmsg++, queue);
 		}
 	}
@@ -200,6 +203,12 @@ void mq_initialize(void)
 	/* Allocate a block of message queue descriptors */
 
 	mq_desblockalloc();
+
+#ifdef CONFIG_MQ_ZEROCOPY
+	/* Fill the pool of buffers for messages passed by reference */
+
+	mq_bufinitialize();
+#endif
 }
 
 /************************************************************************
@@ -107,6 +107,17 @@ void mq_msgfree(FAR struct mqueue_msg_s *mqmsg)
 {
 	irqstate_t saved_state;
 
+#ifdef CONFIG_MQ_ZEROCOPY
+	/* Give back the shared buffer of a message passed by reference that
+	 * was not handed over to a receiver.
+	 */
+
+	if (mqmsg->mailref != NULL) {
+		mq_buffree(mqmsg->mailref);
+		mqmsg->mailref = NULL;
+	}
+#endif
+
 	/* If this is a generally available pre-allocated message,
 	 * then just put it back in the free list.
 	 */
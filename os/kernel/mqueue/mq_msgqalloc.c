@@ -127,9 +127,13 @@ FAR struct mqueue_inode_s *mq_msgqalloc(mode_t mode, FAR struct mq_attr *attr)
 	msgq = (FAR struct mqueue_inode_s *)kmm_zalloc(sizeof(struct mqueue_inode_s));
 
 	if (msgq) {
+		int i;
+
 		/* Initialize the new named message queue */
 
-		sq_init(&msgq->msglist);
+		for (i = 0; i < CONFIG_MQ_PRIO_BUCKETS; i++) {
+			sq_init(&msgq->msglist[i]);
+		}
 		if (attr) {
 			msgq->maxmsgs    = (int16_t)attr->mq_maxmsg;
 			msgq->maxmsgsize = (int16_t)attr->mq_msgsize;
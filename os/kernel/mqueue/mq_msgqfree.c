@@ -106,16 +106,19 @@ void mq_msgqfree(FAR struct mqueue_inode_s *msgq)
 {
 	FAR struct mqueue_msg_s *curr;
 	FAR struct mqueue_msg_s *next;
+	int i;
 
 	/* Deallocate any stranded messages in the message queue. */
 
-	curr = (FAR struct mqueue_msg_s *)msgq->msglist.head;
-	while (curr) {
-		/* Deallocate the message structure. */
+	for (i = 0; i < CONFIG_MQ_PRIO_BUCKETS; i++) {
+		curr = (FAR struct mqueue_msg_s *)msgq->msglist[i].head;
+		while (curr) {
+			/* Deallocate the message structure. */
 
-		next = curr->next;
-		mq_msgfree(curr);
-		curr = next;
+			next = curr->next;
+			mq_msgfree(curr);
+			curr = next;
+		}
 	}
 
 	/* Then deallocate the message queue itself */
@@ -143,6 +143,74 @@ int mq_verifyreceive(mqd_t mqdes, FAR char *msg, size_t msglen)
 	return OK;
 }
 
+/****************************************************************************
+ * Name: mq_msgremove
+ *
+ * Description:
+ *   Remove the oldest of the highest priority messages from a message
+ *   queue: the first message of the highest list that is not empty.
+ *
+ * Parameters:
+ *   msgq - The message queue
+ *
+ * Return Value:
+ *   The message, or NULL if the queue is empty.
+ *
+ * Assumptions:
+ * - Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+FAR struct mqueue_msg_s *mq_msgremove(FAR struct mqueue_inode_s *msgq)
+{
+	FAR struct mqueue_msg_s *mqmsg;
+	uint32_t map = msgq->msgmap;
+	int bucket = 0;
+
+	if (map == 0) {
+		return NULL;
+	}
+
+	/* Find the most significant bit set in the map */
+
+#if CONFIG_MQ_PRIO_BUCKETS > 16
+	if ((map & 0xffff0000) != 0) {
+		bucket += 16;
+		map >>= 16;
+	}
+#endif
+#if CONFIG_MQ_PRIO_BUCKETS > 8
+	if ((map & 0xff00) != 0) {
+		bucket += 8;
+		map >>= 8;
+	}
+#endif
+#if CONFIG_MQ_PRIO_BUCKETS > 4
+	if ((map & 0xf0) != 0) {
+		bucket += 4;
+		map >>= 4;
+	}
+#endif
+#if CONFIG_MQ_PRIO_BUCKETS > 2
+	if ((map & 0xc) != 0) {
+		bucket += 2;
+		map >>= 2;
+	}
+#endif
+#if CONFIG_MQ_PRIO_BUCKETS > 1
+	if ((map & 0x2) != 0) {
+		bucket += 1;
+	}
+#endif
+
+	mqmsg = (FAR struct mqueue_msg_s *)sq_remfirst(&msgq->msglist[bucket]);
+	if (sq_empty(&msgq->msglist[bucket])) {
+		msgq->msgmap &= ~((uint32_t)1 << bucket);
+	}
+
+	return mqmsg;
+}
+
 /****************************************************************************
  * Name: mq_waitreceive
  *
@@ -194,7 +262,7 @@ FAR struct mqueue_msg_s *mq_waitreceive(mqd_t mqdes)
 
 	/* Get the message from the head of the queue */
 
-	while ((rcvmsg = (FAR struct mqueue_msg_s *)sq_remfirst(&msgq->msglist)) == NULL) {
+	while ((rcvmsg = mq_msgremove(msgq)) == NULL) {
 		/* The queue is empty!  Should we block until there the above condition
 		 * has been satisfied?
 		 */
@@ -257,7 +325,9 @@ FAR struct mqueue_msg_s *mq_waitreceive(mqd_t mqdes)
  *   prio    - The user-provided location to return the message priority.
  *
  * Return Value:
- *   Returns the length of the received message.  This function does not fail.
+ *   Returns the length of the received message.  This function does not
+ *   fail, except for a message passed by reference that is larger than the
+ *   mq_msgsize of the queue (EMSGSIZE); the message is discarded then.
  *
  * Assumptions:
  * - The caller has provided all validity checking of the input parameters
@@ -270,9 +340,6 @@ FAR struct mqueue_msg_s *mq_waitreceive(mqd_t mqdes)
 
 ssize_t mq_doreceive(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR char *ubuffer, int *prio)
 {
-	FAR struct tcb_s *btcb;
-	irqstate_t saved_state;
-	FAR struct mqueue_inode_s *msgq;
 	ssize_t rcvmsglen;
 
 	/* Get the length of the message (also the return value) */
@@ -281,7 +348,24 @@ ssize_t mq_doreceive(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR char *ubuf
 
 	/* Copy the message into the caller's buffer */
 
-	memcpy(ubuffer, (const void *)mqmsg->mail, rcvmsglen);
+#ifdef CONFIG_MQ_ZEROCOPY
+	if (mqmsg->mailref != NULL) {
+		/* A shared buffer larger than the queue's messages does not fit the
+		 * caller's buffer: such messages have to be taken with
+		 * mq_receivebuf().  It is discarded with the message below.
+		 */
+
+		if (rcvmsglen > mqdes->msgq->maxmsgsize) {
+			set_errno(EMSGSIZE);
+			rcvmsglen = ERROR;
+		} else {
+			memcpy(ubuffer, (const void *)mqmsg->mailref, rcvmsglen);
+		}
+	} else
+#endif
+	{
+		memcpy(ubuffer, (const void *)mqmsg->mail, rcvmsglen);
+	}
 
 	/* Copy the message priority as well (if a buffer is provided) */
 
@@ -295,7 +379,36 @@ ssize_t mq_doreceive(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR char *ubuf
 
 	/* Check if any tasks are waiting for the MQ not full event. */
 
-	msgq = mqdes->msgq;
+	mq_wakenotfull(mqdes->msgq);
+
+	/* Return the length of the message transferred to the user buffer */
+	return rcvmsglen;
+}
+
+/****************************************************************************
+ * Name: mq_wakenotfull
+ *
+ * Description:
+ *   Wake up the highest priority task waiting for a message queue to
+ *   become non-full, if there is one, once a message has been taken from
+ *   the queue.
+ *
+ * Parameters:
+ *   msgq - The message queue
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - Pre-emption is disabled.
+ *
+ ****************************************************************************/
+
+void mq_wakenotfull(FAR struct mqueue_inode_s *msgq)
+{
+	FAR struct tcb_s *btcb;
+	irqstate_t saved_state;
+
 	if (msgq->nwaitnotfull > 0) {
 		/* Find the highest priority task that is waiting for
 		 * this queue to be not-full in g_waitingformqnotfull list.
@@ -319,7 +432,4 @@ ssize_t mq_doreceive(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR char *ubuf
 
 		irqrestore(saved_state);
 	}
-
-	/* Return the length of the message transferred to the user buffer */
-	return rcvmsglen;
 }
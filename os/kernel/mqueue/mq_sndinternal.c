@@ -216,12 +216,67 @@ FAR struct mqueue_msg_s *mq_msgalloc(void)
 
 			ASSERT(mqmsg);
 			mqmsg->type = MQ_ALLOC_DYN;
+#ifdef CONFIG_MQ_ZEROCOPY
+			mqmsg->mailref = NULL;
+#endif
 		}
 	}
 
 	return mqmsg;
 }
 
+/****************************************************************************
+ * Name: mq_msginsert
+ *
+ * Description:
+ *   Add a message to the list of its priority range in a message queue,
+ *   after the messages of the same or higher priority.  A message whose
+ *   priority does not exceed that of the last message of the list is
+ *   simply appended; only a message that overtakes others searches the
+ *   list.
+ *
+ * Parameters:
+ *   msgq - The message queue
+ *   mqmsg - The message, with its priority set
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void mq_msginsert(FAR struct mqueue_inode_s *msgq, FAR struct mqueue_msg_s *mqmsg)
+{
+	FAR sq_queue_t *list;
+	FAR struct mqueue_msg_s *next;
+	FAR struct mqueue_msg_s *prev;
+	int bucket;
+
+	bucket = MQ_PRIO_BUCKET(mqmsg->priority);
+	list = &msgq->msglist[bucket];
+
+	prev = (FAR struct mqueue_msg_s *)list->tail;
+	if (prev == NULL || mqmsg->priority <= prev->priority) {
+		sq_addlast((FAR sq_entry_t *)mqmsg, list);
+	} else {
+		/* Search the list for the first message of lower priority. Each
+		 * list is maintained in descending priority order.
+		 */
+
+		for (prev = NULL, next = (FAR struct mqueue_msg_s *)list->head; next && mqmsg->priority <= next->priority; prev = next, next = next->next) ;
+
+		if (prev) {
+			sq_addafter((FAR sq_entry_t *)prev, (FAR sq_entry_t *)mqmsg, list);
+		} else {
+			sq_addfirst((FAR sq_entry_t *)mqmsg, list);
+		}
+	}
+
+	msgq->msgmap |= (uint32_t)1 << bucket;
+}
+
 /****************************************************************************
  * Name: mq_waitsend
  *
@@ -334,7 +389,8 @@ int mq_waitsend(mqd_t mqdes)
  *
  * Parameters:
  *   mqdes - Message queue descriptor
- *   msg - Message to send
+ *   mqmsg - Message structure to queue
+ *   msg - Message to send, or NULL if mqmsg->mailref holds it already
  *   msglen - The length of the message in bytes
  *   prio - The priority of the message
  *
@@ -349,8 +405,6 @@ int mq_dosend(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR const char *msg,
 {
 	FAR struct tcb_s *btcb;
 	FAR struct mqueue_inode_s *msgq;
-	FAR struct mqueue_msg_s *next;
-	FAR struct mqueue_msg_s *prev;
 	irqstate_t saved_state;
 
 	/* Get a pointer to the message queue */
@@ -363,27 +417,22 @@ int mq_dosend(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR const char *msg,
 	mqmsg->priority = prio;
 	mqmsg->msglen = msglen;
 
-	/* Copy the message data into the message */
+	/* Copy the message data into the message, unless the message carries a
+	 * shared buffer instead (msg == NULL).
+	 */
 
+#ifdef CONFIG_MQ_ZEROCOPY
+	if (msg != NULL) {
+		memcpy((void *)mqmsg->mail, (FAR const void *)msg, msglen);
+	}
+#else
 	memcpy((void *)mqmsg->mail, (FAR const void *)msg, msglen);
+#endif
 
 	/* Insert the new message in the message queue */
 
 	saved_state = irqsave();
-
-	/* Search the message list to find the location to insert the new
-	 * message. Each is list is maintained in ascending priority order.
-	 */
-
-	for (prev = NULL, next = (FAR struct mqueue_msg_s *)msgq->msglist.head; next && prio <= next->priority; prev = next, next = next->next) ;
-
-	/* Add the message at the right place */
-
-	if (prev) {
-		sq_addafter((FAR sq_entry_t *)prev, (FAR sq_entry_t *)mqmsg, &msgq->msglist);
-	} else {
-		sq_addfirst((FAR sq_entry_t *)mqmsg, &msgq->msglist);
-	}
+	mq_msginsert(msgq, mqmsg);
 
 	/* Increment the count of messages in the queue */
 
@@ -0,0 +1,372 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * kernel/mqueue/mq_zerocopy.c
+ *
+ * Messages passed by reference: the payload is written into a buffer of a
+ * shared pool and the buffer itself travels through the message queue, so
+ * that large payloads are neither copied twice nor bounded by
+ * CONFIG_MQ_MAXMSGSIZE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <string.h>
+#include <sched.h>
+#include <errno.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <tinyara/arch.h>
+#include <tinyara/cancelpt.h>
+
+#include "mqueue/mqueue.h"
+
+#ifdef CONFIG_MQ_ZEROCOPY
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MQ_BUF_WORDS ((CONFIG_MQ_ZEROCOPY_BUFSIZE + 7) / 8)
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/* The shared buffers, and the list of those not in use.  A free buffer
+ * holds its list link in its first word.
+ */
+
+static uint64_t g_mqbufpool[CONFIG_MQ_ZEROCOPY_NBUFS][MQ_BUF_WORDS];
+static sq_queue_t g_mqbuffree;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mq_bufvalid
+ *
+ * Description:
+ *   Return true if buf is the start of a buffer of the pool.
+ *
+ ****************************************************************************/
+
+static bool mq_bufvalid(FAR void *buf)
+{
+	uintptr_t offset = (uintptr_t)buf - (uintptr_t)g_mqbufpool;
+
+	return offset < sizeof(g_mqbufpool) && offset % sizeof(g_mqbufpool[0]) == 0;
+}
+
+/****************************************************************************
+ * Name: mq_msgrequeue
+ *
+ * Description:
+ *   Put a message just taken from a message queue back in front of the
+ *   messages of its priority.
+ *
+ ****************************************************************************/
+
+static void mq_msgrequeue(FAR struct mqueue_inode_s *msgq, FAR struct mqueue_msg_s *mqmsg)
+{
+	FAR struct mqueue_msg_s *next;
+	FAR struct mqueue_msg_s *prev;
+	FAR sq_queue_t *list;
+	irqstate_t saved_state;
+	int bucket;
+
+	bucket = MQ_PRIO_BUCKET(mqmsg->priority);
+	list = &msgq->msglist[bucket];
+
+	saved_state = irqsave();
+	for (prev = NULL, next = (FAR struct mqueue_msg_s *)list->head; next && mqmsg->priority < next->priority; prev = next, next = next->next) ;
+
+	if (prev) {
+		sq_addafter((FAR sq_entry_t *)prev, (FAR sq_entry_t *)mqmsg, list);
+	} else {
+		sq_addfirst((FAR sq_entry_t *)mqmsg, list);
+	}
+
+	msgq->msgmap |= (uint32_t)1 << bucket;
+	msgq->nmsgs++;
+	irqrestore(saved_state);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mq_bufinitialize
+ *
+ * Description:
+ *   Put all the buffers of the pool on the free list.  Called once from
+ *   mq_initialize().
+ *
+ ****************************************************************************/
+
+void mq_bufinitialize(void)
+{
+	int i;
+
+	sq_init(&g_mqbuffree);
+	for (i = 0; i < CONFIG_MQ_ZEROCOPY_NBUFS; i++) {
+		sq_addlast((FAR sq_entry_t *)g_mqbufpool[i], &g_mqbuffree);
+	}
+}
+
+/****************************************************************************
+ * Name: mq_bufalloc
+ *
+ * Description:
+ *   Take a buffer from the shared pool, to be filled and sent with
+ *   mq_sendbuf().  This function may be called from interrupt handlers.
+ *
+ * Parameters:
+ *   size - The number of bytes needed
+ *
+ * Return Value:
+ *   The buffer, or NULL with errno set:
+ *
+ *   EMSGSIZE 'size' exceeds CONFIG_MQ_ZEROCOPY_BUFSIZE.
+ *   ENOMEM   All the buffers are in use.
+ *
+ ****************************************************************************/
+
+FAR void *mq_bufalloc(size_t size)
+{
+	FAR void *buf;
+	irqstate_t saved_state;
+
+	if (size > CONFIG_MQ_ZEROCOPY_BUFSIZE) {
+		set_errno(EMSGSIZE);
+		return NULL;
+	}
+
+	saved_state = irqsave();
+	buf = (FAR void *)sq_remfirst(&g_mqbuffree);
+	irqrestore(saved_state);
+
+	if (buf == NULL) {
+		set_errno(ENOMEM);
+	}
+
+	return buf;
+}
+
+/****************************************************************************
+ * Name: mq_buffree
+ *
+ * Description:
+ *   Give a buffer back to the shared pool.
+ *
+ * Parameters:
+ *   buf - A buffer from mq_bufalloc() or mq_receivebuf(), or NULL
+ *
+ * Return Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void mq_buffree(FAR void *buf)
+{
+	irqstate_t saved_state;
+
+	if (buf == NULL) {
+		return;
+	}
+
+	DEBUGASSERT(mq_bufvalid(buf));
+
+	saved_state = irqsave();
+	sq_addfirst((FAR sq_entry_t *)buf, &g_mqbuffree);
+	irqrestore(saved_state);
+}
+
+/****************************************************************************
+ * Name: mq_sendbuf
+ *
+ * Description:
+ *   This function queues a buffer obtained from mq_bufalloc() as a message
+ *   of buflen bytes, as mq_send() does with a copy of its message.  The
+ *   buffer belongs to the message queue once it is sent, and is handed to
+ *   the receiver as it is.  buflen may exceed the mq_msgsize of the queue;
+ *   such a message can only be received with mq_receivebuf().
+ *
+ * Parameters:
+ *   mqdes - Message queue descriptor
+ *   buf - The buffer holding the message
+ *   buflen - The length of the message in bytes
+ *   prio - The priority of the message
+ *
+ * Return Value:
+ *   On success, mq_sendbuf() returns 0 (OK); on error, -1 (ERROR) is
+ *   returned, with errno set as by mq_send(), and the buffer still belongs
+ *   to the caller.  EMSGSIZE is returned if buflen exceeds
+ *   CONFIG_MQ_ZEROCOPY_BUFSIZE.
+ *
+ ****************************************************************************/
+
+int mq_sendbuf(mqd_t mqdes, FAR void *buf, size_t buflen, int prio)
+{
+	FAR struct mqueue_inode_s *msgq;
+	FAR struct mqueue_msg_s *mqmsg = NULL;
+	irqstate_t saved_state;
+	int ret = ERROR;
+
+	/* mq_sendbuf() is a cancellation point */
+	(void)enter_cancellation_point();
+
+	if (mq_verifysend(mqdes, (FAR const char *)buf, 0, prio) != OK) {
+		leave_cancellation_point();
+		return ERROR;
+	}
+
+	if (buflen > CONFIG_MQ_ZEROCOPY_BUFSIZE) {
+		set_errno(EMSGSIZE);
+		leave_cancellation_point();
+		return ERROR;
+	}
+
+	DEBUGASSERT(mq_bufvalid(buf));
+
+	/* Get a message structure as mq_send() does */
+
+	sched_lock();
+	msgq = mqdes->msgq;
+
+	saved_state = irqsave();
+	if (up_interrupt_context() ||	/* In an interrupt handler */
+		msgq->nmsgs < msgq->maxmsgs ||	/* OR Message queue not full */
+		mq_waitsend(mqdes) == OK) {	/* OR Successfully waited for mq not full */
+		irqrestore(saved_state);
+		mqmsg = mq_msgalloc();
+	} else {
+		irqrestore(saved_state);
+	}
+
+	if (mqmsg) {
+		/* Queue the buffer itself */
+
+		mqmsg->mailref = buf;
+		ret = mq_dosend(mqdes, mqmsg, NULL, buflen, prio);
+	}
+
+	sched_unlock();
+	leave_cancellation_point();
+	return ret;
+}
+
+/****************************************************************************
+ * Name: mq_receivebuf
+ *
+ * Description:
+ *   This function takes the oldest of the highest priority messages from
+ *   the message queue, as mq_receive() does, and returns the buffer
+ *   holding it.  The caller owns the buffer then and gives it back with
+ *   mq_buffree().  A message sent with mq_send() is copied into a buffer
+ *   of the pool.
+ *
+ * Parameters:
+ *   mqdes - Message Queue Descriptor
+ *   buf - The location to return the buffer
+ *   prio - If not NULL, the location to store message priority.
+ *
+ * Return Value:
+ *   On success, the length of the message in bytes is returned.  On
+ *   failure, -1 (ERROR) is returned with errno set as by mq_receive(), or
+ *   to ENOMEM if a message sent with mq_send() cannot be given a buffer;
+ *   that message is left in the queue.
+ *
+ ****************************************************************************/
+
+ssize_t mq_receivebuf(mqd_t mqdes, FAR void **buf, FAR int *prio)
+{
+	FAR struct mqueue_msg_s *mqmsg;
+	irqstate_t saved_state;
+	ssize_t ret = ERROR;
+
+	DEBUGASSERT(up_interrupt_context() == false);
+
+	/* mq_receivebuf() is a cancellation point */
+	(void)enter_cancellation_point();
+
+	if (!buf || !mqdes) {
+		set_errno(EINVAL);
+		leave_cancellation_point();
+		return ERROR;
+	}
+
+	if ((mqdes->oflags & O_RDOK) == 0) {
+		set_errno(EPERM);
+		leave_cancellation_point();
+		return ERROR;
+	}
+
+	/* Get the next message as mq_receive() does */
+
+	sched_lock();
+	saved_state = irqsave();
+	mqmsg = mq_waitreceive(mqdes);
+	irqrestore(saved_state);
+
+	if (mqmsg) {
+		if (mqmsg->mailref == NULL) {
+			/* A message that was copied in: copy it out to a new buffer */
+
+			mqmsg->mailref = mq_bufalloc(mqmsg->msglen);
+			if (mqmsg->mailref == NULL) {
+				mq_msgrequeue(mqdes->msgq, mqmsg);
+				goto errout_with_lock;
+			}
+
+			memcpy(mqmsg->mailref, (FAR const void *)mqmsg->mail, mqmsg->msglen);
+		}
+
+		/* Hand the buffer over to the caller */
+
+		*buf = mqmsg->mailref;
+		mqmsg->mailref = NULL;
+		ret = mqmsg->msglen;
+		if (prio) {
+			*prio = mqmsg->priority;
+		}
+
+		mq_msgfree(mqmsg);
+		mq_wakenotfull(mqdes->msgq);
+	}
+
+errout_with_lock:
+	sched_unlock();
+	leave_cancellation_point();
+	return ret;
+}
+
+#endif							/* CONFIG_MQ_ZEROCOPY */
@@ -80,6 +80,13 @@
 #define MQ_MAX_MSGS    16
 #define MQ_PRIO_MAX    _POSIX_MQ_PRIO_MAX
 
+/* The list of mqueue_inode_s msglist[] holding the messages of priority
+ * prio.  Each of the low priorities, which are the ones applications use,
+ * has a list of its own; the last list holds all the higher priorities.
+ */
+
+#define MQ_PRIO_BUCKET(prio) ((unsigned int)(prio) < CONFIG_MQ_PRIO_BUCKETS ? (unsigned int)(prio) : CONFIG_MQ_PRIO_BUCKETS - 1)
+
 /* This defines the number of messages descriptors to allocate at each
  * "gulp."
  */
@@ -108,10 +115,13 @@ struct mqueue_msg_s {
 	FAR struct mqueue_msg_s *next;	/* Forward link to next message */
 	uint8_t type;					/* (Used to manage allocations) */
 	uint8_t priority;				/* priority of message */
-#if MQ_MAX_BYTES < 256
+#if MQ_MAX_BYTES < 256 && !defined(CONFIG_MQ_ZEROCOPY)
 	uint8_t msglen;					/* Message data length */
 #else
 	uint16_t msglen;				/* Message data length */
+#endif
+#ifdef CONFIG_MQ_ZEROCOPY
+	FAR void *mailref;				/* Shared buffer holding the data, or NULL */
 #endif
 	char mail[MQ_MAX_BYTES];		/* Message data */
 };
@@ -158,6 +168,12 @@ void mq_desblockalloc(void);
 FAR struct mqueue_inode_s *mq_findnamed(FAR const char *mq_name);
 void mq_msgfree(FAR struct mqueue_msg_s *mqmsg);
 
+/* mq_zerocopy.c ***********************************************************/
+
+#ifdef CONFIG_MQ_ZEROCOPY
+void mq_bufinitialize(void);
+#endif
+
 /* mq_waitirq.c ************************************************************/
 
 void mq_waitirq(FAR struct tcb_s *wtcb, int errcode);
@@ -165,13 +181,16 @@ void mq_waitirq(FAR struct tcb_s *wtcb, int errcode);
 /* mq_rcvinternal.c ********************************************************/
 
 int mq_verifyreceive(mqd_t mqdes, FAR char *msg, size_t msglen);
+FAR struct mqueue_msg_s *mq_msgremove(FAR struct mqueue_inode_s *msgq);
 FAR struct mqueue_msg_s *mq_waitreceive(mqd_t mqdes);
+void mq_wakenotfull(FAR struct mqueue_inode_s *msgq);
 ssize_t mq_doreceive(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR char *ubuffer, FAR int *prio);
 
 /* mq_sndinternal.c ********************************************************/
 
 int mq_verifysend(mqd_t mqdes, FAR const char *msg, size_t msglen, int prio);
 FAR struct mqueue_msg_s *mq_msgalloc(void);
+void mq_msginsert(FAR struct mqueue_inode_s *msgq, FAR struct mqueue_msg_s *mqmsg);
 int mq_waitsend(mqd_t mqdes);
 int mq_dosend(mqd_t mqdes, FAR struct mqueue_msg_s *mqmsg, FAR const char *msg, size_t msglen, int prio);
 
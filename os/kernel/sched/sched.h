@@ -267,6 +267,19 @@ void sched_timer_reassess(void);
 void weak_function sched_process_cpuload(void);
 #endif
 
+#ifdef CONFIG_SCHED_STACKSAMPLE
+int sched_stacksample_start(void);
+#endif
+
+#ifdef CONFIG_SCHED_CPUACCT
+void sched_cpuacct_initialize(void);
+void sched_cpuacct_switch(FAR struct tcb_s *from, FAR struct tcb_s *to);
+int sched_cpuacct_irqenter(int irq);
+void sched_cpuacct_irqleave(int outer);
+#else
+#define sched_cpuacct_switch(from, to)
+#endif
+
 bool sched_verifytcb(FAR struct tcb_s *tcb);
 int sched_releasetcb(FAR struct tcb_s *tcb, uint8_t ttype);
 
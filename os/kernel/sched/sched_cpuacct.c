@@ -0,0 +1,260 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/************************************************************************
+ * kernel/sched/sched_cpuacct.c
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
+#include <arch/irq.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SCHED_CPUACCT
+
+/************************************************************************
+ * Private Type Declarations
+ ************************************************************************/
+
+struct irqacct_s {
+	uint64_t cycles;			/* CPU cycles used by the handler */
+	uint32_t count;				/* Times the interrupt was raised */
+};
+
+/************************************************************************
+ * Private Variables
+ ************************************************************************/
+
+/* The cycle counter at the last context switch or interrupt boundary.
+ * Everything from there on has not been accounted yet.
+ */
+
+static uint32_t g_cpuacct_last;
+
+/* The interrupt being handled, or -1 when a thread is running */
+
+static int g_cpuacct_irq = -1;
+
+/* All the cycles accounted so far */
+
+static uint64_t g_cpuacct_total;
+
+#if NR_IRQS > 0
+static struct irqacct_s g_irqacct[NR_IRQS];
+#endif
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_cpuacct_elapsed
+ *
+ * Description:
+ *   Return the cycles since the last boundary, and make now the last
+ *   boundary.  The subtraction is modulo 2^32, so the counter may wrap
+ *   once in between.
+ *
+ ************************************************************************/
+
+static inline uint32_t sched_cpuacct_elapsed(void)
+{
+	uint32_t now = up_cpuacct_cycles();
+	uint32_t elapsed = now - g_cpuacct_last;
+
+	g_cpuacct_last = now;
+	g_cpuacct_total += elapsed;
+	return elapsed;
+}
+
+/************************************************************************
+ * Name: sched_cpuacct_sync
+ *
+ * Description:
+ *   Account the cycles since the last boundary to the running thread or
+ *   interrupt handler, so that their totals are current.
+ *
+ ************************************************************************/
+
+static void sched_cpuacct_sync(void)
+{
+	uint32_t elapsed = sched_cpuacct_elapsed();
+
+#if NR_IRQS > 0
+	if (g_cpuacct_irq >= 0) {
+		g_irqacct[g_cpuacct_irq].cycles += elapsed;
+		return;
+	}
+#endif
+
+	this_task()->cpuacct_cycles += elapsed;
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_cpuacct_initialize
+ *
+ * Description:
+ *   Start the cycle counter.  Everything before is accounted to nobody.
+ *
+ ************************************************************************/
+
+void sched_cpuacct_initialize(void)
+{
+	up_cpuacct_initialize();
+	g_cpuacct_last = up_cpuacct_cycles();
+}
+
+/************************************************************************
+ * Name: sched_cpuacct_switch
+ *
+ * Description:
+ *   Called where the head of the ready-to-run list changes from 'from' to
+ *   'to', with interrupts disabled.  Within an interrupt handler the
+ *   cycles belong to the interrupt, and 'to' only starts to run once the
+ *   handler returns, so nothing is accounted then.
+ *
+ ************************************************************************/
+
+void sched_cpuacct_switch(FAR struct tcb_s *from, FAR struct tcb_s *to)
+{
+	if (g_cpuacct_irq < 0) {
+		from->cpuacct_cycles += sched_cpuacct_elapsed();
+	}
+
+	to->cpuacct_count++;
+}
+
+/************************************************************************
+ * Name: sched_cpuacct_irqenter and sched_cpuacct_irqleave
+ *
+ * Description:
+ *   Called by irq_dispatch() around the handler of 'irq', with interrupts
+ *   disabled.  The cycles before are accounted to the thread or handler
+ *   that was interrupted, those of the handler to 'irq'.
+ *   sched_cpuacct_irqenter() returns what must be passed back to
+ *   sched_cpuacct_irqleave(), so interrupts may nest.
+ *
+ ************************************************************************/
+
+int sched_cpuacct_irqenter(int irq)
+{
+	int outer = g_cpuacct_irq;
+
+#if NR_IRQS > 0
+	if ((unsigned)irq < NR_IRQS) {
+		sched_cpuacct_sync();
+		g_cpuacct_irq = irq;
+		g_irqacct[irq].count++;
+	}
+#endif
+
+	return outer;
+}
+
+void sched_cpuacct_irqleave(int outer)
+{
+	if (g_cpuacct_irq != outer) {
+		sched_cpuacct_sync();
+		g_cpuacct_irq = outer;
+	}
+}
+
+/****************************************************************************
+ * Function:  clock_cpuacct
+ *
+ * Description:
+ *   Return the CPU cycles accounted to the select PID.
+ *
+ ****************************************************************************/
+
+int clock_cpuacct(int pid, FAR struct cpuacct_s *cpuacct)
+{
+	FAR struct tcb_s *tcb;
+	irqstate_t flags;
+	int ret = -ESRCH;
+
+	DEBUGASSERT(cpuacct);
+
+	/* The thread must stay valid and the totals consistent while they are
+	 * copied.
+	 */
+
+	flags = irqsave();
+
+	tcb = sched_gettcb((pid_t)pid);
+	if (tcb != NULL) {
+		sched_cpuacct_sync();
+
+		cpuacct->total = g_cpuacct_total;
+		cpuacct->active = tcb->cpuacct_cycles;
+		cpuacct->count = tcb->cpuacct_count;
+		ret = OK;
+	}
+
+	irqrestore(flags);
+	return ret;
+}
+
+/****************************************************************************
+ * Function:  clock_irqacct
+ *
+ * Description:
+ *   Return the CPU cycles accounted to the select IRQ number.
+ *
+ ****************************************************************************/
+
+int clock_irqacct(int irq, FAR struct cpuacct_s *cpuacct)
+{
+#if NR_IRQS > 0
+	irqstate_t flags;
+#endif
+
+	DEBUGASSERT(cpuacct);
+
+#if NR_IRQS > 0
+	if ((unsigned)irq < NR_IRQS) {
+		flags = irqsave();
+		sched_cpuacct_sync();
+
+		cpuacct->total = g_cpuacct_total;
+		cpuacct->active = g_irqacct[irq].cycles;
+		cpuacct->count = g_irqacct[irq].count;
+
+		irqrestore(flags);
+		return OK;
+	}
+#endif
+
+	return -EINVAL;
+}
+
+#endif							/* CONFIG_SCHED_CPUACCT */
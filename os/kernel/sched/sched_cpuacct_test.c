@@ -0,0 +1,334 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/************************************************************************
+ * kernel/sched/sched_cpuacct_test.c
+ *
+ * Native test of the accounting in sched_cpuacct.c.  The few kernel
+ * interfaces it uses are provided here, and up_cpuacct_cycles() reads
+ * either a counter set by the test or, as the fallback of a native
+ * build, clock_gettime() in nanoseconds.  See Makefile.host.
+ *
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+
+/************************************************************************
+ * Kernel Interfaces
+ ************************************************************************/
+
+#define CONFIG_SCHED_CPUACCT 1
+#define NR_IRQS              8
+
+#define FAR
+#define OK                   0
+#define DEBUGASSERT(f)
+#define DEBUGVERIFY(f)       ((void)(f))
+
+typedef int irqstate_t;
+
+struct tcb_s {
+	pid_t pid;
+	uint64_t cpuacct_cycles;
+	uint32_t cpuacct_count;
+};
+
+struct cpuacct_s {
+	uint64_t total;
+	uint64_t active;
+	uint32_t count;
+};
+
+#define NTASKS               3
+
+static struct tcb_s g_tcbs[NTASKS] = { {0}, {1}, {2} };
+static FAR struct tcb_s *g_running = &g_tcbs[0];
+static bool g_usefake = true;
+static uint32_t g_fake;
+static int g_nfail;
+
+#define this_task()          (g_running)
+
+static irqstate_t irqsave(void)
+{
+	return 0;
+}
+
+static void irqrestore(irqstate_t flags)
+{
+}
+
+static FAR struct tcb_s *sched_gettcb(pid_t pid)
+{
+	return (unsigned)pid < NTASKS ? &g_tcbs[pid] : NULL;
+}
+
+void up_cpuacct_initialize(void)
+{
+}
+
+uint32_t up_cpuacct_cycles(void)
+{
+	struct timespec ts;
+
+	if (g_usefake) {
+		return g_fake;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+#include "sched_cpuacct.c"
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+#define CHECK(c) \
+	do { \
+		if (!(c)) { \
+			printf("FAIL line %d: %s\n", __LINE__, #c); \
+			g_nfail++; \
+		} \
+	} while (0)
+
+static void reset(uint32_t start)
+{
+	int i;
+
+	for (i = 0; i < NTASKS; i++) {
+		g_tcbs[i].cpuacct_cycles = 0;
+		g_tcbs[i].cpuacct_count = 0;
+	}
+
+	for (i = 0; i < NR_IRQS; i++) {
+		g_irqacct[i].cycles = 0;
+		g_irqacct[i].count = 0;
+	}
+
+	g_usefake = true;
+	g_fake = start;
+	g_running = &g_tcbs[0];
+	g_cpuacct_irq = -1;
+	g_cpuacct_total = 0;
+	sched_cpuacct_initialize();
+}
+
+static void run(uint32_t cycles)
+{
+	g_fake += cycles;
+}
+
+static void switchto(int pid)
+{
+	sched_cpuacct_switch(g_running, &g_tcbs[pid]);
+	g_running = &g_tcbs[pid];
+}
+
+static uint64_t sum(void)
+{
+	uint64_t total = 0;
+	int i;
+
+	for (i = 0; i < NTASKS; i++) {
+		total += g_tcbs[i].cpuacct_cycles;
+	}
+
+	for (i = 0; i < NR_IRQS; i++) {
+		total += g_irqacct[i].cycles;
+	}
+
+	return total;
+}
+
+static void test_switch(void)
+{
+	struct cpuacct_s acct;
+
+	reset(1000);
+	run(100);
+	switchto(1);
+	run(50);
+	switchto(2);
+	run(7);
+	switchto(1);
+	run(3);
+
+	CHECK(g_tcbs[0].cpuacct_cycles == 100);
+	CHECK(g_tcbs[1].cpuacct_cycles == 50);
+	CHECK(g_tcbs[2].cpuacct_cycles == 7);
+	CHECK(g_tcbs[1].cpuacct_count == 2);
+	CHECK(g_tcbs[2].cpuacct_count == 1);
+
+	/* Reading the running thread includes what it ran so far */
+
+	CHECK(clock_cpuacct(1, &acct) == OK);
+	CHECK(acct.active == 53 && acct.count == 2 && acct.total == 160);
+	CHECK(clock_cpuacct(NTASKS, &acct) == -ESRCH);
+	CHECK(sum() == g_cpuacct_total);
+}
+
+static void test_irq(void)
+{
+	struct cpuacct_s acct;
+	int outer;
+	int inner;
+
+	reset(0);
+	run(10);
+	outer = sched_cpuacct_irqenter(3);
+	CHECK(outer == -1);
+	run(20);
+	sched_cpuacct_irqleave(outer);
+	run(5);
+
+	CHECK(g_irqacct[3].cycles == 20 && g_irqacct[3].count == 1);
+
+	/* Nested: 2 is interrupted by 5 */
+
+	outer = sched_cpuacct_irqenter(2);
+	run(4);
+	inner = sched_cpuacct_irqenter(5);
+	CHECK(inner == 2);
+	run(7);
+	sched_cpuacct_irqleave(inner);
+	run(3);
+	sched_cpuacct_irqleave(outer);
+	run(1);
+
+	CHECK(g_irqacct[2].cycles == 7 && g_irqacct[5].cycles == 7);
+	CHECK(clock_cpuacct(0, &acct) == OK && acct.active == 16);
+	CHECK(clock_irqacct(5, &acct) == OK && acct.active == 7 && acct.count == 1);
+	CHECK(clock_irqacct(NR_IRQS, &acct) == -EINVAL);
+
+	/* An IRQ number out of range goes to whatever it interrupted */
+
+	outer = sched_cpuacct_irqenter(NR_IRQS + 1);
+	run(9);
+	sched_cpuacct_irqleave(outer);
+	CHECK(clock_cpuacct(0, &acct) == OK && acct.active == 25);
+	CHECK(sum() == g_cpuacct_total);
+}
+
+static void test_switch_in_irq(void)
+{
+	int outer;
+
+	/* A handler wakes up 2: the handler keeps its cycles, and 2 is
+	 * accounted from the return of the handler on.
+	 */
+
+	reset(0);
+	run(10);
+	outer = sched_cpuacct_irqenter(1);
+	run(6);
+	switchto(2);
+	run(4);
+	sched_cpuacct_irqleave(outer);
+	run(30);
+	switchto(0);
+
+	CHECK(g_tcbs[0].cpuacct_cycles == 10);
+	CHECK(g_irqacct[1].cycles == 10);
+	CHECK(g_tcbs[2].cpuacct_cycles == 30 && g_tcbs[2].cpuacct_count == 1);
+	CHECK(sum() == g_cpuacct_total);
+}
+
+static void test_wrap(void)
+{
+	reset(0xfffffff0);
+	run(0x20);
+	switchto(1);
+	run(0x10);
+	switchto(0);
+
+	CHECK(g_tcbs[0].cpuacct_cycles == 0x20);
+	CHECK(g_tcbs[1].cpuacct_cycles == 0x10);
+	CHECK(sum() == g_cpuacct_total);
+}
+
+static void spin(long ns)
+{
+	struct timespec start;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000000000L + (now.tv_nsec - start.tv_nsec) < ns);
+}
+
+static void test_clock(void)
+{
+	struct cpuacct_s acct;
+	int outer;
+	int i;
+
+	/* With the clock_gettime() fallback: 0 spins twice as long as 1, and
+	 * 4 interrupts each take 1/4 of what 1 spins.
+	 */
+
+	reset(0);
+	g_usefake = false;
+	sched_cpuacct_initialize();
+
+	for (i = 0; i < 4; i++) {
+		spin(2000000);
+		switchto(1);
+		spin(1000000);
+		outer = sched_cpuacct_irqenter(4);
+		spin(250000);
+		sched_cpuacct_irqleave(outer);
+		switchto(0);
+	}
+
+	CHECK(clock_cpuacct(0, &acct) == OK);
+	printf("clock: total %llu ns, 0: %llu ns, 1: %llu ns, irq 4: %llu ns\n", (unsigned long long)acct.total, (unsigned long long)g_tcbs[0].cpuacct_cycles, (unsigned long long)g_tcbs[1].cpuacct_cycles, (unsigned long long)g_irqacct[4].cycles);
+
+	CHECK(g_tcbs[0].cpuacct_cycles >= 8000000 && g_tcbs[0].cpuacct_cycles < 12000000);
+	CHECK(g_tcbs[1].cpuacct_cycles >= 4000000 && g_tcbs[1].cpuacct_cycles < 6000000);
+	CHECK(g_irqacct[4].cycles >= 1000000 && g_irqacct[4].cycles < 1500000);
+	CHECK(g_irqacct[4].count == 4);
+	CHECK(sum() == g_cpuacct_total);
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+int main(int argc, char **argv)
+{
+	test_switch();
+	test_irq();
+	test_switch_in_irq();
+	test_wrap();
+	test_clock();
+
+	printf("%s\n", g_nfail ? "FAILED" : "PASSED");
+	return g_nfail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -149,6 +149,7 @@ bool sched_mergepending(void)
 			/* Inform the instrumentation layer that we are switching tasks */
 
 			sched_note_switch(rtrtcb, pndtcb);
+			sched_cpuacct_switch(rtrtcb, pndtcb);
 
 			/* Then insert at the head of the list */
 
@@ -125,6 +125,7 @@ bool sched_removereadytorun(FAR struct tcb_s *rtcb)
 		/* Inform the instrumentation layer that we are switching tasks */
 
 		sched_note_switch(rtcb, ntcb);
+		sched_cpuacct_switch(rtcb, ntcb);
 		ntcb->task_state = TSTATE_TASK_RUNNING;
 		ret = true;
 	}
@@ -0,0 +1,135 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/************************************************************************
+ * kernel/sched/sched_stacksample.c
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sched.h>
+#include <debug.h>
+
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
+#include <tinyara/wqueue.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SCHED_STACKSAMPLE
+
+/************************************************************************
+ * Private Variables
+ ************************************************************************/
+
+static struct work_s g_stacksample_work;
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_stacksample_tcb
+ *
+ * Description:
+ *   Check the stack of one task and keep the result as its newest
+ *   sample.  Called with the scheduler locked.
+ *
+ ************************************************************************/
+
+static void sched_stacksample_tcb(FAR struct tcb_s *tcb)
+{
+	/* The IDLE task runs on the stack it was started with, which is not
+	 * described by its TCB.
+	 */
+
+	if (tcb->stack_alloc_ptr == NULL) {
+		return;
+	}
+
+	tcb->stack_samples[tcb->stack_sampleidx] = (uint32_t)up_check_tcbstack(tcb);
+	if (++tcb->stack_sampleidx >= CONFIG_SCHED_STACKSAMPLE_NSAMPLES) {
+		tcb->stack_sampleidx = 0;
+	}
+
+	if (tcb->stack_nsamples < CONFIG_SCHED_STACKSAMPLE_NSAMPLES) {
+		tcb->stack_nsamples++;
+	}
+}
+
+/************************************************************************
+ * Name: sched_stacksample_worker
+ *
+ * Description:
+ *   Sample the stack of every task, then queue itself again.  Locking
+ *   the scheduler keeps the TCBs from being freed, and unlike
+ *   sched_foreach() leaves interrupts enabled while the stacks are
+ *   searched.
+ *
+ ************************************************************************/
+
+static void sched_stacksample_worker(FAR void *arg)
+{
+	FAR struct tcb_s *tcb;
+	int ndx;
+	int ret;
+
+	sched_lock();
+	for (ndx = 0; ndx < CONFIG_MAX_TASKS; ndx++) {
+		tcb = g_pidhash[ndx].tcb;
+		if (tcb != NULL) {
+			sched_stacksample_tcb(tcb);
+		}
+	}
+	sched_unlock();
+
+	ret = work_queue(LPWORK, &g_stacksample_work, sched_stacksample_worker, NULL, MSEC2TICK(CONFIG_SCHED_STACKSAMPLE_INTERVAL));
+	if (ret < 0) {
+		sdbg("ERROR: work_queue failed: %d\n", ret);
+	}
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_stacksample_start
+ *
+ * Description:
+ *   Start sampling the stack usage of all tasks every
+ *   CONFIG_SCHED_STACKSAMPLE_INTERVAL milliseconds.  Called once the
+ *   low priority worker thread has been started.
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   OK on success, or a negated errno value.
+ *
+ ************************************************************************/
+
+int sched_stacksample_start(void)
+{
+	return work_queue(LPWORK, &g_stacksample_work, sched_stacksample_worker, NULL, MSEC2TICK(CONFIG_SCHED_STACKSAMPLE_INTERVAL));
+}
+
+#endif							/* CONFIG_SCHED_STACKSAMPLE */
@@ -127,6 +127,7 @@ int sched_yield(void)
 
 		/* A context switch will occur. */
 		sched_note_switch(rtcb, ntcb);
+		sched_cpuacct_switch(rtcb, ntcb);
 		ntcb->task_state = TSTATE_TASK_RUNNING;
 		switch_needed = true;
 
@@ -64,6 +64,61 @@
  ****************************************************************************/
 #define MM_PIDHASH(pid) ((pid) & (CONFIG_MAX_TASKS - 1))
 
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+#if (CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES & (CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES - 1)) != 0
+#error "CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES must be a power of two"
+#endif
+
+#define MM_SITEMASK     (CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES - 1)
+#define MM_SITEOTHERS   CONFIG_DEBUG_MM_HEAPINFO_PROFILE_SITES
+#define MM_SITEHASH(a)  ((((uint32_t)(a)) * 2654435761u >> 16) & MM_SITEMASK)
+
+/* Number of entries probed for a caller before it goes to the others entry */
+
+#define MM_SITEPROBES   8
+
+/* Number of entries copied per semaphore hold by heapinfo_profile_snapshot */
+
+#define MM_SITECHUNK    16
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+/****************************************************************************
+ * Name: heapinfo_profile_site
+ *
+ * Description:
+ * Find the profile entry of a caller address, claiming a free one if
+ * the caller is new.  The caller must hold the heap semaphore.
+ ****************************************************************************/
+static FAR struct mm_heapsite_s *heapinfo_profile_site(FAR struct mm_heap_s *heap, mmaddress_t addr)
+{
+	FAR struct mm_heapsite_s *site;
+	uint32_t idx = MM_SITEHASH(addr);
+	int probe;
+
+	if (addr == 0) {
+		return &heap->mm_sites[MM_SITEOTHERS];
+	}
+
+	for (probe = 0; probe < MM_SITEPROBES; probe++) {
+		site = &heap->mm_sites[(idx + probe) & MM_SITEMASK];
+		if (site->addr == addr) {
+			return site;
+		}
+		if (site->addr == 0) {
+			site->addr = addr;
+			return site;
+		}
+	}
+
+	return &heap->mm_sites[MM_SITEOTHERS];
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -250,4 +305,107 @@ void heapinfo_update_node(FAR struct mm_allocnode_s *node, mmaddress_t caller_re
 	}
 	return;
 }
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+/****************************************************************************
+ * Name: heapinfo_profile_live
+ *
+ * Description:
+ * Add a chunk to the live totals of its site and return the site.
+ ****************************************************************************/
+static FAR struct mm_heapsite_s *heapinfo_profile_live(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+	FAR struct mm_heapsite_s *site = heapinfo_profile_site(heap, node->alloc_call_addr);
+
+	site->live_size += node->size;
+	site->live_count++;
+	if (site->live_size > site->peak_size) {
+		site->peak_size = site->live_size;
+	}
+
+	return site;
+}
+
+/****************************************************************************
+ * Name: heapinfo_profile_add
+ *
+ * Description:
+ * Account a newly allocated chunk to the site recorded by
+ * heapinfo_update_node.  Called with the heap semaphore held.
+ ****************************************************************************/
+void heapinfo_profile_add(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+	heapinfo_profile_live(heap, node)->total_count++;
+}
+
+/****************************************************************************
+ * Name: heapinfo_profile_resize
+ *
+ * Description:
+ * Account a chunk taken off with heapinfo_profile_subtract and then resized
+ * in place by realloc or memalign.  It is not a new allocation, so only the
+ * live totals change.  Called with the heap semaphore held.
+ ****************************************************************************/
+void heapinfo_profile_resize(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+	(void)heapinfo_profile_live(heap, node);
+}
+
+/****************************************************************************
+ * Name: heapinfo_profile_subtract
+ *
+ * Description:
+ * Remove an allocated chunk from its site before the chunk is freed or
+ * resized.  Called with the heap semaphore held.
+ ****************************************************************************/
+void heapinfo_profile_subtract(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+	FAR struct mm_heapsite_s *site;
+
+	/* Entries are never released, so a caller maps to the same entry for
+	 * as long as its chunks live.
+	 */
+
+	site = heapinfo_profile_site(heap, node->alloc_call_addr);
+	if (site->live_count == 0 || site->live_size < node->size) {
+		return;
+	}
+
+	site->live_size -= node->size;
+	site->live_count--;
+}
+
+/****************************************************************************
+ * Name: heapinfo_profile_snapshot
+ *
+ * Description:
+ * Copy the profile entries in use to sites, the others entry last, and
+ * return how many were copied.  The semaphore is retaken every few entries
+ * so that allocators are not stalled; each entry is consistent but the
+ * table as a whole may span a few allocations.
+ ****************************************************************************/
+int heapinfo_profile_snapshot(FAR struct mm_heap_s *heap, FAR struct mm_heapsite_s *sites, int nsites)
+{
+	int count = 0;
+	int idx = 0;
+	int end;
+
+	while (idx <= MM_SITEOTHERS && count < nsites) {
+		end = idx + MM_SITECHUNK;
+		if (end > MM_SITEOTHERS + 1) {
+			end = MM_SITEOTHERS + 1;
+		}
+
+		mm_takesemaphore(heap);
+		for (; idx < end && count < nsites; idx++) {
+			if (heap->mm_sites[idx].total_count != 0 || heap->mm_sites[idx].live_count != 0) {
+				sites[count++] = heap->mm_sites[idx];
+			}
+		}
+		mm_givesemaphore(heap);
+	}
+
+	return count;
+}
+#endif
 #endif
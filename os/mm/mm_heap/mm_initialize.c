@@ -169,6 +169,53 @@ void mm_addregion(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heapsi
 	mm_addfreechunk(heap, node);
 }
 
+/****************************************************************************
+ * Name: mm_reset
+ *
+ * Description:
+ *   Discard every chunk of the selected heap and give it heapstart as its
+ *   only region, as mm_initialize() does, but keep its semaphore.  The
+ *   caller holds the semaphore, so tasks waiting on it are not disturbed.
+ *
+ * Parameters:
+ *   heap      - The selected heap
+ *   heapstart - Start of the heap region
+ *   heapsize  - Size of the heap region
+ *
+ * Return Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void mm_reset(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heapsize)
+{
+	int i;
+
+	/* Set up global variables */
+
+	heap->mm_heapsize = 0;
+
+#if CONFIG_MM_REGIONS > 1
+	heap->mm_nregions = 0;
+#endif
+
+	/* Initialize the node array */
+
+	memset(heap->mm_nodelist, 0, sizeof(struct mm_freenode_s) * MM_NNODES);
+	for (i = 1; i < MM_NNODES; i++) {
+		heap->mm_nodelist[i - 1].flink = &heap->mm_nodelist[i];
+		heap->mm_nodelist[i].blink = &heap->mm_nodelist[i - 1];
+	}
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO_PROFILE
+	memset(heap->mm_sites, 0, sizeof(heap->mm_sites));
+#endif
+
+	/* Add the region of memory to the heap */
+
+	mm_addregion(heap, heapstart, heapsize);
+}
+
 /****************************************************************************
  * Name: mm_initialize
  *
@@ -190,8 +237,6 @@ void mm_addregion(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heapsi
 
 void mm_initialize(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heapsize)
 {
-	int i;
-
 	mlldbg("Heap: start=%p size=%u\n", heapstart, heapsize);
 
 	/* The following two lines have cause problems for some older ZiLog
@@ -204,29 +249,13 @@ void mm_initialize(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heaps
 	CHECK_FREENODE_SIZE;
 #endif
 
-	/* Set up global variables */
-
-	heap->mm_heapsize = 0;
-
-#if CONFIG_MM_REGIONS > 1
-	heap->mm_nregions = 0;
-#endif
-
-	/* Initialize the node array */
-
-	memset(heap->mm_nodelist, 0, sizeof(struct mm_freenode_s) * MM_NNODES);
-	for (i = 1; i < MM_NNODES; i++) {
-		heap->mm_nodelist[i - 1].flink = &heap->mm_nodelist[i];
-		heap->mm_nodelist[i].blink = &heap->mm_nodelist[i - 1];
-	}
-
 	/* Initialize the malloc semaphore to one (to support one-at-
 	 * a-time access to private data sets).
 	 */
 
 	mm_seminitialize(heap);
 
-	/* Add the initial region of memory to the heap */
+	/* Set up the node array and add the initial region of memory */
 
-	mm_addregion(heap, heapstart, heapsize);
+	mm_reset(heap, heapstart, heapsize);
 }
@@ -209,6 +209,7 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 		heapinfo_update_node((struct mm_allocnode_s *)node, caller_retaddr);
 		heapinfo_add_size(((struct mm_allocnode_s *)node)->pid, node->size);
 		heapinfo_update_total_size(heap, node->size);
+		heapinfo_profile_add(heap, (struct mm_allocnode_s *)node);
 #endif
 		ret = (void *)((char *)node + SIZEOF_MM_ALLOCNODE);
 	}
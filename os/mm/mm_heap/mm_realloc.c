@@ -160,6 +160,7 @@ FAR void *mm_realloc(FAR struct mm_heap_s *heap, FAR void *oldmem, size_t size)
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 			/* modify the current allocated size of old node */
 			heapinfo_subtract_size(oldnode->pid, oldsize);
+			heapinfo_profile_subtract(heap, oldnode);
 			heapinfo_update_total_size(heap, (-1) * oldsize);
 #endif
 
@@ -170,6 +171,7 @@ FAR void *mm_realloc(FAR struct mm_heap_s *heap, FAR void *oldmem, size_t size)
 
 			heapinfo_add_size(oldnode->pid, oldnode->size);
 			heapinfo_update_total_size(heap, oldnode->size);
+			heapinfo_profile_resize(heap, oldnode);
 #endif
 		}
 
@@ -204,6 +206,7 @@ FAR void *mm_realloc(FAR struct mm_heap_s *heap, FAR void *oldmem, size_t size)
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 		/* modify the current allocated size of old node */
 		heapinfo_subtract_size(oldnode->pid, oldsize);
+		heapinfo_profile_subtract(heap, oldnode);
 		heapinfo_update_total_size(heap, (-1) * oldsize);
 #endif
 
@@ -356,6 +359,7 @@ FAR void *mm_realloc(FAR struct mm_heap_s *heap, FAR void *oldmem, size_t size)
 
 		heapinfo_add_size(oldnode->pid, oldnode->size);
 		heapinfo_update_total_size(heap, oldnode->size);
+		heapinfo_profile_resize(heap, oldnode);
 #endif
 
 		mm_givesemaphore(heap);
@@ -0,0 +1,334 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * mm/mm_heap/mm_subheap.c
+ *
+ * A sub-heap is a complete mm_heap_s managing one chunk of a parent heap.
+ * Allocations of a subsystem bound to it stay inside that chunk, so they
+ * cannot fragment the parent heap, and the whole sub-heap can be reset in
+ * one call when its allocations all end together.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <string.h>
+#include <sched.h>
+#include <errno.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <tinyara/arch.h>
+#include <tinyara/sched.h>
+#include <tinyara/mm/mm.h>
+
+#ifdef CONFIG_MM_SUBHEAP
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* All sub-heaps, the most recently created first.  A sub-heap carved from
+ * another one is therefore found before its parent by mm_subheap_member().
+ */
+
+static FAR struct mm_subheap_s *g_subheaps;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_subheap_unbind
+ *
+ * Description:
+ *   sched_foreach() callback detaching the tasks bound to a sub-heap that
+ *   is being destroyed.
+ *
+ ****************************************************************************/
+
+static void mm_subheap_unbind(FAR struct tcb_s *tcb, FAR void *arg)
+{
+	if (tcb->subheap == (FAR struct mm_subheap_s *)arg) {
+		tcb->subheap = NULL;
+	}
+}
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+/****************************************************************************
+ * Name: mm_subheap_release
+ *
+ * Description:
+ *   Take the chunks still allocated in a sub-heap off the heap info of
+ *   their owners before they are discarded all at once.
+ *
+ ****************************************************************************/
+
+static void mm_subheap_release(FAR struct mm_subheap_s *subheap)
+{
+	FAR struct mm_heap_s *heap = &subheap->heap;
+	FAR struct mm_allocnode_s *node;
+
+	mm_takesemaphore(heap);
+	for (node = (FAR struct mm_allocnode_s *)((FAR char *)heap->mm_heapstart[0] + SIZEOF_MM_ALLOCNODE); node < heap->mm_heapend[0]; node = (FAR struct mm_allocnode_s *)((FAR char *)node + node->size)) {
+		if ((node->preceding & MM_ALLOC_BIT) != 0) {
+			heapinfo_subtract_size(node->pid, node->size);
+		}
+	}
+	mm_givesemaphore(heap);
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_subheap_create
+ *
+ * Description:
+ *   Allocate size bytes from the parent heap and make a sub-heap of them.
+ *   The sub-heap can never grow; allocations that do not fit in it fail.
+ *
+ * Return Value:
+ *   The new sub-heap, or NULL if the parent heap has no room for it.
+ *
+ ****************************************************************************/
+
+FAR struct mm_subheap_s *mm_subheap_create(FAR struct mm_heap_s *parent, size_t size)
+{
+	FAR struct mm_subheap_s *subheap;
+
+	DEBUGASSERT(parent != NULL && size >= MM_MIN_CHUNK + 2 * SIZEOF_MM_ALLOCNODE);
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	ARCH_GET_RET_ADDRESS
+	subheap = (FAR struct mm_subheap_s *)mm_malloc(parent, sizeof(struct mm_subheap_s) + size, retaddr);
+#else
+	subheap = (FAR struct mm_subheap_s *)mm_malloc(parent, sizeof(struct mm_subheap_s) + size);
+#endif
+	if (subheap == NULL) {
+		mdbg("Cannot allocate a sub-heap of %u bytes\n", size);
+		return NULL;
+	}
+
+	memset(subheap, 0, sizeof(struct mm_subheap_s));
+	subheap->parent = parent;
+	subheap->start = (FAR void *)(subheap + 1);
+	subheap->size = size;
+	mm_initialize(&subheap->heap, subheap->start, size);
+
+	sched_lock();
+	subheap->flink = g_subheaps;
+	g_subheaps = subheap;
+	sched_unlock();
+
+	return subheap;
+}
+
+/****************************************************************************
+ * Name: mm_subheap_destroy
+ *
+ * Description:
+ *   Give the memory of a sub-heap back to its parent heap.  The chunks
+ *   still allocated from the sub-heap are discarded and the tasks bound to
+ *   it go back to the user heap.
+ *
+ ****************************************************************************/
+
+void mm_subheap_destroy(FAR struct mm_subheap_s *subheap)
+{
+	FAR struct mm_subheap_s **prev;
+
+	DEBUGASSERT(subheap != NULL);
+
+	sched_lock();
+	for (prev = &g_subheaps; *prev != NULL; prev = &(*prev)->flink) {
+		if (*prev == subheap) {
+			*prev = subheap->flink;
+			break;
+		}
+	}
+	sched_foreach(mm_subheap_unbind, subheap);
+	sched_unlock();
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	mm_subheap_release(subheap);
+#endif
+	mm_free(subheap->parent, subheap);
+}
+
+/****************************************************************************
+ * Name: mm_subheap_reset
+ *
+ * Description:
+ *   Free every chunk of a sub-heap at once, leaving it as it was created.
+ *   No task may be using the chunks, or allocating from the sub-heap,
+ *   while it is reset.
+ *
+ ****************************************************************************/
+
+void mm_subheap_reset(FAR struct mm_subheap_s *subheap)
+{
+	FAR struct mm_heap_s *heap;
+
+	DEBUGASSERT(subheap != NULL);
+	heap = &subheap->heap;
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	mm_subheap_release(subheap);
+#endif
+
+	/* mm_initialize() would re-create the semaphore under any task
+	 * waiting on it.
+	 */
+
+	mm_takesemaphore(heap);
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	heap->total_alloc_size = 0;
+	heap->peak_alloc_size = 0;
+#endif
+	mm_reset(heap, subheap->start, subheap->size);
+	subheap->nresets++;
+	mm_givesemaphore(heap);
+}
+
+/****************************************************************************
+ * Name: mm_subheap_mallinfo
+ *
+ * Description:
+ *   Return the mallinfo of a sub-heap, as mallinfo() does for the user
+ *   heap.  In the user heap the whole sub-heap is one allocated chunk.
+ *
+ ****************************************************************************/
+
+int mm_subheap_mallinfo(FAR struct mm_subheap_s *subheap, FAR struct mallinfo *info)
+{
+	DEBUGASSERT(subheap != NULL);
+
+	return mm_mallinfo(&subheap->heap, info);
+}
+
+/****************************************************************************
+ * Name: mm_subheap_bind
+ *
+ * Description:
+ *   Make malloc() of the task pid (0 for the calling task) allocate from
+ *   subheap, or from the user heap again if subheap is NULL.  The binding
+ *   is per thread and is not inherited by the tasks it creates.
+ *
+ * Return Value:
+ *   OK, or -ESRCH if there is no such task.
+ *
+ ****************************************************************************/
+
+int mm_subheap_bind(pid_t pid, FAR struct mm_subheap_s *subheap)
+{
+	FAR struct tcb_s *tcb;
+
+	tcb = (pid == 0) ? sched_self() : sched_gettcb(pid);
+	if (tcb == NULL) {
+		return -ESRCH;
+	}
+
+	tcb->subheap = subheap;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: mm_subheap_member
+ *
+ * Description:
+ *   Return the sub-heap mem was allocated from, or NULL.
+ *
+ ****************************************************************************/
+
+FAR struct mm_subheap_s *mm_subheap_member(FAR void *mem)
+{
+	FAR struct mm_subheap_s *subheap;
+
+	/* The list is changed with the scheduler locked */
+
+	sched_lock();
+	for (subheap = g_subheaps; subheap != NULL; subheap = subheap->flink) {
+		if (mem > (FAR void *)subheap->heap.mm_heapstart[0] && mem < (FAR void *)subheap->heap.mm_heapend[0]) {
+			break;
+		}
+	}
+	sched_unlock();
+
+	return subheap;
+}
+
+/****************************************************************************
+ * Name: mm_subheap_allocheap
+ *
+ * Description:
+ *   Return the heap the calling task allocates from: its sub-heap if it is
+ *   bound to one, otherwise heap.
+ *
+ ****************************************************************************/
+
+FAR struct mm_heap_s *mm_subheap_allocheap(FAR struct mm_heap_s *heap)
+{
+	FAR struct tcb_s *tcb;
+
+	if (g_subheaps == NULL || up_interrupt_context()) {
+		return heap;
+	}
+
+	tcb = sched_self();
+	if (tcb != NULL && tcb->subheap != NULL) {
+		return &tcb->subheap->heap;
+	}
+
+	return heap;
+}
+
+/****************************************************************************
+ * Name: mm_subheap_ownerheap
+ *
+ * Description:
+ *   Return the heap mem must be freed to: the sub-heap it lies in, if any,
+ *   otherwise heap.  With a NULL mem, as from realloc(NULL, size), this
+ *   is the heap the calling task allocates from.
+ *
+ ****************************************************************************/
+
+FAR struct mm_heap_s *mm_subheap_ownerheap(FAR struct mm_heap_s *heap, FAR void *mem)
+{
+	FAR struct mm_subheap_s *subheap;
+
+	if (g_subheaps == NULL) {
+		return heap;
+	}
+
+	if (mem == NULL) {
+		return mm_subheap_allocheap(heap);
+	}
+
+	subheap = mm_subheap_member(mem);
+	return subheap != NULL ? &subheap->heap : heap;
+}
+
+#endif							/* CONFIG_MM_SUBHEAP */
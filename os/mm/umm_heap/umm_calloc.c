@@ -99,9 +99,9 @@ FAR void *calloc(size_t n, size_t elem_size)
 {
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	ARCH_GET_RET_ADDRESS
-	return mm_calloc(USR_HEAP, n, elem_size, retaddr);
+	return mm_calloc(UMM_ALLOCHEAP(USR_HEAP), n, elem_size, retaddr);
 #else
-	return mm_calloc(USR_HEAP, n, elem_size);
+	return mm_calloc(UMM_ALLOCHEAP(USR_HEAP), n, elem_size);
 #endif
 }
 
@@ -102,7 +102,7 @@
 
 void free(FAR void *mem)
 {
-	mm_free(USR_HEAP, mem);
+	mm_free(UMM_OWNERHEAP(USR_HEAP, mem), mem);
 }
 
 #endif							/* !CONFIG_BUILD_PROTECTED || !__KERNEL__ */
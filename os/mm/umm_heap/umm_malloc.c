@@ -149,9 +149,9 @@ FAR void *malloc(size_t size)
 #else
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	ARCH_GET_RET_ADDRESS
-	return mm_malloc(USR_HEAP, size, retaddr);
+	return mm_malloc(UMM_ALLOCHEAP(USR_HEAP), size, retaddr);
 #else
-	return mm_malloc(USR_HEAP, size);
+	return mm_malloc(UMM_ALLOCHEAP(USR_HEAP), size);
 #endif
 #endif
 }
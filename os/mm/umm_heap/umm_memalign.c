@@ -108,9 +108,9 @@ FAR void *memalign(size_t alignment, size_t size)
 {
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	ARCH_GET_RET_ADDRESS
-	return mm_memalign(USR_HEAP, alignment, size, retaddr);
+	return mm_memalign(UMM_ALLOCHEAP(USR_HEAP), alignment, size, retaddr);
 #else
-	return mm_memalign(USR_HEAP, alignment, size);
+	return mm_memalign(UMM_ALLOCHEAP(USR_HEAP), alignment, size);
 #endif
 }
 
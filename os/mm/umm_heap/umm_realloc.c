@@ -110,9 +110,9 @@ FAR void *realloc(FAR void *oldmem, size_t size)
 {
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	ARCH_GET_RET_ADDRESS
-	return mm_realloc(USR_HEAP, oldmem, size, retaddr);
+	return mm_realloc(UMM_OWNERHEAP(USR_HEAP, oldmem), oldmem, size, retaddr);
 #else
-	return mm_realloc(USR_HEAP, oldmem, size);
+	return mm_realloc(UMM_OWNERHEAP(USR_HEAP, oldmem), oldmem, size);
 #endif
 }
 
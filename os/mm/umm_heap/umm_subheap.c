@@ -0,0 +1,110 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdlib.h>
+
+#include <tinyara/kmalloc.h>
+#include <tinyara/mm/mm.h>
+
+#if defined(CONFIG_MM_SUBHEAP) && !defined(CONFIG_MM_KERNEL_HEAP)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Sub-heaps exist only in the flat build, where the user heap is common */
+
+#define USR_HEAP &g_mmheap
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* In the flat build the kernel allocates from the user heap.  With
+ * sub-heaps, it must do so whatever the calling task is bound to: kernel
+ * objects and task stacks outlive the requests a sub-heap is reset after.
+ * These therefore use the user heap directly, as malloc() and friends do
+ * for an unbound task.  kmm_free() remains free(), which finds the heap
+ * of the chunk.
+ */
+
+/************************************************************************
+ * Name: kmm_malloc
+ ************************************************************************/
+
+FAR void *kmm_malloc(size_t size)
+{
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	ARCH_GET_RET_ADDRESS
+	return mm_malloc(USR_HEAP, size, retaddr);
+#else
+	return mm_malloc(USR_HEAP, size);
+#endif
+}
+
+/************************************************************************
+ * Name: kmm_zalloc
+ ************************************************************************/
+
+FAR void *kmm_zalloc(size_t size)
+{
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	ARCH_GET_RET_ADDRESS
+	return mm_zalloc(USR_HEAP, size, retaddr);
+#else
+	return mm_zalloc(USR_HEAP, size);
+#endif
+}
+
+/************************************************************************
+ * Name: kmm_realloc
+ ************************************************************************/
+
+FAR void *kmm_realloc(FAR void *oldmem, size_t newsize)
+{
+	FAR struct mm_heap_s *heap = oldmem != NULL ? UMM_OWNERHEAP(USR_HEAP, oldmem) : USR_HEAP;
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	ARCH_GET_RET_ADDRESS
+	return mm_realloc(heap, oldmem, newsize, retaddr);
+#else
+	return mm_realloc(heap, oldmem, newsize);
+#endif
+}
+
+/************************************************************************
+ * Name: kmm_memalign
+ ************************************************************************/
+
+FAR void *kmm_memalign(size_t alignment, size_t size)
+{
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	ARCH_GET_RET_ADDRESS
+	return mm_memalign(USR_HEAP, alignment, size, retaddr);
+#else
+	return mm_memalign(USR_HEAP, alignment, size);
+#endif
+}
+
+#endif							/* CONFIG_MM_SUBHEAP && !CONFIG_MM_KERNEL_HEAP */
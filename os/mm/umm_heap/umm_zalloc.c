@@ -118,9 +118,9 @@ FAR void *zalloc(size_t size)
 	/* Use mm_zalloc() becuase it implements the clear */
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	ARCH_GET_RET_ADDRESS
-	return mm_zalloc(USR_HEAP, size, retaddr);
+	return mm_zalloc(UMM_ALLOCHEAP(USR_HEAP), size, retaddr);
 #else
-	return mm_zalloc(USR_HEAP, size);
+	return mm_zalloc(UMM_ALLOCHEAP(USR_HEAP), size);
 #endif
 #endif
 }
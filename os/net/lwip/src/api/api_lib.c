@@ -593,19 +593,11 @@ err_t netconn_send(struct netconn *conn, struct netbuf *buf)
 }
 
 /**
- * Send data over a TCP netconn.
- *
- * @param conn the TCP netconn over which to send data
- * @param dataptr pointer to the application buffer that contains the data to send
- * @param size size of the application data to send
- * @param apiflags combination of following flags :
- * - NETCONN_COPY: data will be copied into memory belonging to the stack
- * - NETCONN_MORE: for TCP connection, PSH flag will be set on last segment sent
- * - NETCONN_DONTBLOCK: only write the data if all dat can be written at once
- * @param bytes_written pointer to a location that receives the number of written bytes
- * @return ERR_OK if data was sent, any other err_t on error
+ * Common part of netconn_write_partly() and netconn_write_zc().
+ * 'zc_req' is owned by the stack once it has been queued by do_writemore;
+ * otherwise it is freed here.
  */
-err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written)
+static err_t netconn_write_internal(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written, struct netconn_zc_req *zc_req)
 {
 	struct api_msg msg;
 	err_t err;
@@ -629,6 +621,11 @@ err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t siz
 	msg.msg.msg.w.dataptr = dataptr;
 	msg.msg.msg.w.apiflags = apiflags;
 	msg.msg.msg.w.len = size;
+#if LWIP_NETCONN_ZEROCOPY_TX
+	msg.msg.msg.w.zc_req = zc_req;
+#else
+	LWIP_UNUSED_ARG(zc_req);
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 #if LWIP_SO_SNDTIMEO
 	if (conn->send_timeout != 0) {
 		/* get the time we started, which is later compared to
@@ -643,6 +640,12 @@ err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t siz
 	   but if it is, this is done inside api_msg.c:do_write(), so we can use the
 	   non-blocking version here. */
 	err = TCPIP_APIMSG(&msg);
+#if LWIP_NETCONN_ZEROCOPY_TX
+	if (msg.msg.msg.w.zc_req != NULL) {
+		/* nothing was queued by reference: the completion record is still ours */
+		mem_free(msg.msg.msg.w.zc_req);
+	}
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 	if ((err == ERR_OK) && (bytes_written != NULL)) {
 		if (dontblock
 #if LWIP_SO_SNDTIMEO
@@ -651,6 +654,12 @@ err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t siz
 		   ) {
 			/* nonblocking write: maybe the data has been sent partly */
 			*bytes_written = msg.msg.msg.w.len;
+#if LWIP_NETCONN_ZEROCOPY_TX
+		} else if (zc_req != NULL) {
+			/* a zero-copy write stops early if the connection fails after
+			   part of the data was queued */
+			*bytes_written = msg.msg.msg.w.len;
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 		} else {
 			/* blocking call succeeded: all data has been sent if it */
 			*bytes_written = size;
@@ -661,6 +670,69 @@ err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t siz
 	return err;
 }
 
+/**
+ * Send data over a TCP netconn.
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send
+ * @param size size of the application data to send
+ * @param apiflags combination of following flags :
+ * - NETCONN_COPY: data will be copied into memory belonging to the stack
+ * - NETCONN_MORE: for TCP connection, PSH flag will be set on last segment sent
+ * - NETCONN_DONTBLOCK: only write the data if all dat can be written at once
+ * @param bytes_written pointer to a location that receives the number of written bytes
+ * @return ERR_OK if data was sent, any other err_t on error
+ */
+err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written)
+{
+	return netconn_write_internal(conn, dataptr, size, apiflags, bytes_written, NULL);
+}
+
+#if LWIP_NETCONN_ZEROCOPY_TX
+/**
+ * Send data over a TCP netconn without copying it into the stack.
+ * The data is queued by reference, so the caller must not modify or free it
+ * until 'sent' has been called. 'sent' runs in tcpip_thread context with
+ * ERR_OK once the peer has acknowledged the last byte, or with the
+ * connection error if the connection is aborted before that.
+ * 'sent' is only called if at least part of the data was queued. In that
+ * case ERR_OK is returned even if the connection failed during the write,
+ * and *bytes_written tells how much was queued.
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send
+ * @param size size of the application data to send
+ * @param apiflags NETCONN_MORE and/or NETCONN_DONTBLOCK (NETCONN_COPY is ignored)
+ * @param bytes_written pointer to a location that receives the number of written bytes
+ * @param sent completion callback (may be NULL)
+ * @param arg argument passed to 'sent'
+ * @return ERR_OK if data was queued, any other err_t if nothing was
+ */
+err_t netconn_write_zc(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written, netconn_sent_fn sent, void *arg)
+{
+	struct netconn_zc_req *req;
+
+	LWIP_ERROR("netconn_write_zc: invalid conn", (conn != NULL), return ERR_ARG;);
+	LWIP_ERROR("netconn_write_zc: invalid conn->type", (conn->type == NETCONN_TCP), return ERR_VAL;);
+	if (size == 0) {
+		return ERR_OK;
+	}
+	if ((netconn_is_nonblocking(conn) || (apiflags & NETCONN_DONTBLOCK)) && !bytes_written) {
+		return ERR_VAL;
+	}
+	req = (struct netconn_zc_req *)mem_malloc(sizeof(struct netconn_zc_req));
+	if (req == NULL) {
+		return ERR_MEM;
+	}
+	req->next = NULL;
+	req->end_seq = 0;
+	req->sent = sent;
+	req->arg = arg;
+
+	return netconn_write_internal(conn, dataptr, size, apiflags & ~NETCONN_COPY, bytes_written, req);
+}
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
+
 /**
  * Close ot shutdown a TCP netconn (doesn't delete it).
  *
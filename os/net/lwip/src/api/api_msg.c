@@ -62,6 +62,7 @@
 #include <net/lwip/ipv4/ip.h>
 #include <net/lwip/udp.h>
 #include <net/lwip/tcp.h>
+#include <net/lwip/tcp_impl.h>
 #include <net/lwip/raw.h>
 
 #include <net/lwip/memp.h>
@@ -82,6 +83,34 @@ static err_t do_writemore(struct netconn *conn);
 static void do_close_internal(struct netconn *conn);
 #endif
 
+#if LWIP_TCP && LWIP_NETCONN_ZEROCOPY_TX
+/**
+ * Complete pending zero-copy writes of a TCP netconn.
+ * With pcb != NULL, only writes whose last byte has been acknowledged are
+ * completed (with 'err'); with pcb == NULL all pending writes are completed
+ * because the connection is gone and the buffers are not referenced anymore.
+ *
+ * @param conn the TCP netconn
+ * @param pcb the pcb of the netconn or NULL
+ * @param err the error passed to the completion callbacks
+ */
+static void netconn_zc_complete(struct netconn *conn, struct tcp_pcb *pcb, err_t err)
+{
+	struct netconn_zc_req *req;
+
+	while ((req = conn->zc_pending) != NULL) {
+		if ((pcb != NULL) && TCP_SEQ_LT(pcb->lastack, req->end_seq)) {
+			break;
+		}
+		conn->zc_pending = req->next;
+		if (req->sent != NULL) {
+			req->sent(req->arg, err);
+		}
+		mem_free(req);
+	}
+}
+#endif							/* LWIP_TCP && LWIP_NETCONN_ZEROCOPY_TX */
+
 #if LWIP_RAW
 /**
  * Receive callback function for RAW netconns.
@@ -327,6 +356,11 @@ static err_t sent_tcp(void *arg, struct tcp_pcb *pcb, u16_t len)
 	LWIP_UNUSED_ARG(pcb);
 	LWIP_ASSERT("conn != NULL", (conn != NULL));
 
+#if LWIP_NETCONN_ZEROCOPY_TX
+	/* release acknowledged zero-copy buffers before a pending close looks at them */
+	netconn_zc_complete(conn, pcb, ERR_OK);
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
+
 	if (conn->state == NETCONN_WRITE) {
 		do_writemore(conn);
 	} else if (conn->state == NETCONN_CLOSE) {
@@ -368,6 +402,11 @@ static void err_tcp(void *arg, err_t err)
 	conn->last_err = err;
 	SYS_ARCH_UNPROTECT(lev);
 
+#if LWIP_NETCONN_ZEROCOPY_TX
+	/* the pcb and its segments are gone: give all lent buffers back */
+	netconn_zc_complete(conn, NULL, err);
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
+
 	/* reset conn->state now before waking up other threads */
 	old_state = conn->state;
 	conn->state = NETCONN_NONE;
@@ -634,6 +673,9 @@ struct netconn *netconn_alloc(enum netconn_type t, netconn_callback callback)
 #if LWIP_TCP
 	conn->current_msg = NULL;
 	conn->write_offset = 0;
+#if LWIP_NETCONN_ZEROCOPY_TX
+	conn->zc_pending = NULL;
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 #endif							/* LWIP_TCP */
 #if LWIP_SO_SNDTIMEO
 	conn->send_timeout = 0;
@@ -668,6 +710,9 @@ void netconn_free(struct netconn *conn)
 	LWIP_ASSERT("recvmbox must be deallocated before calling this function", !sys_mbox_valid(&conn->recvmbox));
 #if LWIP_TCP
 	LWIP_ASSERT("acceptmbox must be deallocated before calling this function", !sys_mbox_valid(&conn->acceptmbox));
+#if LWIP_NETCONN_ZEROCOPY_TX
+	netconn_zc_complete(conn, NULL, ERR_CLSD);
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 #endif							/* LWIP_TCP */
 
 	sys_sem_free(&conn->op_completed);
@@ -767,6 +812,14 @@ static void do_close_internal(struct netconn *conn)
 	/* shutting down both ends is the same as closing */
 	close = shut == NETCONN_SHUT_RDWR;
 
+#if LWIP_NETCONN_ZEROCOPY_TX
+	if (shut_tx && (conn->zc_pending != NULL) && (conn->pcb.tcp->state != LISTEN)) {
+		/* the pcb still references application buffers: keep the callbacks
+		   and wait for sent_tcp/poll_tcp to retry once they are acknowledged */
+		return;
+	}
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
+
 	/* Set back some callback pointers */
 	if (close) {
 		tcp_arg(conn->pcb.tcp, NULL);
@@ -1305,6 +1358,30 @@ err_mem:
 		}
 	}
 	if (write_finished) {
+#if LWIP_NETCONN_ZEROCOPY_TX
+		if ((conn->current_msg->msg.w.zc_req != NULL) && (err != ERR_OK) && (conn->write_offset != 0)) {
+			/* the error came after part of the data was queued by reference:
+			   report that part as written, so that the application keeps the
+			   buffer until 'sent' is called for it */
+			conn->current_msg->msg.w.len = conn->write_offset;
+			conn->write_offset = 0;
+			err = ERR_OK;
+		}
+		if ((conn->current_msg->msg.w.zc_req != NULL) && (err == ERR_OK)) {
+			/* (some of) the data is queued by reference: remember where it ends
+			   so that sent_tcp can tell the application when it is acknowledged */
+			struct netconn_zc_req *req = conn->current_msg->msg.w.zc_req;
+			struct netconn_zc_req **tail = &conn->zc_pending;
+
+			req->end_seq = conn->pcb.tcp->snd_lbb;
+			req->next = NULL;
+			while (*tail != NULL) {
+				tail = &(*tail)->next;
+			}
+			*tail = req;
+			conn->current_msg->msg.w.zc_req = NULL;
+		}
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
 		/* everything was written: set back connection state
 		   and back to application task */
 		conn->current_msg->err = err;
@@ -818,6 +818,162 @@ int lwip_recvfrom(int s, void *mem, size_t len, int flags, struct sockaddr *from
 	return off;
 }
 
+#if LWIP_SOCKET_ZEROCOPY_RECV
+/**
+ * Lend received data to the caller without copying it.
+ *
+ * The payload of the pbuf chain pending on the socket (starting at the
+ * current read offset) is described in iov. The memory stays owned by the
+ * socket and is valid until lwip_recv_zc_release() or another receive call
+ * is made on the same socket.
+ *
+ * @param s the socket
+ * @param iov array receiving the payload segments
+ * @param iovcnt in: number of entries in iov, out: number of entries filled
+ * @param len maximum number of bytes to describe
+ * @param flags MSG_DONTWAIT is supported
+ * @return number of bytes described by iov, 0 if the connection was closed,
+ *         -1 on error (errno is set)
+ */
+int lwip_recv_zc(int s, struct iovec *iov, int *iovcnt, size_t len, int flags)
+{
+	struct socket *sock;
+	void *buf = NULL;
+	struct pbuf *p;
+	struct pbuf *q;
+	u16_t offset;
+	u16_t seglen;
+	size_t total = 0;
+	int n = 0;
+	err_t err;
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_zc(%d, %p, %" SZT_F ", 0x%x)\n", s, iov, len, flags));
+	sock = get_socket(s);
+	if (!sock) {
+		return -1;
+	}
+
+	if ((iov == NULL) || (iovcnt == NULL) || (*iovcnt <= 0)) {
+		sock_set_errno(sock, err_to_errno(ERR_ARG));
+		return -1;
+	}
+
+	if (sock->lastdata == NULL) {
+		if (((flags & MSG_DONTWAIT) || netconn_is_nonblocking(sock->conn)) && (sock->rcvevent <= 0)) {
+			LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_zc(%d): returning EWOULDBLOCK\n", s));
+			sock_set_errno(sock, EWOULDBLOCK);
+			return -1;
+		}
+
+		if (netconn_type(sock->conn) == NETCONN_TCP) {
+			err = netconn_recv_tcp_pbuf(sock->conn, (struct pbuf **)&buf);
+		} else {
+			err = netconn_recv(sock->conn, (struct netbuf **)&buf);
+		}
+
+		if (err != ERR_OK) {
+			LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_zc(%d): error is \"%s\"!\n", s, lwip_strerr(err)));
+			sock_set_errno(sock, err_to_errno(err));
+			return (err == ERR_CLSD) ? 0 : -1;
+		}
+		LWIP_ASSERT("buf != NULL", buf != NULL);
+		sock->lastdata = buf;
+		sock->lastoffset = 0;
+	}
+
+	if (netconn_type(sock->conn) == NETCONN_TCP) {
+		p = (struct pbuf *)sock->lastdata;
+	} else {
+		p = ((struct netbuf *)sock->lastdata)->p;
+	}
+
+	/* skip the part already consumed by earlier reads */
+	offset = sock->lastoffset;
+	for (q = p; (q != NULL) && (offset >= q->len); q = q->next) {
+		offset -= q->len;
+	}
+
+	for (; (q != NULL) && (n < *iovcnt) && (total < len); q = q->next) {
+		seglen = q->len - offset;
+		if (seglen > len - total) {
+			seglen = (u16_t)(len - total);
+		}
+		iov[n].iov_base = (u8_t *)q->payload + offset;
+		iov[n].iov_len = seglen;
+		total += seglen;
+		offset = 0;
+		n++;
+	}
+
+	*iovcnt = n;
+	sock_set_errno(sock, 0);
+	return (int)total;
+}
+
+/**
+ * Give back data lent by lwip_recv_zc().
+ *
+ * For TCP, 'consumed' bytes are removed from the head of the pending data and
+ * the receive window is opened by the same amount; unconsumed data is
+ * returned again by the next receive call. Datagram sockets always drop the
+ * whole datagram, as recvfrom() does.
+ *
+ * @param s the socket
+ * @param consumed number of bytes the application has processed
+ * @return 0 on success, -1 on error (errno is set)
+ */
+int lwip_recv_zc_release(int s, size_t consumed)
+{
+	struct socket *sock;
+	struct pbuf *p;
+	u16_t buflen;
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_zc_release(%d, %" SZT_F ")\n", s, consumed));
+	sock = get_socket(s);
+	if (!sock) {
+		return -1;
+	}
+
+	if (sock->lastdata == NULL) {
+		if (consumed != 0) {
+			sock_set_errno(sock, err_to_errno(ERR_ARG));
+			return -1;
+		}
+		sock_set_errno(sock, 0);
+		return 0;
+	}
+
+	if (netconn_type(sock->conn) == NETCONN_TCP) {
+		p = (struct pbuf *)sock->lastdata;
+		buflen = p->tot_len - sock->lastoffset;
+		if (consumed > buflen) {
+			sock_set_errno(sock, err_to_errno(ERR_ARG));
+			return -1;
+		}
+
+		if (consumed < buflen) {
+			sock->lastoffset += (u16_t)consumed;
+		} else {
+			pbuf_free(p);
+			sock->lastdata = NULL;
+			sock->lastoffset = 0;
+		}
+
+		if (consumed > 0) {
+			/* update receive window */
+			netconn_recved(sock->conn, (u32_t)consumed);
+		}
+	} else {
+		netbuf_delete((struct netbuf *)sock->lastdata);
+		sock->lastdata = NULL;
+		sock->lastoffset = 0;
+	}
+
+	sock_set_errno(sock, 0);
+	return 0;
+}
+#endif							/* LWIP_SOCKET_ZEROCOPY_RECV */
+
 int lwip_read(int s, void *mem, size_t len)
 {
 	return lwip_recvfrom(s, mem, len, 0, NULL, NULL);
@@ -1009,6 +1165,166 @@ int lwip_sendto(int s, const void *data, size_t size, int flags, const struct so
 	return (err == ERR_OK ? short_size : -1);
 }
 
+#if LWIP_SOCKET_SENDMSG
+/*
+ * Scatter-gather send.
+ * TCP: the iovec entries are queued back to back and PSH is only set after
+ * the last one, so small headers share segments with the data that follows.
+ * UDP/RAW: the entries are referenced by one pbuf chain and go out as a
+ * single datagram without an intermediate copy.
+ */
+int lwip_sendmsg(int s, const struct msghdr *msg, int flags)
+{
+	struct socket *sock;
+	err_t err = ERR_OK;
+	size_t total = 0;
+	size_t i;
+
+	sock = get_socket(s);
+	if (!sock) {
+		return -1;
+	}
+	LWIP_ERROR("lwip_sendmsg: invalid msghdr", (msg != NULL) && ((msg->msg_iov != NULL) || (msg->msg_iovlen == 0)), sock_set_errno(sock, err_to_errno(ERR_ARG)); return -1;);
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_sendmsg(%d, iovlen=%" SZT_F ", flags=0x%x)\n", s, (size_t)msg->msg_iovlen, flags));
+
+#if LWIP_TCP
+	if (sock->conn->type == NETCONN_TCP) {
+		u8_t write_flags;
+		size_t written;
+
+		for (i = 0; i < msg->msg_iovlen; i++) {
+			if (msg->msg_iov[i].iov_len == 0) {
+				continue;
+			}
+			write_flags = NETCONN_COPY | ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
+			if ((i + 1 < msg->msg_iovlen) || (flags & MSG_MORE)) {
+				write_flags |= NETCONN_MORE;
+			}
+			written = 0;
+			err = netconn_write_partly(sock->conn, msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len, write_flags, &written);
+			if (err != ERR_OK) {
+				break;
+			}
+			total += written;
+			if (written < msg->msg_iov[i].iov_len) {
+				/* non-blocking write ran out of send buffer */
+				break;
+			}
+		}
+		if ((err != ERR_OK) && (total > 0)) {
+			/* report the part that was queued, the error shows up on the next call */
+			err = ERR_OK;
+		}
+		sock_set_errno(sock, err_to_errno(err));
+		return (err == ERR_OK ? (int)total : -1);
+	}
+#endif							/* LWIP_TCP */
+
+#if (LWIP_UDP || LWIP_RAW)
+	{
+		const struct sockaddr_in *to_in = (const struct sockaddr_in *)msg->msg_name;
+		struct netbuf buf;
+
+		LWIP_ERROR("lwip_sendmsg: invalid address", (((to_in == NULL) && (msg->msg_namelen == 0)) || ((msg->msg_namelen == sizeof(struct sockaddr_in)) && (to_in->sin_family == AF_INET) && ((((mem_ptr_t)to_in) % 4) == 0))), sock_set_errno(sock, err_to_errno(ERR_ARG)); return -1;);
+
+		for (i = 0; i < msg->msg_iovlen; i++) {
+			total += msg->msg_iov[i].iov_len;
+		}
+		LWIP_ERROR("lwip_sendmsg: datagram too long", total <= 0xffff, sock_set_errno(sock, err_to_errno(ERR_VAL)); return -1;);
+
+		memset(&buf, 0, sizeof(buf));
+		if (to_in != NULL) {
+			inet_addr_to_ipaddr(&buf.addr, &to_in->sin_addr);
+			netbuf_fromport(&buf) = ntohs(to_in->sin_port);
+		} else {
+			ip_addr_set_any(&buf.addr);
+		}
+
+#if LWIP_NETIF_TX_SINGLE_PBUF
+		/* the netif wants one pbuf per packet: gather into a single buffer */
+		if (netbuf_alloc(&buf, (u16_t)total) == NULL) {
+			err = ERR_MEM;
+		} else {
+			u16_t offset = 0;
+			for (i = 0; i < msg->msg_iovlen; i++) {
+				MEMCPY((u8_t *)buf.p->payload + offset, msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+				offset += (u16_t)msg->msg_iov[i].iov_len;
+			}
+		}
+#else							/* LWIP_NETIF_TX_SINGLE_PBUF */
+		/* chain one PBUF_REF per entry; only the head needs room for headers */
+		for (i = 0; i < msg->msg_iovlen; i++) {
+			struct pbuf *p;
+
+			if (msg->msg_iov[i].iov_len == 0) {
+				continue;
+			}
+			p = pbuf_alloc((buf.p == NULL) ? PBUF_TRANSPORT : PBUF_RAW, (u16_t)msg->msg_iov[i].iov_len, PBUF_REF);
+			if (p == NULL) {
+				err = ERR_MEM;
+				break;
+			}
+			p->payload = msg->msg_iov[i].iov_base;
+			if (buf.p == NULL) {
+				buf.p = buf.ptr = p;
+			} else {
+				pbuf_cat(buf.p, p);
+			}
+		}
+		if ((err == ERR_OK) && (buf.p == NULL)) {
+			/* no iovec entries: send an empty datagram like sendto(s, NULL, 0) */
+			err = netbuf_ref(&buf, NULL, 0);
+		}
+#endif							/* LWIP_NETIF_TX_SINGLE_PBUF */
+		if (err == ERR_OK) {
+			err = netconn_send(sock->conn, &buf);
+		}
+		netbuf_free(&buf);
+		sock_set_errno(sock, err_to_errno(err));
+		return (err == ERR_OK ? (int)total : -1);
+	}
+#else							/* (LWIP_UDP || LWIP_RAW) */
+	sock_set_errno(sock, err_to_errno(ERR_ARG));
+	return -1;
+#endif							/* (LWIP_UDP || LWIP_RAW) */
+}
+#endif							/* LWIP_SOCKET_SENDMSG */
+
+#if LWIP_NETCONN_ZEROCOPY_TX
+/*
+ * Zero-copy TCP send: 'data' is queued by reference and must not be touched
+ * until 'sent' is called from tcpip_thread (see netconn_write_zc()).
+ */
+int lwip_send_zc(int s, const void *data, size_t size, int flags, netconn_sent_fn sent, void *arg)
+{
+	struct socket *sock;
+	err_t err;
+	u8_t write_flags;
+	size_t written;
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_zc(%d, data=%p, size=%" SZT_F ", flags=0x%x)\n", s, data, size, flags));
+
+	sock = get_socket(s);
+	if (!sock) {
+		return -1;
+	}
+
+	if (sock->conn->type != NETCONN_TCP) {
+		sock_set_errno(sock, err_to_errno(ERR_VAL));
+		return -1;
+	}
+
+	write_flags = ((flags & MSG_MORE) ? NETCONN_MORE : 0) | ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
+	written = 0;
+	err = netconn_write_zc(sock->conn, data, size, write_flags, &written, sent, arg);
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_zc(%d) err=%d written=%" SZT_F "\n", s, err, written));
+	sock_set_errno(sock, err_to_errno(err));
+	return (err == ERR_OK ? (int)written : -1);
+}
+#endif							/* LWIP_NETCONN_ZEROCOPY_TX */
+
 int argument_validation(int domain, int type, int protocol)
 {
 	if (domain == AF_AX25 || domain == AF_X25) {
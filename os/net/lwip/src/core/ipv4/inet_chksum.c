@@ -59,6 +59,7 @@
 #include <net/lwip/def.h>
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 /* These are some reference implementations of the checksum algorithm, with the
@@ -69,7 +70,7 @@
  * #define LWIP_CHKSUM <your_checksum_routine>
  *
  * Or you can select from the implementations below by defining
- * LWIP_CHKSUM_ALGORITHM to 1, 2 or 3.
+ * LWIP_CHKSUM_ALGORITHM to 1, 2, 3 or 4.
  */
 
 #ifndef LWIP_CHKSUM
@@ -270,6 +271,146 @@ static u16_t lwip_standard_chksum(void *dataptr, int len)
 }
 #endif
 
+#if (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2)
+/**
+ * Fold a 64-bit one's complement accumulator down to 16 bits.
+ */
+static u16_t lwip_chksum_fold64(uint64_t acc)
+{
+	u32_t sum;
+
+	acc = (acc >> 32) + (acc & 0xffffffffULL);
+	acc = (acc >> 32) + (acc & 0xffffffffULL);
+	sum = (u32_t)acc;
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+	return (u16_t)sum;
+}
+#endif
+
+#if (LWIP_CHKSUM_ALGORITHM == 4)	/* Alternative version #4 */
+#if defined(__ARM_ARCH_7A__) || defined(__ARM_ARCH_7R__) || \
+	defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+/**
+ * Sum nblocks 16-byte blocks of 32-bit aligned words. Four words are loaded
+ * with a single LDM and added through the carry flag, so the end-around
+ * carry costs one ADC per block instead of one compare per word.
+ */
+static u32_t lwip_chksum_blocks(const u32_t **pl, int nblocks)
+{
+	const u32_t *p = *pl;
+	u32_t sum = 0;
+	u32_t w0, w1, w2, w3;
+
+	__asm__ __volatile__(
+		"1:	ldmia	%[p]!, {%[w0], %[w1], %[w2], %[w3]}\n"
+		"	adds	%[sum], %[sum], %[w0]\n"
+		"	adcs	%[sum], %[sum], %[w1]\n"
+		"	adcs	%[sum], %[sum], %[w2]\n"
+		"	adcs	%[sum], %[sum], %[w3]\n"
+		"	adc	%[sum], %[sum], #0\n"
+		"	subs	%[n], %[n], #1\n"
+		"	bne	1b\n"
+		: [p] "+r"(p), [n] "+r"(nblocks), [sum] "+r"(sum),
+		  [w0] "=&r"(w0), [w1] "=&r"(w1), [w2] "=&r"(w2), [w3] "=&r"(w3)
+		:
+		: "cc", "memory");
+
+	*pl = p;
+	return sum;
+}
+#else
+/**
+ * Portable variant: 32-bit words are added into a 64-bit accumulator, which
+ * cannot overflow for any length lwIP hands us, so no carry handling is
+ * needed inside the loop.
+ */
+static uint64_t lwip_chksum_blocks(const u32_t **pl, int nblocks)
+{
+	const u32_t *p = *pl;
+	uint64_t sum = 0;
+
+	while (nblocks-- > 0) {
+		sum += p[0];
+		sum += p[1];
+		sum += p[2];
+		sum += p[3];
+		p += 4;
+	}
+
+	*pl = p;
+	return sum;
+}
+#endif
+
+/**
+ * Checksum routine summing 16 bytes per iteration. The head is consumed
+ * until the pointer is 32-bit aligned, the bulk is handed to
+ * lwip_chksum_blocks() and the tail is consumed by words, halfwords and a
+ * dangling byte.
+ *
+ * @arg start of buffer to be checksummed. May be an odd byte address.
+ * @len number of bytes in the buffer to be checksummed.
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+static u16_t lwip_standard_chksum(void *dataptr, int len)
+{
+	u8_t *pb = (u8_t *)dataptr;
+	const u32_t *pl;
+	u16_t t = 0;
+	uint64_t sum = 0;
+	u16_t result;
+	/* starts at odd byte address? */
+	int odd = ((mem_ptr_t)pb & 1);
+
+	if (odd && len > 0) {
+		((u8_t *)&t)[1] = *pb++;
+		len--;
+	}
+
+	if (((mem_ptr_t)pb & 2) && len > 1) {
+		sum += *(u16_t *)(void *)pb;
+		pb += 2;
+		len -= 2;
+	}
+
+	pl = (const u32_t *)(void *)pb;
+
+	if (len >= 16) {
+		sum += lwip_chksum_blocks(&pl, len >> 4);
+		len &= 15;
+	}
+
+	while (len > 3) {
+		sum += *pl++;
+		len -= 4;
+	}
+
+	pb = (u8_t *)pl;
+
+	/* 16-bit aligned word remaining? */
+	if (len > 1) {
+		sum += *(u16_t *)(void *)pb;
+		pb += 2;
+		len -= 2;
+	}
+
+	/* dangling tail byte remaining? */
+	if (len > 0) {
+		((u8_t *)&t)[0] = *pb;
+	}
+
+	sum += t;
+
+	result = lwip_chksum_fold64(sum);
+	if (odd) {
+		result = SWAP_BYTES_IN_WORD(result);
+	}
+
+	return result;
+}
+#endif
+
 /* inet_chksum_pseudo:
  *
  * Calculates the pseudo Internet checksum used by TCP and UDP for a pbuf chain.
@@ -451,3 +592,79 @@ u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len)
 	return LWIP_CHKSUM(dst, len);
 }
 #endif							/* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2)	/* Version #2 */
+/** Copy and checksum in a single pass over the data. When source and
+ * destination share the same 32-bit alignment, the body is moved word by
+ * word and each word is added into a 64-bit accumulator on its way through
+ * the registers. The (at most three byte) head and tail are copied with
+ * MEMCPY and summed afterwards. Mismatched alignments fall back to version #1.
+ */
+u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+	const u8_t *s = (const u8_t *)src;
+	u8_t *d = (u8_t *)dst;
+	const u32_t *sl;
+	u32_t *dl;
+	u16_t head;
+	u16_t words;
+	u16_t tail;
+	u16_t body;
+	uint64_t acc = 0;
+	u32_t sum;
+
+	if (len < 16 || ((((mem_ptr_t)s) ^ ((mem_ptr_t)d)) & 3) != 0) {
+		MEMCPY(dst, src, len);
+		return LWIP_CHKSUM(dst, len);
+	}
+
+	head = (u16_t)((4 - ((mem_ptr_t)s & 3)) & 3);
+	words = (u16_t)((len - head) >> 2);
+	tail = (u16_t)(len - head - (words << 2));
+
+	sl = (const u32_t *)(const void *)(s + head);
+	dl = (u32_t *)(void *)(d + head);
+	while (words >= 4) {
+		u32_t w0 = sl[0];
+		u32_t w1 = sl[1];
+		u32_t w2 = sl[2];
+		u32_t w3 = sl[3];
+		dl[0] = w0;
+		dl[1] = w1;
+		dl[2] = w2;
+		dl[3] = w3;
+		acc += w0;
+		acc += w1;
+		acc += w2;
+		acc += w3;
+		sl += 4;
+		dl += 4;
+		words -= 4;
+	}
+	while (words-- > 0) {
+		u32_t w = *sl++;
+		*dl++ = w;
+		acc += w;
+	}
+	body = lwip_chksum_fold64(acc);
+
+	sum = 0;
+	if (head > 0) {
+		MEMCPY(d, s, head);
+		sum += LWIP_CHKSUM(d, head);
+	}
+	if (tail > 0) {
+		MEMCPY(dl, sl, tail);
+		body = (u16_t)FOLD_U32T((u32_t)body + LWIP_CHKSUM(dl, tail));
+	}
+
+	/* body and tail start at offset 'head' from dst: swap if that is odd */
+	if (head & 1) {
+		body = SWAP_BYTES_IN_WORD(body);
+	}
+	sum += body;
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+	return (u16_t)sum;
+}
+#endif							/* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
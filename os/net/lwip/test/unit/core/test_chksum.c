@@ -0,0 +1,250 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "test_chksum.h"
+
+#include <net/lwip/pbuf.h>
+#include <net/lwip/def.h>
+#include <net/lwip/ipv4/inet_chksum.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if !LWIP_CHECKSUM_ON_COPY
+#error "This tests needs LWIP_CHECKSUM_ON_COPY enabled"
+#endif
+
+#define CHKSUM_TEST_MAXLEN   1600
+#define CHKSUM_BENCH_ROUNDS  2000
+
+static u8_t chksum_src[CHKSUM_TEST_MAXLEN + 8];
+static u8_t chksum_dst[CHKSUM_TEST_MAXLEN + 8];
+
+static const u16_t chksum_lens[] = { 1, 2, 3, 15, 16, 17, 63, 64, 65, 536, 1023, 1460, 1500 };
+static const u16_t chksum_segs[] = { 1, 3, 64, 128, 0xffff };
+
+/* Helper functions */
+
+/** Byte-wise reference sum in network order (non-inverted) */
+static u16_t chksum_reference(const u8_t *data, int len)
+{
+	u32_t acc = 0;
+
+	while (len > 1) {
+		acc += ((u32_t)data[0] << 8) | data[1];
+		data += 2;
+		len -= 2;
+	}
+	if (len > 0) {
+		acc += (u32_t)data[0] << 8;
+	}
+	while (acc >> 16) {
+		acc = (acc >> 16) + (acc & 0xffffUL);
+	}
+	return (u16_t)acc;
+}
+
+/** Build a chain of 'seglen' sized PBUF_RAM pbufs holding 'len' bytes of
+ * chksum_src. Each payload is moved by 'align' bytes to exercise odd and
+ * unaligned buffer starts. */
+static struct pbuf *chksum_make_chain(u16_t len, u16_t seglen, u16_t align)
+{
+	struct pbuf *head = NULL;
+	u16_t pos = 0;
+
+	while (pos < len) {
+		u16_t n = LWIP_MIN(seglen, len - pos);
+		struct pbuf *q = pbuf_alloc(PBUF_RAW, n + align, PBUF_RAM);
+		EXPECT_RETNULL(q != NULL);
+		pbuf_header(q, -(s16_t)align);
+		MEMCPY(q->payload, &chksum_src[pos], n);
+		if (head == NULL) {
+			head = q;
+		} else {
+			pbuf_cat(head, q);
+		}
+		pos += n;
+	}
+	return head;
+}
+
+/* Setups/teardown functions */
+
+static void chksum_setup(void)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(chksum_src); i++) {
+		chksum_src[i] = (u8_t)(i * 7 + (i >> 8) + 0x5a);
+	}
+}
+
+static void chksum_teardown(void)
+{
+}
+
+/* Test functions */
+
+/** Compare inet_chksum against the reference for all alignments */
+START_TEST(test_chksum_buffer)
+{
+	u16_t len;
+	u16_t off;
+	LWIP_UNUSED_ARG(_i);
+
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len <= CHKSUM_TEST_MAXLEN; len++) {
+			u16_t sum = (u16_t)~inet_chksum(&chksum_src[off], len);
+			fail_unless(ntohs(sum) == chksum_reference(&chksum_src[off], len));
+		}
+	}
+}
+
+END_TEST
+
+/** Compare inet_chksum_pbuf against the reference for chained pbufs */
+START_TEST(test_chksum_pbuf_chain)
+{
+	size_t l;
+	size_t s;
+	u16_t align;
+	LWIP_UNUSED_ARG(_i);
+
+	for (l = 0; l < sizeof(chksum_lens) / sizeof(chksum_lens[0]); l++) {
+		for (s = 0; s < sizeof(chksum_segs) / sizeof(chksum_segs[0]); s++) {
+			for (align = 0; align < 4; align++) {
+				struct pbuf *p = chksum_make_chain(chksum_lens[l], chksum_segs[s], align);
+				u16_t sum;
+				EXPECT_RET(p != NULL);
+				sum = (u16_t)~inet_chksum_pbuf(p);
+				fail_unless(ntohs(sum) == chksum_reference(chksum_src, chksum_lens[l]));
+				pbuf_free(p);
+			}
+		}
+	}
+}
+
+END_TEST
+
+/** lwip_chksum_copy must copy exactly and return the same sum as LWIP_CHKSUM */
+START_TEST(test_chksum_copy)
+{
+	u16_t len;
+	u16_t soff;
+	u16_t doff;
+	LWIP_UNUSED_ARG(_i);
+
+	for (soff = 0; soff < 4; soff++) {
+		for (doff = 0; doff < 4; doff++) {
+			for (len = 1; len <= CHKSUM_TEST_MAXLEN; len++) {
+				u16_t sum;
+				memset(chksum_dst, 0, sizeof(chksum_dst));
+				sum = LWIP_CHKSUM_COPY(&chksum_dst[doff], &chksum_src[soff], len);
+				fail_unless(memcmp(&chksum_dst[doff], &chksum_src[soff], len) == 0);
+				fail_unless(sum == (u16_t)~inet_chksum(&chksum_src[soff], len));
+			}
+		}
+	}
+}
+
+END_TEST
+
+/** pbuf_fill_chksum at odd offsets must match a checksum over the whole pbuf */
+START_TEST(test_chksum_fill)
+{
+	struct pbuf *p;
+	u16_t chksum = 0;
+	u16_t off = 0;
+	u16_t n = 1;
+	LWIP_UNUSED_ARG(_i);
+
+	p = pbuf_alloc(PBUF_RAW, CHKSUM_TEST_MAXLEN, PBUF_RAM);
+	EXPECT_RET(p != NULL);
+	while (off < CHKSUM_TEST_MAXLEN) {
+		n = LWIP_MIN(n, CHKSUM_TEST_MAXLEN - off);
+		fail_unless(pbuf_fill_chksum(p, off, &chksum_src[off], n, &chksum) == ERR_OK);
+		off += n;
+		n = (u16_t)(n * 3 + 1);
+	}
+	fail_unless(memcmp(p->payload, chksum_src, CHKSUM_TEST_MAXLEN) == 0);
+	fail_unless(ntohs(chksum) == chksum_reference(chksum_src, CHKSUM_TEST_MAXLEN));
+	pbuf_free(p);
+}
+
+END_TEST
+
+/** Not a pass/fail test: report checksum and checksum-on-copy throughput
+ * over pbuf chains of typical sizes and alignments */
+START_TEST(test_chksum_bench)
+{
+	static const u16_t sizes[] = { 64, 536, 1460 };
+	size_t i;
+	u16_t align;
+	int round;
+	volatile u16_t sink = 0;
+	LWIP_UNUSED_ARG(_i);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		for (align = 0; align < 4; align++) {
+			struct pbuf *p = chksum_make_chain(sizes[i], 256, align);
+			clock_t start;
+			double sum_us;
+			double copy_us;
+			double memcpy_us;
+			EXPECT_RET(p != NULL);
+
+			start = clock();
+			for (round = 0; round < CHKSUM_BENCH_ROUNDS; round++) {
+				sink += inet_chksum_pbuf(p);
+			}
+			sum_us = (double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC / CHKSUM_BENCH_ROUNDS;
+
+			start = clock();
+			for (round = 0; round < CHKSUM_BENCH_ROUNDS; round++) {
+				sink += LWIP_CHKSUM_COPY(&chksum_dst[align], &chksum_src[align], sizes[i]);
+			}
+			copy_us = (double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC / CHKSUM_BENCH_ROUNDS;
+
+			start = clock();
+			for (round = 0; round < CHKSUM_BENCH_ROUNDS; round++) {
+				MEMCPY(&chksum_dst[align], &chksum_src[align], sizes[i]);
+				sink += inet_chksum(&chksum_dst[align], sizes[i]);
+			}
+			memcpy_us = (double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC / CHKSUM_BENCH_ROUNDS;
+
+			printf("chksum len %4u align %u: pbuf %.3f us, copy+sum %.3f us, memcpy then sum %.3f us\n", sizes[i], align, sum_us, copy_us, memcpy_us);
+			pbuf_free(p);
+		}
+	}
+	LWIP_UNUSED_ARG(sink);
+}
+
+END_TEST
+/** Create the suite including all tests for this module */
+Suite *chksum_suite(void)
+{
+	TFun tests[] = {
+		test_chksum_buffer,
+		test_chksum_pbuf_chain,
+		test_chksum_copy,
+		test_chksum_fill,
+		test_chksum_bench
+	};
+	return create_suite("CHKSUM", tests, sizeof(tests) / sizeof(TFun), chksum_setup, chksum_teardown);
+}
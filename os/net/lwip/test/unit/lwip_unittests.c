@@ -22,6 +22,7 @@
 #include "tcp/test_tcp.h"
 #include "tcp/test_tcp_oos.h"
 #include "core/test_mem.h"
+#include "core/test_chksum.h"
 #include "etharp/test_etharp.h"
 
 #include <net/lwip/init.h>
@@ -36,6 +37,7 @@ int main()
 		tcp_suite,
 		tcp_oos_suite,
 		mem_suite,
+		chksum_suite,
 		etharp_suite
 	};
 	size_t num = sizeof(suites) / sizeof(void *);
@@ -119,6 +119,18 @@ int recvfrom(int s, void *mem, size_t len, int flags, struct sockaddr *from, soc
 	return lwip_recvfrom(s, mem, len, flags, from, fromlen);
 }
 
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_RECV
+ssize_t recv_zc(int s, struct iovec *iov, int *iovcnt, size_t len, int flags)
+{
+	return lwip_recv_zc(s, iov, iovcnt, len, flags);
+}
+
+int recv_zc_release(int s, size_t consumed)
+{
+	return lwip_recv_zc_release(s, consumed);
+}
+#endif
+
 int send(int s, const void *data, size_t size, int flags)
 {
 	return lwip_send(s, data, size, flags);
@@ -129,6 +141,20 @@ int sendto(int s, const void *data, size_t size, int flags, const struct sockadd
 	return lwip_sendto(s, data, size, flags, to, tolen);
 }
 
+#ifdef CONFIG_NET_SOCKET_SENDMSG
+ssize_t sendmsg(int s, const struct msghdr *msg, int flags)
+{
+	return lwip_sendmsg(s, msg, flags);
+}
+#endif
+
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY_SEND
+ssize_t send_zc(int s, const void *data, size_t size, int flags, netconn_sent_fn sent, void *arg)
+{
+	return lwip_send_zc(s, data, size, flags, sent, arg);
+}
+#endif
+
 int socket(int domain, int type, int protocol)
 {
 	return lwip_socket(domain, type, protocol);
@@ -18,8 +18,14 @@
 
 #include <tinyara/config.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <tls/easy_tls.h>
+#ifdef CONFIG_TLS_SESSION_STORE
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <tls/tls_session_store.h>
+#endif
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -216,6 +222,29 @@ errout:
 	return ret;
 }
 
+#ifdef CONFIG_TLS_SESSION_STORE
+/* The session store key of a client session: host_name if given, else the
+ * peer address, and the peer port. */
+static int tls_session_peer(tls_session *session, tls_opt *opt, char *host, size_t len, unsigned short *port)
+{
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+
+	if (getpeername(session->net.fd, (struct sockaddr *)&addr, &addrlen) < 0 || addr.sin_family != AF_INET) {
+		return -1;
+	}
+	*port = ntohs(addr.sin_port);
+
+	if (opt->host_name) {
+		strncpy(host, opt->host_name, len - 1);
+		host[len - 1] = '\0';
+	} else if (inet_ntop(AF_INET, &addr.sin_addr, host, len) == NULL) {
+		return -1;
+	}
+	return 0;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -280,6 +309,12 @@ tls_session *TLSSession(int fd, tls_ctx *ctx, tls_opt *opt)
 {
 	int ret;
 	tls_session *session = NULL;
+#ifdef CONFIG_TLS_SESSION_STORE
+	char host[64];
+	unsigned short port = 0;
+	int stored = 0;
+	int resume = 0;
+#endif
 
 	if (ctx == NULL || opt == NULL || fd <= 0) {
 		EASY_TLS_DEBUG("TLSSession input error\n");
@@ -305,6 +340,13 @@ tls_session *TLSSession(int fd, tls_ctx *ctx, tls_opt *opt)
 		goto errout;
 	}
 
+#ifdef CONFIG_TLS_SESSION_STORE
+	if (opt->server == MBEDTLS_SSL_IS_CLIENT && opt->transport == MBEDTLS_SSL_TRANSPORT_STREAM) {
+		stored = tls_session_peer(session, opt, host, sizeof(host), &port) == 0;
+		resume = stored && tls_session_store_load(host, port, session->ssl) == 0;
+	}
+#endif
+
 	EASY_TLS_DEBUG("Handshake start .... ");
 
 	while ((ret = mbedtls_ssl_handshake(session->ssl)) != 0) {
@@ -313,11 +355,22 @@ tls_session *TLSSession(int fd, tls_ctx *ctx, tls_opt *opt)
 				EASY_TLS_DEBUG("Failed !! certificate verify fail %d\n", ret);
 			}
 			EASY_TLS_DEBUG("Failed !! %d\n", ret);
+#ifdef CONFIG_TLS_SESSION_STORE
+			if (resume) {
+				tls_session_store_remove(host, port);
+			}
+#endif
 			goto errout;
 		}
 
 	}
 
+#ifdef CONFIG_TLS_SESSION_STORE
+	if (stored) {
+		tls_session_store_save(host, port, session->ssl);
+	}
+#endif
+
 	EASY_TLS_DEBUG("Success !!\n");
 	return session;
 errout:
@@ -346,7 +346,8 @@ void mbedtls_ecp_group_free(mbedtls_ecp_group *grp)
 		mbedtls_mpi_free(&grp->N);
 	}
 
-	if (grp->T != NULL) {
+	/* T_size == 0: static table from mbedtls_ecp_group_load() */
+	if (grp->T != NULL && grp->T_size != 0) {
 		for (i = 0; i < grp->T_size; i++) {
 			mbedtls_ecp_point_free(&grp->T[i]);
 		}
@@ -452,6 +452,39 @@ void mbedtls_net_usleep(unsigned long usec)
 #endif
 }
 
+#if defined(CONFIG_NET_SOCKET_ZEROCOPY_RECV)
+#define NET_RECV_ZC_IOVCNT 4
+
+/*
+ * Copy the record bytes straight out of the lwIP pbufs lent by recv_zc(),
+ * skipping the read() dispatch and the recvfrom() copy loop
+ */
+static int net_recv_zc(int fd, unsigned char *buf, size_t len)
+{
+	struct iovec iov[NET_RECV_ZC_IOVCNT];
+	int iovcnt = NET_RECV_ZC_IOVCNT;
+	size_t off = 0;
+	int ret;
+	int i;
+
+	ret = (int)recv_zc(fd, iov, &iovcnt, len, 0);
+	if (ret <= 0) {
+		return ret;
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(buf + off, iov[i].iov_base, iov[i].iov_len);
+		off += iov[i].iov_len;
+	}
+
+	if (recv_zc_release(fd, off) < 0) {
+		return -1;
+	}
+
+	return (int)off;
+}
+#endif
+
 /*
  * Read at most 'len' characters
  */
@@ -464,7 +497,11 @@ int mbedtls_net_recv(void *ctx, unsigned char *buf, size_t len)
 		return (MBEDTLS_ERR_NET_INVALID_CONTEXT);
 	}
 
+#if defined(CONFIG_NET_SOCKET_ZEROCOPY_RECV)
+	ret = net_recv_zc(fd, buf, len);
+#else
 	ret = (int)read(fd, buf, len);
+#endif
 
 	if (ret < 0) {
 		if (net_would_block(ctx) != 0) {
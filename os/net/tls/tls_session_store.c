@@ -0,0 +1,561 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#ifdef CONFIG_TLS_SESSION_STORE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <tls/tls_session_store.h>
+#include <tls/sha256.h>
+#include <tls/x509_crt.h>
+#if defined(MBEDTLS_X509_CRL_PARSE_C)
+#include <tls/x509_crl.h>
+#endif
+#if defined(MBEDTLS_PLATFORM_C)
+#include <tls/platform.h>
+#else
+#include <stdlib.h>
+#define mbedtls_calloc    calloc
+#define mbedtls_free      free
+#endif
+#if defined(MBEDTLS_HAVE_TIME)
+#include <tls/platform_time.h>
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TLS_SESSION_KEY_LEN		64
+#define TLS_SESSION_CONF_LEN	16
+#define TLS_SESSION_FILE_MAGIC	0x54535332	/* "TSS2" */
+#define TLS_SESSION_TICKET_MAX	1024
+#define TLS_SESSION_CERT_MAX	4096
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_CLI_C)
+#define TLS_SESSION_HAS_TICKETS	1
+#else
+#define TLS_SESSION_HAS_TICKETS	0
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct tls_session_entry {
+	char key[TLS_SESSION_KEY_LEN];	/* "host:port", empty if unused */
+	uint8_t conf[TLS_SESSION_CONF_LEN];	/* digest of how the peer was verified */
+	uint32_t stamp;				/* last use, for LRU replacement */
+	mbedtls_ssl_session session;
+};
+
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+/* On-flash image of one entry, followed by ticket_len ticket bytes and
+ * cert_len bytes of the DER peer certificate
+ */
+struct tls_session_record {
+	char key[TLS_SESSION_KEY_LEN];
+	uint8_t conf[TLS_SESSION_CONF_LEN];
+	uint32_t stamp;
+	int64_t start;
+	int32_t ciphersuite;
+	int32_t compression;
+	uint32_t verify_result;
+	uint32_t ticket_lifetime;
+	uint16_t ticket_len;
+	uint16_t cert_len;
+	uint8_t id_len;
+	uint8_t mfl_code;
+	uint8_t trunc_hmac;
+	uint8_t encrypt_then_mac;
+	uint8_t id[32];
+	uint8_t master[48];
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct tls_session_entry g_tls_sessions[CONFIG_TLS_SESSION_STORE_ENTRIES];
+static uint32_t g_tls_session_clock;
+static pthread_mutex_t g_tls_session_lock = PTHREAD_MUTEX_INITIALIZER;
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+static int g_tls_session_loaded;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int tls_session_key(char *key, const char *host, unsigned short port)
+{
+	int len;
+
+	if (host == NULL) {
+		return -1;
+	}
+	len = snprintf(key, TLS_SESSION_KEY_LEN, "%s:%u", host, port);
+	if (len <= 0 || len >= TLS_SESSION_KEY_LEN) {
+		return -1;
+	}
+	return 0;
+}
+
+/* A session is only offered to a connection that verifies the server the
+ * same way as the one that made it: resuming skips the verification. The
+ * digest covers the authmode, the verify callback and the trusted CAs and
+ * CRLs of the ssl configuration.
+ */
+static void tls_session_conf(uint8_t *conf, const mbedtls_ssl_context *ssl)
+{
+	mbedtls_sha256_context sha;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	const mbedtls_x509_crt *crt;
+#endif
+#if defined(MBEDTLS_X509_CRL_PARSE_C)
+	const mbedtls_x509_crl *crl;
+#endif
+	uint8_t digest[32];
+	uint8_t authmode = ssl->conf->authmode;
+
+	mbedtls_sha256_init(&sha);
+	mbedtls_sha256_starts(&sha, 0);
+	mbedtls_sha256_update(&sha, &authmode, sizeof(authmode));
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	mbedtls_sha256_update(&sha, (const unsigned char *)&ssl->conf->f_vrfy, sizeof(ssl->conf->f_vrfy));
+	for (crt = ssl->conf->ca_chain; crt != NULL && crt->raw.p != NULL; crt = crt->next) {
+		mbedtls_sha256_update(&sha, crt->raw.p, crt->raw.len);
+	}
+#endif
+#if defined(MBEDTLS_X509_CRL_PARSE_C)
+	for (crl = ssl->conf->ca_crl; crl != NULL && crl->raw.p != NULL; crl = crl->next) {
+		mbedtls_sha256_update(&sha, crl->raw.p, crl->raw.len);
+	}
+#endif
+	mbedtls_sha256_finish(&sha, digest);
+	mbedtls_sha256_free(&sha);
+
+	memcpy(conf, digest, TLS_SESSION_CONF_LEN);
+}
+
+static struct tls_session_entry *tls_session_find(const char *key, const uint8_t *conf)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_TLS_SESSION_STORE_ENTRIES; i++) {
+		if (g_tls_sessions[i].key[0] != '\0' && strcmp(g_tls_sessions[i].key, key) == 0 && memcmp(g_tls_sessions[i].conf, conf, TLS_SESSION_CONF_LEN) == 0) {
+			return &g_tls_sessions[i];
+		}
+	}
+	return NULL;
+}
+
+static struct tls_session_entry *tls_session_victim(void)
+{
+	struct tls_session_entry *victim = &g_tls_sessions[0];
+	int i;
+
+	for (i = 0; i < CONFIG_TLS_SESSION_STORE_ENTRIES; i++) {
+		if (g_tls_sessions[i].key[0] == '\0') {
+			return &g_tls_sessions[i];
+		}
+		if ((int32_t)(g_tls_sessions[i].stamp - victim->stamp) < 0) {
+			victim = &g_tls_sessions[i];
+		}
+	}
+	return victim;
+}
+
+static void tls_session_drop(struct tls_session_entry *entry)
+{
+	mbedtls_ssl_session_free(&entry->session);
+	entry->key[0] = '\0';
+}
+
+static int tls_session_expired(const struct tls_session_entry *entry)
+{
+#if defined(MBEDTLS_HAVE_TIME) && (CONFIG_TLS_SESSION_STORE_TIMEOUT > 0)
+	mbedtls_time_t now = mbedtls_time(NULL);
+
+	/* a clock that has not been set yet (now < start) keeps the entry */
+	if (now > entry->session.start && now - entry->session.start > CONFIG_TLS_SESSION_STORE_TIMEOUT) {
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+static void tls_session_flush(void)
+{
+	struct tls_session_record rec;
+	const struct tls_session_entry *entry;
+	uint32_t magic = TLS_SESSION_FILE_MAGIC;
+	int fd;
+	int i;
+
+	fd = open(CONFIG_TLS_SESSION_STORE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		return;
+	}
+	if (write(fd, &magic, sizeof(magic)) != sizeof(magic)) {
+		goto errout;
+	}
+
+	for (i = 0; i < CONFIG_TLS_SESSION_STORE_ENTRIES; i++) {
+		entry = &g_tls_sessions[i];
+		if (entry->key[0] == '\0') {
+			continue;
+		}
+
+		memset(&rec, 0, sizeof(rec));
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+		if (entry->session.peer_cert != NULL) {
+			if (entry->session.peer_cert->raw.len > TLS_SESSION_CERT_MAX) {
+				/* kept in RAM only */
+				continue;
+			}
+			rec.cert_len = (uint16_t)entry->session.peer_cert->raw.len;
+		}
+#endif
+		memcpy(rec.key, entry->key, sizeof(rec.key));
+		memcpy(rec.conf, entry->conf, sizeof(rec.conf));
+		rec.stamp = entry->stamp;
+#if defined(MBEDTLS_HAVE_TIME)
+		rec.start = (int64_t)entry->session.start;
+#endif
+		rec.ciphersuite = entry->session.ciphersuite;
+		rec.compression = entry->session.compression;
+		rec.verify_result = entry->session.verify_result;
+		rec.id_len = (uint8_t)entry->session.id_len;
+		memcpy(rec.id, entry->session.id, sizeof(rec.id));
+		memcpy(rec.master, entry->session.master, sizeof(rec.master));
+#if TLS_SESSION_HAS_TICKETS
+		rec.ticket_lifetime = entry->session.ticket_lifetime;
+		rec.ticket_len = (uint16_t)entry->session.ticket_len;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+		rec.mfl_code = entry->session.mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+		rec.trunc_hmac = (uint8_t)entry->session.trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+		rec.encrypt_then_mac = (uint8_t)entry->session.encrypt_then_mac;
+#endif
+		if (write(fd, &rec, sizeof(rec)) != sizeof(rec)) {
+			goto errout;
+		}
+#if TLS_SESSION_HAS_TICKETS
+		if (rec.ticket_len > 0 && write(fd, entry->session.ticket, rec.ticket_len) != rec.ticket_len) {
+			goto errout;
+		}
+#endif
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+		if (rec.cert_len > 0 && write(fd, entry->session.peer_cert->raw.p, rec.cert_len) != rec.cert_len) {
+			goto errout;
+		}
+#endif
+	}
+
+	close(fd);
+	return;
+
+errout:
+	/* never leave a half-written file behind */
+	close(fd);
+	unlink(CONFIG_TLS_SESSION_STORE_PATH);
+}
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+static int tls_session_restore_cert(int fd, mbedtls_ssl_session *session, uint16_t len)
+{
+	unsigned char *der;
+	int ret = -1;
+
+	der = mbedtls_calloc(1, len);
+	if (der == NULL) {
+		return -1;
+	}
+	if (read(fd, der, len) != len) {
+		goto out;
+	}
+	session->peer_cert = mbedtls_calloc(1, sizeof(mbedtls_x509_crt));
+	if (session->peer_cert == NULL) {
+		goto out;
+	}
+	mbedtls_x509_crt_init(session->peer_cert);
+	if (mbedtls_x509_crt_parse_der(session->peer_cert, der, len) == 0) {
+		ret = 0;
+	}
+
+out:
+	mbedtls_free(der);
+	return ret;
+}
+#endif
+
+static void tls_session_restore(void)
+{
+	struct tls_session_record rec;
+	struct tls_session_entry *entry;
+	uint32_t magic;
+	int fd;
+	int i;
+
+	g_tls_session_loaded = 1;
+
+	fd = open(CONFIG_TLS_SESSION_STORE_PATH, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	if (read(fd, &magic, sizeof(magic)) != sizeof(magic) || magic != TLS_SESSION_FILE_MAGIC) {
+		goto out;
+	}
+
+	for (i = 0; i < CONFIG_TLS_SESSION_STORE_ENTRIES; i++) {
+		if (read(fd, &rec, sizeof(rec)) != sizeof(rec)) {
+			break;
+		}
+		if (rec.key[0] == '\0' || rec.key[TLS_SESSION_KEY_LEN - 1] != '\0' || rec.id_len > sizeof(rec.id) || rec.ticket_len > TLS_SESSION_TICKET_MAX || rec.cert_len > TLS_SESSION_CERT_MAX) {
+			break;
+		}
+
+		entry = &g_tls_sessions[i];
+		mbedtls_ssl_session_init(&entry->session);
+#if TLS_SESSION_HAS_TICKETS
+		if (rec.ticket_len > 0) {
+			entry->session.ticket = mbedtls_calloc(1, rec.ticket_len);
+			if (entry->session.ticket == NULL) {
+				break;
+			}
+			if (read(fd, entry->session.ticket, rec.ticket_len) != rec.ticket_len) {
+				mbedtls_ssl_session_free(&entry->session);
+				break;
+			}
+			entry->session.ticket_len = rec.ticket_len;
+		}
+		entry->session.ticket_lifetime = rec.ticket_lifetime;
+#else
+		if (rec.ticket_len > 0 && lseek(fd, rec.ticket_len, SEEK_CUR) < 0) {
+			break;
+		}
+#endif
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+		if (rec.cert_len > 0 && tls_session_restore_cert(fd, &entry->session, rec.cert_len) < 0) {
+			mbedtls_ssl_session_free(&entry->session);
+			break;
+		}
+#else
+		if (rec.cert_len > 0 && lseek(fd, rec.cert_len, SEEK_CUR) < 0) {
+			mbedtls_ssl_session_free(&entry->session);
+			break;
+		}
+#endif
+#if defined(MBEDTLS_HAVE_TIME)
+		entry->session.start = (mbedtls_time_t)rec.start;
+#endif
+		entry->session.ciphersuite = rec.ciphersuite;
+		entry->session.compression = rec.compression;
+		entry->session.verify_result = rec.verify_result;
+		entry->session.id_len = rec.id_len;
+		memcpy(entry->session.id, rec.id, sizeof(rec.id));
+		memcpy(entry->session.master, rec.master, sizeof(rec.master));
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+		entry->session.mfl_code = rec.mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+		entry->session.trunc_hmac = rec.trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+		entry->session.encrypt_then_mac = rec.encrypt_then_mac;
+#endif
+		memcpy(entry->key, rec.key, sizeof(entry->key));
+		memcpy(entry->conf, rec.conf, sizeof(entry->conf));
+		entry->stamp = rec.stamp;
+		if ((int32_t)(rec.stamp - g_tls_session_clock) > 0) {
+			g_tls_session_clock = rec.stamp;
+		}
+	}
+
+out:
+	close(fd);
+}
+#endif							/* CONFIG_TLS_SESSION_STORE_PERSIST */
+
+static void tls_session_lock(void)
+{
+	pthread_mutex_lock(&g_tls_session_lock);
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+	if (!g_tls_session_loaded) {
+		tls_session_restore();
+	}
+#endif
+}
+
+static void tls_session_unlock(void)
+{
+	pthread_mutex_unlock(&g_tls_session_lock);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int tls_session_store_load(const char *host, unsigned short port, mbedtls_ssl_context *ssl)
+{
+	struct tls_session_entry *entry;
+	char key[TLS_SESSION_KEY_LEN];
+	uint8_t conf[TLS_SESSION_CONF_LEN];
+	int ret = -1;
+
+	if (ssl == NULL || ssl->conf == NULL || tls_session_key(key, host, port) < 0) {
+		return -1;
+	}
+	tls_session_conf(conf, ssl);
+
+	tls_session_lock();
+	entry = tls_session_find(key, conf);
+	if (entry != NULL) {
+		if (tls_session_expired(entry) || entry->session.verify_result != 0) {
+			tls_session_drop(entry);
+		} else if (mbedtls_ssl_set_session(ssl, &entry->session) == 0) {
+			entry->stamp = ++g_tls_session_clock;
+			ret = 0;
+		}
+	}
+	tls_session_unlock();
+
+	return ret;
+}
+
+int tls_session_store_save(const char *host, unsigned short port, const mbedtls_ssl_context *ssl)
+{
+	struct tls_session_entry *entry;
+	mbedtls_ssl_session session;
+	char key[TLS_SESSION_KEY_LEN];
+	uint8_t conf[TLS_SESSION_CONF_LEN];
+
+	if (ssl == NULL || ssl->conf == NULL || tls_session_key(key, host, port) < 0) {
+		return -1;
+	}
+	tls_session_conf(conf, ssl);
+
+	/* copy outside the lock: this parses the peer certificate */
+	mbedtls_ssl_session_init(&session);
+	if (mbedtls_ssl_get_session(ssl, &session) != 0) {
+		mbedtls_ssl_session_free(&session);
+		return -1;
+	}
+
+	/* a resumed session skips peer verification: never keep an unverified one */
+	if (session.verify_result != 0) {
+		mbedtls_ssl_session_free(&session);
+		return -1;
+	}
+#if TLS_SESSION_HAS_TICKETS
+	if (session.ticket_len > TLS_SESSION_TICKET_MAX) {
+		mbedtls_free(session.ticket);
+		session.ticket = NULL;
+		session.ticket_len = 0;
+	}
+	if (session.id_len == 0 && session.ticket_len == 0) {
+#else
+	if (session.id_len == 0) {
+#endif
+		/* the server does not support resumption */
+		mbedtls_ssl_session_free(&session);
+		return -1;
+	}
+
+	tls_session_lock();
+	entry = tls_session_find(key, conf);
+	if (entry == NULL) {
+		entry = tls_session_victim();
+	}
+	if (entry->key[0] != '\0') {
+		mbedtls_ssl_session_free(&entry->session);
+	}
+	memcpy(&entry->session, &session, sizeof(session));
+	strncpy(entry->key, key, sizeof(entry->key));
+	memcpy(entry->conf, conf, sizeof(entry->conf));
+	entry->stamp = ++g_tls_session_clock;
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+	tls_session_flush();
+#endif
+	tls_session_unlock();
+
+	return 0;
+}
+
+void tls_session_store_remove(const char *host, unsigned short port)
+{
+	char key[TLS_SESSION_KEY_LEN];
+	int removed = 0;
+	int i;
+
+	if (tls_session_key(key, host, port) < 0) {
+		return;
+	}
+
+	/* the sessions of every configuration for host:port */
+
+	tls_session_lock();
+	for (i = 0; i < CONFIG_TLS_SESSION_STORE_ENTRIES; i++) {
+		if (g_tls_sessions[i].key[0] != '\0' && strcmp(g_tls_sessions[i].key, key) == 0) {
+			tls_session_drop(&g_tls_sessions[i]);
+			removed = 1;
+		}
+	}
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+	if (removed) {
+		tls_session_flush();
+	}
+#else
+	(void)removed;
+#endif
+	tls_session_unlock();
+}
+
+void tls_session_store_clear(void)
+{
+	int i;
+
+	tls_session_lock();
+	for (i = 0; i < CONFIG_TLS_SESSION_STORE_ENTRIES; i++) {
+		if (g_tls_sessions[i].key[0] != '\0') {
+			tls_session_drop(&g_tls_sessions[i]);
+		}
+	}
+#ifdef CONFIG_TLS_SESSION_STORE_PERSIST
+	unlink(CONFIG_TLS_SESSION_STORE_PATH);
+#endif
+	tls_session_unlock();
+}
+
+#endif							/* CONFIG_TLS_SESSION_STORE */
@@ -0,0 +1,199 @@
+#!/usr/bin/env python
+###########################################################################
+#
+# Copyright 2017 Samsung Electronics All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+# either express or implied. See the License for the specific
+# language governing permissions and limitations under the License.
+#
+###########################################################################
+#
+# Symbolize and rank a heap allocation site profile taken on the target
+# with CONFIG_DEBUG_MM_HEAPINFO_PROFILE, either the binary /proc/heapprof
+# file or the text printed by "heapinfo -s".
+#
+#Example: heapprof.py -e build/output/bin/tinyara -f heapprof.bin
+#         heapprof.py -e build/output/bin/tinyara -f after.txt -b before.txt
+
+import sys
+import re
+import struct
+import subprocess
+from optparse import OptionParser
+
+HEAPPROF_MAGIC = 0x46525048
+HDR_FORMAT = "IHHIIII"
+SITE_FORMAT = "IIIII"
+
+# Chunks up to this size, allocation node included, count as small ones
+# when looking for fragmentation.
+
+SMALL_CHUNK = 64
+
+parser = OptionParser()
+parser.add_option("-f", "--file", dest="infilename", help="profile FILE from /proc/heapprof or heapinfo -s", metavar="INPUT_FILE")
+parser.add_option("-b", "--base", dest="basefilename", help="earlier profile to diff against for leak suspects", metavar="BASE_FILE")
+parser.add_option("-e", "--elf", dest="elf", help="ELF image used to symbolize the caller addresses", metavar="ELF_FILE")
+parser.add_option("-p", "--prefix", dest="prefix", help="toolchain prefix. Default is arm-none-eabi-.", default="arm-none-eabi-")
+parser.add_option("-n", "--top", dest="top", type="int", help="number of sites in each ranking. Default is 10.", default=10)
+parser.add_option("-o", "--output", dest="output", help="Output written to this file. Default is stdout.", metavar="OUTPUT_FILE")
+
+
+class Site:
+	def __init__(self, addr, live, count, peak, allocs):
+		self.addr = addr
+		self.live = live
+		self.count = count
+		self.peak = peak
+		self.allocs = allocs
+
+
+def load_binary(data):
+	for endian in ("<", ">"):
+		hdr = struct.unpack_from(endian + HDR_FORMAT, data, 0)
+		if hdr[0] == HEAPPROF_MAGIC:
+			break
+	else:
+		return None
+	magic, version, entry_size, nsites, heap_size, alloc_size, peak_size = hdr
+	if version != 1 or entry_size < struct.calcsize(SITE_FORMAT):
+		sys.exit("unsupported profile version %d, entry size %d" % (version, entry_size))
+	sites = {}
+	offset = struct.calcsize(HDR_FORMAT)
+	for i in range(nsites):
+		if offset + entry_size > len(data):
+			sys.exit("profile truncated after %d of %d sites" % (i, nsites))
+		site = Site(*struct.unpack_from(endian + SITE_FORMAT, data, offset))
+		sites[site.addr] = site
+		offset += entry_size
+	print("Heap %d bytes, allocated %d, peak %d, %d sites" % (heap_size, alloc_size, peak_size, nsites))
+	return sites
+
+
+def load_text(text):
+	sites = {}
+	for line in text.splitlines():
+		m = re.match(r"\s*0x([0-9a-fA-F]+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s*$", line)
+		if m:
+			site = Site(int(m.group(1), 16), *[int(v) for v in m.groups()[1:]])
+			sites[site.addr] = site
+	return sites
+
+
+def load(filename):
+	data = open(filename, "rb").read()
+	sites = None
+	if len(data) >= struct.calcsize(HDR_FORMAT):
+		sites = load_binary(data)
+	if sites is None:
+		sites = load_text(data.decode("ascii", "replace"))
+	if not sites:
+		sys.exit("%s: no allocation sites found" % filename)
+	return sites
+
+
+def symbolize(elf, prefix, addrs):
+	names = {0: "(others)"}
+	addrs = [a for a in addrs if a != 0]
+	if not elf or not addrs:
+		return names
+
+	# The recorded address is the return address of the malloc call; step
+	# back into the call instruction, dropping the Thumb bit, so that
+	# addr2line reports the calling line rather than the next one.
+
+	args = [prefix + "addr2line", "-f", "-C", "-e", elf] + ["0x%x" % ((a & ~1) - 2) for a in addrs]
+	try:
+		out = subprocess.check_output(args).decode("ascii", "replace").splitlines()
+	except (OSError, subprocess.CalledProcessError) as e:
+		sys.stderr.write("addr2line failed: %s\n" % e)
+		return names
+	for i, addr in enumerate(addrs):
+		func = out[2 * i] if 2 * i < len(out) else "??"
+		loc = out[2 * i + 1] if 2 * i + 1 < len(out) else "??:0"
+		names[addr] = "%s %s" % (func, loc.split("/")[-1])
+	return names
+
+
+def name(names, site):
+	return names.get(site.addr, "0x%08x" % site.addr)
+
+
+def report(title, header, rows):
+	print("\n%s" % title)
+	print(header)
+	print("-" * len(header))
+	if not rows:
+		print("(none)")
+	for row in rows:
+		print(row)
+
+
+(options, args) = parser.parse_args()
+if not options.infilename:
+	parser.print_help()
+	sys.exit(1)
+
+if options.output:
+	sys.stdout = open(options.output, "w")
+
+sites = load(options.infilename)
+base = load(options.basefilename) if options.basefilename else None
+addrs = set(sites.keys())
+if base:
+	addrs |= set(base.keys())
+names = symbolize(options.elf, options.prefix, sorted(addrs))
+top = options.top
+
+# Where the memory is now
+
+ranked = sorted(sites.values(), key=lambda s: s.live, reverse=True)[:top]
+report("Live bytes by allocation site",
+	"    Live  Count     Peak   Allocs  Site",
+	["%8d %6d %8d %8d  %s" % (s.live, s.count, s.peak, s.allocs, name(names, s)) for s in ranked if s.live])
+
+# Leak suspects: with a base profile, the sites whose live size grew
+# between the two; otherwise the sites that never gave memory back,
+# still at their peak with several chunks outstanding.
+
+if base:
+	empty = Site(0, 0, 0, 0, 0)
+	grown = []
+	for s in sites.values():
+		b = base.get(s.addr, empty)
+		if s.live > b.live and s.count > b.count:
+			grown.append((s.live - b.live, s.count - b.count, s))
+	grown.sort(key=lambda g: g[0], reverse=True)
+	report("Leak suspects (growth since %s)" % options.basefilename,
+		"  +Bytes +Count     Live  Site",
+		["%8d %6d %8d  %s" % (d, c, s.live, name(names, s)) for d, c, s in grown[:top]])
+else:
+	held = [s for s in sites.values() if s.count > 1 and s.live == s.peak and s.allocs == s.count]
+	held.sort(key=lambda s: s.live, reverse=True)
+	report("Leak suspects (never freed, at peak)",
+		"    Live  Count  Site",
+		["%8d %6d  %s" % (s.live, s.count, name(names, s)) for s in held[:top]])
+
+# Fragmentation suspects: many small chunks kept alive, which pin free
+# space between them, and sites that churn small chunks through the heap.
+
+small = [s for s in sites.values() if s.count > 1 and s.live // s.count <= SMALL_CHUNK]
+small.sort(key=lambda s: s.count, reverse=True)
+report("Fragmentation suspects (small live chunks)",
+	"   Count  AvgSz     Live  Site",
+	["%8d %6d %8d  %s" % (s.count, s.live // s.count, s.live, name(names, s)) for s in small[:top]])
+
+churn = [s for s in sites.values() if s.allocs > s.count]
+churn.sort(key=lambda s: s.allocs - s.count, reverse=True)
+report("Churn (chunks allocated and freed)",
+	"   Freed  Count     Peak  Site",
+	["%8d %6d %8d  %s" % (s.allocs - s.count, s.count, s.peak, name(names, s)) for s in churn[:top]])